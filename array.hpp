@@ -10,12 +10,41 @@
 #define MN_ARRAY_HPP
 
 #include <stdexcept>
+#include <utility>
 
 #include "policy-compare.hpp"
 
 namespace mina86 {
 
 
+/**
+ * Default memory allocation policy of Array.  Allocates elements with
+ * \c new[] and frees them with \c delete[].  A policy is a class with
+ * static allocate() and deallocate() methods; deallocate() is given
+ * the same number of elements which was passed to allocate() and has
+ * to accept a null pointer.
+ */
+template<class T>
+struct default_alloc_policy {
+	/**
+	 * Allocates memory for given number of elements.
+	 *
+	 * \param[in] n number of elements
+	 * \return pointer to allocated memory
+	 */
+	static T *allocate(unsigned n) { return new T[n]; }
+
+	/**
+	 * Frees memory allocated with allocate().
+	 *
+	 * \param[in] p pointer to allocated memory or null pointer
+	 * \param[in] n number of elements passed to allocate()
+	 */
+	static void deallocate(T *p, unsigned n) { (void)n; delete[] p; }
+};
+
+
+
 /**
  * Class representing a dynamic array which growns and shrinks when
  * elements arr added or removed.  This array is implemented in such a
@@ -35,8 +64,11 @@ namespace mina86 {
  * \a baz will most likelly have the value \c 20 instead of \c 10.  In
  * particular, iterators get invalidated when Array is modified but
  * also when another Array is assigned value of oryginal Array.
+ *
+ * Memory for elements is obtained through \a Alloc policy, see
+ * default_alloc_policy.
  */
-template<class T>
+template<class T, class Alloc = default_alloc_policy<T> >
 class Array {
 
 	/**
@@ -53,7 +85,7 @@ class Array {
 		 * Destructor.
 		 */
 		~Data() {
-			delete[] data;
+			Alloc::deallocate(data, capacity);
 		}
 
 	public:
@@ -80,7 +112,7 @@ class Array {
 		 * \warning All constructors sets reference counter to zero.
 		 *          You need to use inc() to increase it.
 		 */
-		Data() : references(0), data(0), size(0), capacity(0) { }
+		constexpr Data() : references(0), data(0), size(0), capacity(0) { }
 
 		/**
 		 * Constructor allocating initial memory.
@@ -91,7 +123,7 @@ class Array {
 		 * \param[in] c initial capacity.
 		 */
 		Data(unsigned c) : references(0), data(0), size(0), capacity(c) {
-			if (c) data = new T[c];
+			if (c) data = Alloc::allocate(c);
 		}
 
 
@@ -103,33 +135,59 @@ class Array {
 		Data(const Data &d)
 			: references(0), data(0), size(d.size), capacity(d.capacity) {
 			if (!capacity) return;
-			data = new T[capacity];
+			data = Alloc::allocate(capacity);
 			copy(d.data, d.size);
 		}
 
 
 		/**
 		 * Increments references counter.  This should be the first
-		 * thing done after constructing a new Data object.
+		 * thing done after constructing a new Data object.  Does
+		 * nothing for the object returned by empty().
 		 *
 		 * \param[in] d pointer to data object
 		 * \sa dec()
 		 */
 		static void inc(Data *d) {
-			++d->references;
+			if (d!=&shared_empty) ++d->references;
 		}
 
 		/**
 		 * Decrements references counter.  Deletes data object if
-		 * reference counter reaches zero.
+		 * reference counter reaches zero.  Does nothing for the object
+		 * returned by empty().
 		 *
 		 * \param[in] d pointer to data object
 		 * \sa inc()
 		 */
 		static void dec(Data *d) {
-			if (!--d->references) delete d;
+			if (d!=&shared_empty && !--d->references) delete d;
 		}
 
+		/**
+		 * Returns shared Data object with no elements and no memory
+		 * allocated.  Empty Array objects refer to it so that
+		 * creating them does not allocate any memory.  Its reference
+		 * counter is never changed (and stays zero) so it may be
+		 * shared between threads, is never deleted and, since
+		 * isOwn() is \c false for it, is copied before any
+		 * modification.  Using inc() and dec() on it is allowed.
+		 *
+		 * \return pointer to empty data object
+		 */
+		static Data *empty() {
+			return &shared_empty;
+		}
+
+	private:
+		/**
+		 * Object returned by empty().  It is constant initialised so
+		 * it can be used during static initialisation.
+		 */
+		static Data shared_empty;
+
+	public:
+
 
 		/**
 		 * Copy elements and sets size.  This method does not check if
@@ -158,6 +216,22 @@ class Array {
 			for (T *d = data + idx; s; --s) *d++ = *array++;
 		}
 
+		/**
+		 * Moves elements to given location and sets size.  Works like
+		 * copyAt() but leaves source elements in a moved-from state
+		 * so it should be used only when they are about to be
+		 * destroyed.
+		 *
+		 * \param[in] idx index at which elements should be moved
+		 * \param[in] array pointer to first element of array
+		 * \param[in] s number of elements to move
+		 * \sa copyAt()
+		 */
+		void moveAt(int idx, T *array, unsigned s) {
+			size = s + idx;
+			for (T *d = data + idx; s; --s) *d++ = std::move(*array++);
+		}
+
 		/**
 		 * Checks if only one Array object refers to this object.
 		 *
@@ -193,7 +267,7 @@ public:
 		/**
 		 * Reference to Array object
 		 */
-		const Array<T> &array;
+		const Array &array;
 
 		/**
 		 * Requested index.
@@ -207,7 +281,7 @@ public:
 		 * \param[in] arr Array object
 		 * \param[in] idx requested index
 		 */
-		BadIndex(const Array<T> &arr, unsigned idx)
+		BadIndex(const Array &arr, unsigned idx)
 			: array(arr), index(idx) { }
 
 		/**
@@ -223,7 +297,7 @@ public:
 		 *
 		 * \return reference to Array object
 		 */
-		const Array<T> &getArray() const { return array; }
+		const Array &getArray() const { return array; }
 
 
 		/**
@@ -235,12 +309,13 @@ public:
 
 
 	/**
-	 * Default constructor.
+	 * Default constructor.  If \a capacity is zero no memory is
+	 * allocated.
 	 *
 	 * \param[in] capacity initial capacity of the Array
 	 */
 	Array(unsigned capacity = 0) {
-		data = new Data(capacity);
+		data = capacity ? new Data(capacity) : Data::empty();
 		Data::inc(data);
 	}
 
@@ -254,6 +329,17 @@ public:
 		Data::inc(data);
 	}
 
+	/**
+	 * Move constructor.  Takes over data of \a array leaving it
+	 * empty.  No memory is allocated and reference counters are not
+	 * touched.
+	 *
+	 * \param[in] array Array object to move
+	 */
+	Array(Array &&array) noexcept : data(array.data) {
+		Data::inc(array.data = Data::empty());
+	}
+
 	/**
 	 * Destructor.
 	 */
@@ -283,7 +369,7 @@ public:
 	 * \param[in] array Array to copy
 	 * \sa set(const T*, unsigned, unsigned)
 	 */
-	void set(const Array<T> &array) {
+	void set(const Array &array) {
 		if (array.data!=data) {
 			Data::dec(data);
 			Data::inc(data = array.data);
@@ -313,7 +399,10 @@ public:
 	 * and at least \a c.  Moreover, he or she must not * assume that
 	 * the class will really use this memory as it cen ba * freed soon
 	 * after calling this method and then memory pointed by * given
-	 * pointer will be unusable.
+	 * pointer will be unusable.  The memory must have been obtained
+	 * with \a Alloc policy and \a capacity must be the number of
+	 * elements which was requested from it; if it is less then \a
+	 * _size the latter is used.
 	 *
 	 * \param[in] arrays pointer to allocated memory
 	 * \param[in] _size number of elements
@@ -322,14 +411,14 @@ public:
 	 */
 	void set_no_copy(T *arrays, unsigned _size, unsigned capacity = 0) {
 		if (data->isOwn()) {
-			delete[] data->data;
+			Alloc::deallocate(data->data, data->capacity);
 		} else {
 			Data::dec(data);
 			Data::inc(data = new Data());
 		}
 		data->data = arrays;
 		data->size = _size;
-		data->capacity = capacity<_size ? _size+8 : capacity;
+		data->capacity = capacity<_size ? _size : capacity;
 	}
 
 
@@ -343,6 +432,16 @@ public:
 		insert(data->size, element);
 	}
 
+	/**
+	 * Moves element to the end of Array.
+	 *
+	 * \param[in] element element to add
+	 * \sa pop(), unshift()
+	 */
+	void push(T &&element) {
+		insert(data->size, std::move(element));
+	}
+
 	/**
 	 * Returns and removes element at the end of Array.  If array is
 	 * empty BadIndex is thrown.
@@ -352,7 +451,8 @@ public:
 	 */
 	T pop() {
 		if (!data->size) throw BadIndex(*this, 0);
-		T element(data->data[data->size-1]);
+		T element(data->isOwn() ? std::move(data->data[data->size-1])
+		                        : data->data[data->size-1]);
 		shrinkBy(1);
 		return element;
 	}
@@ -411,6 +511,16 @@ public:
 		insert(0, element);
 	}
 
+	/**
+	 * Moves element to the beginning of Array.
+	 *
+	 * \param[in] element element to insert
+	 * \sa unshift(), shift(), pop()
+	 */
+	void unshift(T &&element) {
+		insert(0, std::move(element));
+	}
+
 	/**
 	 * Returns and removed element from the beginning of Array.  If
 	 * array is empty BadIndex is thrown.
@@ -451,7 +561,20 @@ public:
 	 * \param[in] element element to insert
 	 * \sa remove()
 	 */
-	void insert(unsigned pos, const T &element);
+	void insert(unsigned pos, const T &element) {
+		insert(pos, T(element));
+	}
+
+	/**
+	 * Moves element to given position.  If \a pos is greater then
+	 * Array's size (ie. it isn't a valid index nor it points at the
+	 * end of Array) BadIndex will be thrown.
+	 *
+	 * \param[in] pos position to insert at
+	 * \param[in] element element to insert
+	 * \sa remove()
+	 */
+	void insert(unsigned pos, T &&element);
 
 	/**
 	 * Removes element at given position.  If \a order is \c false,
@@ -757,6 +880,22 @@ public:
 		return *this;
 	}
 
+	/**
+	 * Move-assigns Array object.  Takes over data of \a array so no
+	 * memory is allocated nor copied; \a array becomes empty.
+	 * Assigning object to itself does nothing.
+	 *
+	 * \param[in] array Array object to move
+	 */
+	Array &operator=(Array &&array) noexcept {
+		if (this!=&array) {
+			Data::dec(data);
+			data = array.data;
+			Data::inc(array.data = Data::empty());
+		}
+		return *this;
+	}
+
 
 
 	/**
@@ -808,7 +947,7 @@ public:
 		 * \param[in] b second object
 		 * \return \c true if both objects are equal
 		 */
-		static bool eq(const Array<T> &a, const Array<T> &b) {
+		static bool eq(const Array &a, const Array &b) {
 			if (a.data == b.data) return true;
 			if (a.size() != b.size()) return false;
 			const T *e1 = a.begin(), *e2 = b.begin(), *const end = a.end();
@@ -824,7 +963,7 @@ public:
 		 * \return \c true if first object is greater then on equal to the
 		 *         second
 		 */
-		static bool ge(const Array<T> &a, const Array<T> &b) {
+		static bool ge(const Array &a, const Array &b) {
 			if (a.size()<b.size()) return false;
 			if (a.size>b.size()) return true;
 			if (a.data == b.data) return true;
@@ -855,6 +994,10 @@ public:
 };
 
 
+template<class T, class Alloc>
+typename Array<T, Alloc>::Data Array<T, Alloc>::Data::shared_empty;
+
+
 /**
  * Sends elements of Array to output stream.  Separates elements by
  * single space character.
@@ -863,8 +1006,8 @@ public:
  * \param[in] a  an array to send
  * \return \a os
  */
-template<class T>
-std::ostream &operator<<(std::ostream &os, const Array<T> &a) {
+template<class T, class Alloc>
+std::ostream &operator<<(std::ostream &os, const Array<T, Alloc> &a) {
 	const T *begin = a.begin(), *const end = a.end();
 	if (begin!=end) {
 		for (os << *begin; ++begin!=end; os << ' ' << *begin);
@@ -878,8 +1021,8 @@ std::ostream &operator<<(std::ostream &os, const Array<T> &a) {
  * Specialization of \a is_ordered struct saing \a Array<T> has a
  * linear order if \a T has a linear order.
  */
-template<class T>
-struct is_ordered< Array<T> > {
+template<class T, class Alloc>
+struct is_ordered< Array<T, Alloc> > {
 	/**
 	 * Field says that \a Array<T> has linear order if \a T has a
 	 * linear order.
@@ -893,9 +1036,9 @@ struct is_ordered< Array<T> > {
  * Specialization of \a default_cmp_policy structure for \a Array<T>
  * type.
 */
-template<class T>
-struct default_cmp_policy< Array<T> >
-	: public Array<T>::template cmp_policy<> { };
+template<class T, class Alloc>
+struct default_cmp_policy< Array<T, Alloc> >
+	: public Array<T, Alloc>::template cmp_policy<> { };
 
 
 
@@ -907,9 +1050,9 @@ struct default_cmp_policy< Array<T> >
  * \param[in] b the second Array to test for equality
  * \return \c true if both arraies are equal, \c false otherwise
  */
-template<class T>
-bool operator==(const Array<T> &a, const Array<T> &b) {
-	return default_cmp_policy<Array<T> >::eq(a, b);
+template<class T, class Alloc>
+bool operator==(const Array<T, Alloc> &a, const Array<T, Alloc> &b) {
+	return default_cmp_policy<Array<T, Alloc> >::eq(a, b);
 }
 
 
@@ -921,9 +1064,9 @@ bool operator==(const Array<T> &a, const Array<T> &b) {
  * \param[in] b the second Array to test for equality
  * \return \c true if arraies are not equal, \c false otherwise
  */
-template<class T>
-bool operator!=(const Array<T> &a, const Array<T> &b) {
-	return !default_cmp_policy<Array<T> >::eq(a, b);
+template<class T, class Alloc>
+bool operator!=(const Array<T, Alloc> &a, const Array<T, Alloc> &b) {
+	return !default_cmp_policy<Array<T, Alloc> >::eq(a, b);
 }
 
 
@@ -932,8 +1075,8 @@ bool operator!=(const Array<T> &a, const Array<T> &b) {
 
 
 /******************** Implementation ********************/
-template<class T>
-void Array<T>::insert(unsigned pos, const T &element) {
+template<class T, class Alloc>
+void Array<T, Alloc>::insert(unsigned pos, T &&element) {
 	if (pos>data->size) {
 		throw BadIndex(data->size, pos);
 	}
@@ -947,33 +1090,34 @@ void Array<T>::insert(unsigned pos, const T &element) {
 		Data *d = new Data(capacity);
 		const unsigned _size = data->size;
 		d->copyAt(0, data->data, pos);
-		d->copyAt(pos, &element, 1);
+		d->moveAt(pos, &element, 1);
 		d->copyAt(pos + 1, data->data + pos, _size - pos);
 		Data::dec(data);
 		Data::inc(data = d);
 	} else if (data->capacity>=capacity) {
 		T *el = data->data + data->size;
 		for (unsigned left = data->size - pos; left; --el, --left) {
-			*el = *(el - 1);
+			*el = std::move(*(el - 1));
 		}
-		*el = element;
+		*el = std::move(element);
 		++data->size;
 	} else {
 		T *d = data->data;
-		data->data = new T[capacity];
+		const unsigned old = data->capacity;
+		data->data = Alloc::allocate(capacity);
 		data->capacity = capacity;
 		const unsigned _size = data->size;
-		data->copyAt(0, d, pos);
-		data->copyAt(pos, &element, 1);
-		data->copyAt(pos + 1, d + pos, _size - pos);
-		delete[] d;
+		data->moveAt(0, d, pos);
+		data->moveAt(pos, &element, 1);
+		data->moveAt(pos + 1, d + pos, _size - pos);
+		Alloc::deallocate(d, old);
 	}
 }
 
 
 
-template<class T>
-void Array<T>::remove(unsigned pos, bool order) {
+template<class T, class Alloc>
+void Array<T, Alloc>::remove(unsigned pos, bool order) {
 	if (pos>=data->size) {
 		throw BadIndex(data->size, pos);
 	} else if (!data->isOwn()) {
@@ -985,28 +1129,28 @@ void Array<T>::remove(unsigned pos, bool order) {
 		Data::inc(data = d);
 	} else if (data->capacity - data->size >= 256) {
 		T *d = data->data;
-		const unsigned _size = data->size;
-		data->data = new T[_size + 31];
+		const unsigned _size = data->size, old = data->capacity;
+		data->data = Alloc::allocate(_size + 31);
 		data->capacity = _size + 31;
-		data->copyAt(0, d, pos);
-		data->copyAt(pos, d + pos + 1, _size - pos - 1);
-		delete[] d;
+		data->moveAt(0, d, pos);
+		data->moveAt(pos, d + pos + 1, _size - pos - 1);
+		Alloc::deallocate(d, old);
 	} else if (pos == --data->size) {
 		/* nothing */
 	} else if (!order) {
-		data->data[pos] = data->data[data->size];
+		data->data[pos] = std::move(data->data[data->size]);
 	} else {
 		T *el = data->data + pos, *const last = data->data + data->size;
 		for (; el!=last; ++el) {
-			el[0] = el[1];
+			el[0] = std::move(el[1]);
 		}
 	}
 }
 
 
 
-template<class T>
-void Array<T>::resize(unsigned _size, unsigned capacity) {
+template<class T, class Alloc>
+void Array<T, Alloc>::resize(unsigned _size, unsigned capacity) {
 	if (_size==data->size && data->capacity >= capacity
 	    && data->capacity <= capacity + 256
 	    && data->capacity <= data->size + 256) {
@@ -1023,13 +1167,14 @@ void Array<T>::resize(unsigned _size, unsigned capacity) {
 		d->size = _size;
 		Data::dec(data);
 		Data::inc(data = d);
-	} else if (capacity>=data->capacity || capacity+256<=data->capacity) {
+	} else if (capacity>data->capacity || capacity+256<=data->capacity) {
 		T *d = data->data;
-		data->data = new T[capacity];
+		const unsigned old = data->capacity;
+		data->data = Alloc::allocate(capacity);
 		data->capacity = capacity;
-		data->copy(d, _size <= data->size ? _size : data->size);
+		data->moveAt(0, d, _size <= data->size ? _size : data->size);
 		data->size = _size;
-		delete[] d;
+		Alloc::deallocate(d, old);
 	} else {
 		data->size = _size;
 	}
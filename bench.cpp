@@ -0,0 +1,336 @@
+/**
+ * \file
+ * BigInt benchmark.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * This program measures time of parsing, printing, addition,
+ * substraction, multiplication, squaring, division and comparison of
+ * numbers of sizes from one digit up to given number of digits
+ * growing geometrically (1, 3, 10, 30, 100 and so on).  Operands are
+ * generated from a fixed seed so every run measures the same
+ * numbers.  Each operation is repeated until it takes at least
+ * #MIN_TIME and the best of #ROUNDS rounds is reported.  Results are
+ * printed to standard output as JSON:
+ *
+ * \code
+ * {
+ *   "seed": 1,
+ *   "results": [
+ *     { "op": "add", "digits": 1, "iterations": 4194304, "ns": 12.5 },
+ *     ...
+ *   ]
+ * }
+ * \endcode
+ *
+ * Usage is <code>bench [ <var>max-digits</var> [ <var>seed</var> ]
+ * ]</code> where the default is a million digits and seed one.
+ *
+ * With <code>bench compare <var>old</var> <var>new</var> [
+ * <var>percent</var> ]</code> program reads two such files and
+ * compares times of operations present in both.  Operations which
+ * got slower by more than given percent (10 by default) are marked
+ * as regressions and program exits with non-zero status if there was
+ * any.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "bigint.hpp"
+
+using mina86::BigInt;
+
+
+/**
+ * Minimal time a single round of measurement takes, in seconds.
+ */
+static const double MIN_TIME = 0.02;
+
+/**
+ * Number of rounds; the fastest one is reported.
+ */
+static const unsigned ROUNDS = 5;
+
+
+/**
+ * Value results of operations are folded into so the compiler does
+ * not optimise the operations away.
+ */
+static volatile int sink;
+
+
+
+/******************** Operands ********************/
+/**
+ * Reproducible pseudo-random number generator (xorshift).  Unlike
+ * rand() it gives the same sequence on all platforms.
+ */
+struct Random {
+	/** Current state, never zero. */
+	uint64_t state;
+
+	/**
+	 * Initialises generator.
+	 *
+	 * \param[in] seed seed
+	 */
+	explicit Random(uint64_t seed) : state(seed * 2 + 1) { }
+
+	/**
+	 * Returns next pseudo-random number.
+	 *
+	 * \return pseudo-random number
+	 */
+	uint64_t next() {
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	}
+
+	/**
+	 * Returns string of decimal digits.
+	 *
+	 * \param[in] n number of digits
+	 * \return decimal representation of a number with \a n digits
+	 */
+	std::string digits(unsigned long n) {
+		std::string str;
+		str.reserve(n);
+		str += '1' + next() % 9;
+		while (str.size()<n) str += '0' + next() % 10;
+		return str;
+	}
+};
+
+
+
+/******************** Measurement ********************/
+/**
+ * Operands of a single benchmark.
+ */
+struct Operands {
+	/** Decimal representation of #a. */
+	std::string str;
+	/** First operand. */
+	BigInt a;
+	/** Second operand of the same size. */
+	BigInt b;
+	/** Copy of #a with the least significant digit changed. */
+	BigInt c;
+	/** Dividend of twice the size. */
+	BigInt d;
+};
+
+
+/**
+ * Runs operation given number of times.
+ *
+ * \param[in] op name of the operation
+ * \param[in] o operands
+ * \param[in] n number of iterations
+ */
+static void run(const char *op, const Operands &o, unsigned long n) {
+	BigInt r;
+	int s = 0;
+	if (!strcmp(op, "parse")) {
+		while (n--) s += BigInt(o.str).sgn();
+	} else if (!strcmp(op, "print")) {
+		while (n--) s += o.a.toString().size();
+	} else if (!strcmp(op, "add")) {
+		while (n--) s += (r = o.a + o.b).sgn();
+	} else if (!strcmp(op, "sub")) {
+		while (n--) s += (r = o.a - o.b).sgn();
+	} else if (!strcmp(op, "mul")) {
+		while (n--) s += (r = o.a * o.b).sgn();
+	} else if (!strcmp(op, "sqr")) {
+		while (n--) s += (r = o.a).sqr().sgn();
+	} else if (!strcmp(op, "div")) {
+		while (n--) s += (r = o.d / o.b).sgn();
+	} else if (!strcmp(op, "cmp")) {
+		while (n--) s += o.a.cmp(o.c);
+	}
+	sink = sink + s;
+}
+
+
+/**
+ * Measures time of an operation.
+ *
+ * \param[in] op name of the operation
+ * \param[in] o operands
+ * \param[out] iterations number of iterations in a round
+ * \return time of a single operation in nanoseconds
+ */
+static double measure(const char *op, const Operands &o,
+                      unsigned long &iterations) {
+	typedef std::chrono::steady_clock Clock;
+	typedef std::chrono::duration<double> Seconds;
+
+	double best = 0;
+	iterations = 1;
+	for (unsigned round = 0; round<ROUNDS; ) {
+		const Clock::time_point start = Clock::now();
+		run(op, o, iterations);
+		const double t = Seconds(Clock::now() - start).count();
+		if (t<MIN_TIME && !round) {
+			iterations *= t * 8<MIN_TIME ? 8 : 2;
+			continue;
+		}
+		const double ns = t * 1e9 / iterations;
+		if (!round++ || ns<best) best = ns;
+	}
+	return best;
+}
+
+
+/**
+ * Runs all benchmarks and prints results.
+ *
+ * \param[in] max maximal number of digits
+ * \param[in] seed seed of the pseudo-random number generator
+ */
+static void bench(unsigned long max, unsigned long seed) {
+	static const char *const ops[] = {
+		"parse", "print", "add", "sub", "mul", "sqr", "div", "cmp", 0
+	};
+	Random random(seed);
+
+	std::cout << "{\n  \"seed\": " << seed << ",\n  \"results\": [";
+	const char *sep = "\n";
+	for (unsigned long digits = 1, i = 0; digits<=max;
+	     digits = i++ & 1 ? digits * 10 / 3 : digits * 3) {
+		Operands o;
+		o.str = random.digits(digits);
+		o.a = BigInt(o.str);
+		o.b = BigInt(random.digits(digits));
+		o.c = o.a + BigInt(1);
+		o.d = BigInt(random.digits(2 * digits));
+
+		for (const char *const *op = ops; *op; ++op) {
+			unsigned long iterations;
+			const double ns = measure(*op, o, iterations);
+			char buf[160];
+			sprintf(buf, "%s    { \"op\": \"%s\", \"digits\": %lu, "
+			        "\"iterations\": %lu, \"ns\": %.1f }",
+			        sep, *op, digits, iterations, ns);
+			std::cout << buf << std::flush;
+			sep = ",\n";
+		}
+	}
+	std::cout << "\n  ]\n}\n";
+}
+
+
+
+/******************** Comparison ********************/
+/**
+ * Single result read from a file.
+ */
+struct Result {
+	/** Name of the operation. */
+	std::string op;
+	/** Number of digits. */
+	unsigned long digits;
+	/** Time of a single operation in nanoseconds. */
+	double ns;
+};
+
+
+/**
+ * Reads results from a file written by bench().
+ *
+ * \param[in] filename name of the file
+ * \param[out] results results read from the file
+ * \return \c false if file could not be read
+ */
+static bool read_results(const char *filename,
+                         std::vector<Result> &results) {
+	FILE *const fp = fopen(filename, "r");
+	if (!fp) {
+		perror(filename);
+		return false;
+	}
+
+	char line[256], op[32];
+	Result r;
+	while (fgets(line, sizeof line, fp)) {
+		unsigned long iterations;
+		if (sscanf(line, " { \"op\": \"%31[^\"]\", \"digits\": %lu, "
+		           "\"iterations\": %lu, \"ns\": %lf", op, &r.digits,
+		           &iterations, &r.ns)==4) {
+			r.op = op;
+			results.push_back(r);
+		}
+	}
+	fclose(fp);
+	return true;
+}
+
+
+/**
+ * Compares two sets of results and prints the differences.
+ *
+ * \param[in] old_file file with the reference results
+ * \param[in] new_file file with the new results
+ * \param[in] percent slowdown (in per cent) considered a regression
+ * \return number of regressions or \c -1 if files could not be read
+ */
+static int compare(const char *old_file, const char *new_file,
+                   double percent) {
+	std::vector<Result> olds, news;
+	if (!read_results(old_file, olds) || !read_results(new_file, news)) {
+		return -1;
+	}
+
+	int regressions = 0;
+	for (unsigned i = 0; i<news.size(); ++i) {
+		const Result &n = news[i];
+		unsigned j = 0;
+		while (j<olds.size() &&
+		       (olds[j].op!=n.op || olds[j].digits!=n.digits)) {
+			++j;
+		}
+		if (j==olds.size() || olds[j].ns<=0) continue;
+
+		const double change = (n.ns / olds[j].ns - 1) * 100;
+		const char *const mark = change>percent ? "  REGRESSION"
+			: change< -percent ? "  faster" : "";
+		char buf[160];
+		sprintf(buf, "%-6s %8lu digits %14.1f ns %14.1f ns %+7.1f%%%s\n",
+		        n.op.c_str(), n.digits, olds[j].ns, n.ns, change, mark);
+		std::cout << buf;
+		if (change>percent) ++regressions;
+	}
+	std::cout << regressions << " regression(s)\n";
+	return regressions;
+}
+
+
+
+/******************** Main ********************/
+int main(int argc, char **argv) {
+	if (argc>1 && !strcmp(argv[1], "compare")) {
+		if (argc<4) {
+			std::cerr << "usage: " << argv[0]
+			          << " compare <old> <new> [ <percent> ]\n";
+			return 2;
+		}
+		const double percent = argc>4 ? strtod(argv[4], 0) : 10;
+		const int r = compare(argv[2], argv[3], percent);
+		return r<0 ? 2 : r ? 1 : 0;
+	}
+
+	unsigned long max = argc>1 ? strtoul(argv[1], 0, 0) : 1000000;
+	if (!max) max = 1000000;
+	const unsigned long seed = argc>2 ? strtoul(argv[2], 0, 0) : 1;
+	bench(max, seed);
+	return 0;
+}
@@ -0,0 +1,134 @@
+/**
+ * \file
+ * BigInt Accumulator.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * Carry-save summation of many numbers.  See BigIntAccumulator.
+ */
+
+#include "bigint-acc.hpp"
+#include "bigint-limb.hpp"
+
+
+namespace mina86 {
+
+
+/******************** Adding ********************/
+void BigIntAccumulator::add(const BigInt &n, int s) {
+	if (n.sign) add_limbs(n.limbs_ptr(), n.limbs_count(), s * n.sign);
+}
+
+
+void BigIntAccumulator::add(uint64_t value, int s) {
+	const Limb a[2] = {
+		(Limb)value, (Limb)((DLimb)value >> BigInt::LIMB_BITS)
+	};
+	if (value) add_limbs(a, a[1] ? 2 : 1, s);
+}
+
+
+void BigIntAccumulator::add_limbs(const Limb *a, unsigned n, int s) {
+	if (count==MAX_COUNT) fold();
+	++count;
+
+	Array<DLimb> &l = lanes[s<0];
+	const unsigned size = l.size();
+	if (size<n) {
+		const unsigned cap = l.getCapacity();
+		l.resize(n, n<=cap ? cap : n + cap);
+		DLimb *const d = l.rw_begin();
+		for (unsigned i = size; i<n; ++i) d[i] = 0;
+	}
+
+	DLimb *const d = l.rw_begin();
+	for (unsigned i = 0; i<n; ++i) d[i] += a[i];
+}
+
+
+void BigIntAccumulator::fold() {
+	for (unsigned k = 0; k<2; ++k) {
+		if (!lanes[k]) continue;
+		DLimb *const d = lanes[k].rw_begin(), c = 0;
+		const unsigned n = lanes[k].size();
+		for (unsigned i = 0; i<n; ++i) {
+			c += d[i];
+			d[i] = (Limb)c;
+			c >>= BigInt::LIMB_BITS;
+		}
+		for (; c; c >>= BigInt::LIMB_BITS) lanes[k].push((Limb)c);
+	}
+	count = 0;
+}
+
+
+void BigIntAccumulator::clear() {
+	for (unsigned k = 0; k<2; ++k) {
+		if (!lanes[k]) continue;
+		DLimb *const d = lanes[k].rw_begin();
+		for (unsigned i = lanes[k].size(); i; ) d[--i] = 0;
+	}
+	count = 0;
+}
+
+
+
+/******************** Reading ********************/
+/**
+ * Propagates carries between lanes storing the result in a limb
+ * vector.
+ *
+ * \param[out] r result, must have room for \a n plus two limbs
+ * \param[in] d lanes
+ * \param[in] n number of lanes
+ * \return number of limbs with most significant zero limbs stripped
+ */
+static unsigned lanes_to_limbs(Limb *r, const DLimb *d, unsigned n) {
+	DLimb c = 0;
+	unsigned rn = 0;
+	for (; rn<n; ++rn) {
+		c += d[rn];
+		r[rn] = (Limb)c;
+		c >>= BigInt::LIMB_BITS;
+	}
+	for (; c; c >>= BigInt::LIMB_BITS) r[rn++] = (Limb)c;
+	while (rn && !r[rn - 1]) --rn;
+	return rn;
+}
+
+
+BigInt BigIntAccumulator::get() const {
+	const unsigned pn = lanes[0].size(), qn = lanes[1].size();
+	Limb *const p = limbs_alloc(pn + 2), *q = limbs_alloc(qn + 2);
+	unsigned rn = lanes_to_limbs(p, lanes[0].begin(), pn);
+	const unsigned n = lanes_to_limbs(q, lanes[1].begin(), qn);
+
+	/* |p - q| */
+	int s = 1;
+	Limb *r = p;
+	if (rn<n || (rn==n && limbs_cmp(p, q, n)<0)) {
+		limbs_sub(q, q, n, p, rn);
+		r = q;
+		q = p;
+		rn = n;
+		s = -1;
+	} else if (n) {
+		limbs_sub(p, p, rn, q, n);
+	}
+	limbs_free(q, q==p ? pn + 2 : qn + 2);
+	while (rn && !r[rn - 1]) --rn;
+
+	BigInt result;
+	if (rn) {
+		result.sign = s;
+		result.limbs.set_no_copy(r, rn, r==p ? pn + 2 : qn + 2);
+		result.normalize();
+	} else {
+		limbs_free(r, r==p ? pn + 2 : qn + 2);
+	}
+	return result;
+}
+
+
+}
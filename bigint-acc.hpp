@@ -0,0 +1,174 @@
+/**
+ * \file
+ * BigInt Accumulator Header File.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ */
+
+#ifndef MN_BIGINT_ACC_HPP
+#define MN_BIGINT_ACC_HPP
+
+#include "bigint.hpp"
+#include "array.hpp"
+
+
+namespace mina86 {
+
+
+/**
+ * Accumulator summing many numbers.  The sum is kept in a redundant
+ * carry-save form: each limb of an added number is added to its own
+ * lane which is twice as wide as a limb and carries between lanes
+ * are propagated only when the value is read (or once every
+ * 2<sup>32</sup>-1 additions so that lanes never overflow).  Adding
+ * a number is therefore a single pass over its limbs with no carry
+ * chain and lanes grow geometrically so memory is rarely allocated.
+ * Positive and negative numbers are summed in separate lanes.
+ *
+ * \sa BigInt::add()
+ */
+class BigIntAccumulator {
+public:
+	/** Type of a single limb. */
+	typedef BigInt::Limb Limb;
+	/** Type of a single lane. */
+	typedef BigInt::DLimb DLimb;
+
+
+	/**
+	 * Creates accumulator which value is zero.
+	 */
+	BigIntAccumulator() : count(0) { }
+
+	/**
+	 * Creates accumulator with initial value.
+	 *
+	 * \param[in] n initial value
+	 */
+	explicit BigIntAccumulator(const BigInt &n) : count(0) { add(n, 1); }
+
+
+	/**
+	 * Adds number to the accumulator.
+	 *
+	 * \param[in] n number to add
+	 * \return reference to this object
+	 */
+	BigIntAccumulator &operator+=(const BigInt &n) {
+		add(n, 1);
+		return *this;
+	}
+
+	/**
+	 * Substracts number from the accumulator.
+	 *
+	 * \param[in] n number to substract
+	 * \return reference to this object
+	 */
+	BigIntAccumulator &operator-=(const BigInt &n) {
+		add(n, -1);
+		return *this;
+	}
+
+	/**
+	 * Adds a machine integer to the accumulator without converting
+	 * it to BigInt first.
+	 *
+	 * \param[in] n number to add
+	 * \return reference to this object
+	 * \sa BigIntWord
+	 */
+	template<class T>
+	typename std::enable_if<BigIntWord<T>::value, BigIntAccumulator &>::type
+	operator+=(T n) {
+		add(BigIntWord<T>::abs(n), BigIntWord<T>::sign(n));
+		return *this;
+	}
+
+	/**
+	 * Substracts a machine integer from the accumulator.
+	 *
+	 * \param[in] n number to substract
+	 * \return reference to this object
+	 * \sa operator+=(T)
+	 */
+	template<class T>
+	typename std::enable_if<BigIntWord<T>::value, BigIntAccumulator &>::type
+	operator-=(T n) {
+		add(BigIntWord<T>::abs(n), -BigIntWord<T>::sign(n));
+		return *this;
+	}
+
+
+	/**
+	 * Returns value of the accumulator.  Carries are propagated and
+	 * negative lanes are substracted from positive ones only now.
+	 *
+	 * \return sum of all added numbers
+	 */
+	BigInt get() const;
+
+	/**
+	 * Sets value of the accumulator to zero.  Lanes are kept so
+	 * following additions do not need to allocate memory.
+	 */
+	void clear();
+
+
+private:
+	/**
+	 * Number of additions after which carries are propagated.  Each
+	 * addition adds less than 2<sup>32</sup> to a lane and a lane is
+	 * less than 2<sup>32</sup> after carries are propagated so lanes
+	 * cannot overflow before that many additions.
+	 */
+	static const unsigned MAX_COUNT = 0xffffffffu;
+
+	/**
+	 * Lanes of the sum of positive (first array) and negative (second
+	 * array) numbers.  The first lane is the least significant.
+	 */
+	Array<DLimb> lanes[2];
+
+	/** Number of additions since carries were last propagated. */
+	unsigned count;
+
+
+	/**
+	 * Adds a number to the lanes.
+	 *
+	 * \param[in] n number to add
+	 * \param[in] s \c 1 to add \a n, \c -1 to substract it
+	 */
+	void add(const BigInt &n, int s);
+
+	/**
+	 * Adds a machine integer to the lanes.
+	 *
+	 * \param[in] value absolute value of number to add
+	 * \param[in] s \c 1 to add \a value, \c -1 to substract it, \c 0
+	 *              if \a value is zero
+	 */
+	void add(uint64_t value, int s);
+
+	/**
+	 * Adds limb vector to the lanes.
+	 *
+	 * \param[in] a limb vector
+	 * \param[in] n number of limbs
+	 * \param[in] s \c 1 to add \a a, \c -1 to substract it
+	 */
+	void add_limbs(const Limb *a, unsigned n, int s);
+
+	/**
+	 * Propagates carries between lanes adding lanes if needed.
+	 * After that all lanes fit in a limb.
+	 */
+	void fold();
+};
+
+
+}
+
+#endif
@@ -0,0 +1,516 @@
+/**
+ * \file
+ * BigInt Batch.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * Operations on many pairs of small numbers stored as structure of
+ * arrays.  Numbers are kept as sign and absolute value so
+ * multiplication is a plain product of absolute values.  Addition and
+ * substraction compute both the sum and the difference of absolute
+ * values and pick one of them (negating the difference if it
+ * underflowed) with masks instead of branches so that each lane of
+ * a vector may take a different path.  Limb \c j of all pairs is
+ * a contiguous row so vector kernels load limbs of #BigIntBatch::LANES
+ * pairs with a single instruction and carries between limbs travel
+ * down the rows, one per lane.
+ */
+
+#include "bigint-batch.hpp"
+#include "bigint-limb.hpp"
+
+#if defined __GNUC__ && (defined __x86_64__ || defined __i386__)
+#  define MN_BIGINT_X86 1
+#  include <immintrin.h>
+#endif
+
+
+namespace mina86 {
+
+
+/**
+ * Digits used when converting results to strings.
+ */
+static const char DIGITS[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+
+/**
+ * Pointers to rows of a batch passed to kernels.
+ */
+struct BatchRows {
+	/** Limbs of first operands. */
+	const Limb *a[BigIntBatch::LIMBS];
+	/** Limbs of second operands. */
+	const Limb *b[BigIntBatch::LIMBS];
+	/** Signs of first operands. */
+	const Limb *aneg;
+	/** Signs of second operands. */
+	const Limb *bneg;
+	/** Limbs of results. */
+	Limb *r[BigIntBatch::RESULT_LIMBS];
+	/** Signs of results. */
+	Limb *rneg;
+	/** Error flags. */
+	Limb *error;
+};
+
+
+
+/******************** Scalar ********************/
+/**
+ * Adds or substracts pairs one at a time without branches.
+ *
+ * \param[in] l rows
+ * \param[in] n number of pairs
+ * \param[in] flip zero to add, all bits set to substract
+ */
+static void addsub_scalar(const BatchRows &l, unsigned n, Limb flip) {
+	const unsigned L = BigIntBatch::LIMBS;
+	for (unsigned i = 0; i<n; ++i) {
+		const Limb an = l.aneg[i], bn = l.bneg[i] ^ flip;
+		const Limb same = ~(an ^ bn);
+
+		/* Sum and difference of absolute values */
+		Limb d[BigIntBatch::LIMBS], w = 0;
+		DLimb s = 0;
+		for (unsigned j = 0; j<L; ++j) {
+			const Limb x = l.a[j][i], y = l.b[j][i];
+			s += (DLimb)x + y;
+			l.r[j][i] = (Limb)s;
+			s >>= BigInt::LIMB_BITS;
+			d[j] = x - y - w;
+			w = (x < y) | ((x == y) & w);
+		}
+
+		/* Pick sum or (negated if it underflowed) difference */
+		const Limb neg = ~same & (0 - w);
+		Limb c = neg & 1;
+		for (unsigned j = 0; j<L; ++j) {
+			const Limb t = (d[j] ^ neg) + c;
+			c &= t == 0;
+			l.r[j][i] = (same & l.r[j][i]) | (~same & t);
+		}
+		l.r[L][i] = same & (Limb)s;
+		for (unsigned j = L + 1; j<BigIntBatch::RESULT_LIMBS; ++j) {
+			l.r[j][i] = 0;
+		}
+		l.rneg[i] = (an & ~neg) | (bn & neg);
+		l.error[i] = 0;
+	}
+}
+
+
+/**
+ * Multiplies pairs one at a time.
+ *
+ * \param[in] l rows
+ * \param[in] n number of pairs
+ */
+static void mul_scalar(const BatchRows &l, unsigned n) {
+	const unsigned L = BigIntBatch::LIMBS;
+	for (unsigned i = 0; i<n; ++i) {
+		Limb t[BigIntBatch::RESULT_LIMBS] = { 0 };
+		for (unsigned p = 0; p<L; ++p) {
+			const Limb x = l.a[p][i];
+			DLimb c = 0;
+			for (unsigned q = 0; q<L; ++q) {
+				c += (DLimb)x * l.b[q][i] + t[p + q];
+				t[p + q] = (Limb)c;
+				c >>= BigInt::LIMB_BITS;
+			}
+			t[p + L] = (Limb)c;
+		}
+		for (unsigned j = 0; j<BigIntBatch::RESULT_LIMBS; ++j) {
+			l.r[j][i] = t[j];
+		}
+		l.rneg[i] = l.aneg[i] ^ l.bneg[i];
+		l.error[i] = 0;
+	}
+}
+
+
+/**
+ * Divides pairs one at a time.
+ *
+ * \param[in] l rows
+ * \param[in] n number of pairs
+ * \param[in] mod \c true to compute remainders instead of quotients
+ */
+static void divmod(const BatchRows &l, unsigned n, bool mod) {
+	const unsigned L = BigIntBatch::LIMBS;
+	for (unsigned i = 0; i<n; ++i) {
+		Limb a[BigIntBatch::LIMBS], b[BigIntBatch::LIMBS];
+		Limb q[BigIntBatch::LIMBS] = { 0 }, r[BigIntBatch::LIMBS] = { 0 };
+		unsigned an = 0, bn = 0;
+		for (unsigned j = 0; j<L; ++j) {
+			a[j] = l.a[j][i];
+			b[j] = l.b[j][i];
+			if (a[j]) an = j + 1;
+			if (b[j]) bn = j + 1;
+		}
+
+		l.error[i] = !bn;
+		if (!bn) {
+			/* Division by zero, reported by the caller */
+		} else if (an<bn) {
+			for (unsigned j = 0; j<an; ++j) r[j] = a[j];
+		} else if (bn==1) {
+			r[0] = limbs_divmod_1(q, a, an, b[0]);
+		} else {
+			limbs_div_qr(q, r, a, an, b, bn);
+		}
+
+		const Limb *const v = mod ? r : q;
+		for (unsigned j = 0; j<L; ++j) l.r[j][i] = v[j];
+		for (unsigned j = L; j<BigIntBatch::RESULT_LIMBS; ++j) {
+			l.r[j][i] = 0;
+		}
+		l.rneg[i] = mod ? l.aneg[i] : l.aneg[i] ^ l.bneg[i];
+	}
+}
+
+
+
+#ifdef MN_BIGINT_X86
+
+/******************** AVX2 ********************/
+/**
+ * Adds or substracts pairs, #BigIntBatch::LANES at a time.  Works
+ * the same way as addsub_scalar() with comparisons of sign-flipped
+ * limbs in place of unsigned comparisons.
+ *
+ * \param[in] l rows
+ * \param[in] n number of pairs, rounded up to a multiple of
+ *              #BigIntBatch::LANES
+ * \param[in] flip zero to add, all bits set to substract
+ */
+__attribute__((target("avx2")))
+static void addsub_avx2(const BatchRows &l, unsigned n, Limb flip) {
+	const unsigned L = BigIntBatch::LIMBS;
+	const __m256i bias = _mm256_set1_epi32(0x80000000);
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i ones = _mm256_set1_epi32(-1);
+	const __m256i one = _mm256_set1_epi32(1);
+	const __m256i fl = _mm256_set1_epi32(flip);
+
+	for (unsigned i = 0; i<n; i += 8) {
+		const __m256i an = _mm256_loadu_si256((const __m256i *)(l.aneg + i));
+		const __m256i bn = _mm256_xor_si256(
+			_mm256_loadu_si256((const __m256i *)(l.bneg + i)), fl);
+		const __m256i same = _mm256_xor_si256(_mm256_xor_si256(an, bn), ones);
+
+		/* Sum and difference of absolute values; carries and borrows
+		   are masks */
+		__m256i s[BigIntBatch::LIMBS], d[BigIntBatch::LIMBS];
+		__m256i c = zero, w = zero;
+		for (unsigned j = 0; j<L; ++j) {
+			const __m256i x = _mm256_loadu_si256((const __m256i *)(l.a[j] + i));
+			const __m256i y = _mm256_loadu_si256((const __m256i *)(l.b[j] + i));
+			const __m256i xb = _mm256_xor_si256(x, bias);
+			const __m256i yb = _mm256_xor_si256(y, bias);
+
+			const __m256i t = _mm256_add_epi32(x, y);
+			s[j] = _mm256_sub_epi32(t, c);
+			c = _mm256_or_si256(
+				_mm256_cmpgt_epi32(xb, _mm256_xor_si256(t, bias)),
+				_mm256_and_si256(c, _mm256_cmpeq_epi32(s[j], zero)));
+
+			const __m256i u = _mm256_sub_epi32(x, y);
+			d[j] = _mm256_add_epi32(u, w);
+			w = _mm256_or_si256(
+				_mm256_cmpgt_epi32(yb, xb),
+				_mm256_and_si256(w, _mm256_cmpeq_epi32(u, zero)));
+		}
+
+		/* Pick sum or (negated if it underflowed) difference */
+		const __m256i neg = _mm256_andnot_si256(same, w);
+		__m256i k = neg;
+		for (unsigned j = 0; j<L; ++j) {
+			const __m256i t = _mm256_sub_epi32(_mm256_xor_si256(d[j], neg), k);
+			k = _mm256_and_si256(k, _mm256_cmpeq_epi32(t, zero));
+			_mm256_storeu_si256((__m256i *)(l.r[j] + i),
+			                    _mm256_blendv_epi8(t, s[j], same));
+		}
+		_mm256_storeu_si256((__m256i *)(l.r[L] + i),
+		                    _mm256_and_si256(_mm256_and_si256(c, same), one));
+		for (unsigned j = L + 1; j<BigIntBatch::RESULT_LIMBS; ++j) {
+			_mm256_storeu_si256((__m256i *)(l.r[j] + i), zero);
+		}
+		_mm256_storeu_si256((__m256i *)(l.rneg + i),
+		                    _mm256_blendv_epi8(an, bn, neg));
+		_mm256_storeu_si256((__m256i *)(l.error + i), zero);
+	}
+}
+
+
+/**
+ * Multiplies pairs, #BigIntBatch::LANES at a time.  Limbs are
+ * widened to 64 bits so four products are computed by a single
+ * instruction.  Low and high halves of products are summed in
+ * separate columns which cannot overflow and carries between columns
+ * are propagated at the end.
+ *
+ * \param[in] l rows
+ * \param[in] n number of pairs, rounded up to a multiple of
+ *              #BigIntBatch::LANES
+ */
+__attribute__((target("avx2")))
+static void mul_avx2(const BatchRows &l, unsigned n) {
+	const unsigned L = BigIntBatch::LIMBS, R = BigIntBatch::RESULT_LIMBS;
+	const __m256i low = _mm256_set1_epi64x(0xffffffff);
+	const __m256i pack = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+
+	for (unsigned i = 0; i<n; i += 4) {
+		__m256i a[BigIntBatch::LIMBS], b[BigIntBatch::LIMBS];
+		for (unsigned j = 0; j<L; ++j) {
+			a[j] = _mm256_cvtepu32_epi64(
+				_mm_loadu_si128((const __m128i *)(l.a[j] + i)));
+			b[j] = _mm256_cvtepu32_epi64(
+				_mm_loadu_si128((const __m128i *)(l.b[j] + i)));
+		}
+
+		__m256i col[BigIntBatch::RESULT_LIMBS + 1];
+		for (unsigned j = 0; j<=R; ++j) col[j] = _mm256_setzero_si256();
+		for (unsigned p = 0; p<L; ++p) {
+			for (unsigned q = 0; q<L; ++q) {
+				const __m256i t = _mm256_mul_epu32(a[p], b[q]);
+				col[p + q] = _mm256_add_epi64(col[p + q],
+				                              _mm256_and_si256(t, low));
+				col[p + q + 1] = _mm256_add_epi64(col[p + q + 1],
+				                                  _mm256_srli_epi64(t, 32));
+			}
+		}
+
+		__m256i c = _mm256_setzero_si256();
+		for (unsigned j = 0; j<R; ++j) {
+			c = _mm256_add_epi64(col[j], c);
+			const __m256i r = _mm256_permutevar8x32_epi32(c, pack);
+			_mm_storeu_si128((__m128i *)(l.r[j] + i),
+			                 _mm256_castsi256_si128(r));
+			c = _mm256_srli_epi64(c, 32);
+		}
+	}
+
+	for (unsigned i = 0; i<n; i += 8) {
+		const __m256i an = _mm256_loadu_si256((const __m256i *)(l.aneg + i));
+		const __m256i bn = _mm256_loadu_si256((const __m256i *)(l.bneg + i));
+		_mm256_storeu_si256((__m256i *)(l.rneg + i),
+		                    _mm256_xor_si256(an, bn));
+		_mm256_storeu_si256((__m256i *)(l.error + i),
+		                    _mm256_setzero_si256());
+	}
+}
+
+#endif
+
+
+
+/******************** Batch ********************/
+BigIntBatch::BigIntBatch(unsigned capacity) : count(0) {
+	lanes = (capacity + LANES - 1) / LANES * LANES;
+	if (!lanes) lanes = LANES;
+	in.resize(IN_ROWS * lanes);
+	out.resize(OUT_ROWS * lanes);
+	Limb *const i = in.rw_begin(), *const o = out.rw_begin();
+	for (unsigned j = 0; j<IN_ROWS * lanes; ++j) i[j] = 0;
+	for (unsigned j = 0; j<OUT_ROWS * lanes; ++j) o[j] = 0;
+}
+
+
+bool BigIntBatch::push(const BigInt &a, const BigInt &b) {
+	const unsigned an = a.limbs_count(), bn = b.limbs_count();
+	if (an>LIMBS || bn>LIMBS) {
+		return false;
+	}
+
+	Limb *const r = in.rw_begin() + count;
+	const Limb *const ap = a.limbs_ptr(), *const bp = b.limbs_ptr();
+	for (unsigned j = 0; j<LIMBS; ++j) {
+		r[(ROW_A + j) * lanes] = j<an ? ap[j] : 0;
+		r[(ROW_B + j) * lanes] = j<bn ? bp[j] : 0;
+	}
+	r[ROW_A_NEG * lanes] = a.sign<0 ? ~(Limb)0 : 0;
+	r[ROW_B_NEG * lanes] = b.sign<0 ? ~(Limb)0 : 0;
+	++count;
+	return true;
+}
+
+
+/**
+ * Parses plain decimal number.
+ *
+ * \param[in] str number with optional sign
+ * \param[out] v absolute value (#BigIntBatch::LIMBS limbs)
+ * \param[out] neg sign, zero or all bits set
+ * \return \c false if \a str is not a plain decimal number or does
+ *         not fit
+ */
+static bool parse_decimal(const char *str, Limb *v, Limb &neg) {
+	neg = *str=='-' ? ~(Limb)0 : 0;
+	if (*str=='-' || *str=='+') ++str;
+
+	/* 2^128 has 39 digits */
+	unsigned len = 0;
+	while (str[len]>='0' && str[len]<='9') ++len;
+	if (!len || str[len] || len>39) {
+		return false;
+	}
+
+	for (unsigned j = 0; j<BigIntBatch::LIMBS; ++j) v[j] = 0;
+	for (unsigned chunk = (len - 1) % 9 + 1; len; chunk = 9) {
+		Limb d = 0, m = 1;
+		for (unsigned k = 0; k<chunk; ++k) {
+			d = d * 10 + (*str++ - '0');
+			m *= 10;
+		}
+		len -= chunk;
+
+		DLimb c = d;
+		for (unsigned j = 0; j<BigIntBatch::LIMBS; ++j) {
+			c += (DLimb)v[j] * m;
+			v[j] = (Limb)c;
+			c >>= BigInt::LIMB_BITS;
+		}
+		if (c) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool BigIntBatch::push(const char *a, const char *b) {
+	Limb av[LIMBS], bv[LIMBS], an, bn;
+	if (!parse_decimal(a, av, an) || !parse_decimal(b, bv, bn)) {
+		return false;
+	}
+
+	Limb *const r = in.rw_begin() + count;
+	for (unsigned j = 0; j<LIMBS; ++j) {
+		r[(ROW_A + j) * lanes] = av[j];
+		r[(ROW_B + j) * lanes] = bv[j];
+	}
+	r[ROW_A_NEG * lanes] = an;
+	r[ROW_B_NEG * lanes] = bn;
+	++count;
+	return true;
+}
+
+
+void BigIntBatch::run(Op op) {
+	const Limb *const i = in.begin();
+	Limb *const o = out.rw_begin();
+	BatchRows l;
+	for (unsigned j = 0; j<LIMBS; ++j) {
+		l.a[j] = i + (ROW_A + j) * lanes;
+		l.b[j] = i + (ROW_B + j) * lanes;
+	}
+	l.aneg = i + ROW_A_NEG * lanes;
+	l.bneg = i + ROW_B_NEG * lanes;
+	for (unsigned j = 0; j<RESULT_LIMBS; ++j) l.r[j] = o + j * lanes;
+	l.rneg = o + ROW_NEG * lanes;
+	l.error = o + ROW_ERROR * lanes;
+
+#ifdef MN_BIGINT_X86
+	if (limbs_simd_current()>=LIMBS_AVX2) {
+		const unsigned n = (count + LANES - 1) / LANES * LANES;
+		switch (op) {
+		case ADD: addsub_avx2(l, n, 0);         return;
+		case SUB: addsub_avx2(l, n, ~(Limb)0);  return;
+		case MUL: mul_avx2(l, n);               return;
+		default: break;
+		}
+	}
+#endif
+
+	switch (op) {
+	case ADD: addsub_scalar(l, count, 0);        break;
+	case SUB: addsub_scalar(l, count, ~(Limb)0); break;
+	case MUL: mul_scalar(l, count);              break;
+	case DIV: divmod(l, count, false);           break;
+	case MOD: divmod(l, count, true);            break;
+	}
+}
+
+
+void BigIntBatch::run(Op op, const BigInt *a, const BigInt *b, BigInt *r,
+                      unsigned n) {
+	BigIntBatch batch(n<1024 ? n : 1024);
+	Array<unsigned> index(batch.capacity());
+	for (unsigned i = 0; i<n; ) {
+		batch.clear();
+		index.clear();
+		for (; i<n && batch.size()<batch.capacity(); ++i) {
+			if (batch.push(a[i], b[i])) {
+				index.push(i);
+				continue;
+			}
+			switch (op) {
+			case ADD: r[i] = a[i] + b[i]; break;
+			case SUB: r[i] = a[i] - b[i]; break;
+			case MUL: r[i] = a[i] * b[i]; break;
+			case DIV: r[i] = a[i] / b[i]; break;
+			case MOD: r[i] = a[i] % b[i]; break;
+			}
+		}
+
+		batch.run(op);
+		for (unsigned k = 0; k<batch.size(); ++k) {
+			r[index[k]] = batch.result(k);
+		}
+	}
+}
+
+
+BigInt BigIntBatch::result(unsigned i) const {
+	if (failed(i)) {
+		throw BigInt::DivisionByZero();
+	}
+
+	const Limb *const o = out.begin() + i;
+	unsigned n = RESULT_LIMBS;
+	while (n && !o[(n - 1) * lanes]) --n;
+
+	BigInt r;
+	const int s = o[ROW_NEG * lanes] ? -1 : 1;
+	if (n<=2) {
+		r.set_small(s, n ? o[0] | (n>1 ? (DLimb)o[lanes] << 32 : 0) : 0);
+	} else {
+		Limb *const vec = limbs_alloc(n);
+		for (unsigned j = 0; j<n; ++j) vec[j] = o[j * lanes];
+		r.sign = s;
+		r.limbs.set_no_copy(vec, n, n);
+	}
+	return r;
+}
+
+
+std::string BigIntBatch::toString(unsigned i, unsigned base) const {
+	if (base<2 || base>36) {
+		throw BigInt::BadRadix();
+	} else if (failed(i)) {
+		throw BigInt::DivisionByZero();
+	}
+
+	const Limb *const o = out.begin() + i;
+	Limb v[RESULT_LIMBS];
+	unsigned n = 0;
+	for (unsigned j = 0; j<RESULT_LIMBS; ++j) {
+		v[j] = o[j * lanes];
+		if (v[j]) n = j + 1;
+	}
+	if (!n) {
+		return "0";
+	}
+
+	char buf[RESULT_LIMBS * BigInt::LIMB_BITS + 1];
+	char *const end = buf + sizeof buf;
+	char *begin = limbs_get_str_basecase(end, v, n, base);
+	for (char *ch = begin; ch!=end; ++ch) *ch = DIGITS[(int)*ch];
+	if (o[ROW_NEG * lanes]) *--begin = '-';
+	return std::string(begin, end);
+}
+
+
+}
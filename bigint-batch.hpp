@@ -0,0 +1,206 @@
+/**
+ * \file
+ * BigInt Batch Header File.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ */
+
+#ifndef MN_BIGINT_BATCH_HPP
+#define MN_BIGINT_BATCH_HPP
+
+#include <string>
+
+#include "bigint.hpp"
+#include "array.hpp"
+
+
+namespace mina86 {
+
+
+/**
+ * Batch of independent operations on small numbers.  Pairs of
+ * operands whose absolute values fit in #LIMBS limbs are stored as
+ * structure of arrays: the first limbs of all operands are next to
+ * each other, then the second limbs and so on, with signs stored the
+ * same way.  A single operation is then run on all pairs at once:
+ * addition, substraction and multiplication process several pairs
+ * per instruction using AVX2 when the processor supports it (and
+ * a branch-free loop otherwise), while division handles pairs one by
+ * one with no memory allocation.  No BigInt objects are created
+ * unless results are asked for as BigInt, so the cost per operation
+ * is a fraction of the cost of using BigInt.
+ *
+ * \code
+ * BigIntBatch batch;
+ * while (batch.size()<batch.capacity() && read(a, b)) {
+ *     if (!batch.push(a, b)) std::cout << a * b << '\n';
+ * }
+ * batch.run(BigIntBatch::MUL);
+ * for (unsigned i = 0; i<batch.size(); ++i) {
+ *     std::cout << batch.toString(i) << '\n';
+ * }
+ * \endcode
+ */
+class BigIntBatch {
+public:
+	/** Type of a single limb. */
+	typedef BigInt::Limb Limb;
+
+	/** Operations. */
+	enum Op {
+		ADD,   /**< Addition. */
+		SUB,   /**< Substraction. */
+		MUL,   /**< Multiplication. */
+		DIV,   /**< Division rounded towards zero. */
+		MOD    /**< Remainder of division, with sign of the dividend. */
+	};
+
+	/** Maximal number of limbs in absolute value of an operand. */
+	static const unsigned LIMBS = 4;
+
+	/** Number of limbs in absolute value of a result. */
+	static const unsigned RESULT_LIMBS = 2 * LIMBS;
+
+	/** Number of pairs capacity is rounded to. */
+	static const unsigned LANES = 8;
+
+
+	/**
+	 * Creates empty batch.
+	 *
+	 * \param[in] capacity maximal number of pairs, rounded up to
+	 *                     a multiple of #LANES
+	 */
+	explicit BigIntBatch(unsigned capacity = 1024);
+
+
+	/**
+	 * Returns number of pairs in the batch.
+	 *
+	 * \return number of pairs
+	 */
+	unsigned size() const { return count; }
+
+	/**
+	 * Returns maximal number of pairs in the batch.
+	 *
+	 * \return capacity
+	 */
+	unsigned capacity() const { return lanes; }
+
+	/**
+	 * Removes all pairs from the batch.
+	 */
+	void clear() { count = 0; }
+
+
+	/**
+	 * Adds pair of operands to the batch.  Batch must not be full.
+	 *
+	 * \param[in] a first operand
+	 * \param[in] b second operand
+	 * \return \c false if operands are too big in which case nothing
+	 *         is added
+	 */
+	bool push(const BigInt &a, const BigInt &b);
+
+	/**
+	 * Adds pair of operands given as decimal numbers to the batch.
+	 * Numbers may have a sign but nothing else (no white space, no
+	 * prefix, no trailing characters).  Batch must not be full.
+	 *
+	 * \param[in] a first operand
+	 * \param[in] b second operand
+	 * \return \c false if operands are not plain decimal numbers or
+	 *         are too big in which case nothing is added
+	 */
+	bool push(const char *a, const char *b);
+
+
+	/**
+	 * Runs an operation on all pairs.  Results replace results of
+	 * any previous run.
+	 *
+	 * \param[in] op operation
+	 */
+	void run(Op op);
+
+	/**
+	 * Runs an operation on many pairs of numbers.  Pairs which do
+	 * not fit in a batch are computed with BigInt operators.  If
+	 * division by zero occurs DivisionByZero is thrown.
+	 *
+	 * \param[in] op operation
+	 * \param[in] a first operands
+	 * \param[in] b second operands
+	 * \param[out] r results, may be the same as \a a or \a b
+	 * \param[in] n number of pairs
+	 */
+	static void run(Op op, const BigInt *a, const BigInt *b, BigInt *r,
+	                unsigned n);
+
+
+	/**
+	 * Checks whether operation on given pair failed, ie. it was
+	 * a division by zero.
+	 *
+	 * \param[in] i index of the pair
+	 * \return \c true if operation failed
+	 */
+	bool failed(unsigned i) const { return out[ROW_ERROR * lanes + i]; }
+
+	/**
+	 * Returns result of operation on given pair.  If operation failed
+	 * DivisionByZero is thrown.
+	 *
+	 * \param[in] i index of the pair
+	 * \return result
+	 */
+	BigInt result(unsigned i) const;
+
+	/**
+	 * Returns string representation of result of operation on given
+	 * pair.  If operation failed DivisionByZero is thrown.
+	 *
+	 * \param[in] i index of the pair
+	 * \param[in] base base, from 2 to 36
+	 * \return result in given base
+	 */
+	std::string toString(unsigned i, unsigned base = 10) const;
+
+
+private:
+	/** Rows of #in: limbs of first operands. */
+	static const unsigned ROW_A = 0;
+	/** Rows of #in: limbs of second operands. */
+	static const unsigned ROW_B = LIMBS;
+	/** Row of #in: signs of first operands (zero or all bits set). */
+	static const unsigned ROW_A_NEG = 2 * LIMBS;
+	/** Row of #in: signs of second operands. */
+	static const unsigned ROW_B_NEG = 2 * LIMBS + 1;
+	/** Number of rows of #in. */
+	static const unsigned IN_ROWS = 2 * LIMBS + 2;
+
+	/** Row of #out: signs of results (zero or all bits set). */
+	static const unsigned ROW_NEG = RESULT_LIMBS;
+	/** Row of #out: non-zero if operation failed. */
+	static const unsigned ROW_ERROR = RESULT_LIMBS + 1;
+	/** Number of rows of #out. */
+	static const unsigned OUT_ROWS = RESULT_LIMBS + 2;
+
+	/** Number of pairs in the batch. */
+	unsigned count;
+	/** Capacity; length of each row. */
+	unsigned lanes;
+	/** Operands; row \c j holds \c j-th limbs of all pairs. */
+	Array<Limb> in;
+	/** Results, laid out the same way as #in. */
+	Array<Limb> out;
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,282 @@
+/**
+ * \file
+ * BigInt Combinatorial Functions.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * Factorials, binomial coefficients, Fibonacci and Lucas numbers.
+ * Multiplying factors one by one multiplies a huge number by a tiny
+ * one over and over again which costs quadratic time whatever
+ * multiplication algorithm is used.  Instead, factors are packed
+ * into machine words and the words are multiplied in a balanced
+ * tree so both operands of each multiplication have similar size
+ * and big products go through Toom-Cook or NTT.
+ */
+
+#include <utility>
+#include <vector>
+
+#include "bigint-limb.hpp"
+
+
+namespace mina86 {
+
+
+/**
+ * If \a k is at least <code>n / BINOMIAL_RATIO</code> binomial()
+ * uses prime factorization, otherwise it divides product of the
+ * numerator's factors by <code>k!</code>.
+ */
+static const unsigned long BINOMIAL_RATIO = 16;
+
+
+
+/******************** Product trees ********************/
+/**
+ * Packs factors into machine words.  Consecutive factors are
+ * multiplied together as long as their product fits in 64 bits.
+ *
+ * \param[out] words packed products are appended here
+ * \param[in] factor factor to append
+ * \param[in,out] cur product of factors not yet appended to \a words
+ */
+static inline void pack(std::vector<uint64_t> &words, uint64_t factor,
+                        uint64_t &cur) {
+	if (cur>~(uint64_t)0 / factor) {
+		words.push_back(cur);
+		cur = factor;
+	} else {
+		cur *= factor;
+	}
+}
+
+
+/**
+ * Multiplies machine words using a balanced product tree.
+ *
+ * \param[in] v words to multiply
+ * \param[in] n number of words
+ * \return product of the words, one if \a n is zero
+ */
+static BigInt product(const uint64_t *v, unsigned n) {
+	if (!n) {
+		return BigInt(1);
+	} else if (n==1) {
+		return BigInt((unsigned long long)v[0]);
+	}
+	BigInt r = product(v, n / 2);
+	r.mul(product(v + n / 2, n - n / 2));
+	return r;
+}
+
+
+/**
+ * Multiplies consecutive integers using a balanced product tree.
+ *
+ * \param[in] lo the first factor, positive
+ * \param[in] hi the last factor
+ * \return <code>lo * (lo + 1) * ... * hi</code>, one if \a lo is
+ *         greater than \a hi
+ */
+static BigInt product_range(unsigned long lo, unsigned long hi) {
+	std::vector<uint64_t> words;
+	uint64_t cur = 1;
+	for (unsigned long i = lo; i<=hi && i>=lo; ++i) pack(words, i, cur);
+	words.push_back(cur);
+	return product(&words[0], words.size());
+}
+
+
+
+/******************** Prime factorization ********************/
+/**
+ * Lists primes using sieve of Eratosthenes.
+ *
+ * \param[in] n limit
+ * \return all primes not greater than \a n in increasing order
+ */
+static std::vector<unsigned long> primes_upto(unsigned long n) {
+	std::vector<unsigned long> primes;
+	if (n<2) return primes;
+
+	/* Index i stands for 2 * i + 1 */
+	std::vector<bool> composite(n / 2 + 1);
+	primes.push_back(2);
+	for (unsigned long i = 1; 2 * i + 1<=n; ++i) {
+		if (composite[i]) continue;
+		const unsigned long p = 2 * i + 1;
+		primes.push_back(p);
+		for (unsigned long j = p * p / 2; p<=n / p && j<composite.size();
+		     j += p) {
+			composite[j] = true;
+		}
+	}
+	return primes;
+}
+
+
+/**
+ * Computes product of prime powers.  Primes whose exponent has given
+ * bit set are multiplied using a product tree and the result is
+ * built from the most significant bit by squaring and multiplying by
+ * such products so all prime powers are computed with a single
+ * sequence of squarings.
+ *
+ * \param[in] primes primes
+ * \param[in] exps exponents of the primes
+ * \return <code>primes[0]^exps[0] * primes[1]^exps[1] * ...</code>
+ */
+static BigInt prime_powers(const std::vector<unsigned long> &primes,
+                           const std::vector<unsigned long> &exps) {
+	unsigned long all = 0;
+	for (unsigned i = 0; i<exps.size(); ++i) all |= exps[i];
+
+	BigInt r(1);
+	std::vector<uint64_t> words;
+	for (unsigned bit = sizeof all * 8; bit--; ) {
+		if (!(all >> bit)) continue;
+
+		r.sqr();
+		words.clear();
+		uint64_t cur = 1;
+		for (unsigned i = 0; i<primes.size(); ++i) {
+			if (exps[i] >> bit & 1) pack(words, primes[i], cur);
+		}
+		words.push_back(cur);
+		r.mul(product(&words[0], words.size()));
+	}
+	return r;
+}
+
+
+
+/******************** Fibonacci numbers ********************/
+/**
+ * Computes pair of consecutive Fibonacci numbers using fast doubling.
+ *
+ * \param[in] n index
+ * \param[out] a <code>F(n-1)</code>
+ * \param[out] b <code>F(n)</code>
+ */
+static void fibonacci_pair(unsigned long n, BigInt &a, BigInt &b) {
+	/* (a, b) = (F(k-1), F(k)) starting with k = 0 */
+	a = 1;
+	b = 0;
+	bool odd = false;
+	for (unsigned bit = sizeof n * 8; bit--; ) {
+		if (!(n >> bit)) continue;
+
+		a.sqr();
+		b.sqr();
+		BigInt t(b);
+		t.mul(4).sub(a).add(odd ? -2 : 2); /* F(2k+1) */
+		a.add(b);                          /* F(2k-1) */
+		odd = n >> bit & 1;
+		if (odd) {
+			a.sub(t).neg();                /* F(2k) */
+			b = std::move(t);
+		} else {
+			t.sub(a);                      /* F(2k) */
+			b = std::move(t);
+		}
+	}
+}
+
+
+
+/******************** BigInt methods ********************/
+BigInt BigInt::factorial(unsigned long n) {
+	if (n<21) {
+		DLimb r = 1;
+		while (n>1) r *= n--;
+		return BigInt((unsigned long long)r);
+	}
+
+	/* Legendre's formula; two is dealt with by a shift */
+	std::vector<unsigned long> primes = primes_upto(n), exps;
+	primes.erase(primes.begin());
+	exps.reserve(primes.size());
+	for (unsigned i = 0; i<primes.size(); ++i) {
+		unsigned long e = 0;
+		for (unsigned long m = n / primes[i]; m; m /= primes[i]) e += m;
+		exps.push_back(e);
+	}
+	const BigInt odd = prime_powers(primes, exps);
+
+	/* n - popcount(n) is the exponent of two */
+	unsigned long s = n;
+	for (unsigned long m = n; m; m >>= 1) s -= m & 1;
+
+	const unsigned on = odd.limbs_count();
+	const unsigned k = s / LIMB_BITS, rn = on + k + 1;
+	Limb *const vec = limbs_alloc(rn);
+	for (unsigned i = 0; i<k; ++i) vec[i] = 0;
+	if (s % LIMB_BITS) {
+		vec[rn - 1] = limbs_lshift(vec + k, odd.limbs_ptr(), on,
+		                           s % LIMB_BITS);
+	} else {
+		for (unsigned i = 0; i<on; ++i) vec[k + i] = odd.limbs_ptr()[i];
+		vec[rn - 1] = 0;
+	}
+
+	BigInt r;
+	r.sign = 1;
+	r.limbs.set_no_copy(vec, rn, rn);
+	r.normalize();
+	return r;
+}
+
+
+BigInt BigInt::binomial(unsigned long n, unsigned long k) {
+	if (k>n) {
+		return BigInt();
+	} else if (k>n - k) {
+		k = n - k;
+	}
+	if (!k) {
+		return BigInt(1);
+	}
+
+	if (k<n / BINOMIAL_RATIO) {
+		BigInt r = product_range(n - k + 1, n);
+		r.div(factorial(k));
+		return r;
+	}
+
+	/* Kummer's theorem: exponent of p is the number of borrows when
+	   substracting k from n in base p */
+	const std::vector<unsigned long> primes = primes_upto(n);
+	std::vector<unsigned long> exps;
+	exps.reserve(primes.size());
+	for (unsigned i = 0; i<primes.size(); ++i) {
+		const unsigned long p = primes[i];
+		unsigned long e = 0, a = n, b = k, borrow = 0;
+		while (a) {
+			borrow = a % p < b % p + borrow;
+			e += borrow;
+			a /= p;
+			b /= p;
+		}
+		exps.push_back(e);
+	}
+	return prime_powers(primes, exps);
+}
+
+
+BigInt BigInt::fibonacci(unsigned long n) {
+	BigInt a, b;
+	fibonacci_pair(n, a, b);
+	return b;
+}
+
+
+BigInt BigInt::lucas(unsigned long n) {
+	BigInt a, b;
+	fibonacci_pair(n, a, b);
+	a.mul(2).add(b);
+	return a;
+}
+
+
+}
@@ -0,0 +1,381 @@
+/**
+ * \file
+ * BigInt Division.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * Division of limb vectors.  Division by a single limb uses a
+ * precomputed reciprocal (Moller-Granlund), division by two limbs
+ * divides three limbs by two at a time in a single pass.  Longer divisors are
+ * handled by Knuth's algorithm D, or, if both the divisor and the
+ * quotient are big, by Burnikel-Ziegler recursive division which
+ * reduces division to multiplications and therefore benefits from
+ * fast multiplication algorithms.
+ */
+
+#include "bigint-limb.hpp"
+
+
+namespace mina86 {
+
+
+/**
+ * Divisor and quotient size (in limbs) from which Burnikel-Ziegler
+ * algorithm is used.
+ */
+static const unsigned BZ_THRESHOLD = 64;
+
+
+
+/******************** Single limb ********************/
+/**
+ * Computes reciprocal of a normalized limb, ie. <code>floor((B^2 -
+ * 1) / d) - B</code> where \c B is 2^LIMB_BITS.
+ *
+ * \param[in] d divisor with the most significant bit set
+ * \return reciprocal
+ */
+static Limb reciprocal(Limb d) {
+	return (Limb)(~(DLimb)0 / d - ((DLimb)1 << BigInt::LIMB_BITS));
+}
+
+/**
+ * Divides two limb number by a normalized limb using precomputed
+ * reciprocal.
+ *
+ * \param[in] u1 the most significant limb of dividend, must be lower
+ *               then \a d
+ * \param[in] u0 the least significant limb of dividend
+ * \param[in] d divisor with the most significant bit set
+ * \param[in] v reciprocal of \a d (see reciprocal())
+ * \param[out] r remainder
+ * \return quotient
+ */
+static Limb div_preinv(Limb u1, Limb u0, Limb d, Limb v, Limb &r) {
+	const DLimb p = (DLimb)v * u1 + (((DLimb)u1 << BigInt::LIMB_BITS) | u0);
+	Limb q = (Limb)(p >> BigInt::LIMB_BITS) + 1;
+	r = u0 - q * d;
+	if (r > (Limb)p) {
+		--q;
+		r += d;
+	}
+	if (r>=d) {
+		++q;
+		r -= d;
+	}
+	return q;
+}
+
+
+Limb limbs_divmod_1(Limb *q, const Limb *a, unsigned n, Limb d) {
+	if (!n) {
+		return 0;
+	}
+
+	const unsigned s = limb_clz(d), rs = BigInt::LIMB_BITS - s;
+	d <<= s;
+	const Limb v = reciprocal(d);
+	Limb r = 0;
+
+	if (!s) {
+		while (n--) {
+			const Limb t = div_preinv(r, a[n], d, v, r);
+			if (q) q[n] = t;
+		}
+		return r;
+	}
+
+	/* Dividend is shifted on the fly */
+	r = a[n - 1] >> rs;
+	while (--n) {
+		const Limb t = div_preinv(r, (a[n] << s) | (a[n - 1] >> rs), d, v, r);
+		if (q) q[n] = t;
+	}
+	const Limb t = div_preinv(r, a[0] << s, d, v, r);
+	if (q) q[0] = t;
+	return r >> s;
+}
+
+
+/**
+ * Divides three limb number by a normalized two limb number.  This
+ * is a single step of Knuth's algorithm D with the quotient limb
+ * estimate corrected using the whole divisor so the result is exact.
+ *
+ * \param[in,out] r the most significant two limbs of dividend, must be
+ *                  lower than \a d; on output remainder
+ * \param[in] u0 the least significant limb of dividend
+ * \param[in] d divisor with the most significant bit set
+ * \return quotient
+ */
+static Limb div_3by2(DLimb &r, Limb u0, DLimb d) {
+	const Limb d1 = (Limb)(d >> BigInt::LIMB_BITS), d0 = (Limb)d;
+	DLimb q = r / d1, rh = r - q * d1;
+	while ((q >> BigInt::LIMB_BITS) ||
+	       q * d0 > ((rh << BigInt::LIMB_BITS) | u0)) {
+		--q;
+		rh += d1;
+		if (rh >> BigInt::LIMB_BITS) break;
+	}
+	/* The remainder is lower than d so it is computed modulo 2^64 */
+	r = ((rh << BigInt::LIMB_BITS) | u0) - q * d0;
+	return (Limb)q;
+}
+
+
+DLimb limbs_divmod_2(Limb *q, const Limb *a, unsigned n, DLimb d) {
+	if (!n) {
+		return 0;
+	}
+
+	const unsigned s = limb_clz((Limb)(d >> BigInt::LIMB_BITS));
+	const unsigned rs = BigInt::LIMB_BITS - s;
+	d <<= s;
+	DLimb r = 0;
+
+	if (!s) {
+		while (n--) {
+			const Limb t = div_3by2(r, a[n], d);
+			if (q) q[n] = t;
+		}
+		return r;
+	}
+
+	/* Dividend is shifted on the fly */
+	r = a[n - 1] >> rs;
+	while (--n) {
+		const Limb t = div_3by2(r, (a[n] << s) | (a[n - 1] >> rs), d);
+		if (q) q[n] = t;
+	}
+	const Limb t = div_3by2(r, a[0] << s, d);
+	if (q) q[0] = t;
+	return r >> s;
+}
+
+
+
+/******************** Knuth's algorithm D ********************/
+/**
+ * Divides limb vectors using Knuth's algorithm D.  Divisor must be
+ * normalized.  Remainder is left in the lowest \a bn limbs of \a a.
+ *
+ * \param[out] q the lowest \a an - \a bn limbs of quotient
+ * \param[in,out] a dividend (\a an limbs), on output remainder
+ * \param[in] an number of limbs in \a a
+ * \param[in] b divisor with the most significant bit set
+ * \param[in] bn number of limbs in \a b, at least two
+ * \return the most significant limb of quotient (zero or one)
+ */
+static Limb div_basecase(Limb *q, Limb *a, unsigned an,
+                         const Limb *b, unsigned bn) {
+	static const DLimb B = (DLimb)1 << BigInt::LIMB_BITS;
+
+	Limb qh = 0;
+	if (limbs_cmp(a + an - bn, b, bn)>=0) {
+		limbs_sub_n(a + an - bn, a + an - bn, b, bn);
+		qh = 1;
+	}
+
+	const Limb d1 = b[bn - 1], d0 = b[bn - 2];
+	for (unsigned j = an - bn; j--; ) {
+		Limb *const u = a + j;
+		const Limb n2 = u[bn], n1 = u[bn - 1], n0 = u[bn - 2];
+
+		/* Estimate quotient limb */
+		const DLimb num = ((DLimb)n2 << BigInt::LIMB_BITS) | n1;
+		DLimb qhat = num / d1, rhat = num % d1;
+		if (qhat>=B) {
+			qhat = B - 1;
+			rhat = num - qhat * d1;
+		}
+		while (rhat<B && qhat * d0 > ((rhat << BigInt::LIMB_BITS) | n0)) {
+			--qhat;
+			rhat += d1;
+		}
+
+		/* Multiply and substract */
+		const Limb borrow = limbs_submul_1(u, b, bn, (Limb)qhat);
+		if (n2<borrow) {
+			--qhat;
+			limbs_add_n(u, u, b, bn);
+		}
+		u[bn] = 0;
+		q[j] = (Limb)qhat;
+	}
+
+	return qh;
+}
+
+
+
+/******************** Burnikel-Ziegler ********************/
+static void div_2n1n(Limb *q, Limb *a, const Limb *b, unsigned n,
+                     Limb *scratch);
+
+
+/**
+ * Divides 3n limb number by 2n limb number.  Quotient must fit in \a
+ * n limbs, ie. <code>a < b B^n</code>.  Remainder is left in the
+ * lowest 2 * \a n limbs of \a a.
+ *
+ * \param[out] q quotient (\a n limbs)
+ * \param[in,out] a dividend (3 * \a n limbs), on output remainder
+ * \param[in] b divisor with the most significant bit set (2 * \a n
+ *              limbs)
+ * \param[in] n half of the divisor length
+ * \param[in] scratch scratch area (2 * \a n limbs)
+ */
+static void div_3n2n(Limb *q, Limb *a, const Limb *b, unsigned n,
+                     Limb *scratch) {
+	Limb top;
+
+	/* q = [a2, a1] / b1 */
+	if (limbs_cmp(a + 2 * n, b + n, n)<0) {
+		div_2n1n(q, a + n, b + n, n, scratch);
+		top = 0;
+	} else {
+		/* a2 = b1 so q = B^n - 1 and [a2, a1] - q b1 = a1 + b1 */
+		for (unsigned i = 0; i<n; ++i) q[i] = ~(Limb)0;
+		top = limbs_add_n(a + n, a + n, b + n, n);
+	}
+
+	/* [r1, a0] - q b0 */
+	Limb *const d = scratch;
+	limbs_mul(d, q, n, b, n);
+	const Limb borrow = limbs_sub_n(a, a, d, 2 * n);
+
+	/* Correct quotient, at most twice */
+	long t = (long)top - (long)borrow;
+	while (t<0) {
+		t += limbs_add_n(a, a, b, 2 * n);
+		limbs_sub_1(q, q, n, 1);
+	}
+	for (unsigned i = 2 * n; i<3 * n; ++i) a[i] = 0;
+}
+
+
+/**
+ * Divides 2n limb number by n limb number.  Quotient must fit in \a n
+ * limbs, ie. <code>a < b B^n</code>.  Remainder is left in the lowest
+ * \a n limbs of \a a.
+ *
+ * \param[out] q quotient (\a n limbs)
+ * \param[in,out] a dividend (2 * \a n limbs), on output remainder
+ * \param[in] b divisor with the most significant bit set (\a n limbs)
+ * \param[in] n number of limbs in \a b
+ * \param[in] scratch scratch area (\a n limbs)
+ */
+static void div_2n1n(Limb *q, Limb *a, const Limb *b, unsigned n,
+                     Limb *scratch) {
+	if ((n & 1) || n<BZ_THRESHOLD) {
+		div_basecase(q, a, 2 * n, b, n);
+		return;
+	}
+
+	const unsigned h = n / 2;
+	div_3n2n(q + h, a + h, b, h, scratch);
+	div_3n2n(q, a, b, h, scratch);
+}
+
+
+/**
+ * Divides limb vectors using Burnikel-Ziegler algorithm.  Divisor
+ * is padded so that its length is a multiple of a power of two
+ * (which makes the recursion split evenly) and dividend is processed
+ * in blocks of divisor's length from the most significant one.
+ *
+ * \param[out] q quotient (\a an - \a bn + 1 limbs)
+ * \param[out] r remainder (\a bn limbs)
+ * \param[in] a dividend
+ * \param[in] an number of limbs in \a a
+ * \param[in] b divisor
+ * \param[in] bn number of limbs in \a b
+ */
+static void div_bz(Limb *q, Limb *r, const Limb *a, unsigned an,
+                   const Limb *b, unsigned bn) {
+	/* Block size n = j 2^k, j < BZ_THRESHOLD */
+	unsigned n = bn, m = 1;
+	while (n>=BZ_THRESHOLD) {
+		n = (n + 1) / 2;
+		m *= 2;
+	}
+	n *= m;
+
+	/* Normalize, shift by whole limbs and then bits.  There is at
+	 * least one spare limb at the top so the most significant block
+	 * is lower then the divisor. */
+	const unsigned pad = n - bn, s = limb_clz(b[bn - 1]);
+	const unsigned t = (an + pad + 1 + n - 1) / n;
+	Limb *const buf = limbs_scratch(n + t * n + n + n);
+	Limb *const bs = buf, *const as = bs + n, *const qb = as + t * n;
+	Limb *const scratch = qb + n;
+
+	unsigned i;
+	for (i = 0; i<pad; ++i) bs[i] = 0;
+	for (i = 0; i<bn; ++i) bs[pad + i] = b[i];
+	for (i = 0; i<pad; ++i) as[i] = 0;
+	for (i = 0; i<an; ++i) as[pad + i] = a[i];
+	for (i += pad; i<t * n; ++i) as[i] = 0;
+	if (s) {
+		limbs_lshift(bs, bs, n, s);
+		limbs_lshift(as, as, t * n, s);
+	}
+
+	/* Long division by blocks */
+	const unsigned qn = an - bn + 1;
+	for (i = 0; i<qn; ++i) q[i] = 0;
+	for (unsigned j = t - 1; j--; ) {
+		div_2n1n(qb, as + j * n, bs, n, scratch);
+		for (i = 0; i<n && j * n + i<qn; ++i) q[j * n + i] = qb[i];
+	}
+
+	/* Denormalize remainder */
+	if (s) limbs_rshift(as, as, n, s);
+	for (i = 0; i<bn; ++i) r[i] = as[pad + i];
+
+	limbs_scratch_free(buf, n + t * n + n + n);
+}
+
+
+
+/******************** Entry point ********************/
+void limbs_div_qr(Limb *q, Limb *r, const Limb *a, unsigned an,
+                  const Limb *b, unsigned bn) {
+	if (bn==1) {
+		r[0] = limbs_divmod_1(q, a, an, b[0]);
+		return;
+	}
+
+	if (bn>=BZ_THRESHOLD && an - bn>=BZ_THRESHOLD) {
+		div_bz(q, r, a, an, b, bn);
+		return;
+	}
+
+	/* Normalize */
+	const unsigned s = limb_clz(b[bn - 1]);
+	Limb *const buf = limbs_scratch(bn + an + 1);
+	Limb *const bs = buf, *const as = buf + bn;
+	unsigned i;
+	if (s) {
+		limbs_lshift(bs, b, bn, s);
+		as[an] = limbs_lshift(as, a, an, s);
+	} else {
+		for (i = 0; i<bn; ++i) bs[i] = b[i];
+		for (i = 0; i<an; ++i) as[i] = a[i];
+		as[an] = 0;
+	}
+
+	/* Divide and denormalize remainder */
+	div_basecase(q, as, an + 1, bs, bn);
+	if (s) {
+		limbs_rshift(r, as, bn, s);
+	} else {
+		for (i = 0; i<bn; ++i) r[i] = as[i];
+	}
+
+	limbs_scratch_free(buf, bn + an + 1);
+}
+
+
+}
@@ -0,0 +1,226 @@
+/**
+ * \file
+ * BigInt Expression Evaluation.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * Evaluation of sums of numbers and products built by BigIntExpr.
+ * All terms are accumulated in a single buffer holding the result in
+ * two's complement, so terms of either sign are simply added or
+ * substracted and no sign-magnitude juggling is needed in between.
+ * The buffer is two limbs longer than the biggest term which is
+ * enough for any practical number of terms and for the sign.
+ */
+
+#include "bigint-limb.hpp"
+
+
+namespace mina86 {
+
+
+/**
+ * Number of limbs of the shorter factor below which a product is
+ * accumulated row by row (a single pass of schoolbook multiplication
+ * into the result).  Bigger products are computed with limbs_mul()
+ * into a scratch buffer first.  Equals the threshold at which
+ * Karatsuba multiplication takes over.
+ */
+static const unsigned FUSED_THRESHOLD = 32;
+
+/**
+ * Size (in limbs) of the buffer on stack used when result is short.
+ */
+static const unsigned LOCAL_LIMBS = 8;
+
+
+
+/******************** Helpers ********************/
+/**
+ * Adds a limb to or substracts it from a limb vector propagating
+ * carry or borrow.  Stops as soon as there is nothing more to
+ * propagate.
+ *
+ * \param[in,out] r limb vector
+ * \param[in] n number of limbs
+ * \param[in] c limb to add or substract
+ * \param[in] s \c 1 to add, \c -1 to substract
+ */
+static void propagate(Limb *r, unsigned n, Limb c, int s) {
+	if (!c || !n) {
+		return;
+	} else if (s>0) {
+		c = (*r += c) < c;
+		for (++r, --n; c && n; ++r, --n) c = !++*r;
+	} else {
+		const Limb v = *r;
+		*r = v - c;
+		c = v < c;
+		for (++r, --n; c && n; ++r, --n) c = !(*r)--;
+	}
+}
+
+
+/**
+ * Adds a number to or substracts it from a result.
+ *
+ * \param[in,out] r result
+ * \param[in] rn number of limbs of result
+ * \param[in] a number
+ * \param[in] an number of limbs of \a a, not greater than \a rn
+ * \param[in] s \c 1 to add, \c -1 to substract
+ */
+static void accumulate(Limb *r, unsigned rn, const Limb *a, unsigned an,
+                       int s) {
+	const Limb c = s>0 ? limbs_add_n(r, r, a, an)
+		: limbs_sub_n(r, r, a, an);
+	propagate(r + an, rn - an, c, s);
+}
+
+
+/**
+ * Adds product of two numbers to or substracts it from a result
+ * computing the product row by row.
+ *
+ * \param[in,out] r result
+ * \param[in] rn number of limbs of result
+ * \param[in] a first factor
+ * \param[in] an number of limbs of \a a
+ * \param[in] b second factor
+ * \param[in] bn number of limbs of \a b, \a an plus \a bn must not be
+ *               greater than \a rn
+ * \param[in] s \c 1 to add, \c -1 to substract
+ */
+static void accumulate_mul(Limb *r, unsigned rn, const Limb *a, unsigned an,
+                           const Limb *b, unsigned bn, int s) {
+	for (unsigned i = 0; i<bn; ++i, ++r, --rn) {
+		const Limb c = s>0 ? limbs_addmul_1(r, a, an, b[i])
+			: limbs_submul_1(r, a, an, b[i]);
+		propagate(r + an, rn - an, c, s);
+	}
+}
+
+
+
+/******************** Evaluation ********************/
+void BigInt::evaluate(const BigIntTerm *terms, unsigned n, int acc) {
+	/* Single term which needs no buffer */
+	if (n==1 && (!acc || !terms->prod)) {
+		const BigIntTerm &t = *terms;
+		if (acc) {
+			if (t.sign * acc > 0) add(t.a); else sub(t.a);
+		} else {
+			set(t.a);
+			if (t.prod) mul(t.b);
+			if (t.sign<0) neg();
+		}
+		return;
+	}
+
+	/* Size of the result and of scratch buffer */
+	const unsigned dn = acc ? limbs_count() : 0;
+	unsigned m = dn, scratch_n = 0;
+	for (unsigned i = 0; i<n; ++i) {
+		const BigIntTerm &t = terms[i];
+		const unsigned an = t.a.limbs_count();
+		const unsigned bn = t.prod ? t.b.limbs_count() : 0;
+		const unsigned tn = t.prod ? (bn ? an + bn : 0) : an;
+		if (tn>m) m = tn;
+		if (t.prod && an>=FUSED_THRESHOLD && bn>=FUSED_THRESHOLD &&
+		    tn>scratch_n) {
+			scratch_n = tn;
+		}
+	}
+	const unsigned len = m + 2;
+
+	/*
+	 * Result buffer.  Limbs of this object are reused if possible;
+	 * terms hold copies sharing limbs with this object so if limbs
+	 * are shared rw_begin() makes a private copy and terms still see
+	 * the original value.
+	 */
+	Limb local[LOCAL_LIMBS], *r;
+	bool own = false;
+	if (len<=LOCAL_LIMBS) {
+		r = local;
+		for (unsigned i = 0; i<dn; ++i) r[i] = limbs_ptr()[i];
+	} else if (limbs && limbs.getCapacity()>=len) {
+		own = true;
+		limbs.resize(len, limbs.getCapacity());
+		r = limbs.rw_begin();
+	} else {
+		r = limbs_alloc(len);
+		for (unsigned i = 0; i<dn; ++i) r[i] = limbs_ptr()[i];
+	}
+	for (unsigned i = dn; i<len; ++i) r[i] = 0;
+
+	/*
+	 * Accumulate.  If this number is negative its absolute value is
+	 * in the buffer so signs of all terms are flipped.
+	 */
+	const int base = acc && sign<0 ? -1 : 1;
+	Limb *const scratch = scratch_n ? limbs_scratch(scratch_n) : 0;
+	for (unsigned i = 0; i<n; ++i) {
+		const BigIntTerm &t = terms[i];
+		if (!t.a.sign || (t.prod && !t.b.sign)) continue;
+
+		const int s = base * (acc ? acc : 1) * t.sign * t.a.sign
+			* (t.prod ? t.b.sign : 1);
+		const Limb *a = t.a.limbs_ptr();
+		unsigned an = t.a.limbs_count();
+		if (!t.prod) {
+			accumulate(r, len, a, an, s);
+			continue;
+		}
+
+		const Limb *b = t.b.limbs_ptr();
+		unsigned bn = t.b.limbs_count();
+		if (an<bn) {
+			const Limb *const tmp = a; a = b; b = tmp;
+			const unsigned tmpn = an; an = bn; bn = tmpn;
+		}
+		if (bn<FUSED_THRESHOLD) {
+			accumulate_mul(r, len, a, an, b, bn, s);
+		} else {
+			if (a==b && an==bn) {
+				limbs_sqr(scratch, a, an);
+			} else {
+				limbs_mul(scratch, a, an, b, bn);
+			}
+			accumulate(r, len, scratch, an + bn, s);
+		}
+	}
+	limbs_scratch_free(scratch, scratch_n);
+
+	/* Back to sign-magnitude */
+	int s = base;
+	if (r[len - 1] >> (LIMB_BITS - 1)) {
+		for (unsigned i = 0; i<len; ++i) r[i] = ~r[i];
+		propagate(r, len, 1, 1);
+		s = -s;
+	}
+	unsigned rn = len;
+	while (rn && !r[rn - 1]) --rn;
+
+	/* Store */
+	if (rn<=2) {
+		const DLimb v = !rn ? 0 : rn==1 ? r[0]
+			: r[0] | (DLimb)r[1] << LIMB_BITS;
+		if (r!=local && !own) limbs_free(r, len);
+		set_small(s, v);
+	} else if (own) {
+		sign = s;
+		limbs.resize(rn, limbs.getCapacity());
+	} else if (r==local) {
+		Limb *const vec = limbs_alloc(rn);
+		for (unsigned i = 0; i<rn; ++i) vec[i] = r[i];
+		sign = s;
+		limbs.set_no_copy(vec, rn, rn);
+	} else {
+		sign = s;
+		limbs.set_no_copy(r, rn, len);
+	}
+}
+
+
+}
@@ -0,0 +1,501 @@
+/**
+ * \file
+ * Fixed Width BigInt Header File.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ */
+
+#ifndef MN_BIGINT_FIXED_HPP
+#define MN_BIGINT_FIXED_HPP
+
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+#include "bigint.hpp"
+
+
+namespace mina86 {
+
+
+/**
+ * Unsigned integer of a fixed number of bits with limbs stored inline
+ * so it never allocates memory.  Arithmetic is modulo
+ * 2<sup>Bits</sup> just like arithmetic on unsigned machine types,
+ * in particular negative machine integers and negative numbers in
+ * parsed strings wrap around.  All operations except conversion to
+ * and from BigInt are \c constexpr so constants may be computed at
+ * compile time.  Loops run over a constant number of limbs so for
+ * small widths the compiler unrolls them completely.
+ *
+ * Conversion from BigInt is lossless: numbers which are negative or
+ * do not fit in \a Bits bits are rejected with BigInt::OutOfRange.
+ * Likewise parsing throws BigInt::OutOfRange if the absolute value
+ * does not fit.
+ *
+ * \code
+ * typedef FixedBigInt<256> U256;
+ * constexpr U256 p("0xffffffffffffffffffffffffffffffffffffffffffffffff"
+ *                  "fffffffefffffc2f", 16);
+ * static_assert(p * 2 + 1 < p, "2 p + 1 wraps modulo 2^256");
+ * \endcode
+ */
+template<unsigned Bits>
+class FixedBigInt {
+	static_assert(Bits>0, "FixedBigInt needs at least one bit");
+
+public:
+	/** Type of a single limb. */
+	typedef BigInt::Limb Limb;
+	/** Type able to hold a product of two limbs. */
+	typedef BigInt::DLimb DLimb;
+
+	/** Number of bits. */
+	static const unsigned BITS = Bits;
+
+	/** Number of limbs. */
+	static const unsigned LIMBS =
+		(Bits + BigInt::LIMB_BITS - 1) / BigInt::LIMB_BITS;
+
+
+	/**
+	 * Creates number which value is zero.
+	 */
+	constexpr FixedBigInt() : limbs() { }
+
+	/**
+	 * Creates number from a machine integer.  Negative values wrap
+	 * around as for unsigned machine types.
+	 *
+	 * \param[in] n value
+	 * \sa BigIntWord
+	 */
+	template<class T, class = typename std::enable_if<
+		BigIntWord<T>::value>::type>
+	constexpr FixedBigInt(T n) : limbs() {
+		const uint64_t v = BigIntWord<T>::abs(n);
+		for (unsigned i = 0; i<LIMBS && i<2; ++i) {
+			limbs[i] = (Limb)(v >> (i * BigInt::LIMB_BITS));
+		}
+		truncate();
+		if (BigIntWord<T>::sign(n)<0) neg();
+	}
+
+	/**
+	 * Creates number from a BigInt.
+	 *
+	 * \param[in] n value
+	 * \throw BigInt::OutOfRange if \a n is negative or does not fit
+	 */
+	explicit FixedBigInt(const BigInt &n) : limbs() {
+		const unsigned count = n.limbs_count();
+		const Limb *const l = n.limbs_ptr();
+		if (n.sign<0 || count>LIMBS ||
+		    (count==LIMBS && (l[LIMBS - 1] & ~TOP_MASK))) {
+			throw BigInt::OutOfRange();
+		}
+		for (unsigned i = 0; i<count; ++i) limbs[i] = l[i];
+	}
+
+	/**
+	 * Parses C string.
+	 *
+	 * \param[in] str string to parse
+	 * \param[in] base base number is written in
+	 * \sa set(const char*, unsigned)
+	 */
+	explicit constexpr FixedBigInt(const char *str, unsigned base = 10)
+		: limbs() {
+		set(str, base);
+	}
+
+	/**
+	 * Parses string.
+	 *
+	 * \param[in] str string to parse
+	 * \param[in] base base number is written in
+	 * \sa set(const char*, unsigned)
+	 */
+	explicit FixedBigInt(const std::string &str, unsigned base = 10)
+		: limbs() {
+		set(str.c_str(), base);
+	}
+
+
+	/**
+	 * Parses C string and sets value of the number.  Accepts the same
+	 * syntax as BigInt::set(const char*, unsigned), a minus sign
+	 * negates the value modulo 2<sup>Bits</sup>.  If string contains
+	 * no number value is not changed.
+	 *
+	 * \param[in] str string to parse
+	 * \param[in] base base number is written in, from 2 to 36 or zero
+	 * \return \c true if string contained valid number, \c false
+	 *         othewise
+	 * \throw BigInt::BadRadix if \a base is invalid
+	 * \throw BigInt::OutOfRange if absolute value does not fit
+	 */
+	constexpr bool set(const char *str, unsigned base = 10) {
+		if (base==1 || base>36) {
+			throw BigInt::BadRadix();
+		}
+
+		while (*str==' '  || *str=='\t' || *str=='\n' ||
+		       *str=='\r' || *str=='\v' || *str=='\f') ++str;
+
+		bool negative = false;
+		if (*str=='-') {
+			negative = true;
+			++str;
+		} else if (*str=='+') {
+			++str;
+		}
+
+		if (str[0]=='0' && (base==0 || base==16) &&
+		    (str[1]=='x' || str[1]=='X') && digit_value(str[2])<16) {
+			base = 16;
+			str += 2;
+		} else if (str[0]=='0' && (base==0 || base==2) &&
+		           (str[1]=='b' || str[1]=='B') &&
+		           digit_value(str[2])<2) {
+			base = 2;
+			str += 2;
+		} else if (!base) {
+			base = 10;
+		}
+
+		FixedBigInt r;
+		const char *end = str;
+		for (; digit_value(*end)<base; ++end) {
+			if (r.mul_add_1(base, digit_value(*end))) {
+				throw BigInt::OutOfRange();
+			}
+		}
+		if (end==str) {
+			return false;
+		}
+
+		if (negative) r.neg();
+		*this = r;
+		return true;
+	}
+
+
+	/**
+	 * Converts number to BigInt.
+	 *
+	 * \return BigInt with the same value
+	 */
+	BigInt toBigInt() const {
+		unsigned n = LIMBS;
+		while (n && !limbs[n - 1]) --n;
+
+		BigInt r;
+		if (n<=2) {
+			DLimb v = 0;
+			for (unsigned i = n; i--; ) v = v << BigInt::LIMB_BITS | limbs[i];
+			r.set_small(1, v);
+		} else {
+			Limb *const vec = BigInt::Pool::allocate(n);
+			for (unsigned i = 0; i<n; ++i) vec[i] = limbs[i];
+			r.sign = 1;
+			r.limbs.set_no_copy(vec, n, n);
+		}
+		return r;
+	}
+
+	/**
+	 * Converts number to string.
+	 *
+	 * \param[in] base base to use, from 2 to 36
+	 * \return string representation of the number
+	 * \sa BigInt::toString()
+	 */
+	std::string toString(unsigned base = 10) const {
+		return toBigInt().toString(base);
+	}
+
+
+	/**
+	 * Returns limb of the number.  The first limb is the least
+	 * significant.
+	 *
+	 * \param[in] i index of the limb, less than #LIMBS
+	 * \return the limb
+	 */
+	constexpr Limb getLimb(unsigned i) const { return limbs[i]; }
+
+	/**
+	 * Returns sign of the number.
+	 *
+	 * \return \c 0 if number is zero, \c 1 otherwise
+	 */
+	constexpr int sgn() const {
+		for (unsigned i = 0; i<LIMBS; ++i) {
+			if (limbs[i]) return 1;
+		}
+		return 0;
+	}
+
+
+	/**
+	 * Adds number to this number.
+	 *
+	 * \param[in] n number to add
+	 * \return reference to this object
+	 */
+	constexpr FixedBigInt &add(const FixedBigInt &n) {
+		DLimb t = 0;
+		for (unsigned i = 0; i<LIMBS; ++i) {
+			t += (DLimb)limbs[i] + n.limbs[i];
+			limbs[i] = (Limb)t;
+			t >>= BigInt::LIMB_BITS;
+		}
+		truncate();
+		return *this;
+	}
+
+	/**
+	 * Substracts number from this number.
+	 *
+	 * \param[in] n number to substract
+	 * \return reference to this object
+	 */
+	constexpr FixedBigInt &sub(const FixedBigInt &n) {
+		Limb borrow = 0;
+		for (unsigned i = 0; i<LIMBS; ++i) {
+			const DLimb t = (DLimb)limbs[i] - n.limbs[i] - borrow;
+			limbs[i] = (Limb)t;
+			borrow = (Limb)(t >> (2 * BigInt::LIMB_BITS - 1));
+		}
+		truncate();
+		return *this;
+	}
+
+	/**
+	 * Multiplies this number by another number.  Only products of
+	 * limbs which affect the low \a Bits bits are computed.
+	 *
+	 * \param[in] n number to multiply by
+	 * \return reference to this object
+	 */
+	constexpr FixedBigInt &mul(const FixedBigInt &n) {
+		Limb r[LIMBS] = { };
+		for (unsigned i = 0; i<LIMBS; ++i) {
+			DLimb t = 0;
+			for (unsigned j = 0; i + j<LIMBS; ++j) {
+				t += (DLimb)limbs[i] * n.limbs[j] + r[i + j];
+				r[i + j] = (Limb)t;
+				t >>= BigInt::LIMB_BITS;
+			}
+		}
+		for (unsigned i = 0; i<LIMBS; ++i) limbs[i] = r[i];
+		truncate();
+		return *this;
+	}
+
+	/**
+	 * Negates number modulo 2<sup>Bits</sup>.
+	 *
+	 * \return reference to this object
+	 */
+	constexpr FixedBigInt &neg() {
+		Limb c = 1;
+		for (unsigned i = 0; i<LIMBS; ++i) {
+			limbs[i] = ~limbs[i] + c;
+			c = c && !limbs[i];
+		}
+		truncate();
+		return *this;
+	}
+
+	/**
+	 * Compares two numbers.
+	 *
+	 * \param[in] n number to compare with
+	 * \return negative value if this number is less than \a n,
+	 *         positive value if it is greater and zero if they are
+	 *         equal
+	 */
+	constexpr int cmp(const FixedBigInt &n) const {
+		for (unsigned i = LIMBS; i--; ) {
+			if (limbs[i]!=n.limbs[i]) {
+				return limbs[i]<n.limbs[i] ? -1 : 1;
+			}
+		}
+		return 0;
+	}
+
+
+	/** \copydoc add() */
+	constexpr FixedBigInt &operator+=(const FixedBigInt &n) {
+		return add(n);
+	}
+	/** \copydoc sub() */
+	constexpr FixedBigInt &operator-=(const FixedBigInt &n) {
+		return sub(n);
+	}
+	/** \copydoc mul() */
+	constexpr FixedBigInt &operator*=(const FixedBigInt &n) {
+		return mul(n);
+	}
+
+	/**
+	 * Returns negated number.
+	 *
+	 * \return <code>2<sup>Bits</sup> - this</code> modulo
+	 *         2<sup>Bits</sup>
+	 */
+	constexpr FixedBigInt operator-() const {
+		return FixedBigInt(*this).neg();
+	}
+
+	/**
+	 * Checks whether number is zero.
+	 *
+	 * \return \c true if number is zero
+	 */
+	constexpr bool operator!() const { return !sgn(); }
+
+
+	/**
+	 * Adds two numbers.
+	 *
+	 * \param[in] a first number
+	 * \param[in] b second number
+	 * \return sum modulo 2<sup>Bits</sup>
+	 */
+	friend constexpr FixedBigInt operator+(FixedBigInt a,
+	                                       const FixedBigInt &b) {
+		return a.add(b);
+	}
+
+	/**
+	 * Substracts two numbers.
+	 *
+	 * \param[in] a minuend
+	 * \param[in] b subtrahend
+	 * \return difference modulo 2<sup>Bits</sup>
+	 */
+	friend constexpr FixedBigInt operator-(FixedBigInt a,
+	                                       const FixedBigInt &b) {
+		return a.sub(b);
+	}
+
+	/**
+	 * Multiplies two numbers.
+	 *
+	 * \param[in] a first factor
+	 * \param[in] b second factor
+	 * \return product modulo 2<sup>Bits</sup>
+	 */
+	friend constexpr FixedBigInt operator*(FixedBigInt a,
+	                                       const FixedBigInt &b) {
+		return a.mul(b);
+	}
+
+	/** Compares two numbers.  \sa cmp() */
+	friend constexpr bool operator==(const FixedBigInt &a,
+	                                 const FixedBigInt &b) {
+		return !a.cmp(b);
+	}
+	/** Compares two numbers.  \sa cmp() */
+	friend constexpr bool operator!=(const FixedBigInt &a,
+	                                 const FixedBigInt &b) {
+		return a.cmp(b)!=0;
+	}
+	/** Compares two numbers.  \sa cmp() */
+	friend constexpr bool operator<(const FixedBigInt &a,
+	                                const FixedBigInt &b) {
+		return a.cmp(b)<0;
+	}
+	/** Compares two numbers.  \sa cmp() */
+	friend constexpr bool operator<=(const FixedBigInt &a,
+	                                 const FixedBigInt &b) {
+		return a.cmp(b)<=0;
+	}
+	/** Compares two numbers.  \sa cmp() */
+	friend constexpr bool operator>(const FixedBigInt &a,
+	                                const FixedBigInt &b) {
+		return a.cmp(b)>0;
+	}
+	/** Compares two numbers.  \sa cmp() */
+	friend constexpr bool operator>=(const FixedBigInt &a,
+	                                 const FixedBigInt &b) {
+		return a.cmp(b)>=0;
+	}
+
+
+private:
+	/**
+	 * Mask of valid bits of the most significant limb.
+	 */
+	static constexpr Limb TOP_MASK = Bits % BigInt::LIMB_BITS
+		? ((Limb)1 << Bits % BigInt::LIMB_BITS) - 1 : ~(Limb)0;
+
+	/**
+	 * Limbs of the number.  The first limb is the least significant.
+	 * Bits of the most significant limb above #TOP_MASK are zero.
+	 */
+	Limb limbs[LIMBS];
+
+
+	/**
+	 * Clears bits above \a Bits.
+	 */
+	constexpr void truncate() { limbs[LIMBS - 1] &= TOP_MASK; }
+
+	/**
+	 * Multiplies number by a single limb and adds another limb to
+	 * it.
+	 *
+	 * \param[in] m limb to multiply by
+	 * \param[in] a limb to add
+	 * \return \c true if result did not fit in \a Bits bits, number
+	 *         is truncated then
+	 */
+	constexpr bool mul_add_1(Limb m, Limb a) {
+		DLimb t = a;
+		for (unsigned i = 0; i<LIMBS; ++i) {
+			t += (DLimb)limbs[i] * m;
+			limbs[i] = (Limb)t;
+			t >>= BigInt::LIMB_BITS;
+		}
+		const bool overflow = t || (limbs[LIMBS - 1] & ~TOP_MASK);
+		truncate();
+		return overflow;
+	}
+
+	/**
+	 * Returns value of a digit.
+	 *
+	 * \param[in] ch character
+	 * \return value of digit or 36 if \a ch is not a digit
+	 */
+	static constexpr unsigned digit_value(char ch) {
+		return ch>='0' && ch<='9' ? ch - '0'
+			: ch>='a' && ch<='z' ? ch - 'a' + 10
+			: ch>='A' && ch<='Z' ? ch - 'A' + 10 : 36;
+	}
+};
+
+
+/**
+ * Sends number to output stream.  Formatting flags are handled as for
+ * BigInt.
+ *
+ * \param[in] os output stream to send data to
+ * \param[in] n  number to send
+ * \return \a os
+ */
+template<unsigned Bits>
+std::ostream &operator<<(std::ostream &os, const FixedBigInt<Bits> &n) {
+	return os << n.toBigInt();
+}
+
+
+}
+
+
+#endif
@@ -0,0 +1,495 @@
+/**
+ * \file
+ * BigInt Greatest Common Divisor.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * Greatest common divisor, Bezout's coefficients and modular inverse.
+ *
+ * Euclid's algorithm replaces pair <code>(a, b)</code> by <code>(b, a
+ * - q * b)</code>, ie. multiplies it by a matrix of determinant minus
+ * one.  Lehmer's algorithm finds the first few quotients from the
+ * leading 62 bits of both numbers and applies their product, a matrix
+ * with single word entries, to the numbers at once.  Half-GCD
+ * algorithm finds the matrix which halves the numbers recursively:
+ * the leading half of the numbers is halved first (which reduces
+ * whole numbers by a quarter) and so on.
+ *
+ * Any matrix of determinant plus or minus one keeps greatest common
+ * divisor, so a matrix computed from the leading part of the numbers
+ * is always correct.  If its last quotients happen to be wrong the
+ * numbers may end up negative or in wrong order which is fixed by
+ * negating and swapping them, and the algorithm simply carries on.
+ */
+
+#include <utility>
+
+#include "bigint-limb.hpp"
+
+
+namespace mina86 {
+
+
+/**
+ * Number of limbs from which half-GCD algorithm is used.
+ */
+static const unsigned HGCD_THRESHOLD = 500;
+
+
+
+/******************** Helpers ********************/
+/**
+ * Matrix of Bezout's coefficients.  Pair <code>(a, b)</code> being
+ * reduced equals the matrix times the original pair.
+ */
+struct GcdMatrix {
+	/** Entries of the matrix, the first index is a row. */
+	BigInt m[2][2];
+
+	/**
+	 * Creates identity matrix.
+	 */
+	GcdMatrix() {
+		m[0][0].set(1ul);
+		m[1][1].set(1ul);
+	}
+
+	/**
+	 * Checks if the matrix is identity.
+	 *
+	 * \return \c true if matrix is identity
+	 */
+	bool identity() const {
+		static const BigInt one(1.0);
+		return !m[0][1] && !m[1][0] && !m[0][0].cmp(one) && !m[1][1].cmp(one);
+	}
+};
+
+
+/**
+ * Greatest common divisor computation state.  Holds pair of
+ * non-negative numbers <code>a >= b</code> and optionally a matrix of
+ * Bezout's coefficients.  The class is a friend of BigInt so it can
+ * look at the leading bits of the numbers.
+ */
+class BigIntGcd {
+public:
+	/** The bigger number. */
+	BigInt a;
+	/** The smaller number. */
+	BigInt b;
+	/** Matrix of coefficients, maintained only if #track is set. */
+	GcdMatrix M;
+	/** Whether #M is maintained. */
+	const bool track;
+
+	/**
+	 * Initialises state.
+	 *
+	 * \param[in] x first number, must not be negative
+	 * \param[in] y second number, must not be negative
+	 * \param[in] track whether to maintain matrix of coefficients
+	 */
+	BigIntGcd(const BigInt &x, const BigInt &y, bool track)
+		: a(x), b(y), track(track) {
+		if (a.cmp(b)<0) {
+			std::swap(a, b);
+			if (track) {
+				std::swap(M.m[0][0], M.m[1][0]);
+				std::swap(M.m[0][1], M.m[1][1]);
+			}
+		}
+	}
+
+	/**
+	 * Reduces pair until \a b is zero.  \a a is then the greatest
+	 * common divisor.
+	 */
+	void run();
+
+	/**
+	 * Reduces pair until \a b has no more than half as many limbs as
+	 * \a a had.
+	 */
+	void hgcd();
+
+	/**
+	 * Reduces pair using Lehmer's algorithm until \a b has no more
+	 * than \a target limbs.
+	 *
+	 * \param[in] target number of limbs to stop at
+	 */
+	void reduce(unsigned target);
+
+private:
+	/** Scratch numbers. */
+	BigInt t0, t1;
+
+	/**
+	 * Does a single Lehmer's step, ie. finds as many quotients as
+	 * possible from the leading 62 bits and applies them.  If none
+	 * can be found does a single Euclid's step.
+	 *
+	 * \param[in] target number of limbs to stop at
+	 */
+	void lehmer_step(unsigned target);
+
+	/**
+	 * Does a single Euclid's step using full division.
+	 */
+	void euclid_step();
+
+	/**
+	 * Multiplies the pair and #M by matrix <code>[[A, B], [C,
+	 * D]]</code> and makes the pair non-negative and ordered.
+	 */
+	void apply(int64_t A, int64_t B, int64_t C, int64_t D);
+
+	/**
+	 * Multiplies the pair and #M by a matrix and makes the pair
+	 * non-negative and ordered.
+	 *
+	 * \param[in] S matrix to multiply by
+	 */
+	void apply(const GcdMatrix &S);
+
+	/**
+	 * Makes the pair non-negative and ordered updating #M.
+	 */
+	void fixup();
+
+	/**
+	 * Returns number of bits of a number.
+	 *
+	 * \param[in] x number
+	 * \return number of significant bits of \a x's absolute value
+	 */
+	static unsigned bits(const BigInt &x) {
+		const unsigned n = x.limbs_count();
+		return n ? n * BigInt::LIMB_BITS - limb_clz(x.limbs_ptr()[n - 1]) : 0;
+	}
+
+	/**
+	 * Returns absolute value of a number shifted right.
+	 *
+	 * \param[in] x number
+	 * \param[in] shift number of bits to shift by, the result must be
+	 *                  less than 2^62
+	 * \return <code>floor(|x| / 2^shift)</code>
+	 */
+	static int64_t top(const BigInt &x, unsigned shift);
+
+	/**
+	 * Returns number with given number of the least significant limbs
+	 * dropped.
+	 *
+	 * \param[in] x non-negative number
+	 * \param[in] k number of limbs to drop
+	 * \return <code>floor(x / 2^(k * LIMB_BITS))</code>
+	 */
+	static BigInt high(const BigInt &x, unsigned k);
+
+	/**
+	 * Converts machine integer to BigInt.
+	 *
+	 * \param[in] v value
+	 * \return \a v as BigInt
+	 */
+	static BigInt from(int64_t v) {
+		BigInt r;
+		r.set_small(v<0 ? -1 : 1, v<0 ? -(DLimb)v : (DLimb)v);
+		return r;
+	}
+};
+
+
+int64_t BigIntGcd::top(const BigInt &x, unsigned shift) {
+	const Limb *const p = x.limbs_ptr();
+	const unsigned n = x.limbs_count(), i = shift / BigInt::LIMB_BITS;
+	const unsigned off = shift % BigInt::LIMB_BITS;
+	if (i>=n) return 0;
+
+	DLimb v = p[i];
+	if (i + 1<n) v |= (DLimb)p[i + 1] << BigInt::LIMB_BITS;
+	v >>= off;
+	if (off && i + 2<n) v |= (DLimb)p[i + 2] << (2 * BigInt::LIMB_BITS - off);
+	return (int64_t)v;
+}
+
+
+BigInt BigIntGcd::high(const BigInt &x, unsigned k) {
+	const unsigned n = x.limbs_count();
+	BigInt r;
+	if (k<n) {
+		Limb *const vec = limbs_alloc(n - k);
+		for (unsigned i = k; i<n; ++i) vec[i - k] = x.limbs_ptr()[i];
+		r.sign = 1;
+		r.limbs.set_no_copy(vec, n - k, n - k);
+		r.normalize();
+	}
+	return r;
+}
+
+
+
+/******************** Matrix operations ********************/
+void BigIntGcd::fixup() {
+	if (a.sgn()<0) {
+		a.neg();
+		if (track) M.m[0][0].neg(), M.m[0][1].neg();
+	}
+	if (b.sgn()<0) {
+		b.neg();
+		if (track) M.m[1][0].neg(), M.m[1][1].neg();
+	}
+	if (a.cmp(b)<0) {
+		std::swap(a, b);
+		if (track) {
+			std::swap(M.m[0][0], M.m[1][0]);
+			std::swap(M.m[0][1], M.m[1][1]);
+		}
+	}
+}
+
+
+void BigIntGcd::apply(int64_t A, int64_t B, int64_t C, int64_t D) {
+	const BigInt bA = from(A), bB = from(B), bC = from(C), bD = from(D);
+	t0 = a * bA + b * bB;
+	t1 = a * bC + b * bD;
+	std::swap(a, t0);
+	std::swap(b, t1);
+	if (track) {
+		for (unsigned j = 0; j<2; ++j) {
+			t0 = M.m[0][j] * bA + M.m[1][j] * bB;
+			t1 = M.m[0][j] * bC + M.m[1][j] * bD;
+			std::swap(M.m[0][j], t0);
+			std::swap(M.m[1][j], t1);
+		}
+	}
+	fixup();
+}
+
+
+void BigIntGcd::apply(const GcdMatrix &S) {
+	t0 = a * S.m[0][0] + b * S.m[0][1];
+	t1 = a * S.m[1][0] + b * S.m[1][1];
+	std::swap(a, t0);
+	std::swap(b, t1);
+	if (track) {
+		for (unsigned j = 0; j<2; ++j) {
+			t0 = S.m[0][0] * M.m[0][j] + S.m[0][1] * M.m[1][j];
+			t1 = S.m[1][0] * M.m[0][j] + S.m[1][1] * M.m[1][j];
+			std::swap(M.m[0][j], t0);
+			std::swap(M.m[1][j], t1);
+		}
+	}
+	fixup();
+}
+
+
+
+/******************** Euclid and Lehmer ********************/
+void BigIntGcd::euclid_step() {
+	t0 = a;
+	t0.divmod(b, t1);
+	std::swap(a, b);
+	std::swap(b, t1);
+	if (track) {
+		for (unsigned j = 0; j<2; ++j) {
+			M.m[0][j] -= t0 * M.m[1][j];
+			std::swap(M.m[0][j], M.m[1][j]);
+		}
+	}
+}
+
+
+void BigIntGcd::lehmer_step(unsigned target) {
+	const unsigned abits = bits(a);
+	const unsigned shift = abits>62 ? abits - 62 : 0;
+	int64_t x = top(a, shift), y = top(b, shift);
+	int64_t A = 1, B = 0, C = 0, D = 1;
+
+	if (!shift) {
+		/* Numbers fit in 62 bits, all quotients are exact */
+		const int64_t limit = target ? (int64_t)1 << BigInt::LIMB_BITS : 1;
+		while (y>=limit) {
+			const int64_t q = x / y, T = x - q * y;
+			x = y; y = T;
+			const int64_t tA = A - q * C, tB = B - q * D;
+			A = C; B = D; C = tA; D = tB;
+		}
+	} else {
+		/* Knuth's algorithm L: accept quotient only if it is the same
+		   for both extreme values of the truncated bits */
+		while (y + C>0 && y + D>0) {
+			const int64_t q = (x + A) / (y + C);
+			if (q!=(x + B) / (y + D)) break;
+			const int64_t T = x - q * y;
+			x = y; y = T;
+			const int64_t tA = A - q * C, tB = B - q * D;
+			A = C; B = D; C = tA; D = tB;
+		}
+	}
+
+	if (B) {
+		apply(A, B, C, D);
+	} else {
+		euclid_step();
+	}
+}
+
+
+void BigIntGcd::reduce(unsigned target) {
+	while (b.sgn() && b.limbs_count()>target) lehmer_step(target);
+}
+
+
+
+/******************** Half-GCD ********************/
+void BigIntGcd::hgcd() {
+	const unsigned n = a.limbs_count(), target = n / 2 + 1;
+
+	/*
+	 * Reduce leading part of the numbers recursively and apply the
+	 * matrix to whole numbers.  Leading part of p limbs is reduced
+	 * by about p / 2 limbs so p is twice the distance to target but
+	 * no more than two thirds of the number so that subproblems get
+	 * smaller geometrically.
+	 */
+	while (n>=HGCD_THRESHOLD && b.limbs_count()>target) {
+		const unsigned an = a.limbs_count(), abits = bits(a);
+		unsigned p = 2 * (an - target);
+		if (p>2 * an / 3 + 1) p = 2 * an / 3 + 1;
+		if (p<HGCD_THRESHOLD / 2) break;
+
+		BigIntGcd sub(high(a, an - p), high(b, an - p), true);
+		sub.hgcd();
+		if (sub.M.identity()) break;
+		apply(sub.M);
+		if (bits(a)>=abits) break;
+	}
+
+	/* Finish with Lehmer's algorithm */
+	reduce(target);
+}
+
+
+void BigIntGcd::run() {
+	while (b.sgn() && b.limbs_count()>=HGCD_THRESHOLD) {
+		if (a.limbs_count()>b.limbs_count() + 1) {
+			euclid_step();
+		} else {
+			hgcd();
+		}
+	}
+	reduce(0);
+}
+
+
+
+/******************** BigInt methods ********************/
+BigInt &BigInt::gcd(const BigInt &n) {
+	/* Both are small */
+	if (!limbs && !n.limbs) {
+		DLimb x = small_value(), y = n.small_value();
+		while (y) {
+			const DLimb t = x % y;
+			x = y;
+			y = t;
+		}
+		set_small(1, x);
+		return *this;
+	}
+
+	BigIntGcd g(BigInt(*this).abs(), BigInt(n).abs(), false);
+	g.run();
+	return *this = std::move(g.a);
+}
+
+
+BigInt &BigInt::lcm(const BigInt &n) {
+	if (!sign || !n.sign) {
+		zero();
+	} else {
+		const BigInt g = ::mina86::gcd(*this, n);
+		div(g).mul(n).abs();
+	}
+	return *this;
+}
+
+
+BigInt &BigInt::gcdext(const BigInt &n, BigInt &s, BigInt &t) {
+	const BigInt x(*this), y(n);
+	const int xs = x.sign, ys = y.sign;
+
+	BigIntGcd g(BigInt(x).abs(), BigInt(y).abs(), true);
+	g.run();
+	*this = std::move(g.a);
+
+	/* (g, 0) = M * (|x|, |y|) */
+	BigInt u(std::move(g.M.m[0][0])), v(std::move(g.M.m[0][1]));
+	if (xs<0) u.neg();
+	if (ys<0) v.neg();
+	if (!ys) {
+		u.set((long)xs);
+		v.zero();
+	}
+
+	/* Make coefficients minimal: |u| <= |y| / (2 * gcd) */
+	if (ys && sign) {
+		BigInt yg(y);
+		yg.div(*this).abs();
+		u.mod(yg);
+		if (u.sgn()<0) u.add(yg);
+		const int half = BigInt(u).add(u).cmp(yg);
+		if (half>0) u.sub(yg);
+		/* v = (gcd - x * u) / y */
+		v = *this - x * u;
+		v.div(y);
+
+		/* If |u| is exactly |y| / (2 * gcd) both u and u - |y| / gcd
+		   are in range but only one of them gives |v| <= |x| / (2 *
+		   gcd); take the one with smaller |v| */
+		if (!half) {
+			BigInt u2(u), v2;
+			u2.sub(yg);
+			v2 = *this - x * u2;
+			v2.div(y);
+			if (::mina86::abs(v2).cmp(::mina86::abs(v))<0) {
+				u = std::move(u2);
+				v = std::move(v2);
+			}
+		}
+	}
+
+	s = std::move(u);
+	t = std::move(v);
+	return *this;
+}
+
+
+BigInt &BigInt::invmod(const BigInt &m) {
+	if (!m.sign) {
+		throw DivisionByZero();
+	}
+
+	/* Work on a copy so that the number is left intact if the
+	   inverse does not exist */
+	const BigInt mod_(m);
+	BigInt g(*this), s, t;
+	g.gcdext(mod_, s, t);
+	if (g.limbs || g.small_value()!=1) {
+		throw NotInvertible();
+	}
+
+	*this = std::move(s);
+	mod(mod_);
+	if (sign<0) {
+		if (mod_.sign>0) add(mod_); else sub(mod_);
+	}
+	return *this;
+}
+
+
+}
@@ -0,0 +1,158 @@
+/**
+ * \file
+ * BigInt Hash Key Header File.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ */
+
+#ifndef MN_BIGINT_KEY_HPP
+#define MN_BIGINT_KEY_HPP
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+#include "bigint.hpp"
+
+
+namespace mina86 {
+
+
+/**
+ * BigInt number with cached hash used as a key of unordered
+ * containers.  The hash is computed once when the value is set and
+ * serves as a fingerprint: keys with different fingerprints are
+ * unequal so most comparisons of unequal keys finish without looking
+ * at the limbs.  The number can be read but not modified in place;
+ * assigning a new value recomputes the fingerprint so it never gets
+ * stale.  BigInt itself does not cache the hash since every
+ * arithmetic operation would have to invalidate it.
+ *
+ * \sa BigInt::hash()
+ */
+class BigIntKey {
+	/** The number. */
+	BigInt number;
+	/** Hash of #number. */
+	std::size_t fingerprint;
+
+public:
+	/**
+	 * Creates key which value is zero.
+	 */
+	BigIntKey() : number(), fingerprint(number.hash()) { }
+
+	/**
+	 * Creates key with given value.
+	 *
+	 * \param[in] n value of the key
+	 */
+	BigIntKey(const BigInt &n) : number(n), fingerprint(n.hash()) { }
+
+	/**
+	 * Creates key moving value from an expiring number.
+	 *
+	 * \param[in] n value of the key
+	 */
+	BigIntKey(BigInt &&n)
+		: number(std::move(n)), fingerprint(number.hash()) { }
+
+
+	/**
+	 * Sets value of the key and recomputes its fingerprint.
+	 *
+	 * \param[in] n new value
+	 * \return reference to this object
+	 */
+	BigIntKey &operator=(const BigInt &n) {
+		number = n;
+		fingerprint = number.hash();
+		return *this;
+	}
+
+	/**
+	 * Moves value of an expiring number to the key and recomputes its
+	 * fingerprint.
+	 *
+	 * \param[in] n new value
+	 * \return reference to this object
+	 */
+	BigIntKey &operator=(BigInt &&n) {
+		number = std::move(n);
+		fingerprint = number.hash();
+		return *this;
+	}
+
+
+	/**
+	 * Returns value of the key.
+	 *
+	 * \return the number
+	 */
+	const BigInt &get() const { return number; }
+
+	/**
+	 * Returns value of the key.
+	 *
+	 * \return the number
+	 */
+	operator const BigInt &() const { return number; }
+
+	/**
+	 * Returns cached hash of the number.
+	 *
+	 * \return hash equal to <code>get().hash()</code>
+	 */
+	std::size_t hash() const { return fingerprint; }
+
+
+	/**
+	 * Compares two keys.  Fingerprints are compared first so only
+	 * keys which are most likely equal have their limbs compared.
+	 *
+	 * \param[in] k the other key
+	 * \return \c true if keys are equal
+	 */
+	bool operator==(const BigIntKey &k) const {
+		return fingerprint==k.fingerprint && !number.cmp(k.number);
+	}
+
+	/**
+	 * Compares two keys.
+	 *
+	 * \param[in] k the other key
+	 * \return \c true if keys are not equal
+	 * \sa operator==()
+	 */
+	bool operator!=(const BigIntKey &k) const { return !(*this==k); }
+};
+
+
+}
+
+
+namespace std {
+
+/**
+ * Hash function object for BigIntKey returning its cached
+ * fingerprint.
+ *
+ * \sa mina86::BigIntKey::hash()
+ */
+template<> struct hash<mina86::BigIntKey> {
+	/**
+	 * Returns hash of a key.
+	 *
+	 * \param[in] k key
+	 * \return hash of \a k
+	 */
+	std::size_t operator()(const mina86::BigIntKey &k) const {
+		return k.hash();
+	}
+};
+
+}
+
+
+#endif
@@ -0,0 +1,742 @@
+/**
+ * \file
+ * BigInt Limb Routines Header File.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * Low-level routines operating on vectors of limbs used by BigInt
+ * implementation.  Vectors are given as a pointer to the least
+ * significant limb and number of limbs.  This is an internal header
+ * and should not be included by BigInt users.
+ */
+
+#ifndef MN_BIGINT_LIMB_HPP
+#define MN_BIGINT_LIMB_HPP
+
+#include "bigint.hpp"
+
+
+namespace mina86 {
+
+
+typedef BigInt::Limb  Limb;
+typedef BigInt::DLimb DLimb;
+
+
+
+/******************** Vector kernels ********************/
+/**
+ * Instruction sets vector kernels of limbs_add_n() and limbs_sub_n()
+ * may use, from the least capable.
+ */
+enum LimbsSimd { LIMBS_SCALAR, LIMBS_SSE2, LIMBS_AVX2, LIMBS_AVX512 };
+
+/**
+ * Number of limbs from which limbs_add_n() and limbs_sub_n() call
+ * vector kernels.
+ */
+static const unsigned SIMD_LIMBS = 16;
+
+/**
+ * Returns the most capable instruction set the processor supports.
+ *
+ * \return instruction set
+ */
+LimbsSimd limbs_simd_best();
+
+/**
+ * Selects kernels limbs_add_n_simd() and limbs_sub_n_simd() use.  By
+ * default kernels for limbs_simd_best() are used; this is meant for
+ * testing all kernels.  The setting is global.
+ *
+ * \param[in] simd instruction set, must be supported by the processor
+ */
+void limbs_simd_use(LimbsSimd simd);
+
+/**
+ * Returns instruction set kernels currently use.  Other vector code
+ * (eg. BigIntBatch) follows it as well.
+ *
+ * \return instruction set
+ * \sa limbs_simd_use()
+ */
+LimbsSimd limbs_simd_current();
+
+/**
+ * Adds two limb vectors of equal length using vector instructions.
+ * Sums of whole vectors of limbs are computed at once and carries
+ * between limbs of a vector are found with a single addition of
+ * masks of limbs which generate and propagate a carry.  \a r may be
+ * the same as \a a or \a b.
+ *
+ * \param[out] r result (\a n limbs)
+ * \param[in] a first operand
+ * \param[in] b second operand
+ * \param[in] n number of limbs
+ * \return carry
+ * \sa limbs_add_n()
+ */
+Limb limbs_add_n_simd(Limb *r, const Limb *a, const Limb *b, unsigned n);
+
+/**
+ * Substracts two limb vectors of equal length using vector
+ * instructions.  Borrows are found the same way limbs_add_n_simd()
+ * finds carries.  \a r may be the same as \a a or \a b.
+ *
+ * \param[out] r result (\a n limbs)
+ * \param[in] a minuend
+ * \param[in] b subtrahend
+ * \param[in] n number of limbs
+ * \return borrow
+ * \sa limbs_sub_n()
+ */
+Limb limbs_sub_n_simd(Limb *r, const Limb *a, const Limb *b, unsigned n);
+
+
+
+/******************** Limb routines ********************/
+/**
+ * Adds two limb vectors of equal length one limb at a time.  \a r
+ * may be the same as \a a or \a b.
+ *
+ * \param[out] r result (\a n limbs)
+ * \param[in] a first operand
+ * \param[in] b second operand
+ * \param[in] n number of limbs
+ * \return carry
+ */
+inline Limb limbs_add_n_basecase(Limb *r, const Limb *a, const Limb *b,
+                                 unsigned n) {
+	DLimb t = 0;
+	for (unsigned i = 0; i<n; ++i) {
+		t += (DLimb)a[i] + b[i];
+		r[i] = (Limb)t;
+		t >>= BigInt::LIMB_BITS;
+	}
+	return (Limb)t;
+}
+
+/**
+ * Adds two limb vectors of equal length.  Long vectors are added
+ * with limbs_add_n_simd().  \a r may be the same as \a a or \a b.
+ *
+ * \param[out] r result (\a n limbs)
+ * \param[in] a first operand
+ * \param[in] b second operand
+ * \param[in] n number of limbs
+ * \return carry
+ */
+inline Limb limbs_add_n(Limb *r, const Limb *a, const Limb *b, unsigned n) {
+	return n<SIMD_LIMBS ? limbs_add_n_basecase(r, a, b, n)
+		: limbs_add_n_simd(r, a, b, n);
+}
+
+/**
+ * Adds a single limb to a limb vector.  \a r may be the same as \a
+ * a.
+ *
+ * \param[out] r result (\a n limbs)
+ * \param[in] a limb vector
+ * \param[in] n number of limbs
+ * \param[in] c limb to add
+ * \return carry
+ */
+inline Limb limbs_add_1(Limb *r, const Limb *a, unsigned n, Limb c) {
+	unsigned i = 0;
+	for (; c && i<n; ++i) {
+		r[i] = a[i] + c;
+		c = r[i] < c;
+	}
+	if (r!=a) {
+		for (; i<n; ++i) r[i] = a[i];
+	}
+	return c;
+}
+
+/**
+ * Substracts two limb vectors of equal length one limb at a time.
+ * \a r may be the same as \a a or \a b.
+ *
+ * \param[out] r result (\a n limbs)
+ * \param[in] a minuend
+ * \param[in] b subtrahend
+ * \param[in] n number of limbs
+ * \return borrow
+ */
+inline Limb limbs_sub_n_basecase(Limb *r, const Limb *a, const Limb *b,
+                                 unsigned n) {
+	Limb borrow = 0;
+	for (unsigned i = 0; i<n; ++i) {
+		const Limb x = a[i], y = b[i];
+		r[i] = x - y - borrow;
+		borrow = x < y || (x == y && borrow);
+	}
+	return borrow;
+}
+
+/**
+ * Substracts two limb vectors of equal length.  Long vectors are
+ * substracted with limbs_sub_n_simd().  \a r may be the same as \a
+ * a or \a b.
+ *
+ * \param[out] r result (\a n limbs)
+ * \param[in] a minuend
+ * \param[in] b subtrahend
+ * \param[in] n number of limbs
+ * \return borrow
+ */
+inline Limb limbs_sub_n(Limb *r, const Limb *a, const Limb *b, unsigned n) {
+	return n<SIMD_LIMBS ? limbs_sub_n_basecase(r, a, b, n)
+		: limbs_sub_n_simd(r, a, b, n);
+}
+
+/**
+ * Substracts a single limb from a limb vector.  \a r may be the same
+ * as \a a.
+ *
+ * \param[out] r result (\a n limbs)
+ * \param[in] a limb vector
+ * \param[in] n number of limbs
+ * \param[in] b limb to substract
+ * \return borrow
+ */
+inline Limb limbs_sub_1(Limb *r, const Limb *a, unsigned n, Limb b) {
+	unsigned i = 0;
+	for (; b && i<n; ++i) {
+		const Limb x = a[i];
+		r[i] = x - b;
+		b = x < b;
+	}
+	if (r!=a) {
+		for (; i<n; ++i) r[i] = a[i];
+	}
+	return b;
+}
+
+/**
+ * Adds two limb vectors.  \a r may be the same as \a a or \a b.
+ *
+ * \param[out] r result (\a an limbs)
+ * \param[in] a first operand
+ * \param[in] an number of limbs in \a a
+ * \param[in] b second operand
+ * \param[in] bn number of limbs in \a b, must not be greater then \a an
+ * \return carry
+ */
+inline Limb limbs_add(Limb *r, const Limb *a, unsigned an,
+                      const Limb *b, unsigned bn) {
+	const Limb c = limbs_add_n(r, a, b, bn);
+	return limbs_add_1(r + bn, a + bn, an - bn, c);
+}
+
+/**
+ * Substracts two limb vectors.  \a r may be the same as \a a or \a
+ * b.
+ *
+ * \param[out] r result (\a an limbs)
+ * \param[in] a minuend
+ * \param[in] an number of limbs in \a a
+ * \param[in] b subtrahend
+ * \param[in] bn number of limbs in \a b, must not be greater then \a an
+ * \return borrow
+ */
+inline Limb limbs_sub(Limb *r, const Limb *a, unsigned an,
+                      const Limb *b, unsigned bn) {
+	const Limb c = limbs_sub_n(r, a, b, bn);
+	return limbs_sub_1(r + bn, a + bn, an - bn, c);
+}
+
+/**
+ * Compares two limb vectors of equal length.
+ *
+ * \param[in] a first vector
+ * \param[in] b second vector
+ * \param[in] n number of limbs
+ * \return \c -1, \c 0 or \c 1 if \a a is lower, equal or greater
+ *         then \a b
+ */
+inline int limbs_cmp(const Limb *a, const Limb *b, unsigned n) {
+	while (n && a[n - 1]==b[n - 1]) --n;
+	return n ? a[n - 1] < b[n - 1] ? -1 : 1 : 0;
+}
+
+/**
+ * Multiplies limb vector by a single limb and adds result to
+ * another vector.
+ *
+ * \param[in,out] r vector to add result to (\a n limbs)
+ * \param[in] a limb vector
+ * \param[in] n number of limbs
+ * \param[in] b multiplier
+ * \return carry (the limb which did not fit in \a r)
+ */
+inline Limb limbs_addmul_1(Limb *r, const Limb *a, unsigned n, Limb b) {
+	DLimb t = 0;
+	for (unsigned i = 0; i<n; ++i) {
+		t += (DLimb)a[i] * b + r[i];
+		r[i] = (Limb)t;
+		t >>= BigInt::LIMB_BITS;
+	}
+	return (Limb)t;
+}
+
+/**
+ * Multiplies limb vector by a single limb.  \a r may be the same as
+ * \a a.
+ *
+ * \param[out] r result (\a n limbs)
+ * \param[in] a limb vector
+ * \param[in] n number of limbs
+ * \param[in] b multiplier
+ * \param[in] c limb to add to the product
+ * \return carry (the limb which did not fit in \a r)
+ */
+inline Limb limbs_mul_1(Limb *r, const Limb *a, unsigned n, Limb b,
+                        Limb c = 0) {
+	DLimb t = c;
+	for (unsigned i = 0; i<n; ++i) {
+		t += (DLimb)a[i] * b;
+		r[i] = (Limb)t;
+		t >>= BigInt::LIMB_BITS;
+	}
+	return (Limb)t;
+}
+
+/**
+ * Multiplies limb vector by a two limb number.  \a r may be the same
+ * as \a a.
+ *
+ * \param[out] r result (\a n limbs)
+ * \param[in] a limb vector
+ * \param[in] n number of limbs
+ * \param[in] b multiplier
+ * \return carry (the two limbs which did not fit in \a r)
+ */
+inline DLimb limbs_mul_2(Limb *r, const Limb *a, unsigned n, DLimb b) {
+	const Limb b0 = (Limb)b, b1 = (Limb)(b >> BigInt::LIMB_BITS);
+	DLimb t = 0;
+	for (unsigned i = 0; i<n; ++i) {
+		const DLimb lo = (DLimb)a[i] * b0 + (Limb)t;
+		t = (DLimb)a[i] * b1 + (t >> BigInt::LIMB_BITS)
+			+ (lo >> BigInt::LIMB_BITS);
+		r[i] = (Limb)lo;
+	}
+	return t;
+}
+
+/**
+ * Multiplies limb vector by a single limb and substracts result from
+ * another vector.
+ *
+ * \param[in,out] r vector to substract result from (\a n limbs)
+ * \param[in] a limb vector
+ * \param[in] n number of limbs
+ * \param[in] b multiplier
+ * \return borrow (the limb which should be substracted from limb
+ *         following \a r)
+ */
+inline Limb limbs_submul_1(Limb *r, const Limb *a, unsigned n, Limb b) {
+	Limb c = 0;
+	for (unsigned i = 0; i<n; ++i) {
+		const DLimb p = (DLimb)a[i] * b + c;
+		const Limb lo = (Limb)p, x = r[i];
+		r[i] = x - lo;
+		c = (Limb)(p >> BigInt::LIMB_BITS) + (x < lo);
+	}
+	return c;
+}
+
+/**
+ * Counts leading zero bits in a limb.
+ *
+ * \param[in] x limb, must not be zero
+ * \return number of most significant bits which are zero
+ */
+inline unsigned limb_clz(Limb x) {
+	unsigned n = 0;
+	for (unsigned bits = BigInt::LIMB_BITS / 2; bits; bits >>= 1) {
+		if (!(x >> (BigInt::LIMB_BITS - bits))) {
+			n += bits;
+			x <<= bits;
+		}
+	}
+	return n;
+}
+
+/**
+ * Shifts limb vector left by given number of bits.  \a r may be the
+ * same as \a a.
+ *
+ * \param[out] r result (\a n limbs)
+ * \param[in] a limb vector
+ * \param[in] n number of limbs, must be at least one
+ * \param[in] bits number of bits to shift by, must be in range
+ *                 [1, LIMB_BITS)
+ * \return bits shifted out of the most significant limb
+ */
+inline Limb limbs_lshift(Limb *r, const Limb *a, unsigned n, unsigned bits) {
+	const unsigned rbits = BigInt::LIMB_BITS - bits;
+	const Limb out = a[n - 1] >> rbits;
+	while (--n) {
+		r[n] = (a[n] << bits) | (a[n - 1] >> rbits);
+	}
+	r[0] = a[0] << bits;
+	return out;
+}
+
+/**
+ * Shifts limb vector right by given number of bits.  \a r may be the
+ * same as \a a.
+ *
+ * \param[out] r result (\a n limbs)
+ * \param[in] a limb vector
+ * \param[in] n number of limbs, must be at least one
+ * \param[in] bits number of bits to shift by, must be in range
+ *                 [1, LIMB_BITS)
+ * \return bits shifted out of the least significant limb (in the most
+ *         significant bits of returned limb)
+ */
+inline Limb limbs_rshift(Limb *r, const Limb *a, unsigned n, unsigned bits) {
+	const unsigned lbits = BigInt::LIMB_BITS - bits;
+	const Limb out = a[0] << lbits;
+	for (unsigned i = 0; i + 1<n; ++i) {
+		r[i] = (a[i] >> bits) | (a[i + 1] << lbits);
+	}
+	r[n - 1] = a[n - 1] >> bits;
+	return out;
+}
+
+
+
+/******************** Division ********************/
+/**
+ * Divides limb vector by a single limb.  Uses precomputed reciprocal
+ * of the divisor so no hardware division is done in the loop.  \a q
+ * may be the same as \a a.
+ *
+ * \param[out] q quotient (\a n limbs), may be null if only remainder
+ *               is needed
+ * \param[in] a dividend
+ * \param[in] n number of limbs
+ * \param[in] d divisor, must not be zero
+ * \return remainder
+ */
+Limb limbs_divmod_1(Limb *q, const Limb *a, unsigned n, Limb d);
+
+/**
+ * Divides limb vector by a two limb number in a single pass without
+ * allocating any memory.  \a q may be the same as \a a.
+ *
+ * \param[out] q quotient (\a n limbs), may be null if only remainder
+ *               is needed
+ * \param[in] a dividend
+ * \param[in] n number of limbs
+ * \param[in] d divisor, must not fit in a single limb
+ * \return remainder
+ */
+DLimb limbs_divmod_2(Limb *q, const Limb *a, unsigned n, DLimb d);
+
+/**
+ * Divides two limb vectors.  Uses limbs_divmod_1() for single limb
+ * divisors, Knuth's algorithm D for small operands and
+ * Burnikel-Ziegler recursive division for big ones.  \a q and \a r
+ * must not overlap with \a a nor \a b.
+ *
+ * \param[out] q quotient (\a an - \a bn + 1 limbs)
+ * \param[out] r remainder (\a bn limbs)
+ * \param[in] a dividend
+ * \param[in] an number of limbs in \a a
+ * \param[in] b divisor
+ * \param[in] bn number of limbs in \a b, must be at least one and not
+ *               greater then \a an; the most significant limb must
+ *               not be zero
+ */
+void limbs_div_qr(Limb *q, Limb *r, const Limb *a, unsigned an,
+                  const Limb *b, unsigned bn);
+
+
+
+/******************** Exponentiation ********************/
+/**
+ * Raises limb vector to a power modulo another limb vector.  Odd
+ * moduli use Montgomery multiplication, even ones use limbs_div_qr().
+ * Exponent is scanned using sliding window.
+ *
+ * \param[out] r result (\a n limbs), may have most significant zero
+ *               limbs
+ * \param[in] a base, must be less than \a m
+ * \param[in] an number of limbs in \a a, must be at least one and not
+ *               greater than \a n
+ * \param[in] e exponent
+ * \param[in] en number of limbs in \a e, must be at least one; the
+ *               most significant limb must not be zero
+ * \param[in] m modulus, must be greater than one
+ * \param[in] n number of limbs in \a m; the most significant limb
+ *              must not be zero
+ */
+void limbs_powmod(Limb *r, const Limb *a, unsigned an, const Limb *e,
+                  unsigned en, const Limb *m, unsigned n);
+
+/**
+ * Runs single round of Miller-Rabin test, ie. checks whether \a m is
+ * a strong probable prime to base \a a.  Writing <code>m - 1 = d *
+ * 2^s</code> with odd \c d, \a m passes if <code>a^d</code> is one
+ * or any of <code>a^(d * 2^i)</code> for \c i less than \c s is minus
+ * one modulo \a m.  Primes always pass while at most a quarter of
+ * bases let an odd composite pass.  Computation is done with
+ * Montgomery multiplication.
+ *
+ * \param[in] m number to test, must be odd and greater than three
+ * \param[in] n number of limbs in \a m; the most significant limb
+ *              must not be zero
+ * \param[in] a base, must be greater than one and less than \a m
+ * \param[in] an number of limbs in \a a, must be at least one and not
+ *               greater than \a n; the most significant limb must
+ *               not be zero
+ * \return \c true if \a m is a strong probable prime to base \a a
+ */
+bool limbs_sprp(const Limb *m, unsigned n, const Limb *a, unsigned an);
+
+
+
+/******************** Radix conversion ********************/
+/**
+ * Returns number of characters sufficient to hold digits of a \a n
+ * limbs long vector written in given base.
+ *
+ * \param[in] n number of limbs
+ * \param[in] base base, from 2 to 36
+ * \return upper bound of number of digits
+ */
+unsigned limbs_get_str_size(unsigned n, unsigned base);
+
+/**
+ * Converts limb vector into digits in given base.  Digits are written
+ * backwards (ie. the least significant digit at <code>end[-1]</code>)
+ * as their values (not ASCII characters).  Power of two bases are
+ * converted in linear time, other bases are converted by dividing
+ * number by precomputed powers of base and converting quotient and
+ * remainder recursively.
+ *
+ * \param[in] end pointer one past the place for the least significant
+ *                digit; there must be at least limbs_get_str_size()
+ *                characters before it
+ * \param[in] a limb vector
+ * \param[in] n number of limbs, must be at least one; the most
+ *              significant limb must not be zero
+ * \param[in] base base, from 2 to 36
+ * \return pointer to the most significant digit
+ */
+char *limbs_get_str(char *end, const Limb *a, unsigned n, unsigned base);
+
+/**
+ * Converts limb vector into digits in given base using repeated
+ * division by a single limb.  Works the same way as limbs_get_str()
+ * but takes quadratic time.
+ *
+ * \param[in] end pointer one past the place for the least significant
+ *                digit
+ * \param[in] a limb vector
+ * \param[in] n number of limbs, must be at least one; the most
+ *              significant limb must not be zero
+ * \param[in] base base, from 2 to 36
+ * \return pointer to the most significant digit
+ */
+char *limbs_get_str_basecase(char *end, const Limb *a, unsigned n,
+                             unsigned base);
+
+/**
+ * Returns number of limbs sufficient to hold number consisting of \a
+ * len digits in given base.
+ *
+ * \param[in] len number of digits
+ * \param[in] base base, from 2 to 36
+ * \return upper bound of number of limbs
+ */
+unsigned limbs_set_str_size(unsigned len, unsigned base);
+
+/**
+ * Converts digits in given base into limb vector.  Digits are in
+ * "natural" order (ie. the most significant first) and are given as
+ * their values (not ASCII characters).  Power of two bases are
+ * converted in linear time, other bases are converted by splitting
+ * digits in halves, converting them recursively and combining them
+ * with a multiplication by a precomputed power of base.
+ *
+ * \param[out] r result (limbs_set_str_size() limbs)
+ * \param[in] str digits, each must be less then \a base
+ * \param[in] len number of digits
+ * \param[in] base base, from 2 to 36
+ * \return number of limbs in result with most significant zero limbs
+ *         stripped
+ */
+unsigned limbs_set_str(Limb *r, const char *str, unsigned len,
+                       unsigned base);
+
+/**
+ * Converts digits in given base into limb vector using repeated
+ * multiplication by a single limb.  Works the same way as
+ * limbs_set_str() but takes quadratic time.
+ *
+ * \param[out] r result (limbs_set_str_size() limbs)
+ * \param[in] str digits, each must be less then \a base
+ * \param[in] len number of digits
+ * \param[in] base base, from 2 to 36
+ * \return number of limbs in result with most significant zero limbs
+ *         stripped
+ */
+unsigned limbs_set_str_basecase(Limb *r, const char *str, unsigned len,
+                                unsigned base);
+
+
+
+/******************** Multiplication ********************/
+/**
+ * Multiplies two limb vectors.  Picks the fastest algorithm for given
+ * operand sizes.  \a r must not overlap with \a a nor \a b.
+ *
+ * \param[out] r product (\a an + \a bn limbs)
+ * \param[in] a first factor
+ * \param[in] an number of limbs in \a a
+ * \param[in] b second factor
+ * \param[in] bn number of limbs in \a b, must be at least one
+ */
+void limbs_mul(Limb *r, const Limb *a, unsigned an,
+               const Limb *b, unsigned bn);
+
+/**
+ * Multiplies two limb vectors using schoolbook algorithm.  \a r must
+ * not overlap with \a a nor \a b.
+ *
+ * \param[out] r product (\a an + \a bn limbs)
+ * \param[in] a first factor
+ * \param[in] an number of limbs in \a a
+ * \param[in] b second factor
+ * \param[in] bn number of limbs in \a b, must be at least one
+ */
+void limbs_mul_basecase(Limb *r, const Limb *a, unsigned an,
+                        const Limb *b, unsigned bn);
+
+
+/**
+ * Maximal number of limbs in a product computed by limbs_mul_ntt(),
+ * ie. maximal value of \a an + \a bn.
+ */
+static const unsigned NTT_MAX_LIMBS = 1u << 23;
+
+/**
+ * Multiplies two limb vectors using number-theoretic transform.  \a
+ * r must not overlap with \a a nor \a b.
+ *
+ * \param[out] r product (\a an + \a bn limbs)
+ * \param[in] a first factor
+ * \param[in] an number of limbs in \a a
+ * \param[in] b second factor
+ * \param[in] bn number of limbs in \a b, \a an + \a bn must not be
+ *               greater then #NTT_MAX_LIMBS
+ * \param[in] threads maximal number of threads to use
+ */
+void limbs_mul_ntt(Limb *r, const Limb *a, unsigned an,
+                   const Limb *b, unsigned bn, unsigned threads = 1);
+
+
+/**
+ * Squares limb vector.  Picks the fastest algorithm for given operand
+ * size.  \a r must not overlap with \a a.
+ *
+ * \param[out] r square (2 * \a n limbs)
+ * \param[in] a limb vector
+ * \param[in] n number of limbs in \a a, must be at least one
+ */
+void limbs_sqr(Limb *r, const Limb *a, unsigned n);
+
+/**
+ * Squares limb vector using schoolbook algorithm.  Each product of
+ * two different limbs is computed only once.  \a r must not overlap
+ * with \a a.
+ *
+ * \param[out] r square (2 * \a n limbs)
+ * \param[in] a limb vector
+ * \param[in] n number of limbs in \a a, must be at least one
+ */
+void limbs_sqr_basecase(Limb *r, const Limb *a, unsigned n);
+
+/**
+ * Squares limb vector using number-theoretic transform.  \a r must
+ * not overlap with \a a.
+ *
+ * \param[out] r square (2 * \a n limbs)
+ * \param[in] a limb vector
+ * \param[in] n number of limbs in \a a, 2 * \a n must not be greater
+ *              then #NTT_MAX_LIMBS
+ * \param[in] threads maximal number of threads to use
+ */
+void limbs_sqr_ntt(Limb *r, const Limb *a, unsigned n, unsigned threads = 1);
+
+
+
+/******************** Threads ********************/
+/**
+ * Runs tasks in parallel.  At most \a threads threads (including the
+ * calling one) pick tasks in order until all are done.  If any task
+ * throws, the first exception is rethrown once all threads finish.
+ * If a thread cannot be created remaining tasks are run by the
+ * threads which already exist.
+ *
+ * \param[in] tasks tasks to run
+ * \param[in] n number of tasks
+ * \param[in] threads maximal number of threads to use
+ */
+void limbs_parallel(const std::function<void()> *tasks, unsigned n,
+                    unsigned threads);
+
+
+
+/******************** Memory ********************/
+/**
+ * Allocates limb buffer from the pool.  Buffers which become limbs of
+ * a number (ie. are passed to Array::set_no_copy()) must be allocated
+ * with this function.
+ *
+ * \param[in] n number of limbs
+ * \return pointer to allocated memory
+ * \sa limbs_free(), BigInt::Pool
+ */
+inline Limb *limbs_alloc(unsigned n) {
+	return BigInt::Pool::allocate(n);
+}
+
+/**
+ * Frees limb buffer allocated with limbs_alloc().
+ *
+ * \param[in] p pointer to allocated memory or null pointer
+ * \param[in] n number of limbs passed to limbs_alloc()
+ */
+inline void limbs_free(Limb *p, unsigned n) {
+	BigInt::Pool::deallocate(p, n);
+}
+
+/**
+ * Allocates scratch buffer which is freed before the operation which
+ * needs it returns.  If a BigIntArena exists in the calling thread
+ * the buffer is taken from it, otherwise from the pool.
+ *
+ * \param[in] n number of limbs
+ * \return pointer to allocated memory
+ * \sa limbs_scratch_free()
+ */
+Limb *limbs_scratch(unsigned n);
+
+/**
+ * Frees scratch buffer allocated with limbs_scratch().
+ *
+ * \param[in] p pointer to allocated memory or null pointer
+ * \param[in] n number of limbs passed to limbs_scratch()
+ */
+void limbs_scratch_free(Limb *p, unsigned n);
+
+
+}
+
+#endif
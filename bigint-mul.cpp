@@ -0,0 +1,819 @@
+/**
+ * \file
+ * BigInt Multiplication.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * Multiplication of limb vectors.  Small operands are multiplied
+ * using schoolbook algorithm, bigger ones using Karatsuba and
+ * Toom-Cook 3-way algorithms and huge ones using number-theoretic
+ * transform (see bigint-ntt.cpp).  Squaring has its own variant of
+ * each algorithm which computes every cross product only once.
+ * Unbalanced operands are split into chunks of the size of the
+ * shorter operand.  All temporary vectors needed by the recursion are
+ * carved out of a single scratch area allocated once per limbs_mul()
+ * or limbs_sqr() call.  If BigInt::setThreads() allows, sub-products
+ * of big Toom-Cook products are computed in parallel, each with its
+ * own scratch area.
+ */
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+#include "bigint-limb.hpp"
+
+
+namespace mina86 {
+
+
+/**
+ * Operand size (in limbs) from which Karatsuba algorithm is used.
+ */
+static const unsigned KARATSUBA_THRESHOLD = 32;
+
+/**
+ * Operand size (in limbs) from which Toom-Cook 3-way algorithm is
+ * used.
+ */
+static const unsigned TOOM3_THRESHOLD = 160;
+
+/**
+ * Operand size (in limbs) from which Karatsuba algorithm is used for
+ * squaring.
+ */
+static const unsigned SQR_KARATSUBA_THRESHOLD = 48;
+
+/**
+ * Operand size (in limbs) from which Toom-Cook 3-way algorithm is
+ * used for squaring.
+ */
+static const unsigned SQR_TOOM3_THRESHOLD = 192;
+
+/**
+ * Operand size (in limbs) from which number-theoretic transform is
+ * used.
+ */
+static const unsigned NTT_THRESHOLD = 2048;
+
+/**
+ * Operand size (in limbs) from which sub-products of Toom-Cook
+ * algorithm are computed in parallel if more then one thread is
+ * allowed.  Below it starting a thread costs more then it saves.
+ */
+static const unsigned PARALLEL_THRESHOLD = 512;
+
+
+
+/******************** Threads ********************/
+/**
+ * Number of threads multiplication may use, set by
+ * BigInt::setThreads().
+ */
+static thread_local unsigned mul_threads = 1;
+
+
+void BigInt::setThreads(unsigned n) {
+	mul_threads = n ? n : 1;
+}
+
+
+unsigned BigInt::getThreads() {
+	return mul_threads;
+}
+
+
+void limbs_parallel(const std::function<void()> *tasks, unsigned n,
+                    unsigned threads) {
+	std::atomic<unsigned> next(0);
+	std::exception_ptr error;
+	std::mutex lock;
+	const auto worker = [&] {
+		for (unsigned i; (i = next++)<n; ) {
+			try {
+				tasks[i]();
+			} catch (...) {
+				std::lock_guard<std::mutex> guard(lock);
+				if (!error) error = std::current_exception();
+			}
+		}
+	};
+
+	if (threads>n) threads = n;
+	std::thread *const pool = threads>1 ? new std::thread[threads - 1] : 0;
+	unsigned started = 0;
+	for (; started + 1<threads; ++started) {
+		try {
+			pool[started] = std::thread(worker);
+		} catch (const std::system_error &) {
+			break;
+		}
+	}
+	worker();
+	for (unsigned i = 0; i<started; ++i) pool[i].join();
+	delete[] pool;
+
+	if (error) std::rethrow_exception(error);
+}
+
+
+/**
+ * Returns number of threads each of parallel tasks may use.
+ *
+ * \param[in] threads number of threads available
+ * \param[in] n number of tasks
+ * \return number of threads per task, at least one
+ */
+static unsigned threads_share(unsigned threads, unsigned n) {
+	return threads>n ? threads / n : 1;
+}
+
+
+
+/******************** Helpers ********************/
+/**
+ * Computes absolute value of difference of two limb vectors.
+ *
+ * \param[out] r result (\a an limbs)
+ * \param[in] a first operand
+ * \param[in] an number of limbs in \a a
+ * \param[in] b second operand
+ * \param[in] bn number of limbs in \a b, must not be greater then \a an
+ * \return \c true if \a a was lower then \a b
+ */
+static bool limbs_abs_diff(Limb *r, const Limb *a, unsigned an,
+                           const Limb *b, unsigned bn) {
+	while (an>bn && !a[an - 1]) {
+		r[--an] = 0;
+	}
+	if (an==bn && limbs_cmp(a, b, bn)<0) {
+		limbs_sub_n(r, b, a, bn);
+		return true;
+	}
+	limbs_sub(r, a, an, b, bn);
+	return false;
+}
+
+/**
+ * Negates limb vector treating it as a number in two's complement.
+ * \a r may be the same as \a a.
+ *
+ * \param[out] r result (\a n limbs)
+ * \param[in] a limb vector
+ * \param[in] n number of limbs
+ */
+static void limbs_neg(Limb *r, const Limb *a, unsigned n) {
+	unsigned i = 0;
+	for (; i<n && !a[i]; ++i) r[i] = 0;
+	if (i<n) {
+		r[i] = -a[i];
+		for (++i; i<n; ++i) r[i] = ~a[i];
+	}
+}
+
+/**
+ * Checks whether limb vector is negative when treated as a number in
+ * two's complement.
+ *
+ * \param[in] a limb vector
+ * \param[in] n number of limbs
+ * \return \c true if the most significant bit is set
+ */
+static bool limbs_is_neg(const Limb *a, unsigned n) {
+	return a[n - 1] >> (BigInt::LIMB_BITS - 1);
+}
+
+/**
+ * Divides limb vector by two treating it as a number in two's
+ * complement.  The number must be even.
+ *
+ * \param[in,out] a limb vector
+ * \param[in] n number of limbs
+ */
+static void limbs_half(Limb *a, unsigned n) {
+	const Limb top = a[n - 1] & ((Limb)1 << (BigInt::LIMB_BITS - 1));
+	limbs_rshift(a, a, n, 1);
+	a[n - 1] |= top;
+}
+
+/**
+ * Divides limb vector by three.  The number must be divisible by
+ * three.  Works for numbers in two's complement as well.
+ *
+ * \param[in,out] a limb vector
+ * \param[in] n number of limbs
+ */
+static void limbs_divexact_3(Limb *a, unsigned n) {
+	/* 3 * INV3 = 1 (mod 2^32) */
+	static const Limb INV3 = 0xAAAAAAABu;
+	Limb c = 0;
+	for (unsigned i = 0; i<n; ++i) {
+		const Limb x = a[i], s = x - c;
+		c = x < c;
+		const Limb q = s * INV3;
+		a[i] = q;
+		c += (Limb)(((DLimb)q * 3) >> BigInt::LIMB_BITS);
+	}
+}
+
+
+
+/******************** Schoolbook ********************/
+void limbs_mul_basecase(Limb *r, const Limb *a, unsigned an,
+                        const Limb *b, unsigned bn) {
+	r[an] = limbs_mul_1(r, a, an, b[0]);
+	for (unsigned i = 1; i<bn; ++i) {
+		r[an + i] = limbs_addmul_1(r + i, a, an, b[i]);
+	}
+}
+
+
+
+/******************** Balanced multiplication ********************/
+static void mul_n(Limb *r, const Limb *a, const Limb *b, unsigned n,
+                  Limb *scratch, unsigned threads);
+
+
+/**
+ * Returns size of scratch area needed by mul_n().  Since recursion
+ * calls mul_n() for operands of slightly different sizes the maximum
+ * of their requirements is taken.
+ *
+ * \param[in] n number of limbs in each operand
+ * \return number of limbs of scratch space required
+ */
+static unsigned mul_n_scratch(unsigned n) {
+	if (n<KARATSUBA_THRESHOLD) {
+		return 0;
+	} else if (n>=NTT_THRESHOLD && 2 * n<=NTT_MAX_LIMBS) {
+		return 0;
+	} else if (n<TOOM3_THRESHOLD) {
+		const unsigned h = n - n / 2, l = n / 2;
+		const unsigned sh = mul_n_scratch(h), sl = mul_n_scratch(l);
+		return 4 * h + 1 + (sh > sl ? sh : sl);
+	} else {
+		const unsigned k = (n + 2) / 3, s = n - 2 * k;
+		unsigned m = mul_n_scratch(k + 1), t;
+		if ((t = mul_n_scratch(k))>m) m = t;
+		if (s!=k && (t = mul_n_scratch(s))>m) m = t;
+		return 3 * (2 * k + 2) + 2 * (k + 1) + m;
+	}
+}
+
+
+/**
+ * Multiplies two limb vectors of equal length using Karatsuba
+ * algorithm.  Each operand is split into low part of \c h and high
+ * part of \c l limbs and product is computed as:
+ *
+ * \code
+ * z0 = a0 * b0
+ * z2 = a1 * b1
+ * z1 = |a0 - a1| * |b0 - b1|
+ * a * b = z2 B^2h + (z0 + z2 -+ z1) B^h + z0
+ * \endcode
+ *
+ * \param[out] r product (2 * \a n limbs)
+ * \param[in] a first factor
+ * \param[in] b second factor
+ * \param[in] n number of limbs in each factor
+ * \param[in] scratch scratch area (see mul_n_scratch())
+ */
+static void mul_karatsuba(Limb *r, const Limb *a, const Limb *b, unsigned n,
+                          Limb *scratch) {
+	const unsigned h = n - n / 2, l = n / 2;
+	Limb *const z1 = scratch, *const t = scratch + 2 * h;
+	Limb *const next = t + 2 * h + 1;
+
+	/* Differences are stored where t will be later on */
+	const bool na = limbs_abs_diff(t, a, h, a + h, l);
+	const bool nb = limbs_abs_diff(t + h, b, h, b + h, l);
+	mul_n(z1, t, t + h, h, next, 1);
+
+	/* z0 and z2 go directly to the result */
+	mul_n(r, a, b, h, next, 1);
+	mul_n(r + 2 * h, a + h, b + h, l, next, 1);
+
+	/* t = z0 + z2 -+ z1 */
+	Limb c = limbs_add(t, r, 2 * h, r + 2 * h, 2 * l);
+	if (na==nb) {
+		c -= limbs_sub_n(t, t, z1, 2 * h);
+	} else {
+		c += limbs_add_n(t, t, z1, 2 * h);
+	}
+	t[2 * h] = c;
+
+	/* r += t B^h */
+	const unsigned rn = 2 * n - h, tn = 2 * h + 1;
+	limbs_add(r + h, r + h, rn, t, tn < rn ? tn : rn);
+}
+
+
+/**
+ * Evaluates polynomial <code>x2 X^2 + x1 X + x0</code> in point
+ * <code>X = -1</code> and stores result in two's complement.
+ *
+ * \param[out] e result (\a k + 1 limbs)
+ * \param[in] x polynomial coefficients, \c x0 and \c x1 have \a k
+ *              limbs and \c x2 \a s limbs
+ * \param[in] k number of limbs in \c x0 and \c x1
+ * \param[in] s number of limbs in \c x2
+ */
+static void toom3_eval_m1(Limb *e, const Limb *x, unsigned k, unsigned s) {
+	e[k] = limbs_add(e, x, k, x + 2 * k, s);
+	limbs_sub(e, e, k + 1, x + k, k);
+}
+
+/**
+ * Evaluates polynomial <code>x2 X^2 + x1 X + x0</code> in point
+ * <code>X = -2</code> and stores result in two's complement.
+ *
+ * \param[out] e result (\a k + 1 limbs)
+ * \param[in] x polynomial coefficients, \c x0 and \c x1 have \a k
+ *              limbs and \c x2 \a s limbs
+ * \param[in] k number of limbs in \c x0 and \c x1
+ * \param[in] s number of limbs in \c x2
+ */
+static void toom3_eval_m2(Limb *e, const Limb *x, unsigned k, unsigned s) {
+	unsigned i = 0;
+	for (; i<s; ++i) e[i] = x[2 * k + i];
+	for (; i<=k; ++i) e[i] = 0;
+	limbs_lshift(e, e, k + 1, 2);
+	limbs_add(e, e, k + 1, x, k);
+	limbs_sub(e, e, k + 1, x + k, k);
+	limbs_sub(e, e, k + 1, x + k, k);
+}
+
+/**
+ * Multiplies two evaluated points which may be negative.  Operands
+ * are in two's complement and are destroyed.
+ *
+ * \param[out] r product in two's complement (2 * \a n limbs)
+ * \param[in,out] ea first factor
+ * \param[in,out] eb second factor
+ * \param[in] n number of limbs in each factor
+ * \param[in] scratch scratch area (see mul_n_scratch())
+ * \param[in] threads maximal number of threads to use
+ */
+static void toom3_mul_signed(Limb *r, Limb *ea, Limb *eb, unsigned n,
+                             Limb *scratch, unsigned threads) {
+	const bool na = limbs_is_neg(ea, n), nb = limbs_is_neg(eb, n);
+	if (na) limbs_neg(ea, ea, n);
+	if (nb) limbs_neg(eb, eb, n);
+	mul_n(r, ea, eb, n, scratch, threads);
+	if (na!=nb) limbs_neg(r, r, 2 * n);
+}
+
+/**
+ * Interpolates product polynomial in Toom-Cook 3-way algorithm and
+ * computes the final product.  Uses Bodrato's sequence.  All
+ * intermediate values are kept in two's complement.
+ *
+ * \param[in,out] r on input holds v(0) in the lowest 2 * \a k limbs
+ *                  and v(infinity) starting at limb 4 * \a k; on
+ *                  output holds the product (4 * \a k + 2 * \a s
+ *                  limbs)
+ * \param[in] k number of limbs in the lower parts of operands
+ * \param[in] s number of limbs in the highest part of operands
+ * \param[in,out] v1 v(1) (2 * \a k + 2 limbs), destroyed
+ * \param[in,out] vm1 v(-1) (2 * \a k + 2 limbs), destroyed
+ * \param[in,out] vm2 v(-2) (2 * \a k + 2 limbs), destroyed
+ */
+static void toom3_interpolate(Limb *r, unsigned k, unsigned s,
+                              Limb *v1, Limb *vm1, Limb *vm2) {
+	const unsigned L = 2 * k + 2, rn = 4 * k + 2 * s;
+	const Limb *const v0 = r, *const vinf = r + 4 * k;
+	for (unsigned i = 2 * k; i<4 * k; ++i) r[i] = 0;
+
+	/* Interpolation */
+	limbs_sub_n(vm2, vm2, v1, L);            /* r3 = (v(-2) - v(1)) / 3 */
+	limbs_divexact_3(vm2, L);
+	limbs_sub_n(v1, v1, vm1, L);             /* r1 = (v(1) - v(-1)) / 2 */
+	limbs_half(v1, L);
+	limbs_sub(vm1, vm1, L, v0, 2 * k);       /* r2 = v(-1) - v(0) */
+	limbs_sub_n(vm2, vm1, vm2, L);           /* r3 = (r2 - r3) / 2 + 2 vinf */
+	limbs_half(vm2, L);
+	limbs_add(vm2, vm2, L, vinf, 2 * s);
+	limbs_add(vm2, vm2, L, vinf, 2 * s);
+	limbs_add_n(vm1, vm1, v1, L);            /* r2 = r2 + r1 - vinf */
+	limbs_sub(vm1, vm1, L, vinf, 2 * s);
+	limbs_sub_n(v1, v1, vm2, L);             /* r1 = r1 - r3 */
+
+	/* Recomposition */
+	limbs_add(r + k, r + k, rn - k, v1, L);
+	limbs_add(r + 2 * k, r + 2 * k, rn - 2 * k, vm1, L);
+	limbs_add(r + 3 * k, r + 3 * k, rn - 3 * k, vm2,
+	          L < rn - 3 * k ? L : rn - 3 * k);
+}
+
+
+/**
+ * Multiplies two limb vectors of equal length using Toom-Cook 3-way
+ * algorithm.  Operands are split into three parts, treated as
+ * polynomials evaluated in points 0, 1, -1, -2 and infinity and the
+ * product polynomial is interpolated (see toom3_interpolate()).  The
+ * five point products are computed in parallel if \a threads allows
+ * and operands are big enough.
+ *
+ * \param[out] r product (2 * \a n limbs)
+ * \param[in] a first factor
+ * \param[in] b second factor
+ * \param[in] n number of limbs in each factor
+ * \param[in] scratch scratch area (see mul_n_scratch())
+ * \param[in] threads maximal number of threads to use
+ */
+static void mul_toom3(Limb *r, const Limb *a, const Limb *b, unsigned n,
+                      Limb *scratch, unsigned threads) {
+	const unsigned k = (n + 2) / 3, s = n - 2 * k, L = 2 * k + 2;
+	Limb *const v1 = scratch, *const vm1 = v1 + L, *const vm2 = vm1 + L;
+	Limb *const ea = vm2 + L, *const eb = ea + k + 1;
+	Limb *const next = eb + k + 1;
+
+	/* Point 1 */
+	ea[k] = limbs_add(ea, a, k, a + 2 * k, s);
+	ea[k] += limbs_add(ea, ea, k, a + k, k);
+	eb[k] = limbs_add(eb, b, k, b + 2 * k, s);
+	eb[k] += limbs_add(eb, eb, k, b + k, k);
+
+	if (threads>1 && n>=PARALLEL_THRESHOLD) {
+		/* Each product needs its own points and scratch area */
+		unsigned m = mul_n_scratch(k + 1), u;
+		if ((u = mul_n_scratch(k))>m) m = u;
+		if (s!=k && (u = mul_n_scratch(s))>m) m = u;
+		const unsigned bufn = 4 * (k + 1) + 4 * m;
+		Limb *const buf = limbs_scratch(bufn);
+		Limb *const e1a = buf, *const e1b = e1a + k + 1;
+		Limb *const e2a = e1b + k + 1, *const e2b = e2a + k + 1;
+		Limb *const more = e2b + k + 1;
+		toom3_eval_m1(e1a, a, k, s);
+		toom3_eval_m1(e1b, b, k, s);
+		toom3_eval_m2(e2a, a, k, s);
+		toom3_eval_m2(e2b, b, k, s);
+
+		const unsigned t = threads_share(threads, 5);
+		const std::function<void()> tasks[5] = {
+			[=] { mul_n(v1, ea, eb, k + 1, next, t); },
+			[=] { toom3_mul_signed(vm1, e1a, e1b, k + 1, more, t); },
+			[=] { toom3_mul_signed(vm2, e2a, e2b, k + 1, more + m, t); },
+			[=] { mul_n(r, a, b, k, more + 2 * m, t); },
+			[=] { mul_n(r + 4 * k, a + 2 * k, b + 2 * k, s, more + 3 * m, t); }
+		};
+		try {
+			limbs_parallel(tasks, 5, threads);
+		} catch (...) {
+			limbs_scratch_free(buf, bufn);
+			throw;
+		}
+		limbs_scratch_free(buf, bufn);
+		toom3_interpolate(r, k, s, v1, vm1, vm2);
+		return;
+	}
+
+	mul_n(v1, ea, eb, k + 1, next, 1);
+
+	/* Point -1 */
+	toom3_eval_m1(ea, a, k, s);
+	toom3_eval_m1(eb, b, k, s);
+	toom3_mul_signed(vm1, ea, eb, k + 1, next, 1);
+
+	/* Point -2 */
+	toom3_eval_m2(ea, a, k, s);
+	toom3_eval_m2(eb, b, k, s);
+	toom3_mul_signed(vm2, ea, eb, k + 1, next, 1);
+
+	/* Points 0 and infinity go directly to the result */
+	mul_n(r, a, b, k, next, 1);
+	mul_n(r + 4 * k, a + 2 * k, b + 2 * k, s, next, 1);
+	toom3_interpolate(r, k, s, v1, vm1, vm2);
+}
+
+
+/**
+ * Multiplies two limb vectors of equal length.  Chooses algorithm
+ * depending on size of operands.
+ *
+ * \param[out] r product (2 * \a n limbs)
+ * \param[in] a first factor
+ * \param[in] b second factor
+ * \param[in] n number of limbs in each factor
+ * \param[in] scratch scratch area (see mul_n_scratch())
+ * \param[in] threads maximal number of threads to use
+ */
+static void mul_n(Limb *r, const Limb *a, const Limb *b, unsigned n,
+                  Limb *scratch, unsigned threads) {
+	if (n<KARATSUBA_THRESHOLD) {
+		limbs_mul_basecase(r, a, n, b, n);
+	} else if (n<TOOM3_THRESHOLD) {
+		mul_karatsuba(r, a, b, n, scratch);
+	} else if (n>=NTT_THRESHOLD && 2 * n<=NTT_MAX_LIMBS) {
+		limbs_mul_ntt(r, a, n, b, n, threads);
+	} else {
+		mul_toom3(r, a, b, n, scratch, threads);
+	}
+}
+
+
+
+/******************** Squaring ********************/
+void limbs_sqr_basecase(Limb *r, const Limb *a, unsigned n) {
+	/* Products of different limbs */
+	r[0] = 0;
+	r[2 * n - 1] = 0;
+	if (n>1) {
+		r[n] = limbs_mul_1(r + 1, a + 1, n - 1, a[0]);
+		for (unsigned i = 1; i<n - 1; ++i) {
+			r[n + i] = limbs_addmul_1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+		}
+		limbs_lshift(r, r, 2 * n, 1);
+	}
+
+	/* Squares of limbs */
+	Limb c = 0;
+	for (unsigned i = 0; i<n; ++i) {
+		const DLimb sq = (DLimb)a[i] * a[i];
+		DLimb t = (DLimb)r[2 * i] + (Limb)sq + c;
+		r[2 * i] = (Limb)t;
+		t = (t >> BigInt::LIMB_BITS) + r[2 * i + 1] + (sq >> BigInt::LIMB_BITS);
+		r[2 * i + 1] = (Limb)t;
+		c = (Limb)(t >> BigInt::LIMB_BITS);
+	}
+}
+
+
+static void sqr_n(Limb *r, const Limb *a, unsigned n, Limb *scratch,
+                  unsigned threads);
+
+
+/**
+ * Returns size of scratch area needed by sqr_n().
+ *
+ * \param[in] n number of limbs in operand
+ * \return number of limbs of scratch space required
+ */
+static unsigned sqr_n_scratch(unsigned n) {
+	if (n<SQR_KARATSUBA_THRESHOLD) {
+		return 0;
+	} else if (n>=NTT_THRESHOLD && 2 * n<=NTT_MAX_LIMBS) {
+		return 0;
+	} else if (n<SQR_TOOM3_THRESHOLD) {
+		const unsigned h = n - n / 2, l = n / 2;
+		const unsigned sh = sqr_n_scratch(h), sl = sqr_n_scratch(l);
+		return 4 * h + 1 + (sh > sl ? sh : sl);
+	} else {
+		const unsigned k = (n + 2) / 3, s = n - 2 * k;
+		unsigned m = sqr_n_scratch(k + 1), t;
+		if ((t = sqr_n_scratch(k))>m) m = t;
+		if (s!=k && (t = sqr_n_scratch(s))>m) m = t;
+		return 3 * (2 * k + 2) + (k + 1) + m;
+	}
+}
+
+
+/**
+ * Squares limb vector using Karatsuba algorithm.  Since both
+ * differences are the same the middle product is always substracted:
+ *
+ * \code
+ * a^2 = z2 B^2h + (z0 + z2 - (a0 - a1)^2) B^h + z0
+ * \endcode
+ *
+ * \param[out] r square (2 * \a n limbs)
+ * \param[in] a limb vector
+ * \param[in] n number of limbs in \a a
+ * \param[in] scratch scratch area (see sqr_n_scratch())
+ */
+static void sqr_karatsuba(Limb *r, const Limb *a, unsigned n, Limb *scratch) {
+	const unsigned h = n - n / 2, l = n / 2;
+	Limb *const z1 = scratch, *const t = scratch + 2 * h;
+	Limb *const next = t + 2 * h + 1;
+
+	limbs_abs_diff(t, a, h, a + h, l);
+	sqr_n(z1, t, h, next, 1);
+	sqr_n(r, a, h, next, 1);
+	sqr_n(r + 2 * h, a + h, l, next, 1);
+
+	Limb c = limbs_add(t, r, 2 * h, r + 2 * h, 2 * l);
+	c -= limbs_sub_n(t, t, z1, 2 * h);
+	t[2 * h] = c;
+
+	const unsigned rn = 2 * n - h, tn = 2 * h + 1;
+	limbs_add(r + h, r + h, rn, t, tn < rn ? tn : rn);
+}
+
+
+/**
+ * Squares limb vector using Toom-Cook 3-way algorithm.  Evaluated
+ * points are squared so their sign can be dropped.  The five point
+ * squares are computed in parallel if \a threads allows and operand
+ * is big enough.
+ *
+ * \param[out] r square (2 * \a n limbs)
+ * \param[in] a limb vector
+ * \param[in] n number of limbs in \a a
+ * \param[in] scratch scratch area (see sqr_n_scratch())
+ * \param[in] threads maximal number of threads to use
+ */
+static void sqr_toom3(Limb *r, const Limb *a, unsigned n, Limb *scratch,
+                      unsigned threads) {
+	const unsigned k = (n + 2) / 3, s = n - 2 * k, L = 2 * k + 2;
+	Limb *const v1 = scratch, *const vm1 = v1 + L, *const vm2 = vm1 + L;
+	Limb *const ea = vm2 + L, *const next = ea + k + 1;
+
+	/* Point 1 */
+	ea[k] = limbs_add(ea, a, k, a + 2 * k, s);
+	ea[k] += limbs_add(ea, ea, k, a + k, k);
+
+	if (threads>1 && n>=PARALLEL_THRESHOLD) {
+		/* Each square needs its own point and scratch area */
+		unsigned m = sqr_n_scratch(k + 1), u;
+		if ((u = sqr_n_scratch(k))>m) m = u;
+		if (s!=k && (u = sqr_n_scratch(s))>m) m = u;
+		const unsigned bufn = 2 * (k + 1) + 4 * m;
+		Limb *const buf = limbs_scratch(bufn);
+		Limb *const e1 = buf, *const e2 = e1 + k + 1, *const more = e2 + k + 1;
+		toom3_eval_m1(e1, a, k, s);
+		if (limbs_is_neg(e1, k + 1)) limbs_neg(e1, e1, k + 1);
+		toom3_eval_m2(e2, a, k, s);
+		if (limbs_is_neg(e2, k + 1)) limbs_neg(e2, e2, k + 1);
+
+		const unsigned t = threads_share(threads, 5);
+		const std::function<void()> tasks[5] = {
+			[=] { sqr_n(v1, ea, k + 1, next, t); },
+			[=] { sqr_n(vm1, e1, k + 1, more, t); },
+			[=] { sqr_n(vm2, e2, k + 1, more + m, t); },
+			[=] { sqr_n(r, a, k, more + 2 * m, t); },
+			[=] { sqr_n(r + 4 * k, a + 2 * k, s, more + 3 * m, t); }
+		};
+		try {
+			limbs_parallel(tasks, 5, threads);
+		} catch (...) {
+			limbs_scratch_free(buf, bufn);
+			throw;
+		}
+		limbs_scratch_free(buf, bufn);
+		toom3_interpolate(r, k, s, v1, vm1, vm2);
+		return;
+	}
+
+	sqr_n(v1, ea, k + 1, next, 1);
+
+	/* Point -1 */
+	toom3_eval_m1(ea, a, k, s);
+	if (limbs_is_neg(ea, k + 1)) limbs_neg(ea, ea, k + 1);
+	sqr_n(vm1, ea, k + 1, next, 1);
+
+	/* Point -2 */
+	toom3_eval_m2(ea, a, k, s);
+	if (limbs_is_neg(ea, k + 1)) limbs_neg(ea, ea, k + 1);
+	sqr_n(vm2, ea, k + 1, next, 1);
+
+	/* Points 0 and infinity go directly to the result */
+	sqr_n(r, a, k, next, 1);
+	sqr_n(r + 4 * k, a + 2 * k, s, next, 1);
+	toom3_interpolate(r, k, s, v1, vm1, vm2);
+}
+
+
+/**
+ * Squares limb vector.  Chooses algorithm depending on its size.
+ *
+ * \param[out] r square (2 * \a n limbs)
+ * \param[in] a limb vector
+ * \param[in] n number of limbs in \a a
+ * \param[in] scratch scratch area (see sqr_n_scratch())
+ * \param[in] threads maximal number of threads to use
+ */
+static void sqr_n(Limb *r, const Limb *a, unsigned n, Limb *scratch,
+                  unsigned threads) {
+	if (n<SQR_KARATSUBA_THRESHOLD) {
+		limbs_sqr_basecase(r, a, n);
+	} else if (n<SQR_TOOM3_THRESHOLD) {
+		sqr_karatsuba(r, a, n, scratch);
+	} else if (n>=NTT_THRESHOLD && 2 * n<=NTT_MAX_LIMBS) {
+		limbs_sqr_ntt(r, a, n, threads);
+	} else {
+		sqr_toom3(r, a, n, scratch, threads);
+	}
+}
+
+
+
+/******************** Unbalanced multiplication ********************/
+/**
+ * Returns size of scratch area needed by mul_unbalanced().
+ *
+ * \param[in] an number of limbs in the longer operand
+ * \param[in] bn number of limbs in the shorter operand
+ * \return number of limbs of scratch space required
+ */
+static unsigned mul_scratch(unsigned an, unsigned bn) {
+	if (bn<KARATSUBA_THRESHOLD) {
+		return 0;
+	} else if (an==bn) {
+		return mul_n_scratch(bn);
+	}
+
+	const unsigned rem = an % bn;
+	const unsigned n = mul_n_scratch(bn), m = rem ? mul_scratch(bn, rem) : 0;
+	return 2 * bn + (n > m ? n : m);
+}
+
+
+/**
+ * Multiplies two limb vectors.  The longer operand is split into
+ * chunks of the length of the shorter one and each chunk is
+ * multiplied using mul_n().
+ *
+ * \param[out] r product (\a an + \a bn limbs)
+ * \param[in] a first factor
+ * \param[in] an number of limbs in \a a
+ * \param[in] b second factor
+ * \param[in] bn number of limbs in \a b, must not be greater then \a an
+ * \param[in] scratch scratch area (see mul_scratch())
+ * \param[in] threads maximal number of threads each chunk product
+ *                    may use
+ */
+static void mul_unbalanced(Limb *r, const Limb *a, unsigned an,
+                           const Limb *b, unsigned bn, Limb *scratch,
+                           unsigned threads) {
+	if (bn<KARATSUBA_THRESHOLD) {
+		limbs_mul_basecase(r, a, an, b, bn);
+		return;
+	} else if (an==bn) {
+		mul_n(r, a, b, bn, scratch, threads);
+		return;
+	}
+
+	Limb *const tmp = scratch, *const next = scratch + 2 * bn;
+	unsigned off = bn;
+
+	mul_n(r, a, b, bn, next, threads);
+	for (; an - off >= bn; off += bn) {
+		mul_n(tmp, a + off, b, bn, next, threads);
+		const Limb c = limbs_add_n(r + off, r + off, tmp, bn);
+		limbs_add_1(r + off + bn, tmp + bn, bn, c);
+	}
+
+	if (off<an) {
+		const unsigned rem = an - off;
+		mul_unbalanced(tmp, b, bn, a + off, rem, next, threads);
+		const Limb c = limbs_add_n(r + off, r + off, tmp, bn);
+		limbs_add_1(r + off + bn, tmp + bn, rem, c);
+	}
+}
+
+
+
+/******************** Entry point ********************/
+void limbs_mul(Limb *r, const Limb *a, unsigned an,
+               const Limb *b, unsigned bn) {
+	if (an<bn) {
+		const Limb *const t = a; a = b; b = t;
+		const unsigned tn = an; an = bn; bn = tn;
+	}
+
+	if (bn<KARATSUBA_THRESHOLD) {
+		limbs_mul_basecase(r, a, an, b, bn);
+		return;
+	} else if (bn>=NTT_THRESHOLD && an + bn<=NTT_MAX_LIMBS) {
+		limbs_mul_ntt(r, a, an, b, bn, mul_threads);
+		return;
+	}
+
+	const unsigned sn = mul_scratch(an, bn);
+	Limb *const scratch = limbs_scratch(sn);
+	try {
+		mul_unbalanced(r, a, an, b, bn, scratch, mul_threads);
+	} catch (...) {
+		limbs_scratch_free(scratch, sn);
+		throw;
+	}
+	limbs_scratch_free(scratch, sn);
+}
+
+
+void limbs_sqr(Limb *r, const Limb *a, unsigned n) {
+	if (n<SQR_KARATSUBA_THRESHOLD) {
+		limbs_sqr_basecase(r, a, n);
+		return;
+	} else if (n>=NTT_THRESHOLD && 2 * n<=NTT_MAX_LIMBS) {
+		limbs_sqr_ntt(r, a, n, mul_threads);
+		return;
+	}
+
+	const unsigned sn = sqr_n_scratch(n);
+	Limb *const scratch = limbs_scratch(sn);
+	try {
+		sqr_n(r, a, n, scratch, mul_threads);
+	} catch (...) {
+		limbs_scratch_free(scratch, sn);
+		throw;
+	}
+	limbs_scratch_free(scratch, sn);
+}
+
+
+}
@@ -0,0 +1,398 @@
+/**
+ * \file
+ * BigInt Number-Theoretic Transform Multiplication.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * Multiplication of huge limb vectors using number-theoretic
+ * transform.  Operands are treated as polynomials with limbs as
+ * coefficients and are convolved modulo three primes of the form \c
+ * k*2^n+1.  Coefficients of the product are then reconstructed using
+ * Chinese remainder theorem (Garner's algorithm).  Product of the
+ * primes is greater then 2^86 so as long as the shorter operand has
+ * no more then 2^22 limbs the reconstruction is exact.  Only integer
+ * arithmetic is used.  If more then one thread is allowed the three
+ * convolutions run in parallel and big transforms are further split
+ * between threads.
+ */
+
+#include "bigint-limb.hpp"
+
+
+namespace mina86 {
+
+
+/**
+ * Transform size from which transforms are split between threads.
+ */
+static const unsigned NTT_PARALLEL_THRESHOLD = 1u << 14;
+
+
+/**
+ * Number-theoretic transform modulo prime \a P.
+ *
+ * \param P prime modulus of the form \c k*2^n+1 lower then 2^30
+ * \param G primitive root modulo \a P
+ */
+template<Limb P, Limb G>
+struct NTT {
+	/**
+	 * Multiplies two residues.
+	 *
+	 * \param[in] a first factor
+	 * \param[in] b second factor
+	 * \return <code>a * b mod P</code>
+	 */
+	static Limb mul(Limb a, Limb b) {
+		return (Limb)((DLimb)a * b % P);
+	}
+
+	/**
+	 * Raises residue to given power.
+	 *
+	 * \param[in] a base
+	 * \param[in] e exponent
+	 * \return <code>a ^ e mod P</code>
+	 */
+	static Limb pow(Limb a, Limb e) {
+		Limb r = 1;
+		for (; e; e >>= 1, a = mul(a, a)) {
+			if (e & 1) r = mul(r, a);
+		}
+		return r;
+	}
+
+	/**
+	 * Returns multiplicative inverse of a residue.
+	 *
+	 * \param[in] a residue, must not be zero
+	 * \return <code>a ^ -1 mod P</code>
+	 */
+	static Limb inv(Limb a) {
+		return pow(a, P - 2);
+	}
+
+	/**
+	 * Reduces limb vector modulo \a P and pads it with zeros.
+	 *
+	 * \param[out] f result (\a n residues)
+	 * \param[in] a limb vector
+	 * \param[in] an number of limbs in \a a
+	 * \param[in] n size of the transform
+	 */
+	static void load(Limb *f, const Limb *a, unsigned an, unsigned n) {
+		unsigned i = 0;
+		for (; i<an; ++i) f[i] = a[i] % P;
+		for (; i<n; ++i) f[i] = 0;
+	}
+
+	/**
+	 * Performs butterflies of a single stage of the transform on a
+	 * range of residues.
+	 *
+	 * \param[in,out] f residues
+	 * \param[in] size number of residues to process, a multiple of
+	 *                 \a len
+	 * \param[in] len length of blocks in this stage
+	 * \param[in] jb first butterfly in each block to perform
+	 * \param[in] je butterfly in each block to stop at
+	 * \param[in] w roots of unity of this stage (\a len / 2 residues)
+	 */
+	static void butterflies(Limb *f, unsigned size, unsigned len,
+	                        unsigned jb, unsigned je, const Limb *w) {
+		const unsigned half = len >> 1;
+		for (unsigned i = 0; i<size; i += len) {
+			Limb *const x = f + i, *const y = f + i + half;
+			for (unsigned j = jb; j<je; ++j) {
+				const Limb u = x[j], v = mul(y[j], w[j]);
+				x[j] = u + v >= P ? u + v - P : u + v;
+				y[j] = u >= v ? u - v : u + P - v;
+			}
+		}
+	}
+
+	/**
+	 * Performs in-place transform.  Uses iterative Cooley-Tukey
+	 * algorithm with bit-reversal permutation.  The inverse transform
+	 * includes the division by \a n.  If more then one thread is
+	 * allowed and transform is big, residues are split into segments
+	 * which go through the first stages independently and each of
+	 * the remaining stages is split between threads.
+	 *
+	 * \param[in,out] f residues to transform
+	 * \param[in] n size of the transform, a power of two
+	 * \param[in] w scratch space for roots of unity (\a n residues)
+	 * \param[in] inverse whether to perform inverse transform
+	 * \param[in] threads maximal number of threads to use
+	 */
+	static void transform(Limb *f, unsigned n, Limb *w, bool inverse,
+	                      unsigned threads) {
+		/* Bit-reversal permutation */
+		for (unsigned i = 1, j = 0; i<n; ++i) {
+			unsigned bit = n >> 1;
+			for (; j & bit; bit >>= 1) j ^= bit;
+			j ^= bit;
+			if (i<j) {
+				const Limb t = f[i]; f[i] = f[j]; f[j] = t;
+			}
+		}
+
+		/* Roots of unity of stage with blocks of length 2h start at w + h;
+		 * each stage uses every other root of the following one */
+		Limb root = pow(G, (P - 1) / n);
+		if (inverse) root = inv(root);
+		if (n>1) {
+			Limb *const last = w + n / 2;
+			last[0] = 1;
+			for (unsigned j = 1; j<n / 2; ++j) last[j] = mul(last[j - 1], root);
+		}
+		for (unsigned h = n / 4; h; h >>= 1) {
+			for (unsigned j = 0; j<h; ++j) w[h + j] = w[2 * h + 2 * j];
+		}
+
+		/* Number of segments, a power of two */
+		unsigned parts = 1;
+		if (n>=NTT_PARALLEL_THRESHOLD) {
+			while (parts * 2<=threads && parts * 2<=64) parts *= 2;
+		}
+		const unsigned seg = n / parts;
+
+		/* Stages within segments */
+		const auto first = [=](unsigned p) {
+			for (unsigned len = 2; len<=seg; len <<= 1) {
+				butterflies(f + p * seg, seg, len, 0, len >> 1, w + len / 2);
+			}
+		};
+		if (parts==1) {
+			first(0);
+		} else {
+			std::function<void()> tasks[64];
+			for (unsigned p = 0; p<parts; ++p) tasks[p] = [=] { first(p); };
+			limbs_parallel(tasks, parts, parts);
+
+			/* Stages spanning segments */
+			for (unsigned len = 2 * seg; len<=n; len <<= 1) {
+				const unsigned half = len >> 1;
+				for (unsigned p = 0; p<parts; ++p) {
+					const unsigned jb = half / parts * p, je = jb + half / parts;
+					tasks[p] = [=] { butterflies(f, n, len, jb, je, w + half); };
+				}
+				limbs_parallel(tasks, parts, parts);
+			}
+		}
+
+		/* Scale */
+		if (inverse) {
+			const Limb ninv = inv(n);
+			for (unsigned i = 0; i<n; ++i) f[i] = mul(f[i], ninv);
+		}
+	}
+
+	/**
+	 * Computes cyclic convolution of two limb vectors modulo \a P.
+	 *
+	 * \param[out] f result (\a n residues)
+	 * \param[in] a first vector
+	 * \param[in] an number of limbs in \a a
+	 * \param[in] b second vector
+	 * \param[in] bn number of limbs in \a b
+	 * \param[in] n size of the transform, a power of two not lower
+	 *              then \a an + \a bn - 1
+	 * \param[in] tmp scratch space (2 * \a n residues)
+	 * \param[in] threads maximal number of threads to use
+	 */
+	static void convolve(Limb *f, const Limb *a, unsigned an,
+	                     const Limb *b, unsigned bn, unsigned n, Limb *tmp,
+	                     unsigned threads) {
+		Limb *const g = tmp, *const w = tmp + n;
+		load(f, a, an, n);
+		transform(f, n, w, false, threads);
+		load(g, b, bn, n);
+		transform(g, n, w, false, threads);
+		for (unsigned i = 0; i<n; ++i) f[i] = mul(f[i], g[i]);
+		transform(f, n, w, true, threads);
+	}
+
+	/**
+	 * Computes cyclic convolution of limb vector with itself modulo
+	 * \a P.  Needs only one forward transform.
+	 *
+	 * \param[out] f result (\a n residues)
+	 * \param[in] a limb vector
+	 * \param[in] an number of limbs in \a a
+	 * \param[in] n size of the transform, a power of two not lower
+	 *              then 2 * \a an - 1
+	 * \param[in] tmp scratch space (\a n residues)
+	 * \param[in] threads maximal number of threads to use
+	 */
+	static void square(Limb *f, const Limb *a, unsigned an, unsigned n,
+	                   Limb *tmp, unsigned threads) {
+		load(f, a, an, n);
+		transform(f, n, tmp, false, threads);
+		for (unsigned i = 0; i<n; ++i) f[i] = mul(f[i], f[i]);
+		transform(f, n, tmp, true, threads);
+	}
+};
+
+
+/**
+ * The first prime, 7 * 2^26 + 1.
+ */
+typedef NTT<469762049u, 3> NTT1;
+
+/**
+ * The second prime, 5 * 2^25 + 1.
+ */
+typedef NTT<167772161u, 3> NTT2;
+
+/**
+ * The third prime, 119 * 2^23 + 1.
+ */
+typedef NTT<998244353u, 3> NTT3;
+
+
+
+/******************** Reconstruction ********************/
+/**
+ * Reconstructs product from its residues modulo three primes using
+ * Garner's algorithm and propagates carries.
+ *
+ * \param[out] r product (\a len + 1 limbs)
+ * \param[in] f1 coefficients modulo the first prime
+ * \param[in] f2 coefficients modulo the second prime
+ * \param[in] f3 coefficients modulo the third prime
+ * \param[in] len number of coefficients
+ */
+static void ntt_reconstruct(Limb *r, const Limb *f1, const Limb *f2,
+                            const Limb *f3, unsigned len) {
+	static const Limb P1 = 469762049u, P2 = 167772161u;
+
+	/* x = y1 + P1 * (y2 + P2 * y3) */
+	const Limb inv12 = NTT2::inv(P1 % 167772161u);
+	const Limb inv123 = NTT3::inv(NTT3::mul(P1 % 998244353u, P2));
+	Limb c0 = 0, c1 = 0, c2 = 0;
+
+	for (unsigned i = 0; i<len; ++i) {
+		const Limb y1 = f1[i];
+		const Limb y2 = NTT2::mul((f2[i] + 167772161u - y1 % 167772161u)
+		                          % 167772161u, inv12);
+		const Limb x12 = (Limb)(((DLimb)y1 + (DLimb)P1 * y2) % 998244353u);
+		const Limb y3 = NTT3::mul((f3[i] + 998244353u - x12) % 998244353u,
+		                          inv123);
+		const DLimb t = y2 + (DLimb)P2 * y3;
+
+		/* c += y1 + P1 * t; output lowest limb of c */
+		const DLimb lo = (DLimb)P1 * (Limb)t + y1;
+		const DLimb hi = (DLimb)P1 * (Limb)(t >> BigInt::LIMB_BITS);
+		DLimb s = (DLimb)c0 + (Limb)lo;
+		r[i] = (Limb)s;
+		s = (s >> BigInt::LIMB_BITS) + c1 + (lo >> BigInt::LIMB_BITS)
+			+ (Limb)hi;
+		c0 = (Limb)s;
+		s = (s >> BigInt::LIMB_BITS) + c2 + (hi >> BigInt::LIMB_BITS);
+		c1 = (Limb)s;
+		c2 = (Limb)(s >> BigInt::LIMB_BITS);
+	}
+	r[len] = c0;
+}
+
+
+/**
+ * Returns size of the transform needed to compute product of given
+ * size.
+ *
+ * \param[in] len number of coefficients of the product
+ * \return the lowest power of two not lower then \a len
+ */
+static unsigned ntt_size(unsigned len) {
+	unsigned n = 1;
+	while (n<len) n <<= 1;
+	return n;
+}
+
+
+
+/******************** Entry points ********************/
+void limbs_mul_ntt(Limb *r, const Limb *a, unsigned an,
+                   const Limb *b, unsigned bn, unsigned threads) {
+	const unsigned len = an + bn - 1, n = ntt_size(len);
+
+	/* Sequential */
+	if (threads<2) {
+		Limb *const buf = limbs_scratch(5 * n);
+		Limb *const f1 = buf, *const f2 = f1 + n, *const f3 = f2 + n;
+		Limb *const tmp = f3 + n;
+
+		NTT1::convolve(f1, a, an, b, bn, n, tmp, 1);
+		NTT2::convolve(f2, a, an, b, bn, n, tmp, 1);
+		NTT3::convolve(f3, a, an, b, bn, n, tmp, 1);
+		ntt_reconstruct(r, f1, f2, f3, len);
+
+		limbs_scratch_free(buf, 5 * n);
+		return;
+	}
+
+	/* Each prime gets its own scratch space and a third of threads */
+	Limb *const buf = limbs_scratch(9 * n);
+	Limb *const f1 = buf, *const f2 = f1 + n, *const f3 = f2 + n;
+	Limb *const t1 = f3 + n, *const t2 = t1 + 2 * n, *const t3 = t2 + 2 * n;
+	const unsigned t = threads>3 ? threads / 3 : 1;
+	const std::function<void()> tasks[3] = {
+		[=] { NTT1::convolve(f1, a, an, b, bn, n, t1, t); },
+		[=] { NTT2::convolve(f2, a, an, b, bn, n, t2, t); },
+		[=] { NTT3::convolve(f3, a, an, b, bn, n, t3, t); }
+	};
+	try {
+		limbs_parallel(tasks, 3, threads);
+	} catch (...) {
+		limbs_scratch_free(buf, 9 * n);
+		throw;
+	}
+	ntt_reconstruct(r, f1, f2, f3, len);
+
+	limbs_scratch_free(buf, 9 * n);
+}
+
+
+void limbs_sqr_ntt(Limb *r, const Limb *a, unsigned n, unsigned threads) {
+	const unsigned len = 2 * n - 1, size = ntt_size(len);
+
+	/* Sequential */
+	if (threads<2) {
+		Limb *const buf = limbs_scratch(4 * size);
+		Limb *const f1 = buf, *const f2 = f1 + size, *const f3 = f2 + size;
+		Limb *const tmp = f3 + size;
+
+		NTT1::square(f1, a, n, size, tmp, 1);
+		NTT2::square(f2, a, n, size, tmp, 1);
+		NTT3::square(f3, a, n, size, tmp, 1);
+		ntt_reconstruct(r, f1, f2, f3, len);
+
+		limbs_scratch_free(buf, 4 * size);
+		return;
+	}
+
+	/* Each prime gets its own scratch space and a third of threads */
+	Limb *const buf = limbs_scratch(6 * size);
+	Limb *const f1 = buf, *const f2 = f1 + size, *const f3 = f2 + size;
+	Limb *const t1 = f3 + size, *const t2 = t1 + size, *const t3 = t2 + size;
+	const unsigned t = threads>3 ? threads / 3 : 1;
+	const std::function<void()> tasks[3] = {
+		[=] { NTT1::square(f1, a, n, size, t1, t); },
+		[=] { NTT2::square(f2, a, n, size, t2, t); },
+		[=] { NTT3::square(f3, a, n, size, t3, t); }
+	};
+	try {
+		limbs_parallel(tasks, 3, threads);
+	} catch (...) {
+		limbs_scratch_free(buf, 6 * size);
+		throw;
+	}
+	ntt_reconstruct(r, f1, f2, f3, len);
+
+	limbs_scratch_free(buf, 6 * size);
+}
+
+
+}
@@ -0,0 +1,263 @@
+/**
+ * \file
+ * BigInt Memory Pool.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * Allocation of limb buffers.  Limbs of numbers come from a pool of
+ * power of two size classes with a free list per class and thread so
+ * allocating and freeing a buffer is a couple of instructions and
+ * needs no locking.  Scratch buffers of operations come from the same
+ * pool unless a BigIntArena exists in which case they are carved out
+ * of arena's chunks.
+ */
+
+#include <cassert>
+#include <new>
+
+#include "bigint-limb.hpp"
+#include "bigint-pool.hpp"
+
+
+namespace mina86 {
+
+
+/******************** Pool ********************/
+/**
+ * Binary logarithm of the number of limbs in buffers of the smallest
+ * size class.  Numbers stored in limb arrays have at least three
+ * limbs.
+ */
+static const unsigned POOL_MIN_BITS = 2;
+
+/**
+ * Number of limbs in buffers of the smallest size class.  Buffers of
+ * class \a c have <code>POOL_MIN << c</code> limbs.
+ */
+static const unsigned POOL_MIN = 1u << POOL_MIN_BITS;
+
+/**
+ * Number of size classes.
+ */
+static const unsigned POOL_CLASSES = 9;
+
+/**
+ * Number of limbs in buffers of the biggest size class.  Bigger
+ * buffers are allocated directly.
+ */
+static const unsigned POOL_MAX = POOL_MIN << (POOL_CLASSES - 1);
+
+/**
+ * Maximal number of free buffers kept in each size class.  Further
+ * freed buffers are returned to the heap.
+ */
+static const unsigned POOL_DEPTH = 32;
+
+
+namespace {
+
+/**
+ * Free buffer.  The first bytes of a free buffer link it to the next
+ * free buffer of the same size class.
+ */
+struct FreeBuffer {
+	/** Next free buffer. */
+	FreeBuffer *next;
+};
+
+/**
+ * Free lists of a single thread.  Zero-initialized as it has static
+ * storage duration.
+ */
+struct FreeLists {
+	/** The first free buffer of each size class. */
+	FreeBuffer *heads[POOL_CLASSES];
+	/** Number of free buffers of each size class. */
+	unsigned counts[POOL_CLASSES];
+	/**
+	 * Whether the lists were destroyed.  Buffers freed afterwards (by
+	 * destructors of static objects run after thread's exit) go
+	 * straight to the heap.
+	 */
+	bool destroyed;
+
+	/**
+	 * Returns all free buffers to the heap.
+	 */
+	~FreeLists() {
+		for (unsigned c = 0; c<POOL_CLASSES; ++c) {
+			while (heads[c]) {
+				FreeBuffer *const b = heads[c];
+				heads[c] = b->next;
+				delete[] reinterpret_cast<Limb *>(b);
+			}
+			counts[c] = 0;
+		}
+		destroyed = true;
+	}
+};
+
+}
+
+
+/**
+ * Free lists of the calling thread.
+ */
+static thread_local FreeLists free_lists;
+
+
+/**
+ * Returns size class of a buffer.
+ *
+ * \param[in] n number of limbs, at most #POOL_MAX
+ * \return size class
+ */
+static inline unsigned pool_class(unsigned n) {
+	return n<=POOL_MIN ? 0
+		: BigInt::LIMB_BITS - limb_clz(n - 1) - POOL_MIN_BITS;
+}
+
+
+BigInt::Limb *BigInt::Pool::allocate(unsigned n) {
+	if (n>POOL_MAX) {
+		return new Limb[n];
+	}
+
+	const unsigned c = pool_class(n);
+	FreeLists &l = free_lists;
+	if (FreeBuffer *const b = l.heads[c]) {
+		l.heads[c] = b->next;
+		--l.counts[c];
+		return reinterpret_cast<Limb *>(b);
+	}
+	return new Limb[POOL_MIN << c];
+}
+
+
+void BigInt::Pool::deallocate(Limb *p, unsigned n) {
+	if (!p) {
+		return;
+	} else if (n>POOL_MAX) {
+		delete[] p;
+		return;
+	}
+
+	const unsigned c = pool_class(n);
+	FreeLists &l = free_lists;
+	if (l.destroyed || l.counts[c]>=POOL_DEPTH) {
+		delete[] p;
+		return;
+	}
+	FreeBuffer *const b = new (static_cast<void *>(p)) FreeBuffer;
+	b->next = l.heads[c];
+	l.heads[c] = b;
+	++l.counts[c];
+}
+
+
+
+/******************** Arena ********************/
+/**
+ * The innermost arena of the calling thread.
+ */
+static thread_local BigIntArena *current_arena = 0;
+
+
+/**
+ * Rounds number of limbs so that buffers given by an arena are
+ * aligned to 16 bytes.
+ *
+ * \param[in] n number of limbs
+ * \return \a n rounded up to a multiple of four
+ */
+static inline unsigned arena_round(unsigned n) {
+	return (n + 3) & ~3u;
+}
+
+
+BigIntArena::BigIntArena()
+	: chunks(0), previous(current_arena), live(0) {
+	current_arena = this;
+}
+
+
+BigIntArena::~BigIntArena() {
+	assert(!live && current_arena==this);
+	current_arena = previous;
+	while (chunks) {
+		Chunk *const c = chunks;
+		chunks = c->next;
+		::operator delete(c);
+	}
+}
+
+
+BigIntArena *BigIntArena::current() {
+	return current_arena;
+}
+
+
+BigIntArena::Limb *BigIntArena::allocate(unsigned n) {
+	n = arena_round(n);
+	if (!chunks || chunks->size - chunks->used < n) {
+		const unsigned size = n>CHUNK_LIMBS ? n : CHUNK_LIMBS;
+		Chunk *const c = static_cast<Chunk *>(
+			::operator new(sizeof(Chunk) + size * sizeof(Limb)));
+		c->next = chunks;
+		c->size = size;
+		c->used = 0;
+		chunks = c;
+	}
+	Limb *const p = chunks->limbs() + chunks->used;
+	chunks->used += n;
+	++live;
+	return p;
+}
+
+
+bool BigIntArena::release(Limb *p, unsigned n) {
+	n = arena_round(n);
+	for (Chunk *c = chunks; c; c = c->next) {
+		Limb *const l = c->limbs();
+		if (p<l || p>=l + c->size) {
+			continue;
+		}
+
+		--live;
+		/* The most recent buffer; oversized chunks are freed at once */
+		if (c==chunks && p + n==l + c->used) {
+			c->used -= n;
+			if (!c->used && c->size>CHUNK_LIMBS && c->next) {
+				chunks = c->next;
+				::operator delete(c);
+			}
+		}
+		return true;
+	}
+	return false;
+}
+
+
+
+/******************** Scratch buffers ********************/
+Limb *limbs_scratch(unsigned n) {
+	BigIntArena *const a = current_arena;
+	return a ? a->allocate(n) : BigInt::Pool::allocate(n);
+}
+
+
+void limbs_scratch_free(Limb *p, unsigned n) {
+	if (!p) {
+		return;
+	}
+	for (BigIntArena *a = current_arena; a; a = a->getPrevious()) {
+		if (a->release(p, n)) {
+			return;
+		}
+	}
+	BigInt::Pool::deallocate(p, n);
+}
+
+
+}
@@ -0,0 +1,147 @@
+/**
+ * \file
+ * BigInt Arena Header File.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ */
+
+#ifndef MN_BIGINT_POOL_HPP
+#define MN_BIGINT_POOL_HPP
+
+#include "bigint.hpp"
+
+
+namespace mina86 {
+
+
+/**
+ * Scoped arena for scratch memory of BigInt operations.  While an
+ * arena exists, temporary buffers which operations invoked from the
+ * same thread need (products of sub-expressions, Toom-Cook and NTT
+ * workspace, division and radix conversion buffers) are carved out
+ * of large chunks owned by the arena instead of being allocated one
+ * by one.  Buffers released in reverse order of allocation, which is
+ * the usual case, are reused at once; the rest stay allocated and
+ * all chunks are freed in bulk when the arena is destroyed.
+ *
+ * Limbs of numbers always come from BigInt::Pool, never from the
+ * arena, so numbers computed inside the arena's scope may outlive it
+ * and be freed after it is gone.  Only scratch buffers, which are
+ * released before the operation needing them returns, are carved out
+ * of the arena.  A buffer still allocated when the arena is destroyed
+ * would later be freed into memory which no longer exists so the
+ * destructor asserts there are none.  Arenas may be nested, the
+ * innermost one is used.
+ *
+ * \code
+ * BigIntArena arena;
+ * for (unsigned i = 0; i<n; ++i) sum += a[i] * b[i] + c[i] * d[i];
+ * \endcode
+ *
+ * \sa BigInt::Pool
+ */
+class BigIntArena {
+public:
+	/** Type of a single limb. */
+	typedef BigInt::Limb Limb;
+
+
+	/**
+	 * Creates arena and makes it the current arena of the calling
+	 * thread.
+	 */
+	BigIntArena();
+
+	/**
+	 * Frees all memory of the arena and makes the previous arena (if
+	 * any) current again.  Arenas must be destroyed in reverse order
+	 * of creation by the thread which created them and after all
+	 * buffers allocated from them were released.
+	 */
+	~BigIntArena();
+
+
+	/**
+	 * Returns the current arena of the calling thread.
+	 *
+	 * \return innermost arena or null pointer if there is none
+	 */
+	static BigIntArena *current();
+
+	/**
+	 * Allocates limb buffer from the arena.  The buffer must be
+	 * released with release() before the arena is destroyed.
+	 *
+	 * \param[in] n number of limbs
+	 * \return pointer to allocated memory
+	 */
+	Limb *allocate(unsigned n);
+
+	/**
+	 * Releases limb buffer.  If it is the most recently allocated one
+	 * its memory is reused, otherwise it is kept until the arena is
+	 * destroyed.
+	 *
+	 * \param[in] p pointer to allocated memory
+	 * \param[in] n number of limbs passed to allocate()
+	 * \return \c false if \a p was not allocated from this arena
+	 */
+	bool release(Limb *p, unsigned n);
+
+	/**
+	 * Returns the previous arena, ie. the one which was current when
+	 * this one was created.
+	 *
+	 * \return previous arena or null pointer
+	 */
+	BigIntArena *getPrevious() const { return previous; }
+
+
+private:
+	/**
+	 * Minimal number of limbs in a chunk.  Bigger requests get chunks
+	 * of their own.
+	 */
+	static const unsigned CHUNK_LIMBS = 4096;
+
+	/**
+	 * Header of a chunk; limbs follow it.
+	 */
+	struct Chunk {
+		/** Previously allocated chunk. */
+		Chunk *next;
+		/** Number of limbs in the chunk. */
+		unsigned size;
+		/** Number of limbs given away from the beginning. */
+		unsigned used;
+
+		/**
+		 * Returns pointer to the first limb of the chunk.
+		 *
+		 * \return pointer to the first limb
+		 */
+		Limb *limbs() { return reinterpret_cast<Limb *>(this + 1); }
+	};
+
+	/** The most recently allocated chunk. */
+	Chunk *chunks;
+
+	/** Arena which was current when this one was created. */
+	BigIntArena *previous;
+
+	/** Number of buffers allocated and not yet released. */
+	unsigned live;
+
+
+	/** Arenas are not copyable. */
+	BigIntArena(const BigIntArena &);
+	/** Arenas are not copyable. */
+	BigIntArena &operator=(const BigIntArena &);
+};
+
+
+}
+
+
+#endif
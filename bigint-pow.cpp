@@ -0,0 +1,358 @@
+/**
+ * \file
+ * BigInt Modular Exponentiation.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * Modular exponentiation of limb vectors.  Exponent is scanned from
+ * the most significant bit with a sliding window: a table of odd
+ * powers of the base is computed first and then each run of up to \c
+ * k bits which starts and ends with a set bit costs \c k squarings
+ * and a single multiplication.  Odd moduli use Montgomery
+ * representation in which reduction after multiplication needs no
+ * division; even moduli reduce with limbs_div_qr().  Miller-Rabin
+ * test uses the same exponentiation and does the squarings which
+ * follow it without leaving Montgomery representation.
+ */
+
+#include "bigint-limb.hpp"
+
+
+namespace mina86 {
+
+
+/******************** Helpers ********************/
+/**
+ * Computes inverse of an odd limb modulo 2^LIMB_BITS using Newton's
+ * iteration.  Each step doubles number of correct bits.
+ *
+ * \param[in] m odd limb
+ * \return \c x such that <code>m * x == 1</code> modulo 2^LIMB_BITS
+ */
+static Limb limb_inverse(Limb m) {
+	Limb x = m;  /* correct on 3 bits */
+	for (unsigned bits = 3; bits<BigInt::LIMB_BITS; bits *= 2) {
+		x *= 2 - m * x;
+	}
+	return x;
+}
+
+
+/**
+ * Returns window size for exponent of given length.
+ *
+ * \param[in] bits number of bits in exponent
+ * \return number of bits in window
+ */
+static unsigned window_size(unsigned bits) {
+	static const unsigned limits[] = { 7, 36, 140, 450, 1303, 3529 };
+	unsigned k = 1;
+	while (k<=6 && bits>limits[k - 1]) ++k;
+	return k;
+}
+
+
+
+/**
+ * Returns bit of a limb vector.
+ *
+ * \param[in] e limb vector
+ * \param[in] i index of bit, zero being the least significant
+ * \return value of the bit
+ */
+static inline unsigned limbs_bit(const Limb *e, unsigned i) {
+	return (e[i / BigInt::LIMB_BITS] >> (i % BigInt::LIMB_BITS)) & 1;
+}
+
+
+
+/******************** Montgomery ********************/
+/**
+ * Montgomery multiplication modulo an odd number \c m of \c n limbs.
+ * Numbers are kept as <code>x * R mod m</code> where \c R is
+ * 2^(n*LIMB_BITS) and product of two such numbers is reduced by
+ * adding a multiple of \c m which makes the lower half zero and
+ * dropping it.
+ */
+class Montgomery {
+public:
+	/**
+	 * Prepares reduction modulo \a m.
+	 *
+	 * \param[in] m modulus, must be odd
+	 * \param[in] n number of limbs of \a m
+	 */
+	Montgomery(const Limb *m, unsigned n)
+		: m(m), n(n), minv(-limb_inverse(m[0])),
+		  t(limbs_scratch(2 * n)) { }
+
+	/** Frees scratch buffer. */
+	~Montgomery() { limbs_scratch_free(t, 2 * n); }
+
+	/**
+	 * Converts number to Montgomery representation.
+	 *
+	 * \param[out] r result (#n limbs)
+	 * \param[in] a number less than #m
+	 * \param[in] an number of limbs in \a a
+	 */
+	void to(Limb *r, const Limb *a, unsigned an) {
+		Limb *const x = limbs_scratch(an + n);
+		Limb *const q = limbs_scratch(an + 1);
+		for (unsigned i = 0; i<n; ++i) x[i] = 0;
+		for (unsigned i = 0; i<an; ++i) x[n + i] = a[i];
+		limbs_div_qr(q, r, x, an + n, m, n);
+		limbs_scratch_free(q, an + 1);
+		limbs_scratch_free(x, an + n);
+	}
+
+	/**
+	 * Converts number from Montgomery representation.
+	 *
+	 * \param[out] r result (#n limbs), may be the same as \a a
+	 * \param[in] a number in Montgomery representation
+	 */
+	void from(Limb *r, const Limb *a) {
+		for (unsigned i = 0; i<n; ++i) t[i] = a[i];
+		for (unsigned i = n; i<2 * n; ++i) t[i] = 0;
+		redc(r);
+	}
+
+	/**
+	 * Multiplies two numbers in Montgomery representation.
+	 *
+	 * \param[out] r result (#n limbs), may be the same as \a a or \a b
+	 * \param[in] a first factor
+	 * \param[in] b second factor
+	 */
+	void mul(Limb *r, const Limb *a, const Limb *b) {
+		limbs_mul(t, a, n, b, n);
+		redc(r);
+	}
+
+	/**
+	 * Squares number in Montgomery representation.
+	 *
+	 * \param[out] r result (#n limbs), may be the same as \a a
+	 * \param[in] a number
+	 */
+	void sqr(Limb *r, const Limb *a) {
+		limbs_sqr(t, a, n);
+		redc(r);
+	}
+
+private:
+	/** Modulus. */
+	const Limb *const m;
+	/** Number of limbs of modulus. */
+	const unsigned n;
+	/** Negated inverse of the least significant limb of #m. */
+	const Limb minv;
+	/** Scratch buffer for products. */
+	Limb *const t;
+
+	/**
+	 * Reduces product stored in #t.  Each step adds a multiple of #m
+	 * which zeroes the lowest limb.  Carries out of each step are
+	 * saved in the zeroed limbs and added all at once at the end.
+	 *
+	 * \param[out] r result (#n limbs)
+	 */
+	void redc(Limb *r) {
+		for (unsigned i = 0; i<n; ++i) {
+			t[i] = limbs_addmul_1(t + i, m, n, t[i] * minv);
+		}
+		const Limb c = limbs_add_n(r, t + n, t, n);
+		if (c || limbs_cmp(r, m, n)>=0) limbs_sub_n(r, r, m, n);
+	}
+
+	/** Copying is not supported. */
+	Montgomery(const Montgomery &);
+	/** Copying is not supported. */
+	Montgomery &operator=(const Montgomery &);
+};
+
+
+
+/******************** Division ********************/
+/**
+ * Multiplication modulo an even number \c m of \c n limbs.  Products
+ * are reduced with limbs_div_qr().  Has the same interface as
+ * Montgomery.
+ */
+class ModDiv {
+public:
+	/**
+	 * Prepares reduction modulo \a m.
+	 *
+	 * \param[in] m modulus
+	 * \param[in] n number of limbs of \a m
+	 */
+	ModDiv(const Limb *m, unsigned n)
+		: m(m), n(n), t(limbs_scratch(2 * n)),
+		  q(limbs_scratch(n + 1)) { }
+
+	/** Frees scratch buffers. */
+	~ModDiv() {
+		limbs_scratch_free(q, n + 1);
+		limbs_scratch_free(t, 2 * n);
+	}
+
+	/** \copydoc Montgomery::to() */
+	void to(Limb *r, const Limb *a, unsigned an) {
+		for (unsigned i = 0; i<an; ++i) r[i] = a[i];
+		for (unsigned i = an; i<n; ++i) r[i] = 0;
+	}
+
+	/** \copydoc Montgomery::from() */
+	void from(Limb *r, const Limb *a) {
+		if (r!=a) for (unsigned i = 0; i<n; ++i) r[i] = a[i];
+	}
+
+	/** \copydoc Montgomery::mul() */
+	void mul(Limb *r, const Limb *a, const Limb *b) {
+		limbs_mul(t, a, n, b, n);
+		limbs_div_qr(q, r, t, 2 * n, m, n);
+	}
+
+	/** \copydoc Montgomery::sqr() */
+	void sqr(Limb *r, const Limb *a) {
+		limbs_sqr(t, a, n);
+		limbs_div_qr(q, r, t, 2 * n, m, n);
+	}
+
+private:
+	/** Modulus. */
+	const Limb *const m;
+	/** Number of limbs of modulus. */
+	const unsigned n;
+	/** Scratch buffer for products. */
+	Limb *const t;
+	/** Scratch buffer for quotients. */
+	Limb *const q;
+
+	/** Copying is not supported. */
+	ModDiv(const ModDiv &);
+	/** Copying is not supported. */
+	ModDiv &operator=(const ModDiv &);
+};
+
+
+
+/******************** Sliding window ********************/
+/**
+ * Raises number to a power using sliding window exponentiation.
+ *
+ * \param[in] ctx modular multiplication
+ * \param[out] r result (\a n limbs) in representation used by \a ctx
+ * \param[in] a base
+ * \param[in] an number of limbs in \a a
+ * \param[in] e exponent
+ * \param[in] en number of limbs in \a e; the most significant limb
+ *               must not be zero
+ * \param[in] n number of limbs of modulus
+ */
+template<class Ctx>
+static void window_pow(Ctx &ctx, Limb *r, const Limb *a, unsigned an,
+                       const Limb *e, unsigned en, unsigned n) {
+	const int bits = en * BigInt::LIMB_BITS - limb_clz(e[en - 1]);
+	const unsigned k = window_size(bits);
+
+	/* Odd powers a, a^3, ..., a^(2^k - 1) */
+	const unsigned count = 1u << (k - 1);
+	Limb *const table = limbs_scratch((count + 1) * n);
+	Limb *const a2 = table + count * n;
+	ctx.to(table, a, an);
+	if (count>1) {
+		ctx.sqr(a2, table);
+		for (unsigned i = 1; i<count; ++i) {
+			ctx.mul(table + i * n, table + (i - 1) * n, a2);
+		}
+	}
+
+	/* Scan exponent */
+	bool first = true;
+	for (int i = bits - 1; i>=0; ) {
+		if (!limbs_bit(e, i)) {
+			ctx.sqr(r, r);
+			--i;
+			continue;
+		}
+
+		int j = i - (int)k + 1;
+		if (j<0) j = 0;
+		while (!limbs_bit(e, j)) ++j;
+		unsigned val = 0;
+		for (int b = i; b>=j; --b) val = val << 1 | limbs_bit(e, b);
+		const Limb *const p = table + (val >> 1) * n;
+
+		if (first) {
+			for (unsigned l = 0; l<n; ++l) r[l] = p[l];
+			first = false;
+		} else {
+			for (int b = i; b>=j; --b) ctx.sqr(r, r);
+			ctx.mul(r, r, p);
+		}
+		i = j - 1;
+	}
+
+	limbs_scratch_free(table, (count + 1) * n);
+}
+
+
+
+/******************** Entry point ********************/
+void limbs_powmod(Limb *r, const Limb *a, unsigned an, const Limb *e,
+                  unsigned en, const Limb *m, unsigned n) {
+	if (m[0] & 1) {
+		Montgomery ctx(m, n);
+		window_pow(ctx, r, a, an, e, en, n);
+		ctx.from(r, r);
+	} else {
+		ModDiv ctx(m, n);
+		window_pow(ctx, r, a, an, e, en, n);
+		ctx.from(r, r);
+	}
+}
+
+
+bool limbs_sprp(const Limb *m, unsigned n, const Limb *a, unsigned an) {
+	Limb *const buf = limbs_scratch(4 * n);
+	Limb *const d = buf, *const x = buf + n;
+	Limb *const one = buf + 2 * n, *const minus_one = buf + 3 * n;
+
+	/* m - 1 = d * 2^s with d odd; m is odd so d is not zero */
+	limbs_sub_1(d, m, n, 1);
+	unsigned z = 0;
+	while (!d[z]) ++z;
+	const unsigned bits = BigInt::LIMB_BITS - 1 - limb_clz(d[z] & -d[z]);
+	const unsigned s = z * BigInt::LIMB_BITS + bits;
+	unsigned dn = n - z;
+	for (unsigned i = 0; i<dn; ++i) d[i] = d[z + i];
+	if (bits) limbs_rshift(d, d, dn, bits);
+	while (!d[dn - 1]) --dn;
+
+	/* Compare powers with one and minus one in Montgomery representation */
+	Montgomery ctx(m, n);
+	const Limb l = 1;
+	ctx.to(one, &l, 1);
+	limbs_sub_n(minus_one, m, one, n);
+
+	window_pow(ctx, x, a, an, d, dn, n);
+	bool prime = !limbs_cmp(x, one, n) || !limbs_cmp(x, minus_one, n);
+	for (unsigned i = 1; !prime && i<s; ++i) {
+		ctx.sqr(x, x);
+		if (!limbs_cmp(x, minus_one, n)) {
+			prime = true;
+		} else if (!limbs_cmp(x, one, n)) {
+			break;
+		}
+	}
+
+	limbs_scratch_free(buf, 4 * n);
+	return prime;
+}
+
+
+}
@@ -0,0 +1,341 @@
+/**
+ * \file
+ * BigInt Primality Testing.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * Primality test and search for the next prime.  Most composites
+ * have a small factor so numbers are first divided by small primes;
+ * instead of dividing by each prime separately, the number is divided
+ * by products of consecutive primes which fit in a limb and the
+ * remainders are reduced modulo each prime with machine arithmetic.
+ * The remaining numbers go through Miller-Rabin test which does
+ * exponentiation in Montgomery representation (see limbs_sprp()).
+ * Search for the next prime sieves blocks of odd candidates so only
+ * candidates with no small factor are tested.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "bigint-limb.hpp"
+
+
+namespace mina86 {
+
+
+/**
+ * Primes below this limit are used for trial division by
+ * BigInt::isProbablePrime().
+ */
+static const Limb TRIAL_LIMIT = 1000;
+
+/**
+ * Primes below this limit are used to sieve candidates by
+ * BigInt::nextPrime().
+ */
+static const Limb SIEVE_LIMIT = 1 << 14;
+
+/**
+ * Maximal number of odd candidates BigInt::nextPrime() sieves at
+ * once.
+ */
+static const unsigned SIEVE_SIZE = 4096;
+
+/**
+ * Size of a number (in limbs) from which rounds of Miller-Rabin test
+ * run in parallel if more than one thread is allowed.  Below it
+ * starting a thread costs more than a round.
+ */
+static const unsigned PARALLEL_THRESHOLD = 16;
+
+
+
+/******************** Small primes ********************/
+/**
+ * Odd primes below #SIEVE_LIMIT grouped so that product of primes in
+ * each group fits in a limb.  Primes below #TRIAL_LIMIT are never in
+ * the same group as greater primes.
+ */
+struct SmallPrimes {
+	/** Odd primes in increasing order. */
+	std::vector<Limb> primes;
+	/** Products of primes in each group. */
+	std::vector<Limb> products;
+	/** Index of the first prime of each group followed by number of
+	    primes. */
+	std::vector<unsigned> groups;
+	/** Number of groups of primes below #TRIAL_LIMIT. */
+	unsigned trial_groups;
+
+	/** Computes primes with sieve of Eratosthenes and groups them. */
+	SmallPrimes();
+};
+
+
+SmallPrimes::SmallPrimes() {
+	/* Index i stands for 2 * i + 1 */
+	std::vector<bool> composite(SIEVE_LIMIT / 2);
+	for (Limb i = 1; i<SIEVE_LIMIT / 2; ++i) {
+		if (composite[i]) continue;
+		const Limb p = 2 * i + 1;
+		primes.push_back(p);
+		for (Limb j = p * p / 2; j<SIEVE_LIMIT / 2; j += p) composite[j] = true;
+	}
+
+	trial_groups = 0;
+	DLimb product = 1;
+	for (unsigned i = 0; i<primes.size(); ++i) {
+		const bool trial = primes[i]<TRIAL_LIMIT;
+		if (groups.empty() || product * primes[i]>~(Limb)0 ||
+		    trial!=(primes[groups.back()]<TRIAL_LIMIT)) {
+			if (!groups.empty()) products.push_back((Limb)product);
+			groups.push_back(i);
+			trial_groups += trial;
+			product = 1;
+		}
+		product *= primes[i];
+	}
+	products.push_back((Limb)product);
+	groups.push_back(primes.size());
+}
+
+
+/**
+ * Returns table of small primes computing it on first use.
+ *
+ * \return table of small primes
+ */
+static const SmallPrimes &small_primes() {
+	static const SmallPrimes table;
+	return table;
+}
+
+
+/**
+ * Computes remainders of division by small primes.
+ *
+ * \param[out] r remainders, one for each prime in given groups
+ * \param[in] a number
+ * \param[in] n number of limbs in \a a
+ * \param[in] t table of small primes
+ * \param[in] groups number of groups to compute remainders for
+ */
+static void residues(Limb *r, const Limb *a, unsigned n,
+                     const SmallPrimes &t, unsigned groups) {
+	for (unsigned g = 0; g<groups; ++g) {
+		const Limb x = limbs_divmod_1(0, a, n, t.products[g]);
+		for (unsigned i = t.groups[g]; i<t.groups[g + 1]; ++i) {
+			r[i] = x % t.primes[i];
+		}
+	}
+}
+
+
+
+/******************** Miller-Rabin ********************/
+/**
+ * Checks whether a single limb number is a strong probable prime to
+ * given base.  Works the same way as limbs_sprp() but with machine
+ * arithmetic.
+ *
+ * \param[in] m number, must be odd and greater than \a a
+ * \param[in] a base, must be greater than one
+ * \return \c true if \a m is a strong probable prime to base \a a
+ */
+static bool sprp_1(Limb m, Limb a) {
+	Limb d = m - 1;
+	unsigned s = 0;
+	while (!(d & 1)) {
+		d >>= 1;
+		++s;
+	}
+
+	DLimb x = 1, p = a;
+	for (; d; d >>= 1) {
+		if (d & 1) x = x * p % m;
+		p = p * p % m;
+	}
+	if (x==1 || x==m - 1) {
+		return true;
+	}
+	while (--s) {
+		x = x * x % m;
+		if (x==m - 1) return true;
+		if (x==1) break;
+	}
+	return false;
+}
+
+
+/**
+ * Runs Miller-Rabin test.  Numbers which fit in a limb are tested
+ * with bases 2, 7 and 61 which is known to give an exact answer below
+ * 4759123141.  Numbers which fit in two limbs are tested
+ * with the first twelve primes as bases which is known to give an
+ * exact answer below 2^64 (and far beyond).  Bigger numbers are tested
+ * with base two and <code>rounds - 1</code> bases generated with
+ * xorshift generator seeded with the number.
+ *
+ * \param[in] m number, must be odd and greater than 61
+ * \param[in] n number of limbs in \a m; the most significant limb
+ *              must not be zero
+ * \param[in] rounds number of bases, at least one
+ * \return \c true if \a m is a strong probable prime to all bases
+ */
+static bool miller_rabin(const Limb *m, unsigned n, unsigned rounds) {
+	static const Limb small_bases[] = {
+		2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37
+	};
+	if (n==1) {
+		return sprp_1(m[0], 2) && sprp_1(m[0], 7) && sprp_1(m[0], 61);
+	} else if (n==2) {
+		for (unsigned i = 0; i<sizeof small_bases / sizeof *small_bases; ++i) {
+			if (!limbs_sprp(m, n, small_bases + i, 1)) return false;
+		}
+		return true;
+	}
+
+	if (!limbs_sprp(m, n, small_bases, 1)) {
+		return false;
+	} else if (!--rounds) {
+		return true;
+	}
+
+	/* Random bases less than m */
+	std::vector<Limb> bases(rounds * n);
+	std::vector<unsigned> sizes(rounds);
+	uint64_t state = ((uint64_t)m[n - 1] << 32 | m[0]) * 2 + 1;
+	for (unsigned r = 0; r<rounds; ++r) {
+		Limb *const a = &bases[r * n];
+		for (unsigned i = 0; i<n; ++i) {
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+			a[i] = (Limb)(state >> 16);
+		}
+		a[n - 1] %= m[n - 1];
+		unsigned an = n;
+		while (an && !a[an - 1]) --an;
+		if (an<=1 && (!an || a[0]<2)) {
+			a[0] = 2;
+			an = 1;
+		}
+		sizes[r] = an;
+	}
+
+	/* Run rounds, possibly in parallel */
+	std::atomic<bool> composite(false);
+	const auto run = [&](unsigned first, unsigned step) {
+		for (unsigned r = first; r<rounds && !composite; r += step) {
+			if (!limbs_sprp(m, n, &bases[r * n], sizes[r])) composite = true;
+		}
+	};
+
+	unsigned threads = BigInt::getThreads();
+	if (threads>rounds) threads = rounds;
+	if (threads>1 && n>=PARALLEL_THRESHOLD) {
+		std::vector<std::function<void()> > tasks;
+		for (unsigned i = 0; i<threads; ++i) {
+			tasks.push_back([&run, i, threads] { run(i, threads); });
+		}
+		limbs_parallel(&tasks[0], threads, threads);
+	} else {
+		run(0, 1);
+	}
+	return !composite;
+}
+
+
+
+/******************** Entry points ********************/
+bool BigInt::isProbablePrime(unsigned rounds) const {
+	if (sign<=0) {
+		return false;
+	}
+
+	const Limb *const m = limbs_ptr();
+	const unsigned n = limbs_count();
+	const SmallPrimes &t = small_primes();
+	if (n==1 && m[0]<TRIAL_LIMIT) {
+		return m[0]==2 ||
+			std::binary_search(t.primes.begin(), t.primes.end(), m[0]);
+	} else if (!(m[0] & 1)) {
+		return false;
+	}
+
+	/* Trial division */
+	for (unsigned g = 0; g<t.trial_groups; ++g) {
+		const Limb x = limbs_divmod_1(0, m, n, t.products[g]);
+		for (unsigned i = t.groups[g]; i<t.groups[g + 1]; ++i) {
+			if (!(x % t.primes[i])) return false;
+		}
+	}
+	if (n==1 && m[0]<TRIAL_LIMIT * TRIAL_LIMIT) {
+		return true;
+	}
+
+	return miller_rabin(m, n, rounds ? rounds : 1);
+}
+
+
+BigInt &BigInt::nextPrime(unsigned rounds) {
+	const SmallPrimes &t = small_primes();
+	if (sign<=0 || (limbs_count()==1 && limbs_ptr()[0]<2)) {
+		set_small(1, 2);
+		return *this;
+	} else if (limbs_count()==1 && limbs_ptr()[0]<t.primes.back()) {
+		set_small(1, *std::upper_bound(t.primes.begin(), t.primes.end(),
+		                               limbs_ptr()[0]));
+		return *this;
+	}
+
+	/* First odd candidate; it is greater than all primes in the table
+	   so each candidate divisible by any of them is composite */
+	add(limbs_ptr()[0] & 1 ? 2 : 1);
+
+	/* Gaps between primes grow with logarithm of the number so
+	   small numbers need smaller blocks and fewer primes to sieve
+	   with */
+	const unsigned bits = limbs_count() * LIMB_BITS;
+	const unsigned size = std::min(SIEVE_SIZE, std::max(64u, bits));
+	unsigned groups = std::lower_bound(t.groups.begin(), t.groups.end(),
+	                                   4 * bits) - t.groups.begin();
+	if (groups>t.products.size()) groups = t.products.size();
+	const unsigned np = t.groups[groups];
+	std::vector<Limb> rem(np);
+	residues(&rem[0], limbs_ptr(), limbs_count(), t, groups);
+
+	std::vector<char> sieve(size);
+	BigInt c;
+	for (;;) {
+		/* Candidate k is this + 2k; it is divisible by p if
+		   k = -this / 2 (mod p) */
+		std::fill(sieve.begin(), sieve.end(), 0);
+		for (unsigned i = 0; i<np; ++i) {
+			const Limb p = t.primes[i];
+			Limb k = (DLimb)(p - rem[i]) * ((p + 1) / 2) % p;
+			for (; k<size; k += p) sieve[k] = 1;
+		}
+
+		for (unsigned k = 0; k<size; ++k) {
+			if (sieve[k]) continue;
+			(c = *this).add(2 * k);
+			if (miller_rabin(c.limbs_ptr(), c.limbs_count(),
+			                 rounds ? rounds : 1)) {
+				return *this = std::move(c);
+			}
+		}
+
+		add(2 * size);
+		for (unsigned i = 0; i<np; ++i) {
+			rem[i] = (rem[i] + 2 * size) % t.primes[i];
+		}
+	}
+}
+
+
+}
@@ -0,0 +1,384 @@
+/**
+ * \file
+ * BigInt Radix Conversion.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * Conversion of limb vectors from and to strings of digits in bases
+ * from 2 to 36.  Power of two bases map directly onto bits of limbs
+ * and are converted in linear time.  Other bases use a table of
+ * powers <code>B^(2^i)</code> where \c B is the biggest power of base
+ * which fits in a limb.  Numbers are split by dividing by (when
+ * printing) or combined by multiplying by (when parsing) a power of
+ * similar size as square root of the number, so that conversion costs
+ * only a logarithmic factor more than multiplication.
+ */
+
+#include "bigint-limb.hpp"
+
+
+namespace mina86 {
+
+
+/**
+ * Number of limbs below which number is converted to digits by
+ * repeated division by a single limb.
+ */
+static const unsigned GET_STR_THRESHOLD = 30;
+
+/**
+ * Number of digits below which digits are converted to a number by
+ * repeated multiplication by a single limb.
+ */
+static const unsigned SET_STR_THRESHOLD = 600;
+
+
+
+/******************** Helpers ********************/
+/**
+ * Properties of a base.
+ */
+struct Radix {
+	/** Biggest power of base which fits in a limb. */
+	Limb big;
+	/** Number of digits in #big, ie. its exponent. */
+	unsigned digits;
+	/** Base's logarithm if base is a power of two, zero otherwise. */
+	unsigned bits;
+
+	/**
+	 * Computes properties of given base.
+	 *
+	 * \param[in] base base, from 2 to 36
+	 */
+	explicit Radix(unsigned base) : big(base), digits(1), bits(0) {
+		while (big <= ~(Limb)0 / base) {
+			big *= base;
+			++digits;
+		}
+		if (!(base & (base - 1))) {
+			while ((1u << bits) < base) ++bits;
+		}
+	}
+};
+
+
+/**
+ * Returns integer part of base's logarithm.
+ *
+ * \param[in] base base, from 2 to 36
+ * \return <code>floor(log2(base))</code>
+ */
+static unsigned log2_floor(unsigned base) {
+	unsigned bits = 0;
+	while ((2u << bits) <= base) ++bits;
+	return bits;
+}
+
+
+/**
+ * Table of powers <code>B^(2^i)</code> where \c B is Radix::big.
+ */
+class PowerTable {
+public:
+	/**
+	 * Single power.
+	 */
+	struct Power {
+		/** Limbs of the power. */
+		Limb *limbs;
+		/** Number of limbs, most significant limb is not zero. */
+		unsigned n;
+		/** Exponent of power in terms of base. */
+		unsigned digits;
+	};
+
+	/** Powers, the first one being Radix::big. */
+	Power pw[32];
+	/** Index of the biggest power in table. */
+	int top;
+
+	/**
+	 * Computes powers until the next power would have at least \a
+	 * max_digits digits.
+	 *
+	 * \param[in] rx base's properties
+	 * \param[in] max_digits limit of number of digits
+	 */
+	PowerTable(const Radix &rx, unsigned max_digits) : top(0) {
+		pw[0].limbs = limbs_scratch(1);
+		pw[0].limbs[0] = rx.big;
+		pw[0].n = 1;
+		pw[0].digits = rx.digits;
+
+		while (2 * pw[top].digits < max_digits) {
+			const Power &p = pw[top];
+			Power &q = pw[++top];
+			q.limbs = limbs_scratch(2 * p.n);
+			limbs_sqr(q.limbs, p.limbs, p.n);
+			q.n = 2 * p.n - !q.limbs[2 * p.n - 1];
+			q.digits = 2 * p.digits;
+		}
+	}
+
+	/**
+	 * Frees powers.
+	 */
+	~PowerTable() {
+		for (int i = top; i>0; --i) {
+			limbs_scratch_free(pw[i].limbs, 2 * pw[i - 1].n);
+		}
+		limbs_scratch_free(pw[0].limbs, 1);
+	}
+
+private:
+	/** Copying is not supported. */
+	PowerTable(const PowerTable &);
+	/** Copying is not supported. */
+	PowerTable &operator=(const PowerTable &);
+};
+
+
+
+/******************** Limbs -> digits ********************/
+unsigned limbs_get_str_size(unsigned n, unsigned base) {
+	return n * BigInt::LIMB_BITS / log2_floor(base) + 1;
+}
+
+
+/**
+ * Converts limb vector into digits in a power of two base.
+ *
+ * \param[in] end pointer one past the place for the least significant
+ *                digit
+ * \param[in] a limb vector
+ * \param[in] n number of limbs, the most significant limb must not be
+ *              zero
+ * \param[in] bits number of bits per digit
+ * \return pointer to the most significant digit
+ */
+static char *get_str_pow2(char *end, const Limb *a, unsigned n,
+                          unsigned bits) {
+	const unsigned total = n * BigInt::LIMB_BITS - limb_clz(a[n - 1]);
+	const Limb mask = ((Limb)1 << bits) - 1;
+
+	for (unsigned pos = 0; pos<total; pos += bits) {
+		const unsigned i = pos / BigInt::LIMB_BITS;
+		const unsigned off = pos % BigInt::LIMB_BITS;
+		Limb v = a[i] >> off;
+		if (off + bits > BigInt::LIMB_BITS && i + 1 < n) {
+			v |= a[i + 1] << (BigInt::LIMB_BITS - off);
+		}
+		*--end = v & mask;
+	}
+	return end;
+}
+
+
+char *limbs_get_str_basecase(char *end, const Limb *a, unsigned n,
+                             unsigned base) {
+	const Radix rx(base);
+	const unsigned tn = n;
+	Limb local[4], *const tmp = tn<=4 ? local : limbs_scratch(tn);
+	for (unsigned i = 0; i<n; ++i) tmp[i] = a[i];
+
+	while (n) {
+		Limb rem = limbs_divmod_1(tmp, tmp, n, rx.big);
+		if (!tmp[n - 1]) --n;
+		if (n) {
+			for (unsigned i = rx.digits; i; --i, rem /= base) {
+				*--end = rem % base;
+			}
+		} else {
+			do *--end = rem % base; while (rem /= base);
+		}
+	}
+
+	if (tmp!=local) limbs_scratch_free(tmp, tn);
+	return end;
+}
+
+
+/**
+ * Recursively converts limb vector into digits.  Number is divided by
+ * a power of base of about half its size and the quotient and the
+ * remainder are converted separately.
+ *
+ * \param[in] end pointer one past the place for the least significant
+ *                digit
+ * \param[in] a limb vector
+ * \param[in] n number of limbs, may have most significant zero limbs
+ * \param[in] base base, from 2 to 36
+ * \param[in] table powers of base
+ * \param[in] i index of the biggest power which may be used
+ * \param[in] width if not zero exact number of digits to write, the
+ *                  number is padded with zeros
+ * \return pointer to the most significant digit
+ */
+static char *get_str_rec(char *end, const Limb *a, unsigned n,
+                         unsigned base, const PowerTable &table, int i,
+                         unsigned width) {
+	while (n && !a[n - 1]) --n;
+
+	char *begin;
+	if (n<GET_STR_THRESHOLD) {
+		begin = n ? limbs_get_str_basecase(end, a, n, base) : end;
+	} else {
+		while (i>0 && 2 * table.pw[i].n > n + 1) --i;
+		const PowerTable::Power &p = table.pw[i];
+
+		Limb *const q = limbs_scratch(n + 1), *const r = q + (n - p.n + 1);
+		limbs_div_qr(q, r, a, n, p.limbs, p.n);
+		begin = get_str_rec(end, r, p.n, base, table, i, p.digits);
+		begin = get_str_rec(begin, q, n - p.n + 1, base, table, i,
+		                    width>p.digits ? width - p.digits : 0);
+		limbs_scratch_free(q, n + 1);
+	}
+
+	if (width) {
+		for (char *const stop = end - width; begin!=stop; *--begin = 0);
+	}
+	return begin;
+}
+
+
+char *limbs_get_str(char *end, const Limb *a, unsigned n, unsigned base) {
+	const Radix rx(base);
+	if (rx.bits) {
+		return get_str_pow2(end, a, n, rx.bits);
+	} else if (n<GET_STR_THRESHOLD) {
+		return limbs_get_str_basecase(end, a, n, base);
+	} else {
+		const PowerTable table(rx, (n + 1) * rx.digits / 2);
+		return get_str_rec(end, a, n, base, table, table.top, 0);
+	}
+}
+
+
+
+/******************** Digits -> limbs ********************/
+unsigned limbs_set_str_size(unsigned len, unsigned base) {
+	return len / Radix(base).digits + 1;
+}
+
+
+/**
+ * Converts digits in a power of two base into limb vector.
+ *
+ * \param[out] r result
+ * \param[in] str digits
+ * \param[in] len number of digits
+ * \param[in] bits number of bits per digit
+ * \return number of limbs in result with most significant zero limbs
+ *         stripped
+ */
+static unsigned set_str_pow2(Limb *r, const char *str, unsigned len,
+                             unsigned bits) {
+	unsigned n = 0, shift = 0;
+	Limb cur = 0;
+
+	for (const char *ch = str + len; ch!=str; ) {
+		const Limb d = *--ch;
+		cur |= d << shift;
+		shift += bits;
+		if (shift>=BigInt::LIMB_BITS) {
+			r[n++] = cur;
+			shift -= BigInt::LIMB_BITS;
+			cur = shift ? d >> (bits - shift) : 0;
+		}
+	}
+	r[n++] = cur;
+
+	while (n && !r[n - 1]) --n;
+	return n;
+}
+
+
+unsigned limbs_set_str_basecase(Limb *r, const char *str, unsigned len,
+                                unsigned base) {
+	const Radix rx(base);
+	const char *const end = str + len;
+	unsigned n = 0;
+
+	for (unsigned chunk = len ? (len - 1) % rx.digits + 1 : 0; str!=end;
+	     chunk = rx.digits) {
+		Limb value = 0, mul = 1;
+		for (; chunk; --chunk) {
+			value = value * base + *str++;
+			mul *= base;
+		}
+		const Limb c = limbs_mul_1(r, r, n, mul, value);
+		if (c) r[n++] = c;
+	}
+
+	return n;
+}
+
+
+/**
+ * Recursively converts digits into limb vector.  Digits are split so
+ * that the lower part has as many digits as some power of base, the
+ * parts are converted separately and combined with a single
+ * multiplication.
+ *
+ * \param[out] r result
+ * \param[in] str digits
+ * \param[in] len number of digits
+ * \param[in] base base, from 2 to 36
+ * \param[in] table powers of base
+ * \param[in] i index of the biggest power which may be used
+ * \return number of limbs in result with most significant zero limbs
+ *         stripped
+ */
+static unsigned set_str_rec(Limb *r, const char *str, unsigned len,
+                            unsigned base, const PowerTable &table, int i) {
+	if (len<SET_STR_THRESHOLD) {
+		return limbs_set_str_basecase(r, str, len, base);
+	}
+
+	while (i>0 && table.pw[i].digits>=len) --i;
+	const PowerTable::Power &p = table.pw[i];
+	const unsigned hlen = len - p.digits;
+
+	const unsigned lsize = limbs_set_str_size(p.digits, base);
+	const unsigned hsize = limbs_set_str_size(hlen, base);
+	Limb *const l = limbs_scratch(lsize);
+	const unsigned ln = set_str_rec(l, str + hlen, p.digits, base, table, i);
+	Limb *const h = limbs_scratch(hsize);
+	const unsigned hn = set_str_rec(h, str, hlen, base, table, i);
+
+	unsigned n;
+	if (!hn) {
+		for (n = 0; n<ln; ++n) r[n] = l[n];
+	} else {
+		n = hn + p.n;
+		Limb *const t = limbs_scratch(n);
+		limbs_mul(t, p.limbs, p.n, h, hn);
+		limbs_add(t, t, n, l, ln);
+		while (!t[n - 1]) --n;
+		for (unsigned j = 0; j<n; ++j) r[j] = t[j];
+		limbs_scratch_free(t, hn + p.n);
+	}
+
+	limbs_scratch_free(h, hsize);
+	limbs_scratch_free(l, lsize);
+	return n;
+}
+
+
+unsigned limbs_set_str(Limb *r, const char *str, unsigned len,
+                       unsigned base) {
+	const Radix rx(base);
+	if (rx.bits) {
+		return set_str_pow2(r, str, len, rx.bits);
+	} else if (len<SET_STR_THRESHOLD) {
+		return limbs_set_str_basecase(r, str, len, base);
+	} else {
+		const PowerTable table(rx, len);
+		return set_str_rec(r, str, len, base, table, table.top);
+	}
+}
+
+
+}
@@ -0,0 +1,445 @@
+/**
+ * \file
+ * BigInt Roots.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * Integer roots and perfect power detection.  Root of a number is
+ * computed from the root of its leading part: if \c r is the root of
+ * the number shifted right by <code>k * b</code> bits then <code>(r +
+ * 1) * 2^b</code> is slightly greater than the root and a single
+ * Newton's step from it gives the root with all bits correct but
+ * maybe the last one.  Each recursion level doubles number of known
+ * bits so the top level, which costs a division and a power of a
+ * number of full size, dominates the cost.
+ */
+
+#include <cmath>
+#include <utility>
+
+#include "bigint-limb.hpp"
+
+
+namespace mina86 {
+
+
+/**
+ * Number of bits of a root below which perfectPower() checks
+ * candidates computed from the leading bits instead of computing
+ * remainders.
+ */
+static const unsigned SMALL_ROOT_BITS = 40;
+
+/**
+ * Number of small primes modulo which a number is checked to be
+ * a power before its root is computed.
+ */
+static const unsigned FILTER_PRIMES = 6;
+
+
+
+/******************** Machine integers ********************/
+/**
+ * Checks whether a power of a machine integer does not exceed another
+ * one.
+ *
+ * \param[in] m base
+ * \param[in] k exponent
+ * \param[in] n number to compare with
+ * \return \c true if <code>m^k <= n</code>
+ */
+static bool u64_pow_le(uint64_t m, unsigned long k, uint64_t n) {
+	uint64_t r = 1;
+	while (k--) {
+		if (m && r>n / m) return false;
+		r *= m;
+	}
+	return r<=n;
+}
+
+
+/**
+ * Raises machine integer to a power modulo 2^64.
+ *
+ * \param[in] m base
+ * \param[in] k exponent
+ * \return <code>m^k mod 2^64</code>
+ */
+static uint64_t u64_pow(uint64_t m, unsigned long k) {
+	uint64_t r = 1;
+	for (; k; k >>= 1, m *= m) {
+		if (k & 1) r *= m;
+	}
+	return r;
+}
+
+
+/**
+ * Computes root of a machine integer rounded down.
+ *
+ * \param[in] n number
+ * \param[in] k degree of the root, at least two
+ * \return <code>floor(n^(1/k))</code>
+ */
+static uint64_t u64_root(uint64_t n, unsigned long k) {
+	uint64_t lo = 0, hi = (uint64_t)1 << 32;
+	while (hi - lo>1) {
+		const uint64_t mid = lo + (hi - lo) / 2;
+		if (u64_pow_le(mid, k, n)) lo = mid; else hi = mid;
+	}
+	return lo;
+}
+
+
+/**
+ * Raises a number to a power modulo a limb.
+ *
+ * \param[in] a base, less than \a m
+ * \param[in] e exponent
+ * \param[in] m modulus
+ * \return <code>a^e mod m</code>
+ */
+static Limb limb_powmod(Limb a, unsigned long e, Limb m) {
+	DLimb r = 1, x = a;
+	for (; e; e >>= 1, x = x * x % m) {
+		if (e & 1) r = r * x % m;
+	}
+	return (Limb)r;
+}
+
+
+/**
+ * Checks whether a limb is a prime using trial division.
+ *
+ * \param[in] q number to check
+ * \return \c true if \a q is a prime
+ */
+static bool limb_is_prime(Limb q) {
+	if (q<2) return false;
+	for (Limb d = 2; (DLimb)d * d<=q; ++d) {
+		if (!(q % d)) return false;
+	}
+	return true;
+}
+
+
+/**
+ * Computes remainder of division of limb vector by a limb.
+ *
+ * \param[in] a limb vector
+ * \param[in] n number of limbs
+ * \param[in] d divisor, must not be zero
+ * \return <code>a mod d</code>
+ */
+static Limb limbs_mod_1(const Limb *a, unsigned n, Limb d) {
+	DLimb r = 0;
+	while (n--) r = (r << BigInt::LIMB_BITS | a[n]) % d;
+	return (Limb)r;
+}
+
+
+
+/******************** Roots ********************/
+/**
+ * Root computation.  The class is a friend of BigInt so it can look
+ * at limbs of the numbers.
+ */
+class BigIntRoot {
+public:
+	/**
+	 * Computes root of a positive number rounded down.
+	 *
+	 * \param[in] n positive number
+	 * \param[in] k degree of the root, at least two
+	 * \return <code>floor(n^(1/k))</code>
+	 */
+	static BigInt root(const BigInt &n, unsigned long k);
+
+	/**
+	 * Checks whether a positive number is a power with given prime
+	 * exponent.
+	 *
+	 * \param[in] n number, at least two
+	 * \param[in] p prime exponent
+	 * \param[out] r the root if the number is a power
+	 * \return \c true if \a n is <code>r^p</code>
+	 */
+	static bool is_power(const BigInt &n, unsigned long p, BigInt &r);
+
+	/**
+	 * Returns number of bits of a number.
+	 *
+	 * \param[in] x number
+	 * \return number of significant bits of \a x's absolute value
+	 */
+	static unsigned long bits(const BigInt &x) {
+		const unsigned n = x.limbs_count();
+		return n ? (unsigned long)n * BigInt::LIMB_BITS
+			- limb_clz(x.limbs_ptr()[n - 1]) : 0;
+	}
+
+private:
+	/**
+	 * Returns number of trailing zero bits of a non-zero number.
+	 *
+	 * \param[in] x number, must not be zero
+	 * \return number of least significant bits which are zero
+	 */
+	static unsigned long ctz(const BigInt &x);
+
+	/**
+	 * Returns the least significant 64 bits of a number.
+	 *
+	 * \param[in] x number
+	 * \return <code>|x| mod 2^64</code>
+	 */
+	static uint64_t low(const BigInt &x) {
+		const Limb *const p = x.limbs_ptr();
+		const unsigned n = x.limbs_count();
+		return !n ? 0 : n==1 ? p[0] : p[0] | (uint64_t)p[1] << 32;
+	}
+
+	/**
+	 * Converts machine integer to BigInt.
+	 *
+	 * \param[in] v value
+	 * \return \a v as BigInt
+	 */
+	static BigInt from(uint64_t v) {
+		BigInt r;
+		r.set_small(1, v);
+		return r;
+	}
+
+	/**
+	 * Shifts absolute value of a number right.
+	 *
+	 * \param[in] x number
+	 * \param[in] s number of bits to shift by
+	 * \return <code>floor(|x| / 2^s)</code>
+	 */
+	static BigInt shr(const BigInt &x, unsigned long s);
+
+	/**
+	 * Shifts absolute value of a number left.
+	 *
+	 * \param[in] x number
+	 * \param[in] s number of bits to shift by
+	 * \return <code>|x| * 2^s</code>
+	 */
+	static BigInt shl(const BigInt &x, unsigned long s);
+
+	/**
+	 * Stores limb vector in a BigInt.
+	 *
+	 * \param[in] vec limb vector allocated with \c new[] which
+	 *                ownership is passed to the result
+	 * \param[in] n number of limbs in \a vec
+	 * \return non-negative number with limbs \a vec
+	 */
+	static BigInt wrap(Limb *vec, unsigned n) {
+		BigInt r;
+		r.sign = 1;
+		r.limbs.set_no_copy(vec, n, n);
+		r.normalize();
+		return r;
+	}
+};
+
+
+unsigned long BigIntRoot::ctz(const BigInt &x) {
+	const Limb *p = x.limbs_ptr();
+	unsigned long r = 0;
+	for (; !*p; ++p) r += BigInt::LIMB_BITS;
+	for (Limb l = *p; !(l & 1); l >>= 1) ++r;
+	return r;
+}
+
+
+BigInt BigIntRoot::shr(const BigInt &x, unsigned long s) {
+	const unsigned n = x.limbs_count();
+	const unsigned long k = s / BigInt::LIMB_BITS;
+	if (k>=n) return BigInt();
+
+	const unsigned rn = n - k;
+	Limb *const vec = limbs_alloc(rn);
+	if (s % BigInt::LIMB_BITS) {
+		limbs_rshift(vec, x.limbs_ptr() + k, rn, s % BigInt::LIMB_BITS);
+	} else {
+		for (unsigned i = 0; i<rn; ++i) vec[i] = x.limbs_ptr()[k + i];
+	}
+	return wrap(vec, rn);
+}
+
+
+BigInt BigIntRoot::shl(const BigInt &x, unsigned long s) {
+	const unsigned n = x.limbs_count();
+	if (!n) return BigInt();
+
+	const unsigned k = s / BigInt::LIMB_BITS, rn = n + k + 1;
+	Limb *const vec = limbs_alloc(rn);
+	for (unsigned i = 0; i<k; ++i) vec[i] = 0;
+	if (s % BigInt::LIMB_BITS) {
+		vec[rn - 1] = limbs_lshift(vec + k, x.limbs_ptr(), n,
+		                           s % BigInt::LIMB_BITS);
+	} else {
+		for (unsigned i = 0; i<n; ++i) vec[k + i] = x.limbs_ptr()[i];
+		vec[rn - 1] = 0;
+	}
+	return wrap(vec, rn);
+}
+
+
+BigInt BigIntRoot::root(const BigInt &n, unsigned long k) {
+	const unsigned long bn = bits(n);
+	if (k>=bn) {
+		return from(1);
+	} else if (bn<=64) {
+		return from(u64_root(low(n), k));
+	}
+
+	/* Number of bits of the root and of k */
+	const unsigned long rb = (bn + k - 1) / k;
+	unsigned long kb = 0;
+	for (unsigned long t = k; t; t >>= 1) ++kb;
+
+	/*
+	 * Root has only a few bits more than k; there is not enough of
+	 * them for Newton's step to converge in one go so bisect.
+	 * Invariant: lo^k <= n < hi^k.
+	 */
+	if (rb<=2 * kb + 8) {
+		BigInt lo(from(1)), hi(shl(from(1), rb)), mid;
+		const BigInt one(from(1));
+		while (BigInt(hi - lo).cmp(one)>0) {
+			mid = lo + hi;
+			mid = shr(mid, 1);
+			std::swap(pow(mid, k).cmp(n)<=0 ? lo : hi, mid);
+		}
+		return lo;
+	}
+
+	/*
+	 * Root of the leading part.  Its error after shifting back is
+	 * below 2^(b+1) and Newton's step squares relative error so with
+	 * b about half of rb minus bits of k the result is off by at
+	 * most one.
+	 */
+	const unsigned long b = (rb - kb - 3) / 2;
+	BigInt x = root(shr(n, k * b), k);
+	x.add(from(1));
+	x = shl(x, b);
+
+	/* Newton's step from above: y = ((k - 1) x + n / x^(k-1)) / k */
+	BigInt y(n);
+	if (k==2) {
+		y.div(x).add(x);
+		y = shr(y, 1);
+	} else {
+		BigInt k1;
+		k1.set(k - 1);
+		y.div(pow(x, k - 1));
+		y += x * k1;
+		k1.set(k);
+		y.div(k1);
+	}
+
+	/* Newton's step from above never undershoots */
+	while (pow(y, k).cmp(n)>0) y.sub(from(1));
+	return y;
+}
+
+
+
+/******************** Perfect powers ********************/
+bool BigIntRoot::is_power(const BigInt &n, unsigned long p, BigInt &r) {
+	/* Number of trailing zeros must be divisible by p */
+	const unsigned long z = ctz(n);
+	if (z % p) return false;
+
+	const unsigned long bn = bits(n);
+	if (bn / p<SMALL_ROOT_BITS) {
+		/*
+		 * Root is short so the leading bits give it up to one;
+		 * check candidates against the trailing 64 bits.
+		 */
+		const uint64_t top = bn<=64 ? low(n) : low(shr(n, bn - 64));
+		const double e = ((double)(bn<=64 ? 0 : bn - 64)
+		                  + std::log((double)top) / std::log(2.0)) / p;
+		const uint64_t c = (uint64_t)std::floor(std::pow(2.0, e));
+		const uint64_t l = low(n);
+		for (uint64_t d = c ? c - 1 : 0; d<=c + 1; ++d) {
+			if (d>1 && u64_pow(d, p)==l) {
+				r = from(d);
+				if (!pow(r, p).cmp(n)) return true;
+			}
+		}
+		return false;
+	}
+
+	/*
+	 * If n = r^p then n^((q-1)/p) = r^(q-1) = 1 (mod q) for primes
+	 * q = 1 (mod p) which do not divide r.
+	 */
+	const Limb *const a = n.limbs_ptr();
+	const unsigned an = n.limbs_count();
+	unsigned found = 0;
+	for (DLimb q = 2 * p + 1; found<FILTER_PRIMES && q<0xffffffffu;
+	     q += 2 * p) {
+		if (!limb_is_prime((Limb)q)) continue;
+		++found;
+		const Limb m = limbs_mod_1(a, an, (Limb)q);
+		if (m && limb_powmod(m, (q - 1) / p, (Limb)q)!=1) return false;
+	}
+
+	r = root(n, p);
+	return !pow(r, p).cmp(n);
+}
+
+
+
+/******************** BigInt methods ********************/
+BigInt &BigInt::iroot(unsigned long k) {
+	if (!k) {
+		throw DivisionByZero();
+	} else if (sign<0 && !(k & 1)) {
+		throw BadRoot();
+	} else if (k>1 && sign) {
+		const int s = sign;
+		sign = 1;
+		*this = BigIntRoot::root(*this, k);
+		sign = s;
+	}
+	return *this;
+}
+
+
+unsigned long BigInt::perfectPower(BigInt *root) const {
+	if (!limbs && small_value()<=1) {
+		if (root) *root = *this;
+		return 0;
+	}
+
+	/* Even exponents are tried only for positive numbers */
+	BigInt n(*this), r;
+	n.abs();
+	unsigned long k = 1;
+	for (unsigned long p = sign>0 ? 2 : 3; p<BigIntRoot::bits(n); ) {
+		if (BigIntRoot::is_power(n, p, r)) {
+			std::swap(n, r);
+			k *= p;
+		} else {
+			do ++p; while (!limb_is_prime(p));
+		}
+	}
+
+	if (root) {
+		*root = std::move(n);
+		root->sign = sign;
+	}
+	return k;
+}
+
+
+}
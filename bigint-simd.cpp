@@ -0,0 +1,362 @@
+/**
+ * \file
+ * BigInt Vector Addition.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * Addition and substraction of long limb vectors using SSE2, AVX2 or
+ * AVX-512 instructions chosen at run time.  A vector of \c k limbs
+ * of both operands is added lane by lane and two masks are computed:
+ * \c G of lanes which overflowed (generate a carry) and \c P of lanes
+ * whose sum has all bits set (propagate incoming carry).  Carry into
+ * each lane is then given by the bits of <code>((G | P) + G + c) ^
+ * P</code> where \c c is carry into the vector, and bit \c k of the
+ * sum is the carry out of the vector.  This is the carry-lookahead
+ * adder done with a single scalar addition, so the serial dependency
+ * between vectors is one addition and one shift instead of a carry
+ * per limb.  Substraction works the same with borrows: lanes which
+ * underflowed generate a borrow and lanes whose difference is zero
+ * propagate it.
+ *
+ * Kernels are compiled with target attributes so the rest of the
+ * code does not need any special compiler flags.  On other
+ * processors and compilers portable limb by limb loops are used.
+ */
+
+#include <atomic>
+
+#include "bigint-limb.hpp"
+
+#if defined __GNUC__ && (defined __x86_64__ || defined __i386__)
+#  define MN_BIGINT_X86 1
+#  include <immintrin.h>
+#endif
+
+
+namespace mina86 {
+
+
+/**
+ * Type of add and substract kernels.
+ */
+typedef Limb (*Kernel)(Limb *r, const Limb *a, const Limb *b, unsigned n);
+
+
+
+/******************** Helpers ********************/
+/**
+ * Computes carries into lanes of a vector from masks of lanes which
+ * generate and propagate a carry.
+ *
+ * \param[in] g mask of lanes which generate a carry
+ * \param[in] p mask of lanes which propagate a carry
+ * \param[in,out] carry carry into the vector on input, carry out of
+ *                      it on output
+ * \param[in] lanes number of lanes in the vector
+ * \return mask of lanes which receive a carry
+ */
+static inline unsigned lanes_carry(unsigned g, unsigned p, Limb &carry,
+                                   unsigned lanes) {
+	const unsigned t = (g | p) + g + carry;
+	carry = t >> lanes;
+	return (t ^ p) & ((1u << lanes) - 1);
+}
+
+
+/**
+ * Adds limb vectors with incoming carry one limb at a time.
+ *
+ * \param[out] r result (\a n limbs)
+ * \param[in] a first operand
+ * \param[in] b second operand
+ * \param[in] n number of limbs
+ * \param[in] carry incoming carry
+ * \return carry
+ */
+static inline Limb add_tail(Limb *r, const Limb *a, const Limb *b,
+                            unsigned n, Limb carry) {
+	DLimb t = carry;
+	for (unsigned i = 0; i<n; ++i) {
+		t += (DLimb)a[i] + b[i];
+		r[i] = (Limb)t;
+		t >>= BigInt::LIMB_BITS;
+	}
+	return (Limb)t;
+}
+
+
+/**
+ * Substracts limb vectors with incoming borrow one limb at a time.
+ *
+ * \param[out] r result (\a n limbs)
+ * \param[in] a minuend
+ * \param[in] b subtrahend
+ * \param[in] n number of limbs
+ * \param[in] borrow incoming borrow
+ * \return borrow
+ */
+static inline Limb sub_tail(Limb *r, const Limb *a, const Limb *b,
+                            unsigned n, Limb borrow) {
+	for (unsigned i = 0; i<n; ++i) {
+		const Limb x = a[i], y = b[i];
+		r[i] = x - y - borrow;
+		borrow = x < y || (x == y && borrow);
+	}
+	return borrow;
+}
+
+
+
+/******************** Scalar ********************/
+static Limb add_scalar(Limb *r, const Limb *a, const Limb *b, unsigned n) {
+	return limbs_add_n_basecase(r, a, b, n);
+}
+
+static Limb sub_scalar(Limb *r, const Limb *a, const Limb *b, unsigned n) {
+	return limbs_sub_n_basecase(r, a, b, n);
+}
+
+
+
+#ifdef MN_BIGINT_X86
+
+/******************** SSE2 ********************/
+__attribute__((target("sse2")))
+static Limb add_sse2(Limb *r, const Limb *a, const Limb *b, unsigned n) {
+	const __m128i bias = _mm_set1_epi32(0x80000000);
+	const __m128i ones = _mm_set1_epi32(-1);
+	const __m128i bits = _mm_setr_epi32(1, 2, 4, 8);
+	Limb carry = 0;
+	unsigned i = 0;
+	for (; i + 4<=n; i += 4) {
+		const __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+		const __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+		__m128i s = _mm_add_epi32(x, y);
+
+		/* No unsigned comparison; flip sign bits instead */
+		const __m128i g = _mm_cmpgt_epi32(_mm_xor_si128(x, bias),
+		                                  _mm_xor_si128(s, bias));
+		const __m128i p = _mm_cmpeq_epi32(s, ones);
+		const unsigned c = lanes_carry(
+			_mm_movemask_ps(_mm_castsi128_ps(g)),
+			_mm_movemask_ps(_mm_castsi128_ps(p)), carry, 4);
+
+		const __m128i m = _mm_and_si128(_mm_set1_epi32(c), bits);
+		s = _mm_sub_epi32(s, _mm_cmpeq_epi32(m, bits));
+		_mm_storeu_si128((__m128i *)(r + i), s);
+	}
+	return add_tail(r + i, a + i, b + i, n - i, carry);
+}
+
+
+__attribute__((target("sse2")))
+static Limb sub_sse2(Limb *r, const Limb *a, const Limb *b, unsigned n) {
+	const __m128i bias = _mm_set1_epi32(0x80000000);
+	const __m128i bits = _mm_setr_epi32(1, 2, 4, 8);
+	Limb borrow = 0;
+	unsigned i = 0;
+	for (; i + 4<=n; i += 4) {
+		const __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+		const __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+		__m128i d = _mm_sub_epi32(x, y);
+
+		const __m128i g = _mm_cmpgt_epi32(_mm_xor_si128(y, bias),
+		                                  _mm_xor_si128(x, bias));
+		const __m128i p = _mm_cmpeq_epi32(d, _mm_setzero_si128());
+		const unsigned c = lanes_carry(
+			_mm_movemask_ps(_mm_castsi128_ps(g)),
+			_mm_movemask_ps(_mm_castsi128_ps(p)), borrow, 4);
+
+		const __m128i m = _mm_and_si128(_mm_set1_epi32(c), bits);
+		d = _mm_add_epi32(d, _mm_cmpeq_epi32(m, bits));
+		_mm_storeu_si128((__m128i *)(r + i), d);
+	}
+	return sub_tail(r + i, a + i, b + i, n - i, borrow);
+}
+
+
+
+/******************** AVX2 ********************/
+__attribute__((target("avx2")))
+static Limb add_avx2(Limb *r, const Limb *a, const Limb *b, unsigned n) {
+	const __m256i bias = _mm256_set1_epi32(0x80000000);
+	const __m256i ones = _mm256_set1_epi32(-1);
+	const __m256i bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+	Limb carry = 0;
+	unsigned i = 0;
+	for (; i + 8<=n; i += 8) {
+		const __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+		const __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+		__m256i s = _mm256_add_epi32(x, y);
+
+		const __m256i g = _mm256_cmpgt_epi32(_mm256_xor_si256(x, bias),
+		                                     _mm256_xor_si256(s, bias));
+		const __m256i p = _mm256_cmpeq_epi32(s, ones);
+		const unsigned c = lanes_carry(
+			_mm256_movemask_ps(_mm256_castsi256_ps(g)),
+			_mm256_movemask_ps(_mm256_castsi256_ps(p)), carry, 8);
+
+		const __m256i m = _mm256_and_si256(_mm256_set1_epi32(c), bits);
+		s = _mm256_sub_epi32(s, _mm256_cmpeq_epi32(m, bits));
+		_mm256_storeu_si256((__m256i *)(r + i), s);
+	}
+	return add_tail(r + i, a + i, b + i, n - i, carry);
+}
+
+
+__attribute__((target("avx2")))
+static Limb sub_avx2(Limb *r, const Limb *a, const Limb *b, unsigned n) {
+	const __m256i bias = _mm256_set1_epi32(0x80000000);
+	const __m256i bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+	Limb borrow = 0;
+	unsigned i = 0;
+	for (; i + 8<=n; i += 8) {
+		const __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+		const __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+		__m256i d = _mm256_sub_epi32(x, y);
+
+		const __m256i g = _mm256_cmpgt_epi32(_mm256_xor_si256(y, bias),
+		                                     _mm256_xor_si256(x, bias));
+		const __m256i p = _mm256_cmpeq_epi32(d, _mm256_setzero_si256());
+		const unsigned c = lanes_carry(
+			_mm256_movemask_ps(_mm256_castsi256_ps(g)),
+			_mm256_movemask_ps(_mm256_castsi256_ps(p)), borrow, 8);
+
+		const __m256i m = _mm256_and_si256(_mm256_set1_epi32(c), bits);
+		d = _mm256_add_epi32(d, _mm256_cmpeq_epi32(m, bits));
+		_mm256_storeu_si256((__m256i *)(r + i), d);
+	}
+	return sub_tail(r + i, a + i, b + i, n - i, borrow);
+}
+
+
+
+/******************** AVX-512 ********************/
+__attribute__((target("avx512f")))
+static Limb add_avx512(Limb *r, const Limb *a, const Limb *b, unsigned n) {
+	const __m512i ones = _mm512_set1_epi32(-1);
+	Limb carry = 0;
+	unsigned i = 0;
+	for (; i + 16<=n; i += 16) {
+		const __m512i x = _mm512_loadu_si512(a + i);
+		const __m512i y = _mm512_loadu_si512(b + i);
+		__m512i s = _mm512_add_epi32(x, y);
+
+		const __mmask16 c = lanes_carry(_mm512_cmplt_epu32_mask(s, x),
+		                                _mm512_cmpeq_epi32_mask(s, ones),
+		                                carry, 16);
+		s = _mm512_mask_sub_epi32(s, c, s, ones);
+		_mm512_storeu_si512(r + i, s);
+	}
+	return add_tail(r + i, a + i, b + i, n - i, carry);
+}
+
+
+__attribute__((target("avx512f")))
+static Limb sub_avx512(Limb *r, const Limb *a, const Limb *b, unsigned n) {
+	const __m512i ones = _mm512_set1_epi32(-1);
+	Limb borrow = 0;
+	unsigned i = 0;
+	for (; i + 16<=n; i += 16) {
+		const __m512i x = _mm512_loadu_si512(a + i);
+		const __m512i y = _mm512_loadu_si512(b + i);
+		__m512i d = _mm512_sub_epi32(x, y);
+
+		const __mmask16 c = lanes_carry(
+			_mm512_cmplt_epu32_mask(x, y),
+			_mm512_cmpeq_epi32_mask(d, _mm512_setzero_si512()),
+			borrow, 16);
+		d = _mm512_mask_add_epi32(d, c, d, ones);
+		_mm512_storeu_si512(r + i, d);
+	}
+	return sub_tail(r + i, a + i, b + i, n - i, borrow);
+}
+
+#endif
+
+
+
+/******************** Dispatch ********************/
+static Limb add_resolve(Limb *r, const Limb *a, const Limb *b, unsigned n);
+static Limb sub_resolve(Limb *r, const Limb *a, const Limb *b, unsigned n);
+
+/**
+ * Addition kernel in use.  Until the first call it points to a
+ * function which picks the kernel; being constant initialised it is
+ * valid even during initialisation of static objects.
+ */
+static std::atomic<Kernel> add_kernel(add_resolve);
+
+/**
+ * Substraction kernel in use.
+ * \sa add_kernel
+ */
+static std::atomic<Kernel> sub_kernel(sub_resolve);
+
+/**
+ * Instruction set of kernels in use or \c -1 if not chosen yet.
+ */
+static std::atomic<int> simd_level(-1);
+
+
+static Limb add_resolve(Limb *r, const Limb *a, const Limb *b, unsigned n) {
+	limbs_simd_use(limbs_simd_best());
+	return add_kernel.load(std::memory_order_relaxed)(r, a, b, n);
+}
+
+
+static Limb sub_resolve(Limb *r, const Limb *a, const Limb *b, unsigned n) {
+	limbs_simd_use(limbs_simd_best());
+	return sub_kernel.load(std::memory_order_relaxed)(r, a, b, n);
+}
+
+
+LimbsSimd limbs_simd_best() {
+#ifdef MN_BIGINT_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) return LIMBS_AVX512;
+	if (__builtin_cpu_supports("avx2"))    return LIMBS_AVX2;
+	if (__builtin_cpu_supports("sse2"))    return LIMBS_SSE2;
+#endif
+	return LIMBS_SCALAR;
+}
+
+
+void limbs_simd_use(LimbsSimd simd) {
+	Kernel add = add_scalar, sub = sub_scalar;
+#ifdef MN_BIGINT_X86
+	switch (simd) {
+	case LIMBS_AVX512: add = add_avx512; sub = sub_avx512; break;
+	case LIMBS_AVX2:   add = add_avx2;   sub = sub_avx2;   break;
+	case LIMBS_SSE2:   add = add_sse2;   sub = sub_sse2;   break;
+	case LIMBS_SCALAR: break;
+	}
+#else
+	simd = LIMBS_SCALAR;
+#endif
+	add_kernel.store(add, std::memory_order_relaxed);
+	sub_kernel.store(sub, std::memory_order_relaxed);
+	simd_level.store(simd, std::memory_order_relaxed);
+}
+
+
+LimbsSimd limbs_simd_current() {
+	if (simd_level.load(std::memory_order_relaxed)<0) {
+		limbs_simd_use(limbs_simd_best());
+	}
+	return (LimbsSimd)simd_level.load(std::memory_order_relaxed);
+}
+
+
+Limb limbs_add_n_simd(Limb *r, const Limb *a, const Limb *b, unsigned n) {
+	return add_kernel.load(std::memory_order_relaxed)(r, a, b, n);
+}
+
+
+Limb limbs_sub_n_simd(Limb *r, const Limb *a, const Limb *b, unsigned n) {
+	return sub_kernel.load(std::memory_order_relaxed)(r, a, b, n);
+}
+
+
+}
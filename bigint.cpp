@@ -6,40 +6,176 @@
  * Licensed under the Academic Free License version 2.1
  */
 
-#include <cstdio>
+#include <algorithm>
+#include <cfloat>
+#include <climits>
 #include <cmath>
+#include <cstring>
+#include <memory>
 
 #include "bigint.hpp"
+#include "bigint-limb.hpp"
 
 
 namespace mina86 {
 
 
 /**
- * Static buffer for convertin integers into BigInt objects.
+ * Characters used to represent digits in lower case.
  */
-static char buffer[2 + 3 * sizeof(long)];
+static const char LOWER_DIGITS[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+/**
+ * Characters used to represent digits in upper case.
+ */
+static const char UPPER_DIGITS[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+/**
+ * Number of characters which fit in a buffer allocated on stack by
+ * conversion routines.  Longer strings are allocated on heap.
+ */
+static const unsigned STACK_CHARS = 128;
+
+
+/**
+ * Multiplies two double limbs detecting overflow.  Uses compiler's
+ * builtin if available, which compiles to a single multiplication
+ * followed by overflow flag check.
+ *
+ * \param[in] a first factor
+ * \param[in] b second factor
+ * \param[out] r product (valid only if there was no overflow)
+ * \return \c true if product does not fit in double limb
+ */
+static inline bool dlimb_mul_overflow(BigInt::DLimb a, BigInt::DLimb b,
+                                      BigInt::DLimb &r) {
+#if defined __GNUC__ && __GNUC__ >= 5
+	return __builtin_mul_overflow(a, b, &r);
+#else
+	const BigInt::DLimb a1 = a >> BigInt::LIMB_BITS;
+	const BigInt::DLimb b1 = b >> BigInt::LIMB_BITS;
+	if (a1 && b1) {
+		return true;
+	}
+
+	const BigInt::DLimb a0 = (Limb)a, b0 = (Limb)b;
+	const BigInt::DLimb mid = a1 * b0 + a0 * b1;
+	if (mid >> BigInt::LIMB_BITS) {
+		return true;
+	}
+
+	const BigInt::DLimb low = a0 * b0;
+	r = low + (mid << BigInt::LIMB_BITS);
+	return r < low;
+#endif
+}
+
+
+/**
+ * Returns value of a digit.  Letters (either lower or upper case)
+ * represent digits above 9.
+ *
+ * \param[in] ch character
+ * \return digit's value or 36 if \a ch is not a digit in any base
+ */
+static unsigned digit_value(int ch) {
+	if (ch>='0' && ch<='9') {
+		return ch - '0';
+	} else if (ch>='a' && ch<='z') {
+		return ch - 'a' + 10;
+	} else if (ch>='A' && ch<='Z') {
+		return ch - 'A' + 10;
+	} else {
+		return 36;
+	}
+}
+
+
+
+/********** Digits -> BigInt **********/
+void BigInt::set_digits(const char *begin, const char *end, unsigned base) {
+	const unsigned len = end - begin;
+
+	/* Convert characters to digit values */
+	char buf[STACK_CHARS];
+	char *const digits = len<=STACK_CHARS ? buf : new char[len];
+	unsigned i = 0;
+	do digits[i] = digit_value(begin[i]); while (++i<len);
+	set_values(digits, len, base);
+	if (digits!=buf) delete[] digits;
+}
+
+
+void BigInt::set_values(const char *digits, unsigned len, unsigned base) {
+	const unsigned cap = limbs_set_str_size(len, base);
+
+	/* Small numbers are converted on stack */
+	Limb local[3], *const l = cap<=3 ? local : limbs_alloc(cap);
+	const unsigned n = limbs_set_str(l, digits, len, base);
+
+	if (l!=local) {
+		limbs.set_no_copy(l, n, cap);
+		normalize();
+	} else if (n<=2) {
+		set_small(sign, n==2 ? l[0] | (DLimb)l[1] << LIMB_BITS : l[0]);
+	} else {
+		Limb *const vec = limbs_alloc(n);
+		for (unsigned i = 0; i<n; ++i) vec[i] = l[i];
+		limbs.set_no_copy(vec, n, n);
+	}
+}
+
+
+/********** Strips leading zero limbs **********/
+void BigInt::normalize() {
+	const Limb *const begin = limbs.begin(), *end = limbs.end();
+	while (end!=begin && !end[-1]) --end;
+	switch (end - begin) {
+	case 0:
+		if (limbs) set_small(0, 0);
+		break;
+	case 1:
+		set_small(sign, begin[0]);
+		break;
+	case 2:
+		set_small(sign, begin[0] | (DLimb)begin[1] << LIMB_BITS);
+		break;
+	default:
+		if ((unsigned)(end - begin)!=limbs.size()) {
+			limbs.resize(end - begin);
+		}
+	}
+}
 
 
 
 /********** integer -> BigInt **********/
 void BigInt::set(long num) {
-	if (!num) {
-		sign = 0;
+	if (num<0) {
+		set(-(unsigned long)num);
+		sign = -1;
 	} else {
-		sign = num < 0 ? -1 : 1;
-		int len = sprintf(buffer, "%+ld", num);
-		set_digits(buffer + 1, buffer + len);
+		set((unsigned long)num);
 	}
 }
 
 void BigInt::set(unsigned long num) {
-	if ((sign = !!num)) {
-		int len = sprintf(buffer, "%lu", num);
-		set_digits(buffer, buffer + len);
+	set_small(1, num);
+}
+
+void BigInt::set(long long num) {
+	if (num<0) {
+		set(-(unsigned long long)num);
+		sign = -1;
+	} else {
+		set((unsigned long long)num);
 	}
 }
 
+void BigInt::set(unsigned long long num) {
+	set_small(1, num);
+}
+
 
 /********** floating point -> BigInt **********/
 void BigInt::set(double num) {
@@ -55,15 +191,29 @@ void BigInt::set(double num) {
 		sign = 1;
 	}
 
-	digits.resize(0, (int)log10(num) + 4);
+	int exp;
+	frexp(num, &exp);
+	num = floor(num);
+	if (exp<=(int)(2 * LIMB_BITS)) {
+		set_small(sign, (DLimb)num);
+		return;
+	}
+
+	const double base = ldexp(1.0, LIMB_BITS);
+	Array<Limb, Pool> arr(exp / LIMB_BITS + 1);
 	do {
-		digits.push((char)(fmod(num, 10)));
-	} while ((num /= 10)>=1);
+		arr.push((Limb)fmod(num, base));
+	} while ((num = floor(num / base))>=1);
+	limbs = arr;
 }
 
 
 /********** C string -> BigInt **********/
-bool BigInt::set(const char *str) {
+bool BigInt::set(const char *str, unsigned base) {
+	if (base==1 || base>36) {
+		throw BadRadix();
+	}
+
 	while (*str==' '  || *str=='\t' || *str=='\n' ||
 	       *str=='\r' || *str=='\v' || *str=='\f') ++str;
 
@@ -75,15 +225,27 @@ bool BigInt::set(const char *str) {
 		++str;
 	}
 
+	if (str[0]=='0' && (base==0 || base==16) &&
+	    (str[1]=='x' || str[1]=='X') && digit_value(str[2])<16) {
+		base = 16;
+		str += 2;
+	} else if (str[0]=='0' && (base==0 || base==2) &&
+	           (str[1]=='b' || str[1]=='B') && digit_value(str[2])<2) {
+		base = 2;
+		str += 2;
+	} else if (!base) {
+		base = 10;
+	}
+
 	const bool got = *str=='0';
 	while (*str=='0') ++str;
 
 	const char *end = str;
-	while (*end>='0' && *end<='9') ++end;
+	while (digit_value(*end)<base) ++end;
 
 	if (str!=end) {
 		sign = s;
-		set_digits(str, end);
+		set_digits(str, end, base);
 		return true;
 	} else if (got) {
 		zero();
@@ -100,6 +262,8 @@ BigInt &BigInt::add(const BigInt &n) {
 		/* nothing */
 	} else if (!sign) {
 		*this = n;
+	} else if (!limbs && !n.limbs) {
+		add_small(n.sign, n.small_value());
 	} else if (sign * n.sign > 0) {
 		abs_add(n);
 	} else {
@@ -116,11 +280,17 @@ BigInt &BigInt::sub(const BigInt &n) {
 		return *this;
 	}
 	if (!sign) {
-		digits = n.digits;
+		set(n);
 		sign = -n.sign;
 		return *this;
 	}
 
+	/* Both are small */
+	if (!limbs && !n.limbs) {
+		add_small(-n.sign, n.small_value());
+		return *this;
+	}
+
 	/* Have different signs */
 	if (sign * n.sign < 0) {
 		abs_add(n);
@@ -135,52 +305,332 @@ BigInt &BigInt::sub(const BigInt &n) {
 }
 
 
+/********** Adds small number to small *this **********/
+void BigInt::add_small(int s, DLimb value) {
+	const DLimb v = small_value();
+	if (sign!=s) {
+		/* Different signs, result always fits */
+		if (v>=value) {
+			set_small(sign, v - value);
+		} else {
+			set_small(s, value - v);
+		}
+		return;
+	}
+
+	const DLimb r = v + value;
+	if (r>=v) {
+		set_small(sign, r);
+	} else {
+		/* Overflow */
+		Limb *const l = limbs_alloc(4);
+		l[0] = (Limb)r;
+		l[1] = (Limb)(r >> LIMB_BITS);
+		l[2] = 1;
+		limbs.set_no_copy(l, 3, 4);
+	}
+}
+
+
+
 /********** Multiplies *this by number **********/
 BigInt &BigInt::mul(const BigInt &n) {
 	/* At least one of the operands is zero */
 	if (!sign) {
 		return *this;
 	} else if (!n.sign) {
-		digits.clear();
-		sign = 0;
+		zero();
+		return *this;
+	}
+
+	/* Both are small */
+	const unsigned l = limbs_count(), nl = n.limbs_count();
+	if (!limbs && !n.limbs) {
+		DLimb r;
+		if (!dlimb_mul_overflow(small_value(), n.small_value(), r)) {
+			set_small(sign * n.sign, r);
+		} else {
+			Limb *const vec = limbs_alloc(4);
+			if (l>=nl) {
+				limbs_mul_basecase(vec, small, l, n.small, nl);
+			} else {
+				limbs_mul_basecase(vec, n.small, nl, small, l);
+			}
+			sign *= n.sign;
+			limbs.set_no_copy(vec, l + nl, 4);
+			normalize();
+		}
+		return *this;
+	}
+
+	/* Multiplying by itself or a copy sharing limbs */
+	if (limbs.begin()==n.limbs.begin()) {
+		const int s = sign * n.sign;
+		sqr();
+		sign = s;
 		return *this;
 	}
 
 	sign *= n.sign;
 
-	/* Init */
-	const unsigned l = digits.size(), nl = n.digits.size();
-	const char *const d = digits.begin(), *const nd = n.digits.begin();
+	/* Multiply */
+	Limb *const vec = limbs_alloc(l + nl);
+	limbs_mul(vec, limbs_ptr(), l, n.limbs_ptr(), nl);
+
+	/* Remove zeros */
+	limbs.set_no_copy(vec, vec[l + nl - 1] ? l + nl : l + nl - 1, l + nl);
+	return *this;
+}
+
+
+
+/********** Squares *this **********/
+BigInt &BigInt::sqr() {
+	if (!sign) {
+		return *this;
+	}
+
+	sign = 1;
+
+	/* Small */
+	DLimb r;
+	if (!limbs && !dlimb_mul_overflow(small_value(), small_value(), r)) {
+		set_small(1, r);
+		return *this;
+	}
+
+	const unsigned l = limbs_count();
+	Limb *const vec = limbs_alloc(2 * l);
+	limbs_sqr(vec, limbs_ptr(), l);
+	limbs.set_no_copy(vec, vec[2 * l - 1] ? 2 * l : 2 * l - 1, 2 * l);
+	normalize();
+	return *this;
+}
+
+
+
+/********** Divides *this by number **********/
+BigInt &BigInt::divmod(const BigInt &n, BigInt &rem) {
+	if (!n.sign) {
+		throw DivisionByZero();
+	}
+
+	/* Both are small */
+	const int s = sign * n.sign;
+	if (!limbs && !n.limbs) {
+		const DLimb a = small_value(), b = n.small_value();
+		const int rs = sign;
+		rem.set_small(rs, a % b);
+		set_small(s, a / b);
+		return *this;
+	}
+
+	/* |this| < |n| */
+	const unsigned l = limbs_count(), nl = n.limbs_count();
+	if (!sign || l<nl ||
+	    (l==nl && limbs_cmp(limbs_ptr(), n.limbs_ptr(), l)<0)) {
+		rem = std::move(*this);
+		return *this;
+	}
+
+	/* Divide */
+	Limb *const q = limbs_alloc(l - nl + 1), *const r = limbs_alloc(nl);
+	limbs_div_qr(q, r, limbs_ptr(), l, n.limbs_ptr(), nl);
+
+	/* Save results */
+	rem.sign = sign;
+	rem.limbs.set_no_copy(r, nl, nl);
+	rem.normalize();
+	sign = s;
+	limbs.set_no_copy(q, l - nl + 1, l - nl + 1);
+	normalize();
+	return *this;
+}
+
+
+BigInt &BigInt::div(const BigInt &n) {
+	BigInt rem;
+	return divmod(n, rem);
+}
+
+
+BigInt &BigInt::mod(const BigInt &n) {
+	BigInt quot(*this);
+	quot.divmod(n, *this);
+	return *this;
+}
 
-	unsigned i = l + nl;
-	char *vec = new char[i];
-	do { vec[--i] = 0; } while (i);
 
-	/* The loop */
-	for (i = 0; i<l; ++i) {
-		if (!d[i]) {
-			continue;
+
+/********** Adds machine word to *this **********/
+void BigInt::add_word(int s, DLimb value) {
+	if (!value) {
+		return;
+	} else if (!sign) {
+		set_small(s, value);
+		return;
+	} else if (!limbs) {
+		add_small(s, value);
+		return;
+	}
+
+	/* |this| has at least three limbs so it is greater than value */
+	const Limb v[2] = { (Limb)value, (Limb)(value >> LIMB_BITS) };
+	const unsigned l = limbs.size();
+	Limb *const d = limbs.rw_begin();
+	if (sign==s) {
+		if (limbs_add(d, d, l, v, 2)) {
+			limbs.push(1);
 		}
-		unsigned char memory = 0;
-		unsigned ni = 0;
+	} else {
+		limbs_sub(d, d, l, v, 2);
+		normalize();
+	}
+}
+
+
+/********** Multiplies *this by machine word **********/
+void BigInt::mul_word(int s, DLimb value) {
+	if (!sign) {
+		return;
+	} else if (!value) {
+		zero();
+		return;
+	}
 
-		for (; ni<nl; ++ni) {
-			const unsigned char tmp = vec[i + ni] + d[i] * nd[ni] + memory;
-			vec[i + ni] = tmp % 10;
-			memory      = tmp / 10;
+	/* Small */
+	if (!limbs) {
+		DLimb r;
+		if (!dlimb_mul_overflow(small_value(), value, r)) {
+			set_small(sign * s, r);
+			return;
 		}
 
-		for (ni += i; memory; ++ni) {
-			const unsigned char tmp = vec[ni] + memory;
-			vec[ni] = tmp % 10;
-			memory  = tmp / 10;
+		const unsigned l = limbs_count();
+		Limb *const vec = limbs_alloc(4);
+		const DLimb carry = limbs_mul_2(vec, small, l, value);
+		vec[l] = (Limb)carry;
+		vec[l + 1] = (Limb)(carry >> LIMB_BITS);
+		sign *= s;
+		limbs.set_no_copy(vec, l + 2, 4);
+		normalize();
+		return;
+	}
+
+	/* Multiply in place */
+	sign *= s;
+	const unsigned l = limbs.size();
+	Limb *const d = limbs.rw_begin();
+	if (value >> LIMB_BITS) {
+		const DLimb carry = limbs_mul_2(d, d, l, value);
+		if (carry) {
+			limbs.push((Limb)carry);
+			if (carry >> LIMB_BITS) limbs.push((Limb)(carry >> LIMB_BITS));
+		}
+	} else {
+		const Limb carry = limbs_mul_1(d, d, l, (Limb)value);
+		if (carry) {
+			limbs.push(carry);
 		}
 	}
+}
 
-	/* Remove zeros */
-	i = l + nl;
-	if (!vec[i - 1]) --i;
-	digits.set_no_copy(vec, i, l + nl);
+
+/********** Divides *this by machine word **********/
+void BigInt::div_word(int s, DLimb value) {
+	if (!value) {
+		throw DivisionByZero();
+	} else if (!limbs) {
+		set_small(sign * s, small_value() / value);
+		return;
+	}
+
+	sign *= s;
+	Limb *const d = limbs.rw_begin();
+	if (value >> LIMB_BITS) {
+		limbs_divmod_2(d, d, limbs.size(), value);
+	} else {
+		limbs_divmod_1(d, d, limbs.size(), (Limb)value);
+	}
+	normalize();
+}
+
+
+void BigInt::mod_word(DLimb value) {
+	if (!value) {
+		throw DivisionByZero();
+	} else if (!limbs) {
+		set_small(sign, small_value() % value);
+		return;
+	}
+
+	/* Quotient is not needed so limbs are not modified */
+	const DLimb r = value >> LIMB_BITS
+		? limbs_divmod_2(0, limbs.begin(), limbs.size(), value)
+		: limbs_divmod_1(0, limbs.begin(), limbs.size(), (Limb)value);
+	set_small(sign, r);
+}
+
+
+
+/********** Raises *this to a power **********/
+BigInt &BigInt::pow(unsigned long e) {
+	if (!e) {
+		set_small(1, 1);
+		return *this;
+	} else if (!sign) {
+		return *this;
+	}
+
+	const int s = sign<0 && (e & 1) ? -1 : 1;
+	sign = 1;
+	if (limbs || small_value()!=1) {
+		const BigInt base(*this);
+		unsigned long bit = 1;
+		while (bit <= e / 2) bit <<= 1;
+		for (bit >>= 1; bit; bit >>= 1) {
+			sqr();
+			if (e & bit) mul(base);
+		}
+	}
+	sign = s;
+	return *this;
+}
+
+
+/********** Raises *this to a power modulo number **********/
+BigInt &BigInt::powmod(const BigInt &e, const BigInt &m) {
+	if (!m.sign) {
+		throw DivisionByZero();
+	}
+
+	/* Arguments may be this object */
+	BigInt exp(e);
+	const BigInt mod_(m);
+	if (exp.sign<0) {
+		invmod(mod_);
+		exp.neg();
+	}
+	const unsigned n = mod_.limbs_count();
+
+	/* Reduce base to [0, |m|) */
+	mod(mod_);
+	if (sign<0) {
+		if (mod_.sign>0) add(mod_); else sub(mod_);
+	}
+
+	if (n==1 && mod_.small[0]==1) {
+		zero();
+	} else if (!exp.sign) {
+		set_small(1, 1);
+	} else if (sign) {
+		Limb *const r = limbs_alloc(n);
+		limbs_powmod(r, limbs_ptr(), limbs_count(),
+		             exp.limbs_ptr(), exp.limbs_count(), mod_.limbs_ptr(), n);
+		sign = 1;
+		limbs.set_no_copy(r, n, n);
+		normalize();
+	}
 	return *this;
 }
 
@@ -194,15 +644,59 @@ int     BigInt::cmp(const BigInt &n) const {
 		return  1;
 	} else if (!sign) {
 		return  0;
-	} else if (digits.size()<n.digits.size()) {
+	} else if (!limbs && !n.limbs) {
+		const DLimb a = small_value(), b = n.small_value();
+		return a<b ? -sign : a>b ? sign : 0;
+	} else if (limbs.size()<n.limbs.size()) {
 		return -sign;
-	} else if (digits.size()>n.digits.size()) {
+	} else if (limbs.size()>n.limbs.size()) {
+		return  sign;
+	} else if (limbs.begin()==n.limbs.begin()) {
+		/* Copies share limbs */
+		return  0;
+	} else {
+		return sign * limbs_cmp(limbs.begin(), n.limbs.begin(), limbs.size());
+	}
+}
+
+
+/********** Hash **********/
+std::size_t BigInt::hash() const {
+	static const uint64_t K = 0x9e3779b97f4a7c15ull;
+	const Limb *const p = limbs_ptr();
+	const unsigned n = limbs_count();
+
+	uint64_t h = n * K ^ (sign<0 ? ~(uint64_t)0 : 0);
+	unsigned i = 0;
+	for (; i + 1<n; i += 2) {
+		h = (h ^ (p[i] | (uint64_t)p[i + 1] << LIMB_BITS)) * K;
+		h ^= h >> 29;
+	}
+	if (i<n) {
+		h = (h ^ p[i]) * K;
+		h ^= h >> 29;
+	}
+
+	/* Final avalanche from MurmurHash3 */
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdull;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ull;
+	h ^= h >> 33;
+	return (std::size_t)h;
+}
+
+
+int     BigInt::cmp_word(int s, DLimb value) const {
+	if (sign!=s) {
+		return sign<s ? -1 : 1;
+	} else if (!sign) {
+		return  0;
+	} else if (limbs) {
 		return  sign;
 	} else {
-		const char *d = digits.end(), *nd = n.digits.end();
-		unsigned i = digits.size();
-		while (i && *--d == *--nd) --i;
-		return i ? *d < *nd ? -sign : sign : 0;
+		const DLimb a = small_value();
+		return a<value ? -sign : a>value ? sign : 0;
 	}
 }
 
@@ -210,38 +704,39 @@ int     BigInt::cmp(const BigInt &n) const {
 
 /********** Adds number to *this ignoring sign **********/
 void BigInt::abs_add(const BigInt &n) {
+	const unsigned l = limbs_count(), nl = n.limbs_count();
+
+	/* Small number, the other one is big */
+	if (!limbs) {
+		Limb *const r = limbs_alloc(nl + 1);
+		const Limb carry = limbs_add(r, n.limbs.begin(), nl, small, l);
+		r[nl] = carry;
+		limbs.set_no_copy(r, carry ? nl + 1 : nl, nl + 1);
+		return;
+	}
+
 	/* Append zeros */
-	if (digits.size()<n.digits.size()) {
-		unsigned i = digits.size();
-		digits.resize(n.digits.size());
-		char *d = digits.rw_begin() + i;
-		i = n.digits.size() - i;
-		do *d++ = 0; while (--i);
+	if (l<nl) {
+		limbs.resize(nl);
 	}
 
 	/* Init */
-	const char *nd = n.digits.begin();
-	char *d = digits.rw_begin();
-	unsigned char memory = 0;
+	Limb *const d = limbs.rw_begin();
+	const Limb *const nd = n.limbs_ptr();
 
 	/* Add */
-	unsigned len = n.digits.size();
-	do {
-		const char tmp = *d + *nd++ + memory;
-		*d++   = tmp % 10;
-		memory = tmp / 10;
-	} while (--len);
-
-	/* Pending memory */
-	if (memory) {
-		for (len = digits.size() - n.digits.size(); len && *d==9; --len) {
-			*d++ = 0;
-		}
-		if (len) {
-			++*d;
-		} else {
-			digits.push(1);
-		}
+	Limb carry;
+	if (l<nl) {
+		carry = limbs_add_n(d, d, nd, l);
+		carry = limbs_add_1(d + l, nd + l, nl - l, carry);
+	} else {
+		carry = limbs_add_n(d, d, nd, nl);
+		carry = limbs_add_1(d + nl, d + nl, l - nl, carry);
+	}
+
+	/* Pending carry */
+	if (carry) {
+		limbs.push(carry);
 	}
 }
 
@@ -250,20 +745,18 @@ void BigInt::abs_add(const BigInt &n) {
 /********** Substracts number from *this ignoring sign **********/
 void BigInt::abs_sub(const BigInt &n) {
 	/* Compare */
+	const unsigned l = limbs_count(), nl = n.limbs_count();
 	int c;
 	if (!sign) {
 		c = n.sign ? -1 : 0;
 	} else if (!n.sign) {
 		c = 1;
-	} else if (digits.size() > n.digits.size()) {
+	} else if (l > nl) {
 		c = 1;
-	} else if (digits.size() < n.digits.size()) {
+	} else if (l < nl) {
 		c = -1;
 	} else {
-		const char *d = digits.end(), *nd = n.digits.end();
-		unsigned i = digits.size();
-		while (i && *--d == *--nd) --i;
-		c = i ? *d < *nd ? -1 : 1 : 0;
+		c = limbs_cmp(limbs_ptr(), n.limbs_ptr(), l);
 	}
 
 	/* Check compersion result */
@@ -273,36 +766,142 @@ void BigInt::abs_sub(const BigInt &n) {
 		return;
 
 	case -1:
-		BigInt tmp(n);
-		tmp.abs_sub(*this);
-		*this = tmp;
+		/* |n| > |this|, compute n - this */
+		if (!limbs) {
+			Limb *const r = limbs_alloc(nl);
+			limbs_sub(r, n.limbs.begin(), nl, small, l);
+			limbs.set_no_copy(r, nl, nl);
+		} else {
+			limbs.resize(nl);
+			Limb *const d = limbs.rw_begin();
+			const Limb *const nd = n.limbs.begin();
+			const Limb borrow = limbs_sub_n(d, nd, d, l);
+			limbs_sub_1(d + l, nd + l, nl - l, borrow);
+		}
+		sign = -sign;
+		normalize();
 		return;
 	}
 
-	/* Init */
-	const char *nd = n.digits.begin(), *const end = n.digits.end();
-	char *d = digits.rw_begin();
-	unsigned char memory = 0;
-
 	/* Substract */
-	do {
-		const unsigned char tmp = memory + *nd++;
-		*d -= (memory = tmp > *d) ? tmp - 10 : tmp;
-		++d;
-	} while (nd!=end);
+	Limb *const d = limbs.rw_begin();
+	const Limb borrow = limbs_sub_n(d, d, n.limbs_ptr(), nl);
+	limbs_sub_1(d + nl, d + nl, l - nl, borrow);
+
+	/* Remove zeros */
+	normalize();
+}
 
-	/* Pendig memory */
-	if (memory) {
-		while (!*d) *d++ = 9;
-		--*d;
+
+
+/********** Decimal representation **********/
+unsigned BigInt::size() const {
+	if (!sign) {
+		return 1;
 	}
 
-	/* Remove zeros */
-	nd = digits.end();
-	if (!*--nd) {
-		while (!*--nd);
-		digits.resize(nd - digits.begin() + 1);
+	const unsigned n = limbs_count(), size = limbs_get_str_size(n, 10);
+	char local[STACK_CHARS];
+	char *const buf = size<=STACK_CHARS ? local : new char[size];
+	char *const end = buf + size;
+	const unsigned len = end - limbs_get_str(end, limbs_ptr(), n, 10);
+	if (buf!=local) delete[] buf;
+	return len + (sign==-1 ? 1 : 0);
+}
+
+
+Array<char> BigInt::getDigits() const {
+	Array<char> arr;
+	if (!sign) {
+		return arr;
+	}
+
+	const unsigned n = limbs_count(), size = limbs_get_str_size(n, 10);
+	char *const buf = new char[size], *const end = buf + size;
+	const char *begin = limbs_get_str(end, limbs_ptr(), n, 10);
+	arr.set(begin, end - begin);
+	arr.reverse();
+	delete[] buf;
+	return arr;
+}
+
+
+Array<BigInt::Limb> BigInt::getLimbs() const {
+	Array<Limb> arr;
+	const unsigned n = limbs_count();
+	if (n) {
+		arr.set(limbs_ptr(), n, n);
+	}
+	return arr;
+}
+
+
+
+/********** BigInt -> machine types **********/
+long BigInt::toLong() const {
+	const DLimb v = small_value();
+	if (limbs || v>(DLimb)LONG_MAX + (sign<0)) {
+		throw OutOfRange();
+	}
+	return sign<0 ? -(long)(v - 1) - 1 : (long)v;
+}
+
+
+unsigned long BigInt::toUnsignedLong() const {
+	const DLimb v = small_value();
+	if (sign<0 || limbs || v>(DLimb)ULONG_MAX) {
+		throw OutOfRange();
+	}
+	return v;
+}
+
+
+double BigInt::toDouble() const {
+	if (!limbs) {
+		return sign * (double)small_value();
 	}
+
+	/*
+	 * The leading 64 bits are converted, rounding to nearest on the
+	 * way.  Lower bits matter only if they break a tie so they are
+	 * folded into the least significant bit which is below the
+	 * rounding position.
+	 */
+	const Limb *const p = limbs.begin();
+	const unsigned n = limbs.size(), z = limb_clz(p[n - 1]);
+	DLimb top = ((DLimb)p[n - 1] << LIMB_BITS | p[n - 2]) << z;
+	bool sticky = z ? (Limb)(p[n - 3] << z)!=0 : p[n - 3]!=0;
+	if (z) top |= p[n - 3] >> (LIMB_BITS - z);
+	for (unsigned i = 0; !sticky && i<n - 3; ++i) sticky = p[i]!=0;
+
+	const double ret = ldexp((double)(top | sticky),
+	                         (int)(n * LIMB_BITS - z) - 2 * LIMB_BITS);
+	if (ret>DBL_MAX) {
+		throw OutOfRange();
+	}
+	return sign * ret;
+}
+
+
+
+/********** BigInt -> string **********/
+std::string BigInt::toString(unsigned base) const {
+	if (base<2 || base>36) {
+		throw BadRadix();
+	} else if (!sign) {
+		return "0";
+	}
+
+	const unsigned n = limbs_count(), size = limbs_get_str_size(n, base) + 1;
+	char local[STACK_CHARS];
+	char *const buf = size<=STACK_CHARS ? local : new char[size];
+	char *const end = buf + size;
+	char *begin = limbs_get_str(end, limbs_ptr(), n, base);
+	for (char *ch = begin; ch!=end; ++ch) *ch = LOWER_DIGITS[(int)*ch];
+	if (sign<0) *--begin = '-';
+	const std::string str(begin, end);
+	if (buf!=local) delete[] buf;
+	return str;
 }
 
 
@@ -313,60 +912,189 @@ std::ostream &operator<<(std::ostream &os, const BigInt &n) {
 		return os << '0';
 	}
 
-	if (n.sgn()<0) os << '-';
-	const char *const begin = n.getDigits().begin();
-	const char *end = n.getDigits().end();
-	do os << (char)(*--end | '0'); while (end!=begin);
+	const std::ios_base::fmtflags flags = os.flags();
+	const std::ios_base::fmtflags basefield =
+		flags & std::ios_base::basefield;
+	const unsigned base = basefield==std::ios_base::hex ? 16
+		: basefield==std::ios_base::oct ? 8 : 10;
+	const char *const digits = flags & std::ios_base::uppercase
+		? UPPER_DIGITS : LOWER_DIGITS;
+
+	const unsigned l = n.limbs_count(), size = limbs_get_str_size(l, base) + 4;
+	char local[STACK_CHARS];
+	char *const buf = size<=STACK_CHARS ? local : new char[size];
+	char *const end = buf + size - 1;
+	char *begin = limbs_get_str(end, n.limbs_ptr(), l, base);
+	for (char *ch = begin; ch!=end; ++ch) *ch = digits[(int)*ch];
+	if ((flags & std::ios_base::showbase) && base!=10) {
+		if (base==16) {
+			*--begin = flags & std::ios_base::uppercase ? 'X' : 'x';
+		}
+		*--begin = '0';
+	}
+	if (n.sgn()<0) *--begin = '-';
+	*end = 0;
+	os << begin;
+	if (buf!=local) delete[] buf;
 	return os;
 }
 
 
 
 /********** Reads BigInt **********/
+/**
+ * Gives access to get area of any stream buffer.  Protected members
+ * of std::streambuf are named through a derived class which makes
+ * pointers to them accessible; the class itself is never
+ * instantiated.
+ */
+struct StreamBufAccess : public std::streambuf {
+	/**
+	 * Returns pointers to the first and past the last character in
+	 * get area of stream buffer.  Both are equal if there are no
+	 * buffered characters (in particular if buffer is unbuffered).
+	 *
+	 * \param[in] sb stream buffer
+	 * \param[out] end past the last buffered character
+	 * \return the first buffered character
+	 */
+	static const char *get_area(std::streambuf *sb, const char *&end) {
+		end = (sb->*&StreamBufAccess::egptr)();
+		return (sb->*&StreamBufAccess::gptr)();
+	}
+
+	/**
+	 * Consumes characters from get area of stream buffer.
+	 *
+	 * \param[in] sb stream buffer
+	 * \param[in] n number of characters, at most as many as are
+	 *              buffered
+	 */
+	static void consume(std::streambuf *sb, std::ptrdiff_t n) {
+		(sb->*&StreamBufAccess::gbump)((int)n);
+	}
+};
+
+
 std::istream &operator>>(std::istream &is, BigInt &n) {
+	const std::istream::sentry ok(is, true);
+	if (!ok) {
+		return is;
+	}
+
+	/*
+	 * Characters are taken straight from stream buffer; sgetc() and
+	 * snextc() are inline and touch only buffer pointers unless the
+	 * buffer needs to be refilled.  The character following the
+	 * number is left in the stream.
+	 */
+	std::streambuf *const sb = is.rdbuf();
+	const int eof = std::char_traits<char>::eof();
 	int ch, s = 1;
+	unsigned base;
+
+	switch (is.flags() & std::ios_base::basefield) {
+	case std::ios_base::hex: base = 16; break;
+	case std::ios_base::oct: base =  8; break;
+	case std::ios_base::dec: base = 10; break;
+	default:                 base =  0;
+	}
 
 	/* Skip whitepsace */
-	do {
-		ch = is.get();
-	} while (ch==' '  || ch=='\t' || ch=='\n' ||
-	         ch=='\r' || ch=='\v' || ch=='\f');
+	ch = sb->sgetc();
+	while (ch==' '  || ch=='\t' || ch=='\n' ||
+	       ch=='\r' || ch=='\v' || ch=='\f') {
+		ch = sb->snextc();
+	}
 
 	/* Sign */
 	if (ch=='-') {
 		s = -1;
-		ch = is.get();
+		ch = sb->snextc();
 	} else if (ch=='+') {
-		ch = is.get();
+		ch = sb->snextc();
 	}
 
-	/* Not a digit */
-	if (ch<'0' || ch>'9') {
-		is.unget();
-		is.setstate(std::istream::failbit);
-		return is;
+	/* Prefix */
+	bool got = false;
+	if (ch=='0' && (base==0 || base==16)) {
+		got = true;
+		ch = sb->snextc();
+		if (ch=='x' || ch=='X') {
+			base = 16;
+			ch = sb->snextc();
+		} else if (base==0 && (ch=='b' || ch=='B')) {
+			base = 2;
+			ch = sb->snextc();
+		}
+	}
+	if (!base) {
+		base = 10;
 	}
 
 	/* Skip zeros */
-	const bool got = ch=='0';
-	while (ch=='0') ch = is.get();
+	got = got || ch=='0';
+	while (ch=='0') ch = sb->snextc();
+
+	/*
+	 * Digits are scanned in whole runs from the get area of stream
+	 * buffer and their values are written straight into buffer
+	 * passed to set_values().  Before a run is scanned the buffer is
+	 * made big enough for all characters remaining in the get area
+	 * so a number which is buffered as a whole needs at most one
+	 * allocation.  Only a number which spans several refills of
+	 * stream buffer makes the buffer grow (length of a number is not
+	 * known before it is read).  Unbuffered streams are read one
+	 * character at a time.
+	 */
+	char local[STACK_CHARS], *buf = local;
+	std::unique_ptr<char[]> heap;
+	unsigned len = 0, cap = STACK_CHARS;
+	const auto reserve = [&](unsigned more) {
+		if (len + more<=cap) return;
+		cap = std::max(2 * cap, len + more);
+		char *const tmp = new char[cap];
+		std::memcpy(tmp, buf, len);
+		heap.reset(tmp);
+		buf = tmp;
+	};
+
+	for (;;) {
+		const char *end, *p = StreamBufAccess::get_area(sb, end);
+		if (p==end) {
+			/* Get area empty: refill it or read single character if
+			   stream is unbuffered */
+			if ((ch = sb->sgetc())==eof) {
+				is.setstate(std::istream::eofbit);
+				break;
+			}
+			p = StreamBufAccess::get_area(sb, end);
+			if (p==end) {
+				const unsigned d = digit_value(ch);
+				if (d>=base) break;
+				reserve(1);
+				buf[len++] = d;
+				sb->sbumpc();
+				continue;
+			}
+		}
 
-	/* Read digits */
-	Array<char> arr;
-	for (; ch>='0' && ch<='9'; ch = is.get()) {
-		arr.push(ch & 15);
+		reserve(end - p);
+		const char *q = p;
+		for (unsigned d; q!=end && (d = digit_value(*q))<base; ++q) {
+			buf[len++] = d;
+		}
+		StreamBufAccess::consume(sb, q - p);
+		if (q!=end) break;
 	}
 
 	/* Set */
-	if (arr) {
-		arr.reverse();
-		n.digits = arr;
+	if (len) {
 		n.sign = s;
+		n.set_values(buf, len, base);
 	} else if (got) {
-		n.digits.clear();
-		n.sign = 0;
+		n.zero();
 	} else {
-		is.unget();
 		is.setstate(std::istream::failbit);
 	}
 
@@ -9,9 +9,15 @@
 #ifndef MN_BIGINT_HPP
 #define MN_BIGINT_HPP
 
+#include <cstddef>
+#include <exception>
+#include <functional>
 #include <istream>
 #include <ostream>
 #include <string>
+#include <type_traits>
+#include <utility>
+#include <stdint.h>
 
 #include "array.hpp"
 
@@ -19,12 +25,274 @@
 namespace mina86 {
 
 
+struct BigIntTerm;
+template<unsigned N> class BigIntExpr;
+class BigIntGcd;
+class BigIntRoot;
+class BigIntBatch;
+template<unsigned Bits> class FixedBigInt;
+struct BigIntInspect;
+
+
+/**
+ * Traits of machine integer types BigInt operates on directly without
+ * converting them to BigInt first.  \c value is \c true only for
+ * such types, ie. for \c int, \c long and \c long \c long and their
+ * unsigned counterparts.  For them sign() and abs() split a number
+ * into its sign and absolute value.
+ */
+template<class T> struct BigIntWord {
+	/** Whether \a T is a supported machine integer type. */
+	static const bool value = false;
+};
+
+/**
+ * Traits of signed machine integer types.
+ *
+ * \sa BigIntWord
+ */
+template<class T> struct BigIntSignedWord {
+	/** Whether \a T is a supported machine integer type. */
+	static const bool value = true;
+
+	/**
+	 * Returns sign of a number.
+	 *
+	 * \param[in] n number
+	 * \return \c -1, \c 0 or \c 1
+	 */
+	static constexpr int sign(T n) { return n<0 ? -1 : n>0; }
+
+	/**
+	 * Returns absolute value of a number.  Works for the lowest
+	 * value of the type as well.
+	 *
+	 * \param[in] n number
+	 * \return absolute value of \a n
+	 */
+	static constexpr uint64_t abs(T n) {
+		return n<0 ? -(uint64_t)n : (uint64_t)n;
+	}
+};
+
+/**
+ * Traits of unsigned machine integer types.
+ *
+ * \sa BigIntWord
+ */
+template<class T> struct BigIntUnsignedWord {
+	/** Whether \a T is a supported machine integer type. */
+	static const bool value = true;
+
+	/**
+	 * Returns sign of a number.
+	 *
+	 * \param[in] n number
+	 * \return \c 0 or \c 1
+	 */
+	static constexpr int sign(T n) { return n>0; }
+
+	/**
+	 * Returns absolute value of a number.
+	 *
+	 * \param[in] n number
+	 * \return \a n
+	 */
+	static constexpr uint64_t abs(T n) { return n; }
+};
+
+/** \copydoc BigIntSignedWord */
+template<> struct BigIntWord<int> : BigIntSignedWord<int> { };
+/** \copydoc BigIntSignedWord */
+template<> struct BigIntWord<long> : BigIntSignedWord<long> { };
+/** \copydoc BigIntSignedWord */
+template<> struct BigIntWord<long long> : BigIntSignedWord<long long> { };
+/** \copydoc BigIntUnsignedWord */
+template<> struct BigIntWord<unsigned> : BigIntUnsignedWord<unsigned> { };
+/** \copydoc BigIntUnsignedWord */
+template<> struct BigIntWord<unsigned long>
+	: BigIntUnsignedWord<unsigned long> { };
+/** \copydoc BigIntUnsignedWord */
+template<> struct BigIntWord<unsigned long long>
+	: BigIntUnsignedWord<unsigned long long> { };
+
+
 /**
  * Class representing big integer numbers.  Numbers are stored as an
- * array of digits and therefore can hold any integer value.  This
- * class does not (yet) support division.
+ * array of machine word "limbs" (ie. in base 2<sup>32</sup>) and
+ * therefore can hold any integer value.  Numbers which fit in two
+ * limbs are stored inside the object so they need no memory
+ * allocation and arithmetic on them uses native instructions.
+ * Decimal representation is computed only when number is parsed or
+ * printed.
  */
 class BigInt {
+public:
+	/**
+	 * Exception thrown when dividing by zero.
+	 */
+	class DivisionByZero : public std::exception {
+	public:
+		/**
+		 * Returns description of the error.
+		 *
+		 * \return \c "division by zero"
+		 */
+		const char *what() const throw() { return "division by zero"; }
+	};
+
+	/**
+	 * Exception thrown when a number with no modular inverse is
+	 * given to invmod() or raised to a negative power by powmod().
+	 */
+	class NotInvertible : public std::exception {
+	public:
+		/**
+		 * Returns description of the error.
+		 *
+		 * \return \c "number is not invertible"
+		 */
+		const char *what() const throw() {
+			return "number is not invertible";
+		}
+	};
+
+	/**
+	 * Exception thrown when negative exponent is given to a function
+	 * which cannot handle it.
+	 */
+	class NegativeExponent : public std::exception {
+	public:
+		/**
+		 * Returns description of the error.
+		 *
+		 * \return \c "negative exponent"
+		 */
+		const char *what() const throw() { return "negative exponent"; }
+	};
+
+	/**
+	 * Exception thrown when even root of negative number is to be
+	 * computed.
+	 */
+	class BadRoot : public std::exception {
+	public:
+		/**
+		 * Returns description of the error.
+		 *
+		 * \return \c "even root of negative number"
+		 */
+		const char *what() const throw() {
+			return "even root of negative number";
+		}
+	};
+
+	/**
+	 * Exception thrown when number does not fit in a machine type it
+	 * is converted to.
+	 */
+	class OutOfRange : public std::exception {
+	public:
+		/**
+		 * Returns description of the error.
+		 *
+		 * \return \c "number out of range"
+		 */
+		const char *what() const throw() { return "number out of range"; }
+	};
+
+	/**
+	 * Exception thrown when invalid base is given to one of the
+	 * conversion methods.  Valid bases are from 2 to 36.
+	 */
+	class BadRadix : public std::exception {
+	public:
+		/**
+		 * Returns description of the error.
+		 *
+		 * \return \c "radix must be between 2 and 36"
+		 */
+		const char *what() const throw() {
+			return "radix must be between 2 and 36";
+		}
+	};
+
+
+	/**
+	 * Type of a single limb.  Each limb holds #LIMB_BITS bits of
+	 * number's absolute value.
+	 */
+	typedef uint32_t Limb;
+
+	/**
+	 * Type able to hold a product of two limbs.  Used for
+	 * intermediate results.
+	 */
+	typedef uint64_t DLimb;
+
+	/**
+	 * Number of bits in a single limb.
+	 */
+	static const unsigned LIMB_BITS = 32;
+
+
+	/**
+	 * Sets number of threads multiplication and squaring of huge
+	 * numbers may use.  Toom-Cook products of operands longer than
+	 * several hundred limbs compute their sub-products in parallel
+	 * and number-theoretic transforms run modulo each prime in
+	 * parallel and split transforms between threads.  Rounds of
+	 * isProbablePrime() on big numbers run in parallel as well.
+	 * Smaller operations stay sequential.  The setting applies to
+	 * operations
+	 * invoked from the calling thread only so different threads may
+	 * use different settings.  The default is one thread.
+	 *
+	 * \param[in] n maximal number of threads including the calling
+	 *              one, zero means one
+	 * \sa getThreads()
+	 */
+	static void setThreads(unsigned n);
+
+	/**
+	 * Returns number of threads multiplication may use as set by
+	 * setThreads() in the calling thread.
+	 *
+	 * \return number of threads
+	 */
+	static unsigned getThreads();
+
+
+	/**
+	 * Memory allocation policy of limb arrays.  Buffers of up to a
+	 * thousand or so limbs are rounded up to a power of two and freed
+	 * buffers are kept on free lists, one per size class and thread,
+	 * so that temporaries created and destroyed by arithmetic rarely
+	 * reach the heap.  Bigger buffers are allocated directly.
+	 *
+	 * \sa BigIntArena
+	 */
+	struct Pool {
+		/**
+		 * Allocates limb buffer.
+		 *
+		 * \param[in] n number of limbs
+		 * \return pointer to allocated memory
+		 */
+		static Limb *allocate(unsigned n);
+
+		/**
+		 * Frees limb buffer.  The buffer may have been allocated by
+		 * another thread.
+		 *
+		 * \param[in] p pointer to allocated memory or null pointer
+		 * \param[in] n number of limbs passed to allocate()
+		 */
+		static void deallocate(Limb *p, unsigned n);
+	};
+
+
+private:
 	/**
 	 * Sign of the number.  \c -1 if number is negative, \c 0 if it's
 	 * zero, \c 1 otherwise.
@@ -32,9 +300,76 @@ class BigInt {
 	int sign;
 
 	/**
-	 * Array holding digits.
+	 * Absolute value of the number if it fits in two limbs.  The
+	 * first limb is the least significant.  Used only if #limbs is
+	 * empty, so small numbers need no memory allocation.
+	 */
+	Limb small[2];
+
+	/**
+	 * Array holding limbs of number's absolute value if it does not
+	 * fit in #small.  The first limb is the least significant.  The
+	 * array is either empty or it has at least three limbs and the
+	 * last limb is not zero.
+	 */
+	Array<Limb, Pool> limbs;
+
+
+	/**
+	 * Returns pointer to the least significant limb of number's
+	 * absolute value, be it stored in #small or in #limbs.
+	 *
+	 * \return pointer to limbs
+	 * \sa limbs_count()
+	 */
+	const Limb *limbs_ptr() const { return limbs ? limbs.begin() : small; }
+
+	/**
+	 * Returns number of limbs of number's absolute value, be it
+	 * stored in #small or in #limbs.  The most significant limb is
+	 * never zero.
+	 *
+	 * \return number of limbs, zero if number is zero
+	 * \sa limbs_ptr()
+	 */
+	unsigned limbs_count() const {
+		return limbs ? limbs.size() : small[1] ? 2 : small[0] ? 1 : 0;
+	}
+
+	/**
+	 * Returns absolute value of a number stored in #small.
+	 *
+	 * \return absolute value
+	 */
+	DLimb small_value() const {
+		return small[0] | (DLimb)small[1] << LIMB_BITS;
+	}
+
+	/**
+	 * Sets number to a value which fits in #small releasing #limbs.
+	 *
+	 * \param[in] s sign of the number, ignored if \a value is zero
+	 * \param[in] value absolute value of the number
+	 */
+	void set_small(int s, DLimb value) {
+		if (limbs) limbs = Array<Limb, Pool>();
+		sign = value ? s : 0;
+		small[0] = (Limb)value;
+		small[1] = (Limb)(value >> LIMB_BITS);
+	}
+
+	/**
+	 * Adds a number which fits in #small to this object which fits in
+	 * #small as well.  Overflow is detected and the number is moved
+	 * to #limbs only if it happens.
+	 *
+	 * \warning This method assumes this number is not zero.
+	 *
+	 * \param[in] s sign of the number to add
+	 * \param[in] value absolute value of the number to add
+	 * \sa add(), sub()
 	 */
-	Array<char> digits;
+	void add_small(int s, DLimb value);
 
 
 
@@ -60,10 +395,65 @@ class BigInt {
 	 */
 	void abs_sub(const BigInt &n);
 
+	/**
+	 * Adds a machine word to this number.  Works in place in a single
+	 * pass over the limbs; memory is allocated only if the number
+	 * grows out of #small or out of capacity of #limbs.
+	 *
+	 * \param[in] s sign of the number to add
+	 * \param[in] value absolute value of the number to add
+	 * \sa add(T), sub(T)
+	 */
+	void add_word(int s, DLimb value);
+
+	/**
+	 * Multiplies this number by a machine word in place in a single
+	 * pass over the limbs.
+	 *
+	 * \param[in] s sign of the multiplier
+	 * \param[in] value absolute value of the multiplier
+	 * \sa mul(T)
+	 */
+	void mul_word(int s, DLimb value);
+
+	/**
+	 * Divides this number by a machine word in place in a single
+	 * pass over the limbs.  If \a value is zero DivisionByZero is
+	 * thrown.
+	 *
+	 * \param[in] s sign of the divisor
+	 * \param[in] value absolute value of the divisor
+	 * \sa div(T)
+	 */
+	void div_word(int s, DLimb value);
+
+	/**
+	 * Replaces this number with remainder of its division by a
+	 * machine word.  Quotient is not stored anywhere.  If \a value is
+	 * zero DivisionByZero is thrown.
+	 *
+	 * \param[in] value absolute value of the divisor
+	 * \sa mod(T)
+	 */
+	void mod_word(DLimb value);
+
+	/**
+	 * Compares this number with a machine word.
+	 *
+	 * \param[in] s sign of the other number
+	 * \param[in] value absolute value of the other number
+	 * \return the same as cmp()
+	 * \sa cmp(T)
+	 */
+	int cmp_word(int s, DLimb value) const;
+
 
 	/**
-	 * Copies digits from an array.  Digits in passed array are in
-	 * "natural" order.  The first digit must not be zero.
+	 * Converts digits into limbs.  Digits in passed array are in
+	 * "natural" order (ie. the most significant first) and are given
+	 * as ASCII characters (letters for digits above 9 may be either
+	 * lower or upper case).  The first digit must not be zero.  Sign
+	 * of the number must be set prior to calling this method.
 	 *
 	 * \warning This method does not check for any error conditions
 	 *          (such as invalid digit, no digits, zero at the
@@ -72,25 +462,140 @@ class BigInt {
 	 *
 	 * \param[in] begin first digit
 	 * \param[in] end last digit
+	 * \param[in] base base digits are in, from 2 to 36
 	 */
-	void set_digits(const char *begin, const char *end) {
-		digits.resize(end - begin);
-		for (char *d = digits.rw_begin(); begin!=end; *d++ = (*--end & 15));
-	}
+	void set_digits(const char *begin, const char *end, unsigned base = 10);
+
+	/**
+	 * Converts digit values into limbs.  Same as set_digits() except
+	 * digits are given as their values (not ASCII characters) so
+	 * parsers which convert characters as they go need no second
+	 * pass.
+	 *
+	 * \param[in] digits digit values, each less than \a base; the
+	 *                   first must not be zero
+	 * \param[in] len number of digits, must be at least one
+	 * \param[in] base base digits are in, from 2 to 36
+	 * \sa set_digits()
+	 */
+	void set_values(const char *digits, unsigned len, unsigned base);
+
+	/**
+	 * Removes most significant zero limbs and sets #sign to zero if
+	 * no limbs are left.  Moves the number to #small if it fits
+	 * there.
+	 */
+	void normalize();
+
+	/**
+	 * Evaluates sum of terms.  The sum is accumulated in a single
+	 * buffer sized up front for the biggest term so no temporaries
+	 * are created.  Products of numbers shorter than a few dozen
+	 * limbs are added to the buffer row by row as they are computed.
+	 * Buffer of this object is reused if it is big enough.
+	 *
+	 * \param[in] terms terms to sum
+	 * \param[in] n number of terms
+	 * \param[in] acc \c 0 to assign the sum to this object, \c 1 to
+	 *                add it to this object and \c -1 to substract it
+	 *                from this object
+	 */
+	void evaluate(const BigIntTerm *terms, unsigned n, int acc);
 
 
 public:
 	/**
 	 * Default constructor.
 	 */
-	BigInt() : sign(0), digits() { }
+	BigInt() : sign(0), limbs() { small[0] = small[1] = 0; }
 
 	/**
 	 * Copy constructor.
 	 *
 	 * \param[in] n BigInt object to copy
 	 */
-	BigInt(const BigInt &n) : sign(n.sign), digits(n.digits) { }
+	BigInt(const BigInt &n) : sign(n.sign), limbs(n.limbs) {
+		small[0] = n.small[0];
+		small[1] = n.small[1];
+	}
+
+	/**
+	 * Move constructor.  Takes over limbs of \a n which becomes zero.
+	 *
+	 * \param[in] n BigInt object to move
+	 */
+	BigInt(BigInt &&n) noexcept : sign(n.sign), limbs(std::move(n.limbs)) {
+		small[0] = n.small[0];
+		small[1] = n.small[1];
+		n.sign = 0;
+		n.small[0] = n.small[1] = 0;
+	}
+
+	/**
+	 * Evaluates an expression.
+	 *
+	 * \param[in] e expression to evaluate
+	 * \sa BigIntExpr
+	 */
+	template<unsigned N>
+	BigInt(const BigIntExpr<N> &e) : sign(0), limbs() {
+		small[0] = small[1] = 0;
+		evaluate(e.terms, N, 0);
+	}
+
+	/**
+	 * Converts an int into BigInt.
+	 *
+	 * \param[in] num number to convert
+	 */
+	BigInt(int num) : sign(0), limbs() {
+		set((long)num);
+	}
+
+	/**
+	 * Converts an unsigned int into BigInt.
+	 *
+	 * \param[in] num number to convert
+	 */
+	BigInt(unsigned num) : sign(0), limbs() {
+		set((unsigned long)num);
+	}
+
+	/**
+	 * Converts a long into BigInt.
+	 *
+	 * \param[in] num number to convert
+	 */
+	BigInt(long num) : sign(0), limbs() {
+		set(num);
+	}
+
+	/**
+	 * Converts an unsigned long into BigInt.
+	 *
+	 * \param[in] num number to convert
+	 */
+	BigInt(unsigned long num) : sign(0), limbs() {
+		set(num);
+	}
+
+	/**
+	 * Converts a long long into BigInt.
+	 *
+	 * \param[in] num number to convert
+	 */
+	BigInt(long long num) : sign(0), limbs() {
+		set(num);
+	}
+
+	/**
+	 * Converts an unsigned long long into BigInt.
+	 *
+	 * \param[in] num number to convert
+	 */
+	BigInt(unsigned long long num) : sign(0), limbs() {
+		set(num);
+	}
 
 	/**
 	 * Converts a floating point number into BigInt.  Rounds \a num
@@ -98,7 +603,7 @@ public:
 	 *
 	 * \param[in] num number to convert
 	 */
-	BigInt(double num) : sign(0), digits(0) {
+	BigInt(double num) : sign(0), limbs() {
 		set(num);
 	}
 
@@ -106,17 +611,25 @@ public:
 	 * Parses string.
 	 *
 	 * \param[in] str string to parse
-	 * \sa set(std::string)
+	 * \param[in] base base number is written in
+	 * \sa set(const std::string&, unsigned)
 	 */
-	BigInt(std::string str) : sign(0), digits() { set(str.c_str()); }
+	BigInt(const std::string &str, unsigned base = 10) : sign(0), limbs() {
+		small[0] = small[1] = 0;
+		set(str.c_str(), base);
+	}
 
 	/**
 	 * Parses C string.
 	 *
 	 * \param[in] str string to parse
-	 * \sa set(const char*)
+	 * \param[in] base base number is written in
+	 * \sa set(const char*, unsigned)
 	 */
-	BigInt(const char *str) : sign(0), digits() { set(str); }
+	BigInt(const char *str, unsigned base = 10) : sign(0), limbs() {
+		small[0] = small[1] = 0;
+		set(str, base);
+	}
 
 
 
@@ -134,6 +647,20 @@ public:
 	 */
 	void set(unsigned long num);
 
+	/**
+	 * Sets value of BigInt number from a long long number.
+	 *
+	 * \param[in] num number to convert
+	 */
+	void set(long long num);
+
+	/**
+	 * Sets value of BigInt number from an unsigned long long number.
+	 *
+	 * \param[in] num number to convert
+	 */
+	void set(unsigned long long num);
+
 	/**
 	 * Sets value of BigInt number from a floating point number.
 	 * Rounds \a num towards zero.
@@ -146,19 +673,29 @@ public:
 	 * Parses string and sets value of BigInt number.
 	 *
 	 * \param[in] str string to parse
+	 * \param[in] base base number is written in
 	 * \return \c true if string contained valid number, \c false
 	 *         othewise
+	 * \sa set(const char*, unsigned)
 	 */
-	bool set(std::string str) { return set(str.c_str()); }
+	bool set(const std::string &str, unsigned base = 10) {
+		return set(str.c_str(), base);
+	}
 
 	/**
-	 * Parses C string and sets value of BigInt number.
+	 * Parses C string and sets value of BigInt number.  Digits above
+	 * 9 are letters (either lower or upper case).  If \a base is 16
+	 * or 2 number may be prefixed with \c "0x" or \c "0b"
+	 * respectively.  If \a base is zero base is determined from
+	 * prefix: \c "0x" means 16, \c "0b" means 2 and no prefix means
+	 * 10.  If \a base is invalid BadRadix is thrown.
 	 *
 	 * \param[in] str string to parse
+	 * \param[in] base base number is written in, from 2 to 36 or zero
 	 * \return \c true if string contained valid number, \c false
 	 *         othewise
 	 */
-	bool set(const char *str);
+	bool set(const char *str, unsigned base = 10);
 
 	/**
 	 * Sets value of this object to the value of another BigInt
@@ -167,16 +704,17 @@ public:
 	 * \param[in] n number to copy
 	 */
 	void set(const BigInt &n) {
-		digits = n.digits;
+		limbs = n.limbs;
 		sign = n.sign;
+		small[0] = n.small[0];
+		small[1] = n.small[1];
 	}
 
 	/**
 	 * Assigns zero to the object.
 	 */
 	void zero() {
-		sign = 0;
-		digits.clear();
+		set_small(0, 0);
 	}
 
 
@@ -204,174 +742,1614 @@ public:
 	 *
 	 * \param[in] n number to multiply by
 	 * \return reference to this object
-	 * \sa add(), sub()
+	 * \sa add(), sub(), sqr()
 	 */
 	BigInt &mul(const BigInt &n);
 
-
-
 	/**
-	 * Compares two BigInt numbers.
+	 * Squares the number.  This is faster then multiplying number by
+	 * itself using general multiplication.  Note that mul() detects
+	 * if it was given the same number (or its copy) and calls this
+	 * method.
 	 *
-	 * \param[in] n number to compare to
-	 * \return \c -1 if \a n is greater then this, \c 0 if they are
-	 *         equal, \c 1 if \n is lower then this
+	 * \return reference to this object
+	 * \sa mul()
 	 */
-	int  cmp(const BigInt &n) const;
-
-
+	BigInt &sqr();
 
 	/**
-	 * Returns sign of the BigInt number.
+	 * Divides by a BigInt number.  Quotient is rounded towards zero.
+	 * If \a n is zero DivisionByZero is thrown.
 	 *
-	 * \return \c -1 if number is negative, \c 0 if it's zero, \c 1
-	 *         otherwise
-	 * \sa neg(), abs(), #sign
+	 * \param[in] n number to divide by
+	 * \return reference to this object
+	 * \sa mod(), divmod()
 	 */
-	int  sgn() const { return sign; }
+	BigInt &div(const BigInt &n);
 
 	/**
-	 * Negates number.
+	 * Computes remainder of division by a BigInt number.  Remainder
+	 * has the same sign as this number (or is zero), ie. <code>a ==
+	 * a / n * n + a % n</code>.  If \a n is zero DivisionByZero is
+	 * thrown.
 	 *
+	 * \param[in] n number to divide by
 	 * \return reference to this object
-	 * \sa sgn(), abs()
+	 * \sa div(), divmod()
 	 */
-	BigInt &neg() { sign = -sign; return *this; }
+	BigInt &mod(const BigInt &n);
 
 	/**
-	 * Assigns number it's absolute value.  Changes #sign to \c 1 if
-	 * it was \c -1.
+	 * Divides by a BigInt number and saves remainder.  This is faster
+	 * than calling div() and mod() separately.  If \a n is zero
+	 * DivisionByZero is thrown.
 	 *
+	 * \param[in] n number to divide by
+	 * \param[out] rem object to save remainder to, must not be this
+	 *                 object
 	 * \return reference to this object
-	 * \sa sgn(), neg(), #sign
+	 * \sa div(), mod()
 	 */
-	BigInt &abs() { if (sign<0) sign = 1; return *this; }
-
-
+	BigInt &divmod(const BigInt &n, BigInt &rem);
 
 	/**
-	 * Returns number of character this number would take.  It is
-	 * number of digits plus one if number is negative (since a minus
-	 * sign consumes one character as well.
+	 * Adds a machine integer.  Unlike add(const BigInt&) the number
+	 * is not converted to BigInt first; it is added in place with a
+	 * single pass which stops as soon as carry is absorbed.
 	 *
-	 * \return number of characters needed to represent number
+	 * \param[in] n number to add
+	 * \return reference to this object
+	 * \sa BigIntWord
 	 */
-	unsigned size() const {
-		return sign ? digits.size() + (sign==-1 ? 1 : 0) : 1;
+	template<class T>
+	typename std::enable_if<BigIntWord<T>::value, BigInt &>::type
+	add(T n) {
+		add_word(BigIntWord<T>::sign(n), BigIntWord<T>::abs(n));
+		return *this;
 	}
 
 	/**
-	 * Returns reference to an Array holding digits.  Note that digits
-	 * are stored in "reverse order", ie. the first digit is the least
-	 * significient.
+	 * Substracts a machine integer.
 	 *
-	 * \return reference to digits Array
+	 * \param[in] n number to substract
+	 * \return reference to this object
+	 * \sa add(T)
 	 */
-	const Array<char> &getDigits() const { return digits; }
-
-
+	template<class T>
+	typename std::enable_if<BigIntWord<T>::value, BigInt &>::type
+	sub(T n) {
+		add_word(-BigIntWord<T>::sign(n), BigIntWord<T>::abs(n));
+		return *this;
+	}
 
 	/**
-	 * Adds number to this object.
+	 * Multiplies by a machine integer in place using a single pass
+	 * over the limbs.
 	 *
-	 * \param[in] n number to add
-	 * \return reference to this object after addition
-	 * \sa add()
+	 * \param[in] n number to multiply by
+	 * \return reference to this object
+	 * \sa add(T)
 	 */
-	BigInt &operator+=(const BigInt &n) { return add(n); }
+	template<class T>
+	typename std::enable_if<BigIntWord<T>::value, BigInt &>::type
+	mul(T n) {
+		mul_word(BigIntWord<T>::sign(n), BigIntWord<T>::abs(n));
+		return *this;
+	}
 
 	/**
-	 * Substracts number from this object.
+	 * Divides by a machine integer in place using a single pass over
+	 * the limbs.  Quotient is rounded towards zero.  If \a n is zero
+	 * DivisionByZero is thrown.
 	 *
-	 * \param[in] n number to substract
-	 * \return reference to this object ofter substraction
-	 * \sa sub()
+	 * \param[in] n number to divide by
+	 * \return reference to this object
+	 * \sa div(const BigInt&)
+	 */
+	template<class T>
+	typename std::enable_if<BigIntWord<T>::value, BigInt &>::type
+	div(T n) {
+		div_word(BigIntWord<T>::sign(n), BigIntWord<T>::abs(n));
+		return *this;
+	}
+
+	/**
+	 * Computes remainder of division by a machine integer without
+	 * computing the quotient.  Remainder has the same sign as this
+	 * number (or is zero).  If \a n is zero DivisionByZero is thrown.
+	 *
+	 * \param[in] n number to divide by
+	 * \return reference to this object
+	 * \sa mod(const BigInt&)
+	 */
+	template<class T>
+	typename std::enable_if<BigIntWord<T>::value, BigInt &>::type
+	mod(T n) {
+		mod_word(BigIntWord<T>::abs(n));
+		return *this;
+	}
+
+	/**
+	 * Raises number to a power using binary exponentiation, ie. by
+	 * scanning bits of exponent from the most significant one and
+	 * squaring the number for each bit and multiplying it by the
+	 * original number for each set bit.  Zero to the power of zero
+	 * is one.
+	 *
+	 * \param[in] e exponent
+	 * \return reference to this object
+	 * \sa powmod()
+	 */
+	BigInt &pow(unsigned long e);
+
+	/**
+	 * Raises number to a power modulo \a m.  Result is from zero to
+	 * absolute value of \a m minus one.  Odd moduli use Montgomery
+	 * multiplication so no division is done in the loop, even moduli
+	 * use ordinary division.  Exponent is scanned with sliding window
+	 * so only one multiplication per a few bits is needed.  If \a e
+	 * is negative modular inverse of the number is raised to the
+	 * power of minus \a e.  If \a m is zero DivisionByZero is
+	 * thrown, if the inverse does not exist NotInvertible is thrown.
+	 *
+	 * \param[in] e exponent
+	 * \param[in] m modulus
+	 * \return reference to this object
+	 * \sa pow(), invmod()
+	 */
+	BigInt &powmod(const BigInt &e, const BigInt &m);
+
+	/**
+	 * Computes greatest common divisor of this number and \a n.  The
+	 * result is never negative and is zero only if both numbers are
+	 * zero.  Lehmer's algorithm is used which does most of the work
+	 * on the leading 62 bits of the numbers and updates the numbers
+	 * only once per several quotients.  Big numbers are first
+	 * reduced by half-GCD algorithm which computes the quotient
+	 * sequence recursively from the leading halves so that the work
+	 * is done by fast multiplication.
+	 *
+	 * \param[in] n the other number
+	 * \return reference to this object
+	 * \sa lcm(), gcdext()
+	 */
+	BigInt &gcd(const BigInt &n);
+
+	/**
+	 * Computes least common multiple of this number and \a n.  The
+	 * result is never negative and is zero if any of the numbers is
+	 * zero.
+	 *
+	 * \param[in] n the other number
+	 * \return reference to this object
+	 * \sa gcd()
+	 */
+	BigInt &lcm(const BigInt &n);
+
+	/**
+	 * Computes greatest common divisor of this number and \a n and
+	 * Bezout's coefficients, ie. such \a s and \a t that <code>this
+	 * * s + n * t</code> equals the divisor.  Unless one of the
+	 * numbers divides the other, coefficients are the smallest
+	 * possible, ie. <code>|s| <= |n| / (2 * gcd)</code> and
+	 * <code>|t| <= |this| / (2 * gcd)</code>.
+	 *
+	 * \param[in] n the other number
+	 * \param[out] s coefficient of this number
+	 * \param[out] t coefficient of \a n
+	 * \return reference to this object
+	 * \sa gcd(), invmod()
+	 */
+	BigInt &gcdext(const BigInt &n, BigInt &s, BigInt &t);
+
+	/**
+	 * Computes modular inverse of the number, ie. such \c x that
+	 * <code>this * x</code> equals one modulo \a m.  Result is from
+	 * zero to absolute value of \a m minus one.  If \a m is zero
+	 * DivisionByZero is thrown, if the inverse does not exist (ie.
+	 * the number and \a m are not coprime) NotInvertible is thrown
+	 * and the number is left unchanged.
+	 *
+	 * \param[in] m modulus
+	 * \return reference to this object
+	 * \sa gcdext(), powmod()
+	 */
+	BigInt &invmod(const BigInt &m);
+
+	/**
+	 * Computes square root of the number rounded down.  Same as
+	 * <code>iroot(2)</code>.  If the number is negative BadRoot is
+	 * thrown.
+	 *
+	 * \return reference to this object
+	 * \sa iroot()
+	 */
+	BigInt &isqrt() { return iroot(2); }
+
+	/**
+	 * Computes \a k-th root of the number rounded towards zero.  Root
+	 * of the leading part of the number is computed recursively and
+	 * then a single Newton's step doubles number of correct bits so
+	 * the whole computation costs about as much as a few
+	 * multiplications of numbers of the size of the number.  If \a k
+	 * is zero DivisionByZero is thrown, if \a k is even and the
+	 * number is negative BadRoot is thrown.
+	 *
+	 * \param[in] k degree of the root
+	 * \return reference to this object
+	 * \sa isqrt(), perfectPower()
+	 */
+	BigInt &iroot(unsigned long k);
+
+	/**
+	 * Checks whether the number is a perfect power, ie. a power of
+	 * an integer with exponent greater than one, and finds the
+	 * greatest such exponent.  Prime exponents are tried in turn;
+	 * most are rejected by cheap tests of the least significant bits
+	 * or of remainders modulo a few small primes and the remaining
+	 * ones are verified with iroot().  Zero, one and minus one are
+	 * powers with any exponent and for them zero is returned.
+	 *
+	 * \param[out] root if not \c NULL, the root of the number whose
+	 *                  returned power the number is, or the number
+	 *                  itself if it is not a perfect power
+	 * \return the greatest exponent, \c 1 if the number is not
+	 *         a perfect power or \c 0 if it is zero, one or minus one
+	 * \sa iroot()
+	 */
+	unsigned long perfectPower(BigInt *root = 0) const;
+
+	/**
+	 * Checks whether the number is prime.  The number is first
+	 * divided by primes below a thousand.  Numbers which are not
+	 * divisible by any of them are tested by Miller-Rabin test with
+	 * Montgomery multiplication: for numbers below 2^64 the first
+	 * twelve primes are used as bases which gives an exact answer,
+	 * bigger numbers are tested with base two and \a rounds - 1
+	 * pseudo-random bases chosen deterministically from the number.
+	 * A composite passes each round with probability of at most one
+	 * quarter (and far less for random big numbers).  If more than
+	 * one thread is allowed by setThreads() rounds are distributed
+	 * between threads.  Numbers less than two are not primes.
+	 *
+	 * \param[in] rounds number of rounds of Miller-Rabin test, zero
+	 *                   means one
+	 * \return \c true if the number is prime or (for numbers of 2^64
+	 *         and more) a probable prime
+	 * \sa nextPrime()
+	 */
+	bool isProbablePrime(unsigned rounds = 25) const;
+
+	/**
+	 * Replaces the number with the smallest (probable) prime greater
+	 * than it.  Candidates are sieved in blocks with primes below
+	 * 2^14 whose remainders are computed once and updated from block
+	 * to block and only the remaining candidates are tested with
+	 * Miller-Rabin test as in isProbablePrime().  Numbers less than
+	 * two are replaced with two.
+	 *
+	 * \param[in] rounds number of rounds of Miller-Rabin test, zero
+	 *                   means one
+	 * \return reference to this object
+	 * \sa isProbablePrime()
+	 */
+	BigInt &nextPrime(unsigned rounds = 25);
+
+
+	/**
+	 * Computes factorial of a number.  The factorial is computed
+	 * from its prime factorization: primes whose exponent has given
+	 * bit set are multiplied using a balanced product tree and the
+	 * products are combined by repeated squaring starting with the
+	 * most significant bit.  Power of two is applied at the end as
+	 * a shift.  This way all multiplications are of balanced
+	 * operands and big ones use the fastest algorithm available.
+	 *
+	 * \param[in] n number
+	 * \return <code>n!</code>
+	 * \sa binomial()
+	 */
+	static BigInt factorial(unsigned long n);
+
+	/**
+	 * Computes binomial coefficient.  If \a k is a considerable part
+	 * of \a n the coefficient is computed from its prime
+	 * factorization as in factorial(), otherwise product of \a k
+	 * factors of the numerator computed with a balanced product tree
+	 * is divided by <code>k!</code>.
+	 *
+	 * \param[in] n size of the set
+	 * \param[in] k size of subsets
+	 * \return number of \a k element subsets of \a n element set,
+	 *         zero if \a k is greater than \a n
+	 * \sa factorial()
+	 */
+	static BigInt binomial(unsigned long n, unsigned long k);
+
+	/**
+	 * Computes Fibonacci number using fast doubling.  Pair
+	 * <code>(F(k-1), F(k))</code> is doubled for each bit of \a n
+	 * with two squarings from <code>F(2k-1) = F(k)^2 +
+	 * F(k-1)^2</code> and <code>F(2k+1) = 4 F(k)^2 - F(k-1)^2 + 2
+	 * (-1)^k</code>.
+	 *
+	 * \param[in] n index
+	 * \return <code>F(n)</code> where <code>F(0) = 0</code> and
+	 *         <code>F(1) = 1</code>
+	 * \sa lucas()
+	 */
+	static BigInt fibonacci(unsigned long n);
+
+	/**
+	 * Computes Lucas number as <code>F(n) + 2 F(n-1)</code> from the
+	 * pair of Fibonacci numbers fibonacci() computes.
+	 *
+	 * \param[in] n index
+	 * \return <code>L(n)</code> where <code>L(0) = 2</code> and
+	 *         <code>L(1) = 1</code>
+	 * \sa fibonacci()
+	 */
+	static BigInt lucas(unsigned long n);
+
+
+
+	/**
+	 * Compares two BigInt numbers.
+	 *
+	 * \param[in] n number to compare to
+	 * \return \c -1 if \a n is greater then this, \c 0 if they are
+	 *         equal, \c 1 if \n is lower then this
+	 */
+	int  cmp(const BigInt &n) const;
+
+	/**
+	 * Computes hash of the number.  Limbs are mixed two at a time
+	 * with a multiplication so hashing is a single fast pass; equal
+	 * numbers always have equal hashes.  The result is not cached,
+	 * use BigIntKey if number is hashed or compared many times.
+	 *
+	 * \return hash of the number
+	 * \sa BigIntKey
+	 */
+	std::size_t hash() const;
+
+	/**
+	 * Compares with a machine integer without converting it to
+	 * BigInt.
+	 *
+	 * \param[in] n number to compare to
+	 * \return \c -1 if \a n is greater then this, \c 0 if they are
+	 *         equal, \c 1 if \n is lower then this
+	 */
+	template<class T>
+	typename std::enable_if<BigIntWord<T>::value, int>::type
+	cmp(T n) const {
+		return cmp_word(BigIntWord<T>::sign(n), BigIntWord<T>::abs(n));
+	}
+
+
+
+	/**
+	 * Returns sign of the BigInt number.
+	 *
+	 * \return \c -1 if number is negative, \c 0 if it's zero, \c 1
+	 *         otherwise
+	 * \sa neg(), abs(), #sign
+	 */
+	int  sgn() const { return sign; }
+
+	/**
+	 * Negates number.
+	 *
+	 * \return reference to this object
+	 * \sa sgn(), abs()
+	 */
+	BigInt &neg() { sign = -sign; return *this; }
+
+	/**
+	 * Assigns number it's absolute value.  Changes #sign to \c 1 if
+	 * it was \c -1.
+	 *
+	 * \return reference to this object
+	 * \sa sgn(), neg(), #sign
+	 */
+	BigInt &abs() { if (sign<0) sign = 1; return *this; }
+
+
+
+	/**
+	 * Returns number of character this number would take.  It is
+	 * number of digits plus one if number is negative (since a minus
+	 * sign consumes one character as well.
+	 *
+	 * \note Since number is not stored in decimal this requires
+	 *       a conversion and is as expensive as printing the number.
+	 *
+	 * \return number of characters needed to represent number
+	 */
+	unsigned size() const;
+
+	/**
+	 * Returns Array holding decimal digits.  Note that digits are
+	 * stored in "reverse order", ie. the first digit is the least
+	 * significient.
+	 *
+	 * \note Since number is not stored in decimal this requires
+	 *       a conversion and is as expensive as printing the number.
+	 *
+	 * \return Array of decimal digits
+	 * \sa getLimbs()
+	 */
+	Array<char> getDigits() const;
+
+	/**
+	 * Returns Array holding limbs of number's absolute value.  Note
+	 * that limbs are stored in "reverse order", ie. the first limb is
+	 * the least significient.  The most significant limb is never
+	 * zero and Array is empty iff the number is zero.
+	 *
+	 * \note Limbs are copied to a new Array since number's own limbs
+	 *       are kept in pooled memory.
+	 *
+	 * \return Array of limbs
+	 * \sa getDigits()
+	 */
+	Array<Limb> getLimbs() const;
+
+	/**
+	 * Converts the number to long.  If it does not fit OutOfRange is
+	 * thrown.
+	 *
+	 * \return value of the number
+	 * \sa toUnsignedLong(), toDouble()
+	 */
+	long toLong() const;
+
+	/**
+	 * Converts the number to unsigned long.  If it is negative or
+	 * does not fit OutOfRange is thrown.
+	 *
+	 * \return value of the number
+	 * \sa toLong(), toDouble()
+	 */
+	unsigned long toUnsignedLong() const;
+
+	/**
+	 * Converts the number to double rounding to nearest.  If the
+	 * number is greater than the greatest finite double OutOfRange
+	 * is thrown.
+	 *
+	 * \return value of the number
+	 * \sa toLong(), toUnsignedLong()
+	 */
+	double toDouble() const;
+
+	/**
+	 * Returns representation of the number in given base.  Digits
+	 * above 9 are lower case letters, negative numbers are preceded
+	 * by a minus sign and no prefix is added.  Power of two bases
+	 * take linear time, other bases take time close to the time of
+	 * multiplication.  If \a base is invalid BadRadix is thrown.
+	 *
+	 * \param[in] base base to use, from 2 to 36
+	 * \return string representation of the number
+	 */
+	std::string toString(unsigned base = 10) const;
+
+
+
+	/**
+	 * Adds number to this object.
+	 *
+	 * \param[in] n number to add
+	 * \return reference to this object after addition
+	 * \sa add()
+	 */
+	BigInt &operator+=(const BigInt &n) { return add(n); }
+
+	/**
+	 * Substracts number from this object.
+	 *
+	 * \param[in] n number to substract
+	 * \return reference to this object ofter substraction
+	 * \sa sub()
 	 */
 	BigInt &operator-=(const BigInt &n) { return sub(n); }
 
-	/**
-	 * Multiplies this object by a number.
-	 *
-	 * \param[in] n number to multiple by
-	 * \return reference to this object ofter multiplication
-	 * \sa add()
-	 */
-	BigInt &operator*=(const BigInt &n) { return mul(n); }
+	/**
+	 * Multiplies this object by a number.
+	 *
+	 * \param[in] n number to multiple by
+	 * \return reference to this object ofter multiplication
+	 * \sa add()
+	 */
+	BigInt &operator*=(const BigInt &n) { return mul(n); }
+
+	/**
+	 * Divides this object by a number.
+	 *
+	 * \param[in] n number to divide by
+	 * \return reference to this object after division
+	 * \sa div()
+	 */
+	BigInt &operator/=(const BigInt &n) { return div(n); }
+
+	/**
+	 * Assigns this object remainder of division by a number.
+	 *
+	 * \param[in] n number to divide by
+	 * \return reference to this object
+	 * \sa mod()
+	 */
+	BigInt &operator%=(const BigInt &n) { return mod(n); }
+
+	/**
+	 * Adds machine integer to this object.
+	 *
+	 * \param[in] n number to add
+	 * \return reference to this object after addition
+	 * \sa add(T)
+	 */
+	template<class T>
+	typename std::enable_if<BigIntWord<T>::value, BigInt &>::type
+	operator+=(T n) { return add(n); }
+
+	/**
+	 * Substracts machine integer from this object.
+	 *
+	 * \param[in] n number to substract
+	 * \return reference to this object after substraction
+	 * \sa sub(T)
+	 */
+	template<class T>
+	typename std::enable_if<BigIntWord<T>::value, BigInt &>::type
+	operator-=(T n) { return sub(n); }
+
+	/**
+	 * Multiplies this object by a machine integer.
+	 *
+	 * \param[in] n number to multiply by
+	 * \return reference to this object after multiplication
+	 * \sa mul(T)
+	 */
+	template<class T>
+	typename std::enable_if<BigIntWord<T>::value, BigInt &>::type
+	operator*=(T n) { return mul(n); }
+
+	/**
+	 * Divides this object by a machine integer.
+	 *
+	 * \param[in] n number to divide by
+	 * \return reference to this object after division
+	 * \sa div(T)
+	 */
+	template<class T>
+	typename std::enable_if<BigIntWord<T>::value, BigInt &>::type
+	operator/=(T n) { return div(n); }
+
+	/**
+	 * Assigns this object remainder of division by a machine integer.
+	 *
+	 * \param[in] n number to divide by
+	 * \return reference to this object
+	 * \sa mod(T)
+	 */
+	template<class T>
+	typename std::enable_if<BigIntWord<T>::value, BigInt &>::type
+	operator%=(T n) { return mod(n); }
+
+	/**
+	 * Adds value of an expression to this object.  Products in the
+	 * expression are accumulated directly into this object's limbs,
+	 * so <code>sum += a * b</code> in a loop does not allocate memory
+	 * once the number has grown.
+	 *
+	 * \param[in] e expression to add
+	 * \return reference to this object after addition
+	 * \sa BigIntExpr
+	 */
+	template<unsigned N>
+	BigInt &operator+=(const BigIntExpr<N> &e) {
+		evaluate(e.terms, N, 1);
+		return *this;
+	}
+
+	/**
+	 * Substracts value of an expression from this object.
+	 *
+	 * \param[in] e expression to substract
+	 * \return reference to this object after substraction
+	 * \sa operator+=(const BigIntExpr<N>&)
+	 */
+	template<unsigned N>
+	BigInt &operator-=(const BigIntExpr<N> &e) {
+		evaluate(e.terms, N, -1);
+		return *this;
+	}
+
+
+
+	/**
+	 * Sets value of this object to the value of another BigInt
+	 * object.
+	 *
+	 * \param[in] n number to copy
+	 * \sa set(const BigInt &n)
+	 */
+	BigInt &operator= (const BigInt &n) {
+		set(n);
+		return *this;
+	}
+
+	/**
+	 * Moves value of another BigInt object to this object.  \a n
+	 * becomes zero.
+	 *
+	 * \param[in] n number to move
+	 */
+	BigInt &operator= (BigInt &&n) noexcept {
+		if (this!=&n) {
+			limbs = std::move(n.limbs);
+			sign = n.sign;
+			small[0] = n.small[0];
+			small[1] = n.small[1];
+			n.zero();
+		}
+		return *this;
+	}
+
+	/**
+	 * Sets value of this object to the value of an expression.  The
+	 * expression may refer to this object.
+	 *
+	 * \param[in] e expression to evaluate
+	 * \sa BigIntExpr
+	 */
+	template<unsigned N>
+	BigInt &operator= (const BigIntExpr<N> &e) {
+		evaluate(e.terms, N, 0);
+		return *this;
+	}
+
+
+
+	/**
+	 * Checks if number is not zero.
+	 *
+	 * \return \c true if number is not zero.
+	 */
+	operator bool() const { return sign; }
+
+	/**
+	 * Checks if number is zero.
+	 *
+	 * \return \c true if number is zero.
+	 */
+	bool operator !() const { return !sign; }
+
+
+
+	/* Friends */
+	friend std::ostream &operator<<(std::ostream &os, const BigInt &n);
+	friend std::istream &operator>>(std::istream &is, BigInt &n);
+	friend class BigIntAccumulator;
+	friend class BigIntGcd;
+	friend class BigIntRoot;
+	friend class BigIntBatch;
+	template<unsigned Bits> friend class FixedBigInt;
+	friend struct BigIntInspect;
+};
+
+
+
+
+/**
+ * Single term of a BigInt expression, ie. a number or a product of two
+ * numbers, with a sign.  Numbers are held by value but since copies
+ * of BigInt share limbs this is as cheap as holding a reference and
+ * the term stays valid even if it outlives a temporary.
+ */
+struct BigIntTerm {
+	/** The number or the first factor. */
+	BigInt a;
+	/** The second factor, used only if #prod is set. */
+	BigInt b;
+	/** \c 1 if term is added, \c -1 if it is substracted. */
+	int sign;
+	/** Whether the term is a product of #a and #b. */
+	bool prod;
+};
+
+
+/**
+ * Sum of \a N terms built by arithmetic operators.  Sums, differences
+ * and products of BigInt numbers are not computed right away but are
+ * collected in an expression which is evaluated once it is assigned
+ * to, added to or substracted from a BigInt object.  The whole
+ * expression is computed in a single buffer, so for example <code>x =
+ * a * b + c * d - e</code> creates no temporaries.  Products whose
+ * operand is itself an expression evaluate that operand first.
+ *
+ * Expressions convert to BigInt implicitly so they may be passed
+ * wherever a BigInt is expected.  Expressions whose operands are
+ * expiring BigInt objects (eg. <code>x + 1</code>) are still computed
+ * right away in storage of the expiring object.
+ *
+ * Expressions also have the const query methods of BigInt so that
+ * eg. <code>(a + b).cmp(c)</code> compiles.  Except for sgn() of
+ * a single term, each of them evaluates the whole expression into a
+ * temporary BigInt every time it is called, so a value which is
+ * queried more than once should be assigned to a BigInt first.
+ * Expressions have no modifying methods; <code>auto x = a * b</code>
+ * holds an expression, not a number, and has to be written as
+ * <code>BigInt x = a * b</code> to be modified.
+ *
+ * \sa BigInt::evaluate()
+ */
+template<unsigned N>
+class BigIntExpr {
+public:
+	/** Terms of the expression. */
+	BigIntTerm terms[N];
+
+	/**
+	 * Creates expression consisting of a single number.
+	 *
+	 * \param[in] a the number
+	 */
+	explicit BigIntExpr(BigInt a) {
+		static_assert(N == 1, "single term expression");
+		terms[0].a = std::move(a);
+		terms[0].sign = 1;
+		terms[0].prod = false;
+	}
+
+	/**
+	 * Creates expression consisting of a product of two numbers.
+	 *
+	 * \param[in] a the first factor
+	 * \param[in] b the second factor
+	 */
+	BigIntExpr(BigInt a, BigInt b) {
+		static_assert(N == 1, "single term expression");
+		terms[0].a = std::move(a);
+		terms[0].b = std::move(b);
+		terms[0].sign = 1;
+		terms[0].prod = true;
+	}
+
+	/**
+	 * Creates expression which is a sum or difference of two other
+	 * expressions.
+	 *
+	 * \param[in] x the first expression
+	 * \param[in] y the second expression
+	 * \param[in] s \c 1 to add \a y, \c -1 to substract it
+	 */
+	template<unsigned K>
+	BigIntExpr(const BigIntExpr<K> &x, const BigIntExpr<N - K> &y, int s) {
+		for (unsigned i = 0; i<K; ++i) terms[i] = x.terms[i];
+		for (unsigned i = 0; i<N - K; ++i) {
+			terms[K + i] = y.terms[i];
+			terms[K + i].sign *= s;
+		}
+	}
+
+
+	/**
+	 * \copydoc BigInt::cmp(const BigInt&) const
+	 * Evaluates the expression into a temporary.
+	 */
+	int  cmp(const BigInt &n) const { return BigInt(*this).cmp(n); }
+
+	/**
+	 * \copydoc BigInt::cmp(T) const
+	 * Evaluates the expression into a temporary.
+	 */
+	template<class T>
+	typename std::enable_if<BigIntWord<T>::value, int>::type
+	cmp(T n) const { return BigInt(*this).cmp(n); }
+
+	/**
+	 * \copydoc BigInt::sgn()
+	 * Sign of a single number or product is computed from signs of
+	 * the factors; other expressions are evaluated into a temporary.
+	 */
+	int  sgn() const {
+		if (N==1) {
+			return terms[0].sign * terms[0].a.sgn() *
+				(terms[0].prod ? terms[0].b.sgn() : 1);
+		}
+		return BigInt(*this).sgn();
+	}
+
+	/**
+	 * \copydoc BigInt::toString()
+	 * Evaluates the expression into a temporary.
+	 */
+	std::string toString(unsigned base = 10) const {
+		return BigInt(*this).toString(base);
+	}
+
+	/**
+	 * \copydoc BigInt::toLong()
+	 * Evaluates the expression into a temporary.
+	 */
+	long toLong() const { return BigInt(*this).toLong(); }
+
+	/**
+	 * \copydoc BigInt::toUnsignedLong()
+	 * Evaluates the expression into a temporary.
+	 */
+	unsigned long toUnsignedLong() const {
+		return BigInt(*this).toUnsignedLong();
+	}
+
+	/**
+	 * \copydoc BigInt::toDouble()
+	 * Evaluates the expression into a temporary.
+	 */
+	double toDouble() const { return BigInt(*this).toDouble(); }
+
+	/**
+	 * \copydoc BigInt::isProbablePrime()
+	 * Evaluates the expression into a temporary.
+	 */
+	bool isProbablePrime(unsigned rounds = 25) const {
+		return BigInt(*this).isProbablePrime(rounds);
+	}
+
+	/**
+	 * Checks if expression is non-zero.
+	 *
+	 * \return \c true if expression does not equal zero
+	 * \sa sgn()
+	 */
+	explicit operator bool() const { return sgn(); }
+
+	/**
+	 * Checks if expression is zero.
+	 *
+	 * \return \c true if expression equals zero
+	 * \sa sgn()
+	 */
+	bool operator !() const { return !sgn(); }
+};
+
+
+
+/**
+ * Adds two BigInt numbers.  The sum is computed once the expression
+ * is assigned to a BigInt object.
+ *
+ * \param[in] a first BigInt number
+ * \param[in] b second BigInt number
+ * \return expression which equals \a a plus \a b
+ * \sa BigIntExpr, BigInt::add()
+ */
+inline BigIntExpr<2> operator+(const BigInt &a, const BigInt &b) {
+	return BigIntExpr<2>(BigIntExpr<1>(a), BigIntExpr<1>(b), 1);
+}
+
+/**
+ * Adds two BigInt numbers reusing storage of the expiring one.
+ *
+ * \param[in] a first BigInt number
+ * \param[in] b second BigInt number
+ * \return \a a plus \a b
+ * \sa BigInt::add()
+ */
+inline BigInt operator+(BigInt &&a, const BigInt &b) {
+	return std::move(a.add(b));
+}
+
+/**
+ * \copydoc operator+(BigInt&&, const BigInt&)
+ */
+inline BigInt operator+(const BigInt &a, BigInt &&b) {
+	return std::move(b.add(a));
+}
+
+/**
+ * \copydoc operator+(BigInt&&, const BigInt&)
+ */
+inline BigInt operator+(BigInt &&a, BigInt &&b) {
+	return std::move(a.add(b));
+}
+
+/**
+ * Adds a number to or from an expression.
+ *
+ * \param[in] a first operand
+ * \param[in] b second operand
+ * \return expression which equals \a a plus \a b
+ */
+template<unsigned N>
+inline BigIntExpr<N + 1> operator+(const BigIntExpr<N> &a, const BigInt &b) {
+	return BigIntExpr<N + 1>(a, BigIntExpr<1>(b), 1);
+}
+
+/**
+ * \copydoc operator+(const BigIntExpr<N>&, const BigInt&)
+ */
+template<unsigned N>
+inline BigIntExpr<N + 1> operator+(const BigIntExpr<N> &a, BigInt &&b) {
+	return BigIntExpr<N + 1>(a, BigIntExpr<1>(std::move(b)), 1);
+}
+
+/**
+ * \copydoc operator+(const BigIntExpr<N>&, const BigInt&)
+ */
+template<unsigned N>
+inline BigIntExpr<N + 1> operator+(const BigInt &a, const BigIntExpr<N> &b) {
+	return BigIntExpr<N + 1>(BigIntExpr<1>(a), b, 1);
+}
+
+/**
+ * \copydoc operator+(const BigIntExpr<N>&, const BigInt&)
+ */
+template<unsigned N>
+inline BigIntExpr<N + 1> operator+(BigInt &&a, const BigIntExpr<N> &b) {
+	return BigIntExpr<N + 1>(BigIntExpr<1>(std::move(a)), b, 1);
+}
+
+/**
+ * \copydoc operator+(const BigIntExpr<N>&, const BigInt&)
+ */
+template<unsigned N, unsigned M>
+inline BigIntExpr<N + M> operator+(const BigIntExpr<N> &a,
+                                    const BigIntExpr<M> &b) {
+	return BigIntExpr<N + M>(a, b, 1);
+}
+
+/**
+ * Substracts two BigInt numbers.  The difference is computed once the
+ * expression is assigned to a BigInt object.
+ *
+ * \param[in] a first BigInt number
+ * \param[in] b second BigInt number
+ * \return expression which equals \a a minus \a b
+ * \sa BigIntExpr, BigInt::sub()
+ */
+inline BigIntExpr<2> operator-(const BigInt &a, const BigInt &b) {
+	return BigIntExpr<2>(BigIntExpr<1>(a), BigIntExpr<1>(b), -1);
+}
+
+/**
+ * Substracts two BigInt numbers reusing storage of the expiring one.
+ *
+ * \param[in] a first BigInt number
+ * \param[in] b second BigInt number
+ * \return \a a minus \a b
+ * \sa BigInt::sub()
+ */
+inline BigInt operator-(BigInt &&a, const BigInt &b) {
+	return std::move(a.sub(b));
+}
+
+/**
+ * \copydoc operator-(BigInt&&, const BigInt&)
+ */
+inline BigInt operator-(const BigInt &a, BigInt &&b) {
+	return std::move(b.sub(a).neg());
+}
+
+/**
+ * \copydoc operator-(BigInt&&, const BigInt&)
+ */
+inline BigInt operator-(BigInt &&a, BigInt &&b) {
+	return std::move(a.sub(b));
+}
+
+/**
+ * Substracts a number to or from an expression.
+ *
+ * \param[in] a first operand
+ * \param[in] b second operand
+ * \return expression which equals \a a minus \a b
+ */
+template<unsigned N>
+inline BigIntExpr<N + 1> operator-(const BigIntExpr<N> &a, const BigInt &b) {
+	return BigIntExpr<N + 1>(a, BigIntExpr<1>(b), -1);
+}
+
+/**
+ * \copydoc operator-(const BigIntExpr<N>&, const BigInt&)
+ */
+template<unsigned N>
+inline BigIntExpr<N + 1> operator-(const BigIntExpr<N> &a, BigInt &&b) {
+	return BigIntExpr<N + 1>(a, BigIntExpr<1>(std::move(b)), -1);
+}
+
+/**
+ * \copydoc operator-(const BigIntExpr<N>&, const BigInt&)
+ */
+template<unsigned N>
+inline BigIntExpr<N + 1> operator-(const BigInt &a, const BigIntExpr<N> &b) {
+	return BigIntExpr<N + 1>(BigIntExpr<1>(a), b, -1);
+}
+
+/**
+ * \copydoc operator-(const BigIntExpr<N>&, const BigInt&)
+ */
+template<unsigned N>
+inline BigIntExpr<N + 1> operator-(BigInt &&a, const BigIntExpr<N> &b) {
+	return BigIntExpr<N + 1>(BigIntExpr<1>(std::move(a)), b, -1);
+}
+
+/**
+ * \copydoc operator-(const BigIntExpr<N>&, const BigInt&)
+ */
+template<unsigned N, unsigned M>
+inline BigIntExpr<N + M> operator-(const BigIntExpr<N> &a,
+                                    const BigIntExpr<M> &b) {
+	return BigIntExpr<N + M>(a, b, -1);
+}
+
+/**
+ * Multiplies two BigInt numbers.  The product is computed once the
+ * expression is assigned to a BigInt object, and if it is a part of
+ * a sum it is accumulated directly into the result.
+ *
+ * \param[in] a first BigInt number
+ * \param[in] b second BigInt number
+ * \return expression which equals \a a multiplied by \a b
+ * \sa BigIntExpr, BigInt::mul()
+ */
+inline BigIntExpr<1> operator*(const BigInt &a, const BigInt &b) {
+	return BigIntExpr<1>(a, b);
+}
+
+/**
+ * Multiplies two BigInt numbers reusing storage of the expiring one.
+ *
+ * \param[in] a first BigInt number
+ * \param[in] b second BigInt number
+ * \return \a a multiplied by \a b
+ * \sa BigInt::mul()
+ */
+inline BigInt operator*(BigInt &&a, const BigInt &b) {
+	return std::move(a.mul(b));
+}
+
+/**
+ * \copydoc operator*(BigInt&&, const BigInt&)
+ */
+inline BigInt operator*(const BigInt &a, BigInt &&b) {
+	return std::move(b.mul(a));
+}
+
+/**
+ * \copydoc operator*(BigInt&&, const BigInt&)
+ */
+inline BigInt operator*(BigInt &&a, BigInt &&b) {
+	return std::move(a.mul(b));
+}
+
+/**
+ * Multiplies a number by an expression.  The expression is evaluated
+ * first.
+ *
+ * \param[in] a first operand
+ * \param[in] b second operand
+ * \return expression which equals \a a multiplied by \a b
+ */
+template<unsigned N>
+inline BigIntExpr<1> operator*(const BigIntExpr<N> &a, const BigInt &b) {
+	return BigIntExpr<1>(BigInt(a), b);
+}
+
+/**
+ * \copydoc operator*(const BigIntExpr<N>&, const BigInt&)
+ */
+template<unsigned N>
+inline BigIntExpr<1> operator*(const BigIntExpr<N> &a, BigInt &&b) {
+	return BigIntExpr<1>(BigInt(a), std::move(b));
+}
+
+/**
+ * \copydoc operator*(const BigIntExpr<N>&, const BigInt&)
+ */
+template<unsigned N>
+inline BigIntExpr<1> operator*(const BigInt &a, const BigIntExpr<N> &b) {
+	return BigIntExpr<1>(a, BigInt(b));
+}
+
+/**
+ * \copydoc operator*(const BigIntExpr<N>&, const BigInt&)
+ */
+template<unsigned N>
+inline BigIntExpr<1> operator*(BigInt &&a, const BigIntExpr<N> &b) {
+	return BigIntExpr<1>(std::move(a), BigInt(b));
+}
+
+/**
+ * \copydoc operator*(const BigIntExpr<N>&, const BigInt&)
+ */
+template<unsigned N, unsigned M>
+inline BigIntExpr<1> operator*(const BigIntExpr<N> &a,
+                               const BigIntExpr<M> &b) {
+	return BigIntExpr<1>(BigInt(a), BigInt(b));
+}
+
+
+
+/**
+ * Divides two BigInt numbers.
+ *
+ * \param[in] a dividend
+ * \param[in] b divisor
+ * \return new BigInt object which equals \a a divided by \a b
+ * \sa BigInt::div()
+ */
+inline BigInt operator/(const BigInt &a, const BigInt &b) {
+	return BigInt(a).div(b);
+}
+
+/**
+ * Divides two BigInt numbers reusing storage of the expiring
+ * dividend.
+ *
+ * \param[in] a dividend
+ * \param[in] b divisor
+ * \return \a a divided by \a b
+ * \sa BigInt::div()
+ */
+inline BigInt operator/(BigInt &&a, const BigInt &b) {
+	return std::move(a.div(b));
+}
+
+/**
+ * Computes remainder of division of two BigInt numbers.
+ *
+ * \param[in] a dividend
+ * \param[in] b divisor
+ * \return new BigInt object which equals remainder of \a a divided
+ *         by \a b
+ * \sa BigInt::mod()
+ */
+inline BigInt operator%(const BigInt &a, const BigInt &b) {
+	return BigInt(a).mod(b);
+}
+
+/**
+ * Computes remainder of division of two BigInt numbers reusing
+ * storage of the expiring dividend.
+ *
+ * \param[in] a dividend
+ * \param[in] b divisor
+ * \return remainder of \a a divided by \a b
+ * \sa BigInt::mod()
+ */
+inline BigInt operator%(BigInt &&a, const BigInt &b) {
+	return std::move(a.mod(b));
+}
+
+/**
+ * Adds machine integer to a BigInt number.  The sum is computed
+ * right away using BigInt::add(T) so no BigInt is created for \a b.
+ *
+ * \param[in] a BigInt number
+ * \param[in] b machine integer
+ * \return new BigInt object which equals \a a plus \a b
+ * \sa BigIntWord
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, BigInt>::type
+operator+(const BigInt &a, T b) {
+	return BigInt(a).add(b);
+}
+
+/**
+ * \copydoc operator+(const BigInt&, T)
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, BigInt>::type
+operator+(BigInt &&a, T b) {
+	return std::move(a.add(b));
+}
+
+/**
+ * \copydoc operator+(const BigInt&, T)
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, BigInt>::type
+operator+(T a, const BigInt &b) {
+	return BigInt(b).add(a);
+}
+
+/**
+ * \copydoc operator+(const BigInt&, T)
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, BigInt>::type
+operator+(T a, BigInt &&b) {
+	return std::move(b.add(a));
+}
+
+/**
+ * Adds machine integer to an expression.
+ *
+ * \param[in] a first operand
+ * \param[in] b second operand
+ * \return expression which equals \a a plus \a b
+ */
+template<unsigned N, class T>
+inline typename std::enable_if<BigIntWord<T>::value, BigIntExpr<N + 1> >::type
+operator+(const BigIntExpr<N> &a, T b) {
+	return BigIntExpr<N + 1>(a, BigIntExpr<1>(BigInt(b)), 1);
+}
+
+/**
+ * \copydoc operator+(const BigIntExpr<N>&, T)
+ */
+template<unsigned N, class T>
+inline typename std::enable_if<BigIntWord<T>::value, BigIntExpr<N + 1> >::type
+operator+(T a, const BigIntExpr<N> &b) {
+	return BigIntExpr<N + 1>(BigIntExpr<1>(BigInt(a)), b, 1);
+}
+
+/**
+ * Substracts machine integer from a BigInt number or the other way
+ * around.  The difference is computed right away using
+ * BigInt::sub(T) so no BigInt is created for the machine integer.
+ *
+ * \param[in] a minuend
+ * \param[in] b subtrahend
+ * \return new BigInt object which equals \a a minus \a b
+ * \sa BigIntWord
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, BigInt>::type
+operator-(const BigInt &a, T b) {
+	return BigInt(a).sub(b);
+}
+
+/**
+ * \copydoc operator-(const BigInt&, T)
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, BigInt>::type
+operator-(BigInt &&a, T b) {
+	return std::move(a.sub(b));
+}
+
+/**
+ * \copydoc operator-(const BigInt&, T)
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, BigInt>::type
+operator-(T a, const BigInt &b) {
+	return BigInt(b).sub(a).neg();
+}
+
+/**
+ * \copydoc operator-(const BigInt&, T)
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, BigInt>::type
+operator-(T a, BigInt &&b) {
+	return std::move(b.sub(a).neg());
+}
+
+/**
+ * Substracts machine integer from an expression or the other way
+ * around.
+ *
+ * \param[in] a first operand
+ * \param[in] b second operand
+ * \return expression which equals \a a minus \a b
+ */
+template<unsigned N, class T>
+inline typename std::enable_if<BigIntWord<T>::value, BigIntExpr<N + 1> >::type
+operator-(const BigIntExpr<N> &a, T b) {
+	return BigIntExpr<N + 1>(a, BigIntExpr<1>(BigInt(b)), -1);
+}
+
+/**
+ * \copydoc operator-(const BigIntExpr<N>&, T)
+ */
+template<unsigned N, class T>
+inline typename std::enable_if<BigIntWord<T>::value, BigIntExpr<N + 1> >::type
+operator-(T a, const BigIntExpr<N> &b) {
+	return BigIntExpr<N + 1>(BigIntExpr<1>(BigInt(a)), b, -1);
+}
+
+/**
+ * Multiplies BigInt number by a machine integer.  The product is
+ * computed right away in a single pass using BigInt::mul(T).
+ *
+ * \param[in] a BigInt number
+ * \param[in] b machine integer
+ * \return new BigInt object which equals \a a multiplied by \a b
+ * \sa BigIntWord
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, BigInt>::type
+operator*(const BigInt &a, T b) {
+	return BigInt(a).mul(b);
+}
 
+/**
+ * \copydoc operator*(const BigInt&, T)
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, BigInt>::type
+operator*(BigInt &&a, T b) {
+	return std::move(a.mul(b));
+}
 
+/**
+ * \copydoc operator*(const BigInt&, T)
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, BigInt>::type
+operator*(T a, const BigInt &b) {
+	return BigInt(b).mul(a);
+}
 
-	/**
-	 * Sets value of this object to the value of another BigInt
-	 * object.
-	 *
-	 * \param[in] n number to copy
-	 * \sa set(const BigInt &n)
-	 */
-	BigInt &operator= (const BigInt &n) {
-		digits = n.digits;
-		sign = n.sign;
-		return *this;
-	}
+/**
+ * \copydoc operator*(const BigInt&, T)
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, BigInt>::type
+operator*(T a, BigInt &&b) {
+	return std::move(b.mul(a));
+}
 
+/**
+ * Multiplies an expression by a machine integer.  The expression is
+ * evaluated first.
+ *
+ * \param[in] a expression
+ * \param[in] b machine integer
+ * \return \a a multiplied by \a b
+ */
+template<unsigned N, class T>
+inline typename std::enable_if<BigIntWord<T>::value, BigInt>::type
+operator*(const BigIntExpr<N> &a, T b) {
+	return BigInt(a).mul(b);
+}
 
+/**
+ * \copydoc operator*(const BigIntExpr<N>&, T)
+ */
+template<unsigned N, class T>
+inline typename std::enable_if<BigIntWord<T>::value, BigInt>::type
+operator*(T a, const BigIntExpr<N> &b) {
+	return BigInt(b).mul(a);
+}
 
-	/**
-	 * Checks if number is not zero.
-	 *
-	 * \return \c true if number is not zero.
-	 */
-	operator bool() const { return sign; }
+/**
+ * Divides BigInt number by a machine integer in a single pass.
+ *
+ * \param[in] a dividend
+ * \param[in] b divisor
+ * \return new BigInt object which equals \a a divided by \a b
+ * \sa BigInt::div(T)
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, BigInt>::type
+operator/(const BigInt &a, T b) {
+	return BigInt(a).div(b);
+}
 
-	/**
-	 * Checks if number is zero.
-	 *
-	 * \return \c true if number is zero.
-	 */
-	bool operator !() const { return !sign; }
+/**
+ * \copydoc operator/(const BigInt&, T)
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, BigInt>::type
+operator/(BigInt &&a, T b) {
+	return std::move(a.div(b));
+}
+
+/**
+ * Computes remainder of division of BigInt number by a machine
+ * integer in a single pass without computing the quotient.
+ *
+ * \param[in] a dividend
+ * \param[in] b divisor
+ * \return new BigInt object which equals remainder of \a a divided
+ *         by \a b
+ * \sa BigInt::mod(T)
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, BigInt>::type
+operator%(const BigInt &a, T b) {
+	return BigInt(a).mod(b);
+}
 
+/**
+ * \copydoc operator%(const BigInt&, T)
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, BigInt>::type
+operator%(BigInt &&a, T b) {
+	return std::move(a.mod(b));
+}
 
+/**
+ * Squares BigInt number.
+ *
+ * \param[in] n BigInt number
+ * \return new BigInt object which equals \a n multiplied by \a n
+ * \sa BigInt::sqr()
+ */
+inline BigInt sqr(const BigInt &n) {
+	return BigInt(n).sqr();
+}
 
-	/* Friends */
-	friend std::istream &operator>>(std::istream &is, BigInt &n);
-};
+/**
+ * Squares expiring BigInt number reusing its storage.
+ *
+ * \param[in] n BigInt number
+ * \return \a n multiplied by \a n
+ * \sa BigInt::sqr()
+ */
+inline BigInt sqr(BigInt &&n) {
+	return std::move(n.sqr());
+}
 
+/**
+ * Raises BigInt number to a power.
+ *
+ * \param[in] n BigInt number
+ * \param[in] e exponent
+ * \return new BigInt object which equals \a n to the power of \a e
+ * \sa BigInt::pow()
+ */
+inline BigInt pow(const BigInt &n, unsigned long e) {
+	return BigInt(n).pow(e);
+}
 
+/**
+ * Raises expiring BigInt number to a power reusing its storage.
+ *
+ * \param[in] n BigInt number
+ * \param[in] e exponent
+ * \return \a n to the power of \a e
+ * \sa BigInt::pow()
+ */
+inline BigInt pow(BigInt &&n, unsigned long e) {
+	return std::move(n.pow(e));
+}
 
+/**
+ * Raises BigInt number to a power modulo another number.
+ *
+ * \param[in] n BigInt number
+ * \param[in] e exponent, must not be negative
+ * \param[in] m modulus
+ * \return new BigInt object which equals \a n to the power of \a e
+ *         modulo \a m
+ * \sa BigInt::powmod()
+ */
+inline BigInt powmod(const BigInt &n, const BigInt &e, const BigInt &m) {
+	return BigInt(n).powmod(e, m);
+}
 
 /**
- * Adds two BigInt numbers.
+ * Computes greatest common divisor of two BigInt numbers.
  *
  * \param[in] a first BigInt number
  * \param[in] b second BigInt number
- * \return new BigInt object which equal \a a plus \a b
- * \sa BigInt::add()
+ * \return new BigInt object which equals greatest common divisor of
+ *         \a a and \a b
+ * \sa BigInt::gcd()
  */
-inline BigInt operator+(const BigInt &a, const BigInt &b) {
-	return BigInt(a).add(b);
+inline BigInt gcd(const BigInt &a, const BigInt &b) {
+	return BigInt(a).gcd(b);
 }
 
 /**
- * Substracts two BigInt numbers.
+ * Computes least common multiple of two BigInt numbers.
  *
  * \param[in] a first BigInt number
  * \param[in] b second BigInt number
- * \return new BigInt object which equals \a a minus \a b
- * \sa BigInt::sub()
+ * \return new BigInt object which equals least common multiple of
+ *         \a a and \a b
+ * \sa BigInt::lcm()
  */
-inline BigInt operator-(const BigInt &a, const BigInt &b) {
-	return BigInt(a).sub(b);
+inline BigInt lcm(const BigInt &a, const BigInt &b) {
+	return BigInt(a).lcm(b);
 }
 
 /**
- * Multiplies two BigInt numbers.
+ * Computes greatest common divisor of two BigInt numbers and Bezout's
+ * coefficients.
  *
  * \param[in] a first BigInt number
  * \param[in] b second BigInt number
- * \return new BigInt object which equals \a a multiplied by \a b
- * \sa BigInt::mul()
+ * \param[out] s coefficient of \a a
+ * \param[out] t coefficient of \a b
+ * \return new BigInt object which equals <code>a * s + b * t</code>
+ *         and greatest common divisor of \a a and \a b
+ * \sa BigInt::gcdext()
  */
-inline BigInt operator*(const BigInt &a, const BigInt &b) {
-	return BigInt(a).mul(b);
+inline BigInt gcdext(const BigInt &a, const BigInt &b, BigInt &s,
+                     BigInt &t) {
+	return BigInt(a).gcdext(b, s, t);
+}
+
+/**
+ * Computes modular inverse of a BigInt number.
+ *
+ * \param[in] n BigInt number
+ * \param[in] m modulus
+ * \return new BigInt object which equals inverse of \a n modulo \a m
+ * \sa BigInt::invmod()
+ */
+inline BigInt invmod(const BigInt &n, const BigInt &m) {
+	return BigInt(n).invmod(m);
+}
+
+/**
+ * Computes square root of a BigInt number rounded down.
+ *
+ * \param[in] n BigInt number
+ * \return new BigInt object which equals square root of \a n
+ * \sa BigInt::isqrt()
+ */
+inline BigInt isqrt(const BigInt &n) {
+	return BigInt(n).isqrt();
+}
+
+/**
+ * Computes square root of a BigInt number rounded down.
+ *
+ * \param[in] n BigInt number
+ * \return \a n with square root of itself computed
+ * \sa BigInt::isqrt()
+ */
+inline BigInt isqrt(BigInt &&n) {
+	return std::move(n.isqrt());
+}
+
+/**
+ * Computes root of a BigInt number rounded towards zero.
+ *
+ * \param[in] n BigInt number
+ * \param[in] k degree of the root
+ * \return new BigInt object which equals \a k-th root of \a n
+ * \sa BigInt::iroot()
+ */
+inline BigInt iroot(const BigInt &n, unsigned long k) {
+	return BigInt(n).iroot(k);
+}
+
+/**
+ * Computes root of a BigInt number rounded towards zero.
+ *
+ * \param[in] n BigInt number
+ * \param[in] k degree of the root
+ * \return \a n with \a k-th root of itself computed
+ * \sa BigInt::iroot()
+ */
+inline BigInt iroot(BigInt &&n, unsigned long k) {
+	return std::move(n.iroot(k));
+}
+
+/**
+ * Finds the smallest (probable) prime greater than a BigInt number.
+ *
+ * \param[in] n BigInt number
+ * \return new BigInt object which equals the smallest prime greater
+ *         than \a n
+ * \sa BigInt::nextPrime()
+ */
+inline BigInt nextPrime(const BigInt &n) {
+	return BigInt(n).nextPrime();
+}
+
+/**
+ * Finds the smallest (probable) prime greater than a BigInt number.
+ *
+ * \param[in] n BigInt number
+ * \return \a n replaced with the smallest prime greater than itself
+ * \sa BigInt::nextPrime()
+ */
+inline BigInt nextPrime(BigInt &&n) {
+	return std::move(n.nextPrime());
 }
 
 
@@ -397,6 +2375,30 @@ inline BigInt operator-(const BigInt &n) {
 	return BigInt(n).neg();
 }
 
+/**
+ * Negates expiring number reusing its storage.
+ *
+ * \param[in] n BigInt numebr to negate
+ * \return negation of \a n
+ * \sa BigInt::neg()
+ */
+inline BigInt operator-(BigInt &&n) {
+	return std::move(n.neg());
+}
+
+/**
+ * Negates an expression.
+ *
+ * \param[in] e expression to negate
+ * \return expression which equals minus \a e
+ */
+template<unsigned N>
+inline BigIntExpr<N> operator-(const BigIntExpr<N> &e) {
+	BigIntExpr<N> r(e);
+	for (unsigned i = 0; i<N; ++i) r.terms[i].sign = -r.terms[i].sign;
+	return r;
+}
+
 /**
  * Returns abstract value of a number.
  *
@@ -408,6 +2410,17 @@ inline BigInt abs(const BigInt &n) {
 	return BigInt(n).abs();
 }
 
+/**
+ * Returns abstract value of an expiring number reusing its storage.
+ *
+ * \param[in] n BigInt number
+ * \return absolute value of \a n
+ * \sa BigInt::abs()
+ */
+inline BigInt abs(BigInt &&n) {
+	return std::move(n.abs());
+}
+
 
 
 /**
@@ -482,10 +2495,182 @@ inline bool operator< (const BigInt &a, const BigInt &b) {
 	return a.cmp(b)< 0;
 }
 
+/**
+ * Compares BigInt number with a machine integer.
+ *
+ * \param[in] a BigInt number
+ * \param[in] b machine integer
+ * \return \c true if both numebrs are equal
+ * \sa BigInt::cmp(T)
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, bool>::type
+operator==(const BigInt &a, T b) {
+	return a.cmp(b)==0;
+}
+
+/**
+ * Compares BigInt number with a machine integer.
+ *
+ * \param[in] a BigInt number
+ * \param[in] b machine integer
+ * \return \c true if numbers are not equal
+ * \sa BigInt::cmp(T)
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, bool>::type
+operator!=(const BigInt &a, T b) {
+	return a.cmp(b)!=0;
+}
+
+/**
+ * Compares BigInt number with a machine integer.
+ *
+ * \param[in] a BigInt number
+ * \param[in] b machine integer
+ * \return \c true if \a a is greater then or equal to \a b
+ * \sa BigInt::cmp(T)
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, bool>::type
+operator>=(const BigInt &a, T b) {
+	return a.cmp(b)>=0;
+}
+
+/**
+ * Compares BigInt number with a machine integer.
+ *
+ * \param[in] a BigInt number
+ * \param[in] b machine integer
+ * \return \c true if \a a is lower then or equal to \a b
+ * \sa BigInt::cmp(T)
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, bool>::type
+operator<=(const BigInt &a, T b) {
+	return a.cmp(b)<=0;
+}
+
+/**
+ * Compares BigInt number with a machine integer.
+ *
+ * \param[in] a BigInt number
+ * \param[in] b machine integer
+ * \return \c true if \a a is greater then \a b
+ * \sa BigInt::cmp(T)
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, bool>::type
+operator> (const BigInt &a, T b) {
+	return a.cmp(b)> 0;
+}
+
+/**
+ * Compares BigInt number with a machine integer.
+ *
+ * \param[in] a BigInt number
+ * \param[in] b machine integer
+ * \return \c true if \a a is lower then \a b
+ * \sa BigInt::cmp(T)
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, bool>::type
+operator< (const BigInt &a, T b) {
+	return a.cmp(b)< 0;
+}
+
+/**
+ * Compares machine integer with a BigInt number.
+ *
+ * \param[in] a machine integer
+ * \param[in] b BigInt number
+ * \return \c true if both numebrs are equal
+ * \sa BigInt::cmp(T)
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, bool>::type
+operator==(T a, const BigInt &b) {
+	return b.cmp(a)==0;
+}
+
+/**
+ * Compares machine integer with a BigInt number.
+ *
+ * \param[in] a machine integer
+ * \param[in] b BigInt number
+ * \return \c true if numbers are not equal
+ * \sa BigInt::cmp(T)
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, bool>::type
+operator!=(T a, const BigInt &b) {
+	return b.cmp(a)!=0;
+}
+
+/**
+ * Compares machine integer with a BigInt number.
+ *
+ * \param[in] a machine integer
+ * \param[in] b BigInt number
+ * \return \c true if \a a is greater then or equal to \a b
+ * \sa BigInt::cmp(T)
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, bool>::type
+operator>=(T a, const BigInt &b) {
+	return b.cmp(a)<=0;
+}
+
+/**
+ * Compares machine integer with a BigInt number.
+ *
+ * \param[in] a machine integer
+ * \param[in] b BigInt number
+ * \return \c true if \a a is lower then or equal to \a b
+ * \sa BigInt::cmp(T)
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, bool>::type
+operator<=(T a, const BigInt &b) {
+	return b.cmp(a)>=0;
+}
+
+/**
+ * Compares machine integer with a BigInt number.
+ *
+ * \param[in] a machine integer
+ * \param[in] b BigInt number
+ * \return \c true if \a a is greater then \a b
+ * \sa BigInt::cmp(T)
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, bool>::type
+operator> (T a, const BigInt &b) {
+	return b.cmp(a)< 0;
+}
+
+/**
+ * Compares machine integer with a BigInt number.
+ *
+ * \param[in] a machine integer
+ * \param[in] b BigInt number
+ * \return \c true if \a a is lower then \a b
+ * \sa BigInt::cmp(T)
+ */
+template<class T>
+inline typename std::enable_if<BigIntWord<T>::value, bool>::type
+operator< (T a, const BigInt &b) {
+	return b.cmp(a)> 0;
+}
+
 
 
 /**
- * Sends BigInt number to an output stream.
+ * Sends BigInt number to an output stream.  Number is printed in
+ * hexadecimal if \c std::ios_base::hex is set, in octal if \c
+ * std::ios_base::oct is set and in decimal otherwise.  Flags \c
+ * std::ios_base::showbase and \c std::ios_base::uppercase are also
+ * honoured.
  *
  * \param[in] os output stream to send to
  * \param[in] n number to print
@@ -494,9 +2679,12 @@ inline bool operator< (const BigInt &a, const BigInt &b) {
 std::ostream &operator<<(std::ostream &os, const BigInt &n);
 
 /**
- * Reads BigInt number from an input stream.  If there is no valid
- * integer in stream \a failbit is set and stream is left in undefined
- * state, ie. some characters may be lost.
+ * Reads BigInt number from an input stream.  Base is determined by
+ * stream's \c std::ios_base::basefield flags the same way it is for
+ * built-in integers (if no base is set \c "0x" and \c "0b" prefixes
+ * are recognised).  If there is no valid integer in stream \a failbit
+ * is set and stream is left in undefined state, ie. some characters
+ * may be lost.
  *
  * \param[in] is input stream to send to
  * \param[in] n number to read
@@ -509,4 +2697,25 @@ std::istream &operator>>(std::istream &is, BigInt &n);
 }
 
 
+namespace std {
+
+/**
+ * Hash function object for BigInt so that it can be used as a key of
+ * unordered containers.
+ *
+ * \sa mina86::BigInt::hash()
+ */
+template<> struct hash<mina86::BigInt> {
+	/**
+	 * Computes hash of a number.
+	 *
+	 * \param[in] n number
+	 * \return hash of \a n
+	 */
+	std::size_t operator()(const mina86::BigInt &n) const { return n.hash(); }
+};
+
+}
+
+
 #endif
@@ -0,0 +1,120 @@
+/**
+ * \file
+ * BigInt accumulator tester.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * This program adds and substracts random numbers of various sizes
+ * and signs as well as machine integers using BigIntAccumulator and
+ * compares the sum with the one computed using BigInt::add() and
+ * BigInt::sub().  Value is read in the middle of summing too to check
+ * that reading does not disturb the accumulator.
+ *
+ * If argument is given it should be a number representing how many
+ * sums program should check.  The default is 200.
+ */
+
+#include <climits>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+
+#include "bigint-acc.hpp"
+#include "check.hpp"
+
+using mina86::BigInt;
+using mina86::BigIntAccumulator;
+
+
+/**
+ * Sizes (in limbs) of random numbers picked more often then others.
+ */
+static const unsigned SIZES[] = { 0, 1, 2, 3, 10, 100 };
+
+
+/******************** Main ********************/
+int main(int argc, char **argv) {
+	int num = argc==1 ? 200 : strtol(argv[1], 0, 0);
+	if (num<1) num = 200;
+	int failed = 0;
+
+	srand(time(0));
+
+	do {
+		BigIntAccumulator acc;
+		BigInt sum;
+		if (rand() & 1) {
+			sum = random_sized(SIZES, 50);
+			acc = BigIntAccumulator(sum);
+		}
+
+		for (unsigned i = 1 + rand() % 300; i; --i) {
+			switch (rand() % 8) {
+			case 0: {
+				const BigInt n = random_sized(SIZES, 50);
+				acc += n;
+				sum.add(n);
+				break;
+			}
+			case 1: {
+				const BigInt n = random_sized(SIZES, 50);
+				acc -= n;
+				sum.sub(n);
+				break;
+			}
+			case 2: {
+				const long n = rand() & 1 ? LONG_MIN
+					: (long)rand() - RAND_MAX / 2;
+				acc += n;
+				BigInt t;
+				t.set(n);
+				sum.add(t);
+				break;
+			}
+			case 3: {
+				const unsigned long n = rand() & 1 ? ULONG_MAX : rand();
+				acc -= n;
+				BigInt t;
+				t.set(n);
+				sum.sub(t);
+				break;
+			}
+			case 4:
+				if (acc.get().cmp(sum)) {
+					std::cout << "acc: partial sums differ\n";
+					++failed;
+				}
+				break;
+			case 5:
+				acc += 1;
+				sum.add(BigInt(1.0));
+				break;
+			case 6: {
+				const long long n = rand() & 1 ? LLONG_MIN : -(long long)rand();
+				acc -= n;
+				sum.sub(BigInt(n));
+				break;
+			}
+			case 7:
+				acc += 5u;
+				acc -= 2ull;
+				sum.add(BigInt(3.0));
+				break;
+			}
+		}
+
+		if (acc.get().cmp(sum)) {
+			std::cout << "acc: sums differ\n";
+			++failed;
+		}
+		acc.clear();
+		if (acc.get().sgn()) {
+			std::cout << "acc: cleared accumulator is not zero\n";
+			++failed;
+		}
+	} while (--num);
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,165 @@
+/**
+ * \file
+ * BigInt batch tester.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * This program fills batches with random pairs of numbers, runs all
+ * operations on them and compares results with the ones given by
+ * BigInt operators.  Limbs are often all zeros or all ones so that
+ * carries and borrows propagate over all limbs.  Batches are checked
+ * with every instruction set the processor supports and operands are
+ * added both as BigInt objects and as strings.
+ *
+ * If argument is given it should be a number representing how many
+ * batches program should check.  The default is 200.
+ */
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+
+#include "bigint-batch.hpp"
+#include "bigint-limb.hpp"
+#include "check.hpp"
+
+using mina86::BigInt;
+using mina86::BigIntBatch;
+
+
+/**
+ * Names of instruction sets.
+ */
+static const char *const names[] = { "scalar", "SSE2", "AVX2", "AVX-512" };
+
+/**
+ * Names of operations.
+ */
+static const char *const ops[] = { "add", "sub", "mul", "div", "mod" };
+
+
+/**
+ * Computes expected result.
+ *
+ * \param[in] op operation
+ * \param[in] a first operand
+ * \param[in] b second operand
+ * \return result
+ */
+static BigInt expected(BigIntBatch::Op op, const BigInt &a,
+                       const BigInt &b) {
+	switch (op) {
+	case BigIntBatch::ADD: return a + b;
+	case BigIntBatch::SUB: return a - b;
+	case BigIntBatch::MUL: return a * b;
+	case BigIntBatch::DIV: return a / b;
+	default:               return a % b;
+	}
+}
+
+
+/**
+ * Checks single batch of random numbers with all operations.
+ *
+ * \param[in] name name of instruction set
+ * \return number of failed checks
+ */
+static int check_batch(const char *name) {
+	const unsigned n = rand() % 3 ? rand() % 40 : rand() % 2000;
+	BigIntBatch batch(n), strings(n);
+	BigInt *const a = new BigInt[n], *const b = new BigInt[n];
+	BigInt *const r = new BigInt[n];
+	int failed = 0;
+
+	for (unsigned i = 0; i<n; ++i) {
+		a[i] = random_pattern(BigIntBatch::LIMBS);
+		b[i] = random_pattern(BigIntBatch::LIMBS);
+		const std::string as = a[i].toString(), bs = b[i].toString();
+		if (!batch.push(a[i], b[i]) || !strings.push(as.c_str(), bs.c_str())) {
+			std::cout << name << ": cannot push " << a[i] << ", " << b[i]
+			          << '\n';
+			++failed;
+		}
+	}
+
+	/* Too big or malformed operands must be rejected */
+	BigIntBatch small(1);
+	const BigInt big("340282366920938463463374607431768211456");
+	if (small.push(big, BigInt(1)) || small.push("1", "1e5") ||
+	    small.push("", "1") || small.push("-", "1") ||
+	    small.push("0x10", "1") || small.push("1", big.toString().c_str()) ||
+	    small.size()) {
+		std::cout << name << ": invalid operands accepted\n";
+		++failed;
+	}
+
+	for (unsigned o = BigIntBatch::ADD; o<=BigIntBatch::MOD; ++o) {
+		const BigIntBatch::Op op = (BigIntBatch::Op)o;
+		const unsigned base = 2 + rand() % 35;
+		batch.run(op);
+		strings.run(op);
+		for (unsigned i = 0; i<n; ++i) {
+			const bool zero = !b[i] && op>=BigIntBatch::DIV;
+			if (batch.failed(i)!=zero || strings.failed(i)!=zero) {
+				std::cout << name << ' ' << ops[o] << ": " << a[i] << ", "
+				          << b[i] << ": wrong error flag\n";
+				++failed;
+				continue;
+			} else if (zero) {
+				continue;
+			}
+
+			const BigInt x = expected(op, a[i], b[i]);
+			if (batch.result(i)!=x || strings.result(i)!=x ||
+			    batch.toString(i, base)!=x.toString(base)) {
+				std::cout << name << ' ' << ops[o] << ": " << a[i] << ", "
+				          << b[i] << ": expected " << x << ", got "
+				          << batch.result(i) << '\n';
+				++failed;
+			}
+		}
+	}
+
+	/* Computing many pairs at once, some too big for a batch */
+	for (unsigned i = 0; i<n; ++i) {
+		if (!(rand() % 8)) a[i] = random_pattern(3 * BigIntBatch::LIMBS);
+		if (!b[i]) b[i] = 1;
+	}
+	for (unsigned o = BigIntBatch::ADD; o<=BigIntBatch::MOD; ++o) {
+		const BigIntBatch::Op op = (BigIntBatch::Op)o;
+		BigIntBatch::run(op, a, b, r, n);
+		for (unsigned i = 0; i<n; ++i) {
+			if (r[i]!=expected(op, a[i], b[i])) {
+				std::cout << name << ' ' << ops[o] << ": " << a[i] << ", "
+				          << b[i] << ": wrong result of static run\n";
+				++failed;
+			}
+		}
+	}
+
+	delete[] a;
+	delete[] b;
+	delete[] r;
+	return failed;
+}
+
+
+/******************** Main ********************/
+int main(int argc, char **argv) {
+	int num = argc==1 ? 200 : strtol(argv[1], 0, 0);
+	if (num<1) num = 200;
+	int failed = 0;
+
+	srand(time(0));
+
+	const mina86::LimbsSimd best = mina86::limbs_simd_best();
+	for (int s = mina86::LIMBS_SCALAR; s<=best; ++s) {
+		mina86::limbs_simd_use((mina86::LimbsSimd)s);
+		for (int i = 0; i<num; ++i) failed += check_batch(names[s]);
+	}
+	mina86::limbs_simd_use(best);
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,164 @@
+/**
+ * \file
+ * BigInt combinatorial functions tester.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * This program compares factorials, binomial coefficients, Fibonacci
+ * and Lucas numbers of small arguments with ones computed by naive
+ * multiplication and addition, and checks identities which relate
+ * the functions for random big arguments: <code>n! = n (n-1)!</code>,
+ * <code>C(n, k) k! (n-k)! = n!</code>, <code>F(2n) = F(n)
+ * L(n)</code> and <code>L(n)^2 - 5 F(n)^2 = 4 (-1)^n</code>.
+ *
+ * If argument is given it should be a number representing how many
+ * numbers program should check.  The default is 100.
+ */
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <vector>
+
+#include "bigint.hpp"
+
+using mina86::BigInt;
+
+
+/**
+ * Largest argument of functions compared with naive computations.
+ */
+static const unsigned long SMALL = 1000;
+
+
+/**
+ * Checks functions for all small arguments.
+ *
+ * \param[out] fact factorials of numbers up to #SMALL
+ * \return number of failed checks
+ */
+static int check_small(std::vector<BigInt> &fact) {
+	int failed = 0;
+
+	fact.push_back(BigInt(1));
+	for (unsigned long n = 1; n<=SMALL; ++n) {
+		fact.push_back(fact.back() * BigInt(n));
+	}
+	for (unsigned long n = 0; n<=SMALL; ++n) {
+		if (BigInt::factorial(n).cmp(fact[n])) {
+			std::cout << n << "!: differs\n";
+			++failed;
+		}
+	}
+
+	BigInt f0(0), f1(1), l0(2), l1(1);
+	for (unsigned long n = 0; n<=SMALL; ++n) {
+		if (BigInt::fibonacci(n).cmp(f0)) {
+			std::cout << "F(" << n << "): differs\n";
+			++failed;
+		}
+		if (BigInt::lucas(n).cmp(l0)) {
+			std::cout << "L(" << n << "): differs\n";
+			++failed;
+		}
+		f0 += f1;
+		std::swap(f0, f1);
+		l0 += l1;
+		std::swap(l0, l1);
+	}
+
+	return failed;
+}
+
+
+/**
+ * Checks binomial coefficient of small arguments.
+ *
+ * \param[in] fact factorials of numbers up to #SMALL
+ * \return number of failed checks
+ */
+static int check_binomial(const std::vector<BigInt> &fact) {
+	const unsigned long n = rand() % (SMALL + 1);
+	const unsigned long k = rand() % (n + 2);
+	const BigInt expected = k>n ? BigInt()
+		: fact[n] / (fact[k] * fact[n - k]);
+	if (BigInt::binomial(n, k).cmp(expected)) {
+		std::cout << "C(" << n << ", " << k << "): differs\n";
+		return 1;
+	}
+	return 0;
+}
+
+
+/**
+ * Checks identities for random big arguments.
+ *
+ * \return number of failed checks
+ */
+static int check_big() {
+	int failed = 0;
+
+	const unsigned long n = SMALL + rand() % 20000;
+	const BigInt f = BigInt::factorial(n);
+	if (f.cmp(BigInt::factorial(n - 1) * BigInt(n))) {
+		std::cout << n << "!: differs from " << n << " * " << n - 1
+		          << "!\n";
+		++failed;
+	}
+
+	const unsigned long k = rand() & 1 ? rand() % (n / 16)
+		: rand() % (n + 1);
+	BigInt c = BigInt::binomial(n, k);
+	c *= BigInt::factorial(k);
+	c *= BigInt::factorial(n - k);
+	if (c.cmp(f)) {
+		std::cout << "C(" << n << ", " << k << "): differs\n";
+		++failed;
+	}
+
+	/* Huge n with small k */
+	const unsigned long m = 1000000000000ul + rand();
+	BigInt d(m);
+	d *= BigInt(m - 1);
+	d *= BigInt(m - 2);
+	d /= BigInt(6);
+	if (BigInt::binomial(m, 3).cmp(d) || BigInt::binomial(m, m - 3).cmp(d)) {
+		std::cout << "C(" << m << ", 3): differs\n";
+		++failed;
+	}
+
+	const unsigned long i = rand() % 1000000;
+	const BigInt fi = BigInt::fibonacci(i), li = BigInt::lucas(i);
+	if (BigInt::fibonacci(2 * i).cmp(fi * li)) {
+		std::cout << "F(" << 2 * i << "): differs from F(" << i
+		          << ") * L(" << i << ")\n";
+		++failed;
+	}
+	BigInt r = li * li - BigInt(5) * fi * fi;
+	if (r.cmp(BigInt(i & 1 ? -4 : 4))) {
+		std::cout << "L(" << i << ")^2 - 5 F(" << i << ")^2: differs\n";
+		++failed;
+	}
+
+	return failed;
+}
+
+
+/******************** Main ********************/
+int main(int argc, char **argv) {
+	int num = argc==1 ? 100 : strtol(argv[1], 0, 0);
+	if (num<1) num = 100;
+	int failed = 0;
+
+	srand(time(0));
+
+	std::vector<BigInt> fact;
+	failed += check_small(fact);
+	for (int i = 0; i<num * 10; ++i) failed += check_binomial(fact);
+	do {
+		failed += check_big();
+	} while (--num);
+
+	return failed ? 1 : 0;
+}
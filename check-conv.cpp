@@ -0,0 +1,171 @@
+/**
+ * \file
+ * BigInt machine type conversion tester.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * This program converts random machine integers to BigInt and back
+ * and compares results with decimal representation printed by the C
+ * library.  Values around limits of machine types are checked to be
+ * converted or rejected as appropriate.  BigInt::toDouble() is
+ * compared with strtod() which rounds decimal representation
+ * correctly.  Finally the same conversions are run on several threads
+ * at once.
+ *
+ * If argument is given it should be a number representing how many
+ * numbers program should check.  The default is 1000.
+ */
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bigint.hpp"
+#include "check.hpp"
+
+using mina86::BigInt;
+
+
+/**
+ * Checks that converting to machine type throws OutOfRange.
+ *
+ * \param[in] n number to convert
+ * \param[in] to_long whether to convert with toLong() or with
+ *                    toUnsignedLong()
+ * \return \c 1 if exception was not thrown, \c 0 otherwise
+ */
+static int check_range(const BigInt &n, bool to_long) {
+	try {
+		if (to_long) n.toLong(); else n.toUnsignedLong();
+	} catch (const BigInt::OutOfRange &) {
+		return 0;
+	}
+	std::cout << (to_long ? "toLong" : "toUnsignedLong") << ": "
+	          << n << " accepted\n";
+	return 1;
+}
+
+
+/**
+ * Number of threads check_threads() runs.
+ */
+static const unsigned THREADS = 4;
+
+
+/**
+ * Converts numbers to BigInt and back on #THREADS threads at once.
+ * Each thread converts all numbers (starting at different offsets)
+ * so that threads create, modify and destroy BigInts at the same
+ * time.
+ *
+ * \param[in] num number of numbers to convert
+ * \return number of failed checks
+ */
+static int check_threads(unsigned num) {
+	std::vector<unsigned long long> values(num);
+	std::vector<std::string> strings(num);
+	char buf[64];
+	for (unsigned i = 0; i<num; ++i) {
+		values[i] = random_ull();
+		sprintf(buf, "%llu", values[i]);
+		strings[i] = buf;
+	}
+
+	unsigned errors[THREADS] = { 0 };
+	std::vector<std::thread> threads;
+	for (unsigned t = 0; t<THREADS; ++t) {
+		threads.emplace_back([&values, &strings, &errors, num, t] {
+			BigInt b;
+			for (unsigned j = 0; j<num; ++j) {
+				const unsigned i = (j + t * num / THREADS) % num;
+				const BigInt a(values[i]);
+				b.set(-(long long)(values[i] >> 1));
+				if (a.toString()!=strings[i] ||
+				    (values[i]<=ULONG_MAX &&
+				     a.toUnsignedLong()!=(unsigned long)values[i]) ||
+				    BigInt(b).add(a).sub(a)!=b || b.sgn()>0) {
+					++errors[t];
+				}
+			}
+		});
+	}
+
+	int failed = 0;
+	for (unsigned t = 0; t<THREADS; ++t) {
+		threads[t].join();
+		if (errors[t]) {
+			std::cout << "thread " << t << ": " << errors[t]
+			          << " conversions failed\n";
+			++failed;
+		}
+	}
+	return failed;
+}
+
+
+/******************** Main ********************/
+int main(int argc, char **argv) {
+	int num = argc==1 ? 1000 : strtol(argv[1], 0, 0);
+	if (num<1) num = 1000;
+	int failed = 0;
+	char buf[64];
+
+	srand(time(0));
+	failed += check_threads(num);
+
+	/* Limits */
+	const BigInt lmin(LONG_MIN), lmax(LONG_MAX), umax(ULONG_MAX);
+	if (lmin.toLong()!=LONG_MIN || lmax.toLong()!=LONG_MAX ||
+	    umax.toUnsignedLong()!=ULONG_MAX) {
+		std::cout << "limits: conversion failed\n";
+		++failed;
+	}
+	failed += check_range(BigInt(lmin).sub(1), true);
+	failed += check_range(BigInt(lmax).add(1), true);
+	failed += check_range(BigInt(umax).add(1), false);
+	failed += check_range(BigInt(-1), false);
+
+	do {
+		/* Machine integers */
+		const unsigned long long u = random_ull();
+		const long long l = rand() & 1 ? (long long)u : -(long long)(u >> 1);
+		sprintf(buf, "%llu", u);
+		const BigInt a(u);
+		if (a.toString()!=buf ||
+		    (u<=ULONG_MAX && a.toUnsignedLong()!=(unsigned long)u)) {
+			std::cout << "unsigned long long: " << buf << " differs\n";
+			++failed;
+		}
+		sprintf(buf, "%lld", l);
+		const BigInt b(l);
+		if (b.toString()!=buf ||
+		    (l>=LONG_MIN && l<=LONG_MAX && b.toLong()!=(long)l)) {
+			std::cout << "long long: " << buf << " differs\n";
+			++failed;
+		}
+
+		/* Floating point */
+		const BigInt c = random_signed(rand() % 250);
+		const double d = c.toDouble(), e = strtod(c.toString().c_str(), 0);
+		if (d!=e) {
+			std::cout << "toDouble: " << c << ": got " << d << ", expected "
+			          << e << '\n';
+			++failed;
+		}
+	} while (--num);
+
+	try {
+		random_signed(300).toDouble();
+		std::cout << "toDouble: too big number accepted\n";
+		++failed;
+	} catch (const BigInt::OutOfRange &) {
+	}
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,102 @@
+/**
+ * \file
+ * BigInt division tester.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * This program divides random limb vectors of various sizes and
+ * checks whether quotient and remainder satisfy <code>a = q * b +
+ * r</code> and <code>r < b</code>.  Sizes are chosen so that
+ * single-limb, schoolbook and recursive division all get exercised.
+ * Some operands have all bits set or have only the top bit set to
+ * stress quotient digit estimation and correction steps.
+ *
+ * If argument is given it should be a number representing how many
+ * divisions program should check.  The default is 200.
+ */
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+
+#include "bigint-limb.hpp"
+
+using mina86::Limb;
+
+
+/**
+ * Fills limb vector with random limbs, with all bits set or with
+ * only the top bit set.
+ *
+ * \param[out] a limb vector
+ * \param[in] n number of limbs
+ */
+static void fill(Limb *a, unsigned n) {
+	const int kind = rand() % 8;
+	for (unsigned i = 0; i<n; ++i) {
+		a[i] = kind == 0 ? ~(Limb)0 : kind == 1 ? 0
+			: ((Limb)rand() << 16) ^ (Limb)rand();
+	}
+	if (kind == 1) a[n - 1] = (Limb)1 << (mina86::BigInt::LIMB_BITS - 1);
+	if (!a[n - 1]) a[n - 1] = 1;
+}
+
+
+/**
+ * Returns random divisor size.
+ *
+ * \return number of limbs
+ */
+static unsigned random_size() {
+	static const unsigned sizes[] = { 1, 2, 3, 63, 64, 65, 128, 200, 1000 };
+	return rand() & 1 ? 1 + rand() % 1500
+		: sizes[rand() % (sizeof sizes / sizeof *sizes)];
+}
+
+
+/******************** Main ********************/
+int main(int argc, char **argv) {
+	int num = argc==1 ? 200 : strtol(argv[1], 0, 0);
+	if (num<1) num = 200;
+	int failed = 0;
+
+	srand(time(0));
+
+	do {
+		const unsigned bn = random_size();
+		const unsigned an = bn + rand() % (rand() & 1 ? 4 : 2000);
+		const unsigned qn = an - bn + 1;
+		Limb *const a = new Limb[an], *const b = new Limb[bn];
+		Limb *const q = new Limb[qn], *const r = new Limb[bn];
+		Limb *const x = new Limb[an + 1];
+		fill(a, an);
+		fill(b, bn);
+
+		mina86::limbs_div_qr(q, r, a, an, b, bn);
+
+		/* x = q * b + r */
+		mina86::limbs_mul(x, q, qn, b, bn);
+		const Limb c = mina86::limbs_add(x, x, an + 1, r, bn);
+
+		bool ok = !c && !x[an];
+		for (unsigned i = 0; ok && i<an; ++i) ok = x[i] == a[i];
+		if (!ok) {
+			std::cout << "div: " << an << " / " << bn
+			          << ": q * b + r differs from a\n";
+		} else if (mina86::limbs_cmp(r, b, bn) >= 0) {
+			std::cout << "div: " << an << " / " << bn
+			          << ": remainder not less than divisor\n";
+			ok = false;
+		}
+		failed += !ok;
+
+		delete[] a;
+		delete[] b;
+		delete[] q;
+		delete[] r;
+		delete[] x;
+	} while (--num);
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,138 @@
+/**
+ * \file
+ * BigInt expression tester.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * This program evaluates expressions on random numbers of various
+ * sizes and signs and compares results with the ones computed
+ * operation by operation using BigInt methods.  Sizes are chosen so
+ * that numbers stored inline, products accumulated row by row and
+ * products computed into scratch buffer all get exercised.
+ * Expressions which refer to their destination are checked as well
+ * and so are methods called on expressions.
+ *
+ * If argument is given it should be a number representing how many
+ * sets of numbers program should check.  The default is 200.
+ */
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+
+#include "bigint.hpp"
+#include "check.hpp"
+
+using mina86::BigInt;
+
+
+/**
+ * Sizes (in limbs) of random numbers picked more often then others.
+ */
+static const unsigned SIZES[] = { 0, 1, 2, 3, 31, 32, 33, 100 };
+
+
+/**
+ * Compares result with expected value and prints message if they
+ * differ.
+ *
+ * \param[in] name description of the expression
+ * \param[in] got result of evaluating expression
+ * \param[in] expected expected result
+ * \return \c 1 if values differ, \c 0 otherwise
+ */
+static int check(const char *name, const BigInt &got, const BigInt &expected) {
+	if (got.cmp(expected)) {
+		std::cout << "expr: " << name << ": results differ\n";
+		return 1;
+	}
+	return 0;
+}
+
+
+/******************** Main ********************/
+int main(int argc, char **argv) {
+	int num = argc==1 ? 200 : strtol(argv[1], 0, 0);
+	if (num<1) num = 200;
+	int failed = 0;
+
+	srand(time(0));
+
+	do {
+		const BigInt a = random_sized(SIZES, 150), b = random_sized(SIZES, 150);
+		const BigInt c = random_sized(SIZES, 150), d = random_sized(SIZES, 150);
+		const BigInt e = random_sized(SIZES, 150);
+		BigInt x, y, z;
+
+		/* a * b + c * d - e */
+		x = a * b + c * d - e;
+		y = a; y.mul(b);
+		z = c; z.mul(d);
+		y.add(z).sub(e);
+		failed += check("a * b + c * d - e", x, y);
+
+		/* a - b + c */
+		const BigInt w = a - b + c;
+		y = a; y.sub(b).add(c);
+		failed += check("a - b + c", w, y);
+
+		/* e - (a * b - c) */
+		x = e - (a * b - c);
+		y = a; y.mul(b).sub(c).neg().add(e);
+		failed += check("e - (a * b - c)", x, y);
+
+		/* (a + b) * (c - d) */
+		x = (a + b) * (c - d);
+		y = a; y.add(b);
+		z = c; z.sub(d);
+		y.mul(z);
+		failed += check("(a + b) * (c - d)", x, y);
+
+		/* x += a * b, x -= c * d */
+		x = e; x += a * b; x -= c * d;
+		y = a; y.mul(b);
+		z = c; z.mul(d);
+		y.add(e).sub(z);
+		failed += check("x += a * b; x -= c * d", x, y);
+
+		/* a * a - b * b */
+		x = a * a - b * b;
+		y = a; y.sqr();
+		z = b; z.sqr();
+		y.sub(z);
+		failed += check("a * a - b * b", x, y);
+
+		/* x = x * a + x */
+		x = e; x = x * a + x;
+		y = e; y.mul(a).add(e);
+		failed += check("x = x * a + x", x, y);
+
+		/* x -= x * b */
+		x = e; x -= x * b;
+		y = e; y.mul(b).neg().add(e);
+		failed += check("x -= x * b", x, y);
+
+		/* Conversions of expressions */
+		if (BigInt(a + b).cmp(BigInt(b).add(a)) ||
+		    sqr(a - b)!=(a - b) * (a - b)) {
+			std::cout << "expr: conversions: results differ\n";
+			++failed;
+		}
+
+		/* Methods of expressions */
+		y = a; y.mul(b);
+		z = a; z.add(b);
+		if ((a + b).sgn()!=z.sgn() || (a * b).sgn()!=y.sgn() ||
+		    (e - a * b).sgn()!=BigInt(e).sub(y).sgn() ||
+		    (a * b).cmp(c)!=y.cmp(c) || (a * b).cmp(7)!=y.cmp(7) ||
+		    (a - b).toString(16)!=BigInt(a).sub(b).toString(16) ||
+		    bool(a * b)!=bool(y) || !(a + b)!=!z) {
+			std::cout << "expr: methods: results differ\n";
+			++failed;
+		}
+	} while (--num);
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,157 @@
+/**
+ * \file
+ * Fixed width BigInt tester.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * This program checks at compile time that constants are parsed and
+ * computed as expected and then adds, substracts, multiplies,
+ * compares, parses and converts random numbers of several widths and
+ * compares results with the ones given by BigInt reduced modulo
+ * 2<sup>Bits</sup>.  Numbers which do not fit are checked to be
+ * rejected.
+ *
+ * If argument is given it should be a number representing how many
+ * numbers program should check.  The default is 1000.
+ */
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+
+#include "bigint.hpp"
+#include "bigint-fixed.hpp"
+#include "check.hpp"
+
+using mina86::BigInt;
+using mina86::FixedBigInt;
+
+
+/* Compile time */
+static_assert(FixedBigInt<64>("18446744073709551615") ==
+              FixedBigInt<64>(-1), "parsing at compile time failed");
+static_assert(FixedBigInt<256>(1) - FixedBigInt<256>(2) ==
+              FixedBigInt<256>("0x" "ffffffffffffffffffffffffffffffff"
+                               "ffffffffffffffffffffffffffffffff", 16),
+              "substraction at compile time failed");
+static_assert(FixedBigInt<128>(0xffffffffffffffffull) *
+              FixedBigInt<128>(0xffffffffffffffffull) ==
+              FixedBigInt<128>("340282366920938463426481119284349108225"),
+              "multiplication at compile time failed");
+static_assert(FixedBigInt<100>(-1) + 1 == 0 && FixedBigInt<100>(-1) > 1,
+              "wrapping at compile time failed");
+
+/* Example from documentation of FixedBigInt */
+typedef FixedBigInt<256> U256;
+constexpr U256 p("0xffffffffffffffffffffffffffffffffffffffffffffffff"
+                 "fffffffefffffc2f", 16);
+static_assert(p * 2 + 1 < p, "2 p + 1 wraps modulo 2^256");
+
+
+/**
+ * Reduces number modulo 2<sup>Bits</sup>.
+ *
+ * \param[in] n number
+ * \param[in] m 2<sup>Bits</sup>
+ * \return non-negative remainder
+ */
+static BigInt wrap(const BigInt &n, const BigInt &m) {
+	BigInt r = n % m;
+	if (r.sgn()<0) r += m;
+	return r;
+}
+
+
+/**
+ * Checks operations on two random numbers of given width.  Absolute
+ * values of the numbers are less than 2<sup>Bits</sup> so they may
+ * be parsed.
+ *
+ * \return number of failed checks
+ */
+template<unsigned Bits>
+static int check() {
+	typedef FixedBigInt<Bits> Fixed;
+	const BigInt m = pow(BigInt(2), Bits);
+	const BigInt a = random_signed(rand() % (Bits / 4 + 4)) % m;
+	const BigInt b = random_signed(rand() % (Bits / 4 + 4)) % m;
+	const BigInt wa = wrap(a, m), wb = wrap(b, m);
+	int failed = 0;
+
+	/* Parsing and conversion */
+	const Fixed fa(a.toString(), 10), fb(b.toString(16), 16);
+	if (fa.toBigInt().cmp(wa) || fb.toBigInt().cmp(wb) ||
+	    Fixed(wa)!=fa || Fixed(wb.toString(7), 7)!=fb) {
+		std::cout << Bits << ": conversion of " << a << " or " << b
+		          << " differs\n";
+		++failed;
+	}
+	if (fa.toString()!=wa.toString()) {
+		std::cout << Bits << ": toString of " << a << " differs\n";
+		++failed;
+	}
+
+	/* Arithmetic */
+	if ((fa + fb).toBigInt().cmp(wrap(a + b, m)) ||
+	    (fa - fb).toBigInt().cmp(wrap(a - b, m)) ||
+	    (fa * fb).toBigInt().cmp(wrap(a * b, m)) ||
+	    (-fa).toBigInt().cmp(wrap(-a, m))) {
+		std::cout << Bits << ": arithmetic on " << a << " and " << b
+		          << " differs\n";
+		++failed;
+	}
+	if (fa.cmp(fb)!=wa.cmp(wb) || (fa<fb)!=(wa<wb) ||
+	    (fa==fb)!=!wa.cmp(wb)) {
+		std::cout << Bits << ": comparison of " << a << " and " << b
+		          << " differs\n";
+		++failed;
+	}
+
+	/* Rejected numbers */
+	const BigInt big = wa + m;
+	try {
+		Fixed x(big);
+		std::cout << Bits << ": " << big << " accepted\n";
+		++failed;
+	} catch (const BigInt::OutOfRange &) {
+	}
+	try {
+		Fixed x(big.toString());
+		std::cout << Bits << ": string " << big << " accepted\n";
+		++failed;
+	} catch (const BigInt::OutOfRange &) {
+	}
+	if (wa.sgn()) {
+		try {
+			Fixed x(-wa);
+			std::cout << Bits << ": " << -wa << " accepted\n";
+			++failed;
+		} catch (const BigInt::OutOfRange &) {
+		}
+	}
+
+	return failed;
+}
+
+
+/******************** Main ********************/
+int main(int argc, char **argv) {
+	int num = argc==1 ? 1000 : strtol(argv[1], 0, 0);
+	if (num<1) num = 1000;
+	int failed = 0;
+
+	srand(time(0));
+
+	do {
+		failed += check<1>();
+		failed += check<32>();
+		failed += check<64>();
+		failed += check<100>();
+		failed += check<256>();
+		failed += check<512>();
+	} while (--num);
+
+	return failed ? 1 : 0;
+}
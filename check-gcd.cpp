@@ -0,0 +1,148 @@
+/**
+ * \file
+ * BigInt greatest common divisor tester.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * This program computes greatest common divisors of random numbers
+ * with a random common factor and compares results of BigInt::gcd()
+ * with the ones given by plain Euclid's algorithm.  Bezout's
+ * coefficients returned by BigInt::gcdext() are checked to satisfy
+ * Bezout's identity and to be minimal, least common multiple and
+ * modular inverse are checked against the divisor.  Sizes are chosen
+ * so that numbers stored inline, Lehmer's algorithm and half-GCD
+ * algorithm (from 500 limbs) all get exercised.
+ *
+ * If argument is given it should be a number representing how many
+ * pairs of numbers program should check.  The default is 100.
+ */
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include "bigint.hpp"
+#include "check.hpp"
+
+using mina86::BigInt;
+
+
+/**
+ * Computes greatest common divisor using Euclid's algorithm.
+ *
+ * \param[in] a first number
+ * \param[in] b second number
+ * \return greatest common divisor of \a a and \a b
+ */
+static BigInt naive_gcd(BigInt a, BigInt b) {
+	while (b.sgn()) {
+		a.mod(b);
+		std::swap(a, b);
+	}
+	return abs(a);
+}
+
+
+/**
+ * Checks results of gcdext(), lcm() and invmod() for given pair.
+ *
+ * \param[in] a first number
+ * \param[in] b second number
+ * \param[in] g their greatest common divisor
+ * \return number of failed checks
+ */
+static int check_ext(const BigInt &a, const BigInt &b, const BigInt &g) {
+	int failed = 0;
+	BigInt s, t;
+	const BigInt d = gcdext(a, b, s, t);
+
+	if (d.cmp(g) || BigInt(a * s + b * t).cmp(g)) {
+		std::cout << "gcdext: Bezout's identity does not hold\n";
+		++failed;
+	} else if (a.sgn() && b.sgn() &&
+	           BigInt(a).mod(b).sgn() && BigInt(b).mod(a).sgn() &&
+	           (BigInt(s).add(s).mul(g).abs().cmp(abs(b))>0 ||
+	            BigInt(t).add(t).mul(g).abs().cmp(abs(a))>0)) {
+		std::cout << "gcdext: coefficients are not minimal\n";
+		++failed;
+	}
+
+	const BigInt l = lcm(a, b), p = BigInt(a).mul(b).abs();
+	if (!p.sgn() ? l.sgn() : BigInt(l).mul(g).cmp(p)) {
+		std::cout << "lcm: results differ\n";
+		++failed;
+	}
+
+	if (b.sgn()) {
+		BigInt x(a);
+		try {
+			x.invmod(b);
+			if (g.cmp(BigInt(1.0)) || x.sgn()<0 || x.cmp(abs(b))>=0 ||
+			    BigInt(a * x).sub(BigInt(1.0)).mod(b).sgn()) {
+				std::cout << "invmod: wrong inverse\n";
+				++failed;
+			}
+		} catch (const BigInt::NotInvertible &) {
+			if (!g.cmp(BigInt(1.0))) {
+				std::cout << "invmod: inverse not found\n";
+				++failed;
+			}
+			if (x.cmp(a)) {
+				std::cout << "invmod: number changed on failure\n";
+				++failed;
+			}
+		}
+	}
+
+	return failed;
+}
+
+
+/******************** Main ********************/
+int main(int argc, char **argv) {
+	int num = argc==1 ? 100 : strtol(argv[1], 0, 0);
+	if (num<1) num = 100;
+	int failed = 0;
+
+	srand(time(0));
+
+	do {
+		static const unsigned sizes[] = { 0, 1, 2, 3, 40, 200, 600, 1500 };
+		const unsigned an = rand() & 1 ? rand() % 40
+			: sizes[rand() % (sizeof sizes / sizeof *sizes)];
+		const unsigned bn = rand() % 4 ? an : rand() % (an + 10);
+		const unsigned gn = rand() % 4 ? rand() % 3 : rand() % (an / 2 + 1);
+
+		const BigInt c = random_number(gn);
+		BigInt a = random_number(an), b = random_number(bn);
+		if (c.sgn()) a.mul(c), b.mul(c);
+		if (rand() & 1) a.neg();
+		if (rand() & 1) b.neg();
+
+		const BigInt g = naive_gcd(a, b);
+		if (gcd(a, b).cmp(g)) {
+			std::cout << "gcd: " << an << " and " << bn
+			          << " limbs: results differ\n";
+			++failed;
+		}
+		failed += check_ext(a, b, g);
+
+		/* |b| / gcd equal two makes |s| <= |b| / (2 * gcd) hold for
+		   two values of s only one of which gives minimal t */
+		BigInt h = random_number(1 + rand() % 3);
+		BigInt x = random_number(1 + rand() % 3).mul(2).add(1).mul(h);
+		if (rand() & 1) h.neg();
+		if (rand() & 1) x.neg();
+		failed += check_ext(x, BigInt(h).mul(2), abs(h));
+		failed += check_ext(BigInt(h).mul(2), x, abs(h));
+	} while (--num);
+
+	/* Known pair which used to get |t| = 102 instead of 101 */
+	const BigInt a("-1ced06b1bbdef", 16), b("48f4b758dda", 16);
+	failed += check_ext(a, b, naive_gcd(a, b));
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,123 @@
+/**
+ * \file
+ * BigInt hashing tester.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * This program builds equal numbers in different ways (parsing,
+ * arithmetic, copying and moving) and checks that they have equal
+ * hashes.  Then it removes duplicates from a stream of random
+ * numbers using unordered sets of BigInt and BigIntKey objects and
+ * compares the result with the one given by an ordered set.  Hashes
+ * of distinct numbers, including ones which differ in a single bit
+ * or only in sign, are checked not to collide.
+ *
+ * If argument is given it should be a number representing how many
+ * numbers program should check.  The default is 1000.
+ */
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "bigint.hpp"
+#include "bigint-key.hpp"
+#include "check.hpp"
+
+using mina86::BigInt;
+using mina86::BigIntKey;
+
+
+/**
+ * Checks that numbers equal to \a a built in different ways have the
+ * same hash.
+ *
+ * \param[in] a number
+ * \return \c 1 if hashes differ, \c 0 otherwise
+ */
+static int check_equal(const BigInt &a) {
+	const std::size_t h = std::hash<BigInt>()(a);
+	BigInt b(a.toString(16), 16), c(a), d(a);
+	c.mul(3).add(7).sub(7).div(3);
+	d.neg().neg();
+	const BigInt e(std::move(d));
+	if (b.hash()!=h || c.hash()!=h || e.hash()!=h || BigIntKey(a).hash()!=h) {
+		std::cout << "hash: " << a.getLimbs().size()
+		          << " limbs: equal numbers have different hashes\n";
+		return 1;
+	}
+	return 0;
+}
+
+
+/******************** Main ********************/
+int main(int argc, char **argv) {
+	int num = argc==1 ? 1000 : strtol(argv[1], 0, 0);
+	if (num<1) num = 1000;
+	int failed = 0;
+
+	srand(time(0));
+
+	/* Equal numbers */
+	std::vector<BigInt> pool;
+	for (int i = 0; i<num; ++i) {
+		static const unsigned sizes[] = { 0, 8, 15, 16, 17, 24, 100, 1000 };
+		const unsigned n = rand() & 1 ? rand() % 40
+			: sizes[rand() % (sizeof sizes / sizeof *sizes)];
+		pool.push_back(random_signed(n));
+		failed += check_equal(pool.back());
+	}
+	failed += check_equal(BigInt());
+
+	/* Duplicates */
+	std::set<BigInt> ordered;
+	std::unordered_set<BigInt> plain;
+	std::unordered_set<BigIntKey> keys;
+	for (int i = 0; i<num * 4; ++i) {
+		const BigInt &a = pool[rand() % pool.size()];
+		const BigInt b(a.toString(), 10);
+		ordered.insert(b);
+		plain.insert(b);
+		keys.insert(b);
+	}
+	if (plain.size()!=ordered.size() || keys.size()!=ordered.size()) {
+		std::cout << "unordered_set: " << plain.size() << " and "
+		          << keys.size() << " numbers, expected " << ordered.size()
+		          << '\n';
+		++failed;
+	}
+	for (std::set<BigInt>::const_iterator it = ordered.begin();
+	     it!=ordered.end(); ++it) {
+		if (!plain.count(*it) || !keys.count(*it)) {
+			std::cout << "unordered_set: number not found\n";
+			++failed;
+			break;
+		}
+	}
+
+	/* Collisions */
+	std::set<BigInt> distinct;
+	std::unordered_set<std::size_t> hashes;
+	for (std::set<BigInt>::const_iterator it = ordered.begin();
+	     it!=ordered.end(); ++it) {
+		const BigInt values[] = {
+			*it, -*it, BigInt(*it).add(*it), BigInt(*it).add(*it).add(1)
+		};
+		for (unsigned i = 0; i<sizeof values / sizeof *values; ++i) {
+			distinct.insert(values[i]);
+			hashes.insert(values[i].hash());
+		}
+	}
+	if (hashes.size()!=distinct.size()) {
+		std::cout << "hash: " << distinct.size() - hashes.size()
+		          << " collisions\n";
+		++failed;
+	}
+
+	return failed ? 1 : 0;
+}
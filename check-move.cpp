@@ -0,0 +1,232 @@
+/**
+ * \file
+ * Move semantics tester.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * This program moves Array and BigInt objects and checks that
+ * moved-from objects are empty (or zero) and usable, that moving an
+ * object onto itself is harmless and that modifying an own Array
+ * moves elements instead of copying them.  Then it checks that
+ * binary operators taking an expiring BigInt reuse its limbs and that
+ * they never modify limbs shared with a copy.
+ *
+ * If argument is given it should be a number representing how many
+ * numbers program should check.  The default is 200.
+ */
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include "array.hpp"
+#include "bigint.hpp"
+#include "check.hpp"
+
+using mina86::Array;
+using mina86::BigInt;
+using mina86::BigIntInspect;
+
+
+/**
+ * Element which counts how many times elements were copied.
+ */
+struct Counted {
+	/** Number of copies made so far. */
+	static unsigned copies;
+	/** Value of the element. */
+	int value;
+
+	/** Creates element with value zero. */
+	Counted() : value(0) { }
+	/** Creates element with given value. */
+	explicit Counted(int v) : value(v) { }
+	/** Copies element. */
+	Counted(const Counted &c) : value(c.value) { ++copies; }
+	/** Moves element. */
+	Counted(Counted &&c) noexcept : value(c.value) { c.value = -1; }
+	/** Copies element. */
+	Counted &operator=(const Counted &c) {
+		value = c.value;
+		++copies;
+		return *this;
+	}
+	/** Moves element. */
+	Counted &operator=(Counted &&c) noexcept {
+		value = c.value;
+		c.value = -1;
+		return *this;
+	}
+};
+
+unsigned Counted::copies = 0;
+
+
+/**
+ * Checks that Array holds numbers from \a first to
+ * <code>first + n - 1</code>.
+ *
+ * \param[in] a array
+ * \param[in] first the first number
+ * \param[in] n number of elements
+ * \return \c true if array holds given numbers
+ */
+static bool holds(const Array<int> &a, int first, unsigned n) {
+	bool ok = a.size()==n;
+	for (unsigned i = 0; ok && i<n; ++i) ok = a[i]==first + (int)i;
+	return ok;
+}
+
+
+/**
+ * Checks moving Array objects.
+ *
+ * \return number of failed checks
+ */
+static int check_array() {
+	int failed = 0;
+
+	Array<int> a, c;
+	for (int i = 0; i<100; ++i) a.push(i);
+	for (int i = 0; i<10; ++i) c.push(1000 + i);
+
+	Array<int> b(std::move(a));
+	a.push(7);
+	if (!holds(b, 0, 100) || !holds(a, 7, 1)) {
+		std::cout << "Array: move constructor failed\n";
+		++failed;
+	}
+
+	c = std::move(b);
+	b.push(8);
+	if (!holds(c, 0, 100) || !holds(b, 8, 1)) {
+		std::cout << "Array: move assignment failed\n";
+		++failed;
+	}
+
+	Array<int> &alias = c;
+	c = std::move(alias);
+	if (!holds(c, 0, 100)) {
+		std::cout << "Array: self move assignment failed\n";
+		++failed;
+	}
+
+	/* Own array moves elements when it grows or shrinks */
+	Array<Counted> e;
+	for (int i = 0; i<300; ++i) e.push(Counted(i));
+	Counted::copies = 0;
+	for (int i = 0; i<300; ++i) e.insert(i, Counted(-2));
+	for (int i = 0; i<300; ++i) e.remove(0);
+	e.resize(1000);
+	bool ok = Counted::copies==0 && e.size()==1000;
+	for (int i = 0; ok && i<300; ++i) ok = e[i].value==i;
+	if (!ok) {
+		std::cout << "Array: elements of own array copied or lost\n";
+		++failed;
+	}
+
+	/* Shared array is copied and the copy does not disturb the other */
+	const Array<Counted> f(e);
+	e.remove(0);
+	e.rw_at(0).value = -3;
+	if (!Counted::copies || f.size()!=1000 || f[0].value!=0 ||
+	    f[1].value!=1) {
+		std::cout << "Array: shared array modified\n";
+		++failed;
+	}
+	return failed;
+}
+
+
+/**
+ * Checks moving BigInt objects and binary operators on expiring
+ * numbers.
+ *
+ * \param[in] n number of limbs of tested numbers, at least three
+ * \return number of failed checks
+ */
+static int check_bigint(unsigned n) {
+	int failed = 0;
+	const BigInt a = random_number(n), b = random_number(n / 2 + 1);
+	const std::string as = a.toString();
+
+	/* Move constructor and assignment */
+	BigInt x(a), y(std::move(x));
+	if (x.sgn() || BigInt(x).add(1)!=BigInt(1) || y!=a) {
+		std::cout << "BigInt: move constructor failed\n";
+		++failed;
+	}
+	x = b;
+	y = std::move(x);
+	if (x.sgn() || y!=b) {
+		std::cout << "BigInt: move assignment failed\n";
+		++failed;
+	}
+	BigInt &alias = y;
+	y = std::move(alias);
+	if (y!=b) {
+		std::cout << "BigInt: self move assignment failed\n";
+		++failed;
+	}
+
+	/* Expiring own number gives its limbs to the result; top limb
+	   cleared so that no carry makes it grow */
+	const BigInt z = BigInt(a).sub(BigInt(a).div(2));
+	const BigInt expected = BigInt(z).add(b), product = BigInt(z).mul(b);
+	BigInt w = BigInt(z).add(1).sub(1);
+	const BigInt::Limb *const limbs = BigIntInspect::limbs(w);
+	BigInt r = std::move(w) + b;
+	if (r!=expected || w.sgn() || BigIntInspect::limbs(r)!=limbs) {
+		std::cout << "BigInt: rvalue operator+ did not reuse limbs\n";
+		++failed;
+	}
+	const BigInt::Limb *const rlimbs = BigIntInspect::limbs(r);
+	r = std::move(r) * 3u;
+	if (r!=BigInt(expected).mul(3u) || BigIntInspect::limbs(r)!=rlimbs) {
+		std::cout << "BigInt: rvalue operator* did not reuse limbs\n";
+		++failed;
+	}
+
+	/* Expiring number sharing limbs with a copy must not modify them */
+	w = z;
+	const BigInt copy = w;
+	r = std::move(w) + b;
+	if (r!=expected || copy!=z ||
+	    BigIntInspect::limbs(r)==BigIntInspect::limbs(copy)) {
+		std::cout << "BigInt: rvalue operator+ modified shared limbs\n";
+		++failed;
+	}
+	w = z;
+	r = std::move(w) * b;
+	if (r!=product || copy!=z) {
+		std::cout << "BigInt: rvalue operator* modified shared limbs\n";
+		++failed;
+	}
+	w = z;
+	r = std::move(w) * 3u - b;
+	if (r!=BigInt(z).mul(3u).sub(b) || copy!=z || a.toString()!=as) {
+		std::cout << "BigInt: rvalue operator- modified shared limbs\n";
+		++failed;
+	}
+	return failed;
+}
+
+
+/******************** Main ********************/
+int main(int argc, char **argv) {
+	int num = argc==1 ? 200 : strtol(argv[1], 0, 0);
+	if (num<1) num = 200;
+	int failed = 0;
+
+	srand(time(0));
+
+	failed += check_array();
+	do {
+		failed += check_bigint(3 + rand() % 100);
+	} while (--num);
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,159 @@
+/**
+ * \file
+ * BigInt multiplication tester.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * This program multiplies and squares random limb vectors of various
+ * sizes using all multiplication algorithms (schoolbook, Karatsuba,
+ * Toom-Cook and number-theoretic transform) and compares results with
+ * the ones given by schoolbook multiplication.  Sizes are chosen
+ * around thresholds at which algorithms are switched; in addition
+ * every run multiplies and squares operands of all sizes next to
+ * Karatsuba and Toom-Cook thresholds.  Some operands have all bits
+ * set to stress carry propagation.  Each product is also computed
+ * with a random number of threads to check parallel Toom-Cook
+ * products and split transforms.
+ *
+ * If argument is given it should be a number representing how many
+ * products program should check.  The default is 200.
+ */
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+
+#include "bigint-limb.hpp"
+#include "check.hpp"
+
+using mina86::Limb;
+
+
+/**
+ * Returns random operand size.
+ *
+ * \return number of limbs
+ */
+static unsigned random_size() {
+	static const unsigned sizes[] = {
+		1, 31, 32, 33, 159, 160, 161, 512, 2048, 2500, 9000
+	};
+	return rand() & 1 ? 1 + rand() % 3000
+		: sizes[rand() % (sizeof sizes / sizeof *sizes)];
+}
+
+
+/**
+ * Compares two products.
+ *
+ * \param[in] name name of tested algorithm
+ * \param[in] x expected product
+ * \param[in] y tested product
+ * \param[in] n number of limbs
+ * \param[in] an number of limbs in the first factor
+ * \param[in] bn number of limbs in the second factor
+ * \return \c true if products are equal
+ */
+static bool check(const char *name, const Limb *x, const Limb *y, unsigned n,
+                  unsigned an, unsigned bn) {
+	for (unsigned i = 0; i<n; ++i) {
+		if (x[i]!=y[i]) {
+			std::cout << name << ": " << an << " x " << bn
+			          << ": products differ at limb " << i << '\n';
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/**
+ * Multiplies and squares random operands of all sizes next to
+ * Karatsuba and Toom-Cook thresholds (32 and 160 limbs for products
+ * and 48 and 192 limbs for squares) and compares results with
+ * schoolbook multiplication.  Factors are both balanced and differ
+ * in size by one or two limbs.
+ *
+ * \return number of failed checks
+ */
+static int check_thresholds() {
+	static const unsigned thresholds[] = { 32, 160, 48, 192 };
+	Limb a[200], b[200], x[400], y[400];
+	int failed = 0;
+
+	for (unsigned t = 0; t<sizeof thresholds / sizeof *thresholds; ++t) {
+		for (unsigned an = thresholds[t] - 2; an<=thresholds[t] + 2; ++an) {
+			for (unsigned bn = an - 2; bn<=an; ++bn) {
+				fill(a, an);
+				fill(b, bn);
+				mina86::limbs_mul_basecase(x, a, an, b, bn);
+				mina86::limbs_mul(y, a, an, b, bn);
+				failed += !check("mul", x, y, an + bn, an, bn);
+			}
+			mina86::limbs_mul_basecase(x, a, an, a, an);
+			mina86::limbs_sqr(y, a, an);
+			failed += !check("sqr", x, y, 2 * an, an, an);
+		}
+	}
+	return failed;
+}
+
+
+/******************** Main ********************/
+int main(int argc, char **argv) {
+	int num = argc==1 ? 200 : strtol(argv[1], 0, 0);
+	if (num<1) num = 200;
+	int failed = 0;
+
+	srand(time(0));
+
+	failed += check_thresholds();
+	do {
+		const unsigned an = random_size(), bn = random_size();
+		Limb *const a = new Limb[an], *const b = new Limb[bn];
+		const unsigned rn = an + (an > bn ? an : bn);
+		Limb *const x = new Limb[rn], *const y = new Limb[rn];
+		fill(a, an);
+		fill(b, bn);
+
+		if (an>=bn) {
+			mina86::limbs_mul_basecase(x, a, an, b, bn);
+		} else {
+			mina86::limbs_mul_basecase(x, b, bn, a, an);
+		}
+
+		const unsigned threads = 2 + rand() % 15;
+		mina86::limbs_mul(y, a, an, b, bn);
+		failed += !check("mul", x, y, an + bn, an, bn);
+		mina86::BigInt::setThreads(threads);
+		mina86::limbs_mul(y, a, an, b, bn);
+		failed += !check("mul (threads)", x, y, an + bn, an, bn);
+		mina86::BigInt::setThreads(1);
+		mina86::limbs_mul_ntt(y, a, an, b, bn);
+		failed += !check("ntt", x, y, an + bn, an, bn);
+		mina86::limbs_mul_ntt(y, a, an, b, bn, threads);
+		failed += !check("ntt (threads)", x, y, an + bn, an, bn);
+
+		mina86::limbs_mul_basecase(x, a, an, a, an);
+		mina86::limbs_sqr_basecase(y, a, an);
+		failed += !check("sqr_basecase", x, y, 2 * an, an, an);
+		mina86::limbs_sqr(y, a, an);
+		failed += !check("sqr", x, y, 2 * an, an, an);
+		mina86::BigInt::setThreads(threads);
+		mina86::limbs_sqr(y, a, an);
+		failed += !check("sqr (threads)", x, y, 2 * an, an, an);
+		mina86::BigInt::setThreads(1);
+		mina86::limbs_sqr_ntt(y, a, an);
+		failed += !check("sqr_ntt", x, y, 2 * an, an, an);
+		mina86::limbs_sqr_ntt(y, a, an, threads);
+		failed += !check("sqr_ntt (threads)", x, y, 2 * an, an, an);
+
+		delete[] a;
+		delete[] b;
+		delete[] x;
+		delete[] y;
+	} while (--num);
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,255 @@
+/**
+ * \file
+ * BigInt memory pool tester.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * This program allocates and frees limb buffers of random sizes from
+ * the pool, fills them with patterns and checks that no buffer
+ * overwrites another, also when buffers are freed by a different
+ * thread than the one which allocated them.  Then it computes
+ * products, quotients, powers, expressions and radix conversions of
+ * random numbers inside nested arenas and compares results with the
+ * ones computed without an arena, also after the arenas are gone and
+ * another arena reused their memory.
+ *
+ * If argument is given it should be a number representing how many
+ * numbers program should check.  The default is 200.
+ */
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bigint.hpp"
+#include "bigint-pool.hpp"
+#include "check.hpp"
+
+using mina86::BigInt;
+using mina86::BigIntArena;
+
+
+/**
+ * Allocated buffer together with its size.
+ */
+struct Buffer {
+	/** Pointer to the buffer. */
+	BigInt::Limb *p;
+	/** Number of limbs. */
+	unsigned n;
+	/** Value all limbs are set to. */
+	BigInt::Limb v;
+};
+
+
+/**
+ * Checks that buffer was not overwritten and frees it.
+ *
+ * \param[in] b buffer
+ * \return \c 1 if buffer was overwritten, \c 0 otherwise
+ */
+static int check_free(const Buffer &b) {
+	int failed = 0;
+	for (unsigned i = 0; i<b.n; ++i) {
+		if (b.p[i]!=b.v) {
+			failed = 1;
+			break;
+		}
+	}
+	BigInt::Pool::deallocate(b.p, b.n);
+	if (failed) {
+		std::cout << "pool: buffer of " << b.n << " limbs overwritten\n";
+	}
+	return failed;
+}
+
+
+/**
+ * Allocates random buffers, frees some of them and checks the rest.
+ *
+ * \param[in] num number of buffers
+ * \param[out] kept buffers which were not freed
+ * \return number of failed checks
+ */
+static int check_pool(unsigned num, std::vector<Buffer> &kept) {
+	int failed = 0;
+	std::vector<Buffer> bufs;
+	for (unsigned i = 0; i<num; ++i) {
+		static const unsigned sizes[] = { 3, 4, 5, 8, 9, 1024, 1025, 5000 };
+		Buffer b;
+		b.n = rand() & 1 ? 1 + rand() % 1100
+			: sizes[rand() % (sizeof sizes / sizeof *sizes)];
+		b.p = BigInt::Pool::allocate(b.n);
+		b.v = rand();
+		for (unsigned j = 0; j<b.n; ++j) b.p[j] = b.v;
+		bufs.push_back(b);
+
+		if (rand() % 3 == 0) {
+			const unsigned k = rand() % bufs.size();
+			failed += check_free(bufs[k]);
+			bufs[k] = bufs.back();
+			bufs.pop_back();
+		}
+	}
+	kept.insert(kept.end(), bufs.begin(), bufs.end());
+	return failed;
+}
+
+
+/**
+ * Computes several results of operations on given numbers.
+ *
+ * \param[in] a first number
+ * \param[in] b second number
+ * \return vector of results
+ */
+static std::vector<BigInt> compute(const BigInt &a, const BigInt &b) {
+	std::vector<BigInt> r;
+	r.push_back(a * b);
+	r.push_back(a * a);
+	r.push_back(a / b);
+	r.push_back(a % b);
+	r.push_back(a * b - b * b + a);
+	r.push_back(BigInt(a.toString(), 10));
+	r.push_back(BigInt(b.toString(7), 7));
+	r.push_back(powmod(a, BigInt(65537), b + 1));
+	return r;
+}
+
+
+/**
+ * Checks that results computed inside nested arenas are the same as
+ * results computed without arena.
+ *
+ * \param[in] a first number
+ * \param[in] b second number
+ * \return number of failed checks
+ */
+static int check_arena(const BigInt &a, const BigInt &b) {
+	const std::vector<BigInt> expected = compute(a, b);
+	std::vector<BigInt> got, inner;
+	int failed = 0;
+
+	{
+		BigIntArena arena;
+		got = compute(a, b);
+		{
+			BigIntArena nested;
+			if (BigIntArena::current()!=&nested ||
+			    nested.getPrevious()!=&arena) {
+				std::cout << "arena: wrong current arena\n";
+				++failed;
+			}
+			inner = compute(b, a);
+		}
+		got.insert(got.end(), inner.begin(), inner.end());
+		if (BigIntArena::current()!=&arena) {
+			std::cout << "arena: previous arena not restored\n";
+			++failed;
+		}
+	}
+	if (BigIntArena::current()) {
+		std::cout << "arena: arena not removed\n";
+		++failed;
+	}
+
+	const std::vector<BigInt> swapped = compute(b, a);
+	for (unsigned i = 0; i<got.size(); ++i) {
+		const BigInt &e = i<expected.size() ? expected[i]
+			: swapped[i - expected.size()];
+		if (got[i].cmp(e)) {
+			std::cout << "arena: " << a.getLimbs().size() << " and "
+			          << b.getLimbs().size() << " limbs: result " << i
+			          << " differs\n";
+			++failed;
+		}
+	}
+	return failed;
+}
+
+
+/**
+ * Checks numbers computed inside an arena which outlive it.  After
+ * the arena is destroyed another one, which may get the same memory,
+ * is used for other computations.  Then the numbers are compared with
+ * results computed without an arena, modified and freed.
+ *
+ * \param[in] a first number
+ * \param[in] b second number
+ * \return number of failed checks
+ */
+static int check_escape(const BigInt &a, const BigInt &b) {
+	const BigInt product = a * b, quotient = a / b;
+	const std::string str = a.toString();
+	BigInt p, q;
+	std::string s;
+	int failed = 0;
+
+	{
+		BigIntArena arena;
+		BigInt t = a * b;
+		p = std::move(t);
+		q = a / b;
+		s = p.toString(16);
+	}
+	{
+		BigIntArena arena;
+		const BigInt t = b * b + a * a;
+		if (t.cmp(BigInt(b).sqr().add(BigInt(a).sqr()))) {
+			std::cout << "arena: sum of squares differs\n";
+			++failed;
+		}
+	}
+
+	if (p.cmp(product) || q.cmp(quotient) || s!=product.toString(16)
+	    || a.toString()!=str) {
+		std::cout << "arena: number outliving arena changed\n";
+		++failed;
+	}
+	p.mul(3).add(q);
+	if (p.cmp(product * 3 + quotient)) {
+		std::cout << "arena: modifying number outliving arena failed\n";
+		++failed;
+	}
+	return failed;
+}
+
+
+/******************** Main ********************/
+int main(int argc, char **argv) {
+	int num = argc==1 ? 200 : strtol(argv[1], 0, 0);
+	if (num<1) num = 200;
+	int failed = 0;
+
+	srand(time(0));
+
+	/* Pool */
+	std::vector<Buffer> kept;
+	failed += check_pool(num * 20, kept);
+	std::thread thread([&kept, &failed] {
+		std::vector<Buffer> mine;
+		int f = check_pool(kept.size(), mine);
+		for (unsigned i = 0; i<kept.size(); ++i) f += check_free(kept[i]);
+		kept.swap(mine);
+		failed += f;
+	});
+	thread.join();
+	for (unsigned i = 0; i<kept.size(); ++i) failed += check_free(kept[i]);
+
+	/* Arena */
+	do {
+		static const unsigned sizes[] = { 8, 24, 300, 1000, 3000, 8000 };
+		const unsigned an = rand() & 1 ? rand() % 400
+			: sizes[rand() % (sizeof sizes / sizeof *sizes)];
+		const unsigned bn = 1 + rand() % (an + 1);
+		const BigInt a = random_bits(4 * an + 1), b = random_bits(4 * bn + 1);
+		failed += check_arena(a, b);
+		failed += check_escape(a, b);
+	} while (--num);
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,94 @@
+/**
+ * \file
+ * BigInt exponentiation tester.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * This program raises random numbers to random powers modulo random
+ * odd and even moduli and compares results of BigInt::powmod() with
+ * the ones given by plain binary exponentiation reducing with
+ * BigInt::mod() after each step.  Sizes are chosen so that single
+ * limb moduli, all window sizes and moduli of a few thousand bits
+ * get exercised.  BigInt::pow() is compared with repeated
+ * multiplication.
+ *
+ * If argument is given it should be a number representing how many
+ * exponentiations program should check.  The default is 100.
+ */
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+
+#include "bigint.hpp"
+#include "check.hpp"
+
+using mina86::BigInt;
+
+
+/**
+ * Computes <code>a^e mod m</code> using binary exponentiation with
+ * reduction after each step.
+ *
+ * \param[in] a base
+ * \param[in] e exponent
+ * \param[in] m modulus
+ * \return result from zero to absolute value of \a m minus one
+ */
+static BigInt naive_powmod(BigInt a, BigInt e, const BigInt &m) {
+	const BigInt two(2.0);
+	BigInt r(1.0), bit;
+	r.mod(m);
+	a.mod(m);
+	while (e.sgn()) {
+		BigInt(e).divmod(two, bit);
+		if (bit.sgn()) r.mul(a).mod(m);
+		a.sqr().mod(m);
+		e.div(two);
+	}
+	if (r.sgn()<0) r.add(abs(m));
+	return r;
+}
+
+
+/******************** Main ********************/
+int main(int argc, char **argv) {
+	int num = argc==1 ? 100 : strtol(argv[1], 0, 0);
+	if (num<1) num = 100;
+	int failed = 0;
+
+	srand(time(0));
+
+	do {
+		static const unsigned sizes[] = { 1, 1, 2, 3, 16, 64, 128 };
+		const unsigned mn = rand() & 1 ? 1 + rand() % 40
+			: sizes[rand() % (sizeof sizes / sizeof *sizes)];
+		const unsigned en = rand() % 4 ? 1 + rand() % 4 : 1 + rand() % 120;
+
+		BigInt m = random_number(mn);
+		if (rand() & 1) m.add(BigInt(1.0));
+		if (rand() & 1) m.neg();
+		BigInt a = random_number(rand() % (2 * mn + 1));
+		if (rand() & 1) a.neg();
+		const BigInt e = rand() % 8 ? random_number(en) : BigInt();
+
+		if (powmod(a, e, m).cmp(naive_powmod(a, e, m))) {
+			std::cout << "powmod: " << mn << " limbs modulus, " << en
+			          << " limbs exponent: results differ\n";
+			++failed;
+		}
+
+		const unsigned long p = rand() % 40;
+		a = random_number(rand() % 8);
+		BigInt x(1.0);
+		for (unsigned long i = 0; i<p; ++i) x.mul(a);
+		if (pow(a, p).cmp(x)) {
+			std::cout << "pow: " << p << " exponent: results differ\n";
+			++failed;
+		}
+	} while (--num);
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,181 @@
+/**
+ * \file
+ * BigInt primality test tester.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * This program compares isProbablePrime() and nextPrime() of all
+ * numbers below #SMALL with sieve of Eratosthenes, checks known
+ * primes (Mersenne primes) and known composites which fool weaker
+ * tests (Carmichael numbers, strong pseudoprimes to many bases,
+ * products of two big primes), with one thread and with several.
+ * Then for random numbers it checks that the number nextPrime()
+ * returns is a prime and that all numbers in between are composite.
+ *
+ * If argument is given it should be a number representing how many
+ * random numbers program should check.  The default is 20.
+ */
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "bigint.hpp"
+#include "check.hpp"
+
+using mina86::BigInt;
+
+
+/**
+ * Numbers below this limit are compared with sieve of Eratosthenes.
+ */
+static const unsigned long SMALL = 200000;
+
+
+/**
+ * Checks all small numbers.
+ *
+ * \return number of failed checks
+ */
+static int check_small() {
+	std::vector<bool> prime(SMALL + 1, true);
+	prime[0] = prime[1] = false;
+	for (unsigned long p = 2; p * p<=SMALL; ++p) {
+		if (!prime[p]) continue;
+		for (unsigned long j = p * p; j<=SMALL; j += p) prime[j] = false;
+	}
+
+	int failed = 0;
+	unsigned long next = SMALL;
+	while (!prime[next]) --next;
+	for (unsigned long n = next; n--; ) {
+		const BigInt x(n);
+		if (x.isProbablePrime()!=prime[n]) {
+			std::cout << n << ": wrong result of isProbablePrime()\n";
+			++failed;
+		}
+		if (BigInt(x).nextPrime()!=BigInt(next)) {
+			std::cout << n << ": wrong result of nextPrime()\n";
+			++failed;
+		}
+		if (prime[n]) next = n;
+	}
+
+	static const long negative[] = { -1, -2, -3, -7, -8, -97 };
+	for (unsigned i = 0; i<sizeof negative / sizeof *negative; ++i) {
+		const BigInt x(negative[i]);
+		if (x.isProbablePrime() || BigInt(x).nextPrime()!=BigInt(2)) {
+			std::cout << negative[i] << ": wrong result\n";
+			++failed;
+		}
+	}
+	return failed;
+}
+
+
+/**
+ * Checks known primes and composites.
+ *
+ * \return number of failed checks
+ */
+static int check_known() {
+	static const char *const composites[] = {
+		/* Carmichael numbers */
+		"561", "41041", "825265", "321197185",
+		/* Strong pseudoprimes to base 2, to bases 2 to 7 and to all
+		   prime bases up to 23 */
+		"2047", "3215031751", "3825123056546413051",
+		/* Fermat numbers F5 and F6 */
+		"4294967297", "18446744073709551617",
+		/* Mersenne numbers with prime exponent */
+		"147573952589676412927",
+		/* (2^61 - 1) (2^89 - 1) and (2^89 - 1) (2^127 - 1) */
+		"1427247692705959880439315947500961989719490561",
+		"105312291668557186697918027513529248857806893649219117400977309697",
+		0
+	};
+
+	int failed = 0;
+	for (const char *const *c = composites; *c; ++c) {
+		if (BigInt(*c).isProbablePrime()) {
+			std::cout << *c << ": composite taken for a prime\n";
+			++failed;
+		}
+	}
+
+	/* Mersenne primes */
+	static const unsigned exps[] = {
+		31, 61, 89, 107, 127, 521, 607, 1279, 0
+	};
+	for (const unsigned *e = exps; *e; ++e) {
+		const BigInt p = BigInt(2).pow(*e) - BigInt(1);
+		if (!p.isProbablePrime()) {
+			std::cout << "2^" << *e << "-1: prime taken for a composite\n";
+			++failed;
+		}
+		if (BigInt(p * p).isProbablePrime()) {
+			std::cout << "(2^" << *e << "-1)^2: composite taken for a prime\n";
+			++failed;
+		}
+		if (BigInt(p - BigInt(2)).nextPrime()!=p) {
+			std::cout << "2^" << *e << "-3: wrong result of nextPrime()\n";
+			++failed;
+		}
+	}
+	return failed;
+}
+
+
+/**
+ * Checks nextPrime() of random number and primality of numbers
+ * between the two.
+ *
+ * \return number of failed checks
+ */
+static int check_random() {
+	const BigInt n = random_bits(33 + rand() % 600);
+	const BigInt p = mina86::nextPrime(n);
+	int failed = 0;
+
+	if (p<=n || !p.isProbablePrime()) {
+		std::cout << n << ": nextPrime() returned " << p << '\n';
+		return 1;
+	}
+	for (BigInt x = n + BigInt(1); x<p; x += BigInt(1)) {
+		if (x.isProbablePrime()) {
+			std::cout << n << ": nextPrime() skipped " << x << '\n';
+			++failed;
+			break;
+		}
+	}
+
+	const BigInt q = mina86::nextPrime(random_bits(33 + rand() % 600));
+	if (BigInt(p * q).isProbablePrime()) {
+		std::cout << p << " * " << q << ": composite taken for a prime\n";
+		++failed;
+	}
+	return failed;
+}
+
+
+/******************** Main ********************/
+int main(int argc, char **argv) {
+	int num = argc==1 ? 20 : strtol(argv[1], 0, 0);
+	if (num<1) num = 20;
+	int failed = 0;
+
+	srand(time(0));
+
+	failed += check_small();
+	for (unsigned threads = 1; threads<=4; threads += 3) {
+		BigInt::setThreads(threads);
+		failed += check_known();
+		for (int i = 0; i<num; ++i) failed += check_random();
+	}
+	BigInt::setThreads(1);
+
+	return failed ? 1 : 0;
+}
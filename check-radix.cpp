@@ -0,0 +1,218 @@
+/**
+ * \file
+ * BigInt radix conversion tester.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * This program converts random limb vectors of various sizes into
+ * digits in various bases and back.  Digits produced by
+ * limbs_get_str() are compared with the ones given by quadratic
+ * algorithm and limb vectors produced by limbs_set_str() are compared
+ * with the ones given by quadratic algorithm and with the original
+ * vector.  Sizes are chosen so that recursive conversion gets
+ * exercised and some numbers have long runs of zero digits to test
+ * padding.  Digits in bases 8, 10 and 16 are also read back from
+ * a stream with BigInt's extraction operator; the stream hands out
+ * characters in chunks of random size or one by one without any
+ * buffer.
+ *
+ * If argument is given it should be a number representing how many
+ * conversions program should check.  The default is 100.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+
+#include "bigint-limb.hpp"
+#include "check.hpp"
+
+using mina86::Limb;
+
+
+/**
+ * Stream buffer which hands out characters of a string in chunks of
+ * given size.  With chunk size zero it has no get area at all and
+ * gives characters one by one through underflow() and uflow().
+ */
+class ChunkBuf : public std::streambuf {
+	/** The string. */
+	std::string str;
+	/** Position of the next chunk. */
+	std::size_t pos;
+	/** Chunk size or zero. */
+	std::size_t chunk;
+
+protected:
+	int_type underflow() {
+		if (pos>=str.size()) {
+			return traits_type::eof();
+		} else if (!chunk) {
+			return traits_type::to_int_type(str[pos]);
+		}
+		char *const begin = &str[pos];
+		const std::size_t n = std::min(chunk, str.size() - pos);
+		setg(begin, begin, begin + n);
+		pos += n;
+		return traits_type::to_int_type(*begin);
+	}
+
+	int_type uflow() {
+		if (chunk) return std::streambuf::uflow();
+		const int_type ch = underflow();
+		if (ch!=traits_type::eof()) ++pos;
+		return ch;
+	}
+
+public:
+	/**
+	 * Creates buffer.
+	 *
+	 * \param[in] s the string
+	 * \param[in] c chunk size or zero
+	 */
+	ChunkBuf(const std::string &s, std::size_t c)
+		: str(s), pos(0), chunk(c) { }
+};
+
+
+/**
+ * Returns random number size.
+ *
+ * \return number of limbs
+ */
+static unsigned random_size() {
+	static const unsigned sizes[] = { 1, 2, 29, 30, 31, 100, 1000 };
+	return rand() & 1 ? 1 + rand() % 2000
+		: sizes[rand() % (sizeof sizes / sizeof *sizes)];
+}
+
+
+/**
+ * Returns random base.
+ *
+ * \return base from 2 to 36
+ */
+static unsigned random_base() {
+	static const unsigned bases[] = { 2, 8, 10, 10, 10, 16, 3, 36 };
+	return rand() & 1 ? 2 + rand() % 35
+		: bases[rand() % (sizeof bases / sizeof *bases)];
+}
+
+
+/**
+ * Reads number from stream and compares it with limb vector.  Number
+ * is written with leading white space, sign and prefix and is
+ * followed by another number to check that extraction stops at the
+ * first character which is not a digit.  Hexadecimal numbers are
+ * read either with base set or with base taken from the prefix.
+ *
+ * \param[in] digits digit values, the most significant first
+ * \param[in] len number of digits
+ * \param[in] base base, 8, 10 or 16
+ * \param[in] a limb vector
+ * \param[in] n number of limbs
+ * \return \c true if number was read correctly
+ */
+static bool check_stream(const char *digits, unsigned len, unsigned base,
+                         const Limb *a, unsigned n) {
+	const bool neg = rand() & 1;
+	std::string str(rand() % 3, ' ');
+	str += neg ? "\n-" : "\t";
+	if (base==16) str += "0x";
+	for (unsigned i = 0; i<len; ++i) str += "0123456789abcdef"[(int)digits[i]];
+	str += " 7";
+
+	/* Whole string buffered, chunks of random size or no buffer */
+	const unsigned kind = rand() % 4;
+	std::istringstream sstr(str);
+	ChunkBuf buf(str, kind==3 ? 0 : kind==2 ? 1 + rand() % 8
+	             : 1 + rand() % (str.size() + 1));
+	std::istream in(kind ? (std::streambuf *)&buf : sstr.rdbuf());
+	mina86::BigInt x, y;
+	if (base==8) {
+		in >> std::oct;
+	} else if (base==10) {
+		in >> std::dec;
+	} else if (rand() & 1) {
+		in >> std::hex;
+	} else {
+		in.unsetf(std::ios_base::basefield);
+	}
+	if (!(in >> x >> y) || !in.eof() || x.sgn()!=(neg ? -1 : 1) ||
+	    y.getLimbs().size()!=1 || y.getLimbs()[0]!=7) {
+		return false;
+	}
+
+	const mina86::Array<Limb> limbs = x.getLimbs();
+	bool ok = limbs.size()==n;
+	for (unsigned i = 0; ok && i<n; ++i) ok = limbs[i]==a[i];
+	return ok;
+}
+
+
+/******************** Main ********************/
+int main(int argc, char **argv) {
+	int num = argc==1 ? 100 : strtol(argv[1], 0, 0);
+	if (num<1) num = 100;
+	int failed = 0;
+
+	srand(time(0));
+
+	do {
+		const unsigned n = random_size(), base = random_base();
+		const unsigned size = mina86::limbs_get_str_size(n, base);
+		Limb *const a = new Limb[n];
+		char *const x = new char[size], *const y = new char[size];
+		fill(a, n);
+
+		/* Long run of zero digits in the middle */
+		if (n>4 && !(rand() % 4)) {
+			a[n / 2 - 1] = a[n / 2] = 0;
+		}
+
+		const char *const xb = mina86::limbs_get_str(x + size, a, n, base);
+		const char *const yb = mina86::limbs_get_str_basecase(y + size, a, n,
+		                                                      base);
+		const unsigned len = x + size - xb;
+		bool ok = len==(unsigned)(y + size - yb);
+		for (unsigned i = 0; ok && i<len; ++i) ok = xb[i]==yb[i];
+		if (!ok) {
+			std::cout << "get_str: " << n << " limbs, base " << base
+			          << ": digits differ\n";
+			++failed;
+		}
+
+		const unsigned cap = mina86::limbs_set_str_size(len, base);
+		Limb *const r = new Limb[cap], *const s = new Limb[cap];
+		const unsigned rn = mina86::limbs_set_str(r, xb, len, base);
+		const unsigned sn = mina86::limbs_set_str_basecase(s, xb, len, base);
+		ok = rn==n && sn==n;
+		for (unsigned i = 0; ok && i<n; ++i) ok = r[i]==a[i] && s[i]==a[i];
+		if (!ok) {
+			std::cout << "set_str: " << n << " limbs, base " << base
+			          << ": limbs differ\n";
+			++failed;
+		}
+
+		if ((base==8 || base==10 || base==16) &&
+		    !check_stream(xb, len, base, a, n)) {
+			std::cout << "operator>>: " << n << " limbs, base " << base
+			          << ": numbers differ\n";
+			++failed;
+		}
+
+		delete[] a;
+		delete[] x;
+		delete[] y;
+		delete[] r;
+		delete[] s;
+	} while (--num);
+
+	return failed ? 1 : 0;
+}
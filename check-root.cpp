@@ -0,0 +1,101 @@
+/**
+ * \file
+ * BigInt roots tester.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * This program computes roots of random numbers of random degrees
+ * and checks that the result is the greatest number whose power does
+ * not exceed the number.  Roots of exact powers and their neighbours
+ * are checked as well and BigInt::perfectPower() is checked to find
+ * the exponent of numbers built as powers and to reject the rest.
+ * Sizes are chosen so that numbers stored inline, roots found with
+ * bisection and roots found with Newton's iteration all get
+ * exercised.
+ *
+ * If argument is given it should be a number representing how many
+ * numbers program should check.  The default is 200.
+ */
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+
+#include "bigint.hpp"
+#include "check.hpp"
+
+using mina86::BigInt;
+
+
+/**
+ * Checks that root is computed correctly, ie. that <code>r^k <=
+ * |n| < (r+1)^k</code> and that it has the same sign as \a n.
+ *
+ * \param[in] n number
+ * \param[in] k degree of the root
+ * \return \c 1 if root is wrong, \c 0 otherwise
+ */
+static int check_root(const BigInt &n, unsigned long k) {
+	const BigInt r = iroot(n, k), a = abs(n), ar = abs(r);
+	if (r.sgn()!=n.sgn() || pow(ar, k).cmp(a)>0 ||
+	    pow(ar + BigInt(1.0), k).cmp(a)<=0) {
+		std::cout << "iroot: " << n.getLimbs().size() << " limbs, degree "
+		          << k << ": wrong root\n";
+		return 1;
+	}
+	return 0;
+}
+
+
+/******************** Main ********************/
+int main(int argc, char **argv) {
+	int num = argc==1 ? 200 : strtol(argv[1], 0, 0);
+	if (num<1) num = 200;
+	int failed = 0;
+
+	srand(time(0));
+
+	do {
+		static const unsigned sizes[] = { 1, 2, 3, 8, 50, 300 };
+		static const unsigned long degrees[] = { 2, 2, 3, 5, 7, 64, 1000 };
+		const unsigned n = rand() & 1 ? rand() % 40
+			: sizes[rand() % (sizeof sizes / sizeof *sizes)];
+		const unsigned long k = rand() & 1 ? 2 + rand() % 20
+			: degrees[rand() % (sizeof degrees / sizeof *degrees)];
+
+		/* Random number */
+		BigInt a = random_number(n);
+		if (k & 1 && rand() & 1) a.neg();
+		failed += check_root(a, k);
+
+		/* Exact power and its neighbours */
+		BigInt r = random_number(1 + rand() % (n / k + 2));
+		const unsigned long e = k<20 ? k : 2 + rand() % 5;
+		const BigInt p = pow(r, e);
+		failed += check_root(p, e);
+		failed += check_root(p - BigInt(1.0), e);
+		failed += check_root(p + BigInt(1.0), e);
+
+		/* Perfect powers; 9 is the only power following another one */
+		if (r.cmp(BigInt(1.0))>0 && r.perfectPower()==1) {
+			BigInt root;
+			const unsigned long got = p.perfectPower(&root);
+			if (got!=e || root.cmp(r)) {
+				std::cout << "perfectPower: " << r.getLimbs().size()
+				          << " limbs to the power of " << e
+				          << ": got exponent " << got << '\n';
+				++failed;
+			}
+		}
+		const BigInt q = p + BigInt(1.0);
+		if (r.cmp(BigInt(1.0))>0 && q.cmp(BigInt(9.0)) &&
+		    q.perfectPower()>1) {
+			std::cout << "perfectPower: power plus one is a power\n";
+			++failed;
+		}
+	} while (--num);
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,152 @@
+/**
+ * \file
+ * BigInt vector addition tester.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * This program adds and substracts random limb vectors using vector
+ * kernels for every instruction set the processor supports and
+ * compares results with the ones given by limb by limb loops.  Limbs
+ * are often all zeros or all ones so that carries and borrows
+ * propagate over many limbs and across vectors.  Results are checked
+ * also when the result overwrites one of the operands.
+ *
+ * If argument is given it should be a number representing how many
+ * vectors program should check.  The default is 2000.
+ */
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+
+#include "bigint-limb.hpp"
+
+using mina86::Limb;
+
+
+/**
+ * Names of instruction sets.
+ */
+static const char *const names[] = { "scalar", "SSE2", "AVX2", "AVX-512" };
+
+
+/**
+ * Fills limb vector with random limbs.  Depending on random choice
+ * limbs are random, all bits set, zero or mix of the above.
+ *
+ * \param[out] a limb vector
+ * \param[in] n number of limbs
+ */
+static void fill(Limb *a, unsigned n) {
+	const unsigned kind = rand() % 4;
+	for (unsigned i = 0; i<n; ++i) {
+		const Limb r = ((Limb)rand() << 16) ^ (Limb)rand();
+		switch (kind == 3 ? rand() % 3 : kind) {
+		case 0: a[i] = r; break;
+		case 1: a[i] = ~(Limb)0; break;
+		case 2: a[i] = r & 1; break;
+		}
+	}
+}
+
+
+/**
+ * Returns random vector size.
+ *
+ * \return number of limbs
+ */
+static unsigned random_size() {
+	static const unsigned sizes[] = {
+		0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 64, 1000, 4099
+	};
+	return rand() & 1 ? rand() % 200
+		: sizes[rand() % (sizeof sizes / sizeof *sizes)];
+}
+
+
+/**
+ * Compares two results.
+ *
+ * \param[in] what name of the operation
+ * \param[in] x expected result
+ * \param[in] xc expected carry
+ * \param[in] y tested result
+ * \param[in] yc tested carry
+ * \param[in] n number of limbs
+ * \return \c true if results are equal
+ */
+static bool check(const char *what, const Limb *x, Limb xc, const Limb *y,
+                  Limb yc, unsigned n) {
+	for (unsigned i = 0; i<n; ++i) {
+		if (x[i]!=y[i]) {
+			std::cout << what << ": " << n << " limbs: results differ at "
+			          << "limb " << i << '\n';
+			return false;
+		}
+	}
+	if (xc!=yc) {
+		std::cout << what << ": " << n << " limbs: carries differ\n";
+		return false;
+	}
+	return true;
+}
+
+
+/**
+ * Checks addition and substraction of random vectors with currently
+ * selected kernels.
+ *
+ * \param[in] name name of instruction set
+ * \return number of failed checks
+ */
+static int check_kernels(const char *name) {
+	const unsigned n = random_size();
+	Limb *const a = new Limb[n + 1], *const b = new Limb[n + 1];
+	Limb *const x = new Limb[n + 1], *const y = new Limb[n + 1];
+	int failed = 0;
+	fill(a, n);
+	fill(b, n);
+
+	const std::string add = std::string(name) + " add";
+	const std::string sub = std::string(name) + " sub";
+
+	Limb xc = mina86::limbs_add_n_basecase(x, a, b, n);
+	Limb yc = mina86::limbs_add_n_simd(y, a, b, n);
+	failed += !check(add.c_str(), x, xc, y, yc, n);
+	for (unsigned i = 0; i<n; ++i) y[i] = a[i];
+	yc = mina86::limbs_add_n_simd(y, y, b, n);
+	failed += !check((add + " in place").c_str(), x, xc, y, yc, n);
+
+	xc = mina86::limbs_sub_n_basecase(x, a, b, n);
+	yc = mina86::limbs_sub_n_simd(y, a, b, n);
+	failed += !check(sub.c_str(), x, xc, y, yc, n);
+	for (unsigned i = 0; i<n; ++i) y[i] = b[i];
+	yc = mina86::limbs_sub_n_simd(y, a, y, n);
+	failed += !check((sub + " in place").c_str(), x, xc, y, yc, n);
+
+	delete[] a;
+	delete[] b;
+	delete[] x;
+	delete[] y;
+	return failed;
+}
+
+
+/******************** Main ********************/
+int main(int argc, char **argv) {
+	int num = argc==1 ? 2000 : strtol(argv[1], 0, 0);
+	if (num<1) num = 2000;
+	int failed = 0;
+
+	srand(time(0));
+
+	const mina86::LimbsSimd best = mina86::limbs_simd_best();
+	for (int s = mina86::LIMBS_SCALAR; s<=best; ++s) {
+		mina86::limbs_simd_use((mina86::LimbsSimd)s);
+		for (int i = 0; i<num; ++i) failed += check_kernels(names[s]);
+	}
+	mina86::limbs_simd_use(best);
+
+	return failed ? 1 : 0;
+}
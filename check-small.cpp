@@ -0,0 +1,232 @@
+/**
+ * \file
+ * BigInt inline storage tester.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * Numbers which fit in two limbs are stored inside BigInt object and
+ * bigger ones in a shared array of limbs.  This program runs
+ * operations on values around 2^64 so that results move between the
+ * two representations and checks that every result is stored where
+ * it belongs and has correct value.  Then it copies inline and heap
+ * values back and forth while limbs are shared and checks that
+ * modifying one copy leaves the others intact.
+ *
+ * If argument is given it should be a number representing how many
+ * numbers program should check.  The default is 1000.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+
+#include "bigint.hpp"
+#include "check.hpp"
+
+using mina86::BigInt;
+using mina86::BigIntInspect;
+
+
+/**
+ * The biggest absolute value which fits in two limbs.
+ */
+static const BigInt MAX_INLINE("ffffffffffffffff", 16);
+
+
+/**
+ * Checks that number is stored inline if and only if it fits in two
+ * limbs and that it has expected value.
+ *
+ * \param[in] what description of the operation printed on failure
+ * \param[in] n number to check
+ * \param[in] expected expected value in hexadecimal
+ * \return \c 1 if check failed, \c 0 otherwise
+ */
+static int check(const char *what, const BigInt &n,
+                 const std::string &expected) {
+	const bool fits = BigInt(n).abs().cmp(MAX_INLINE)<=0;
+	const std::string got = n.toString(16);
+	if (fits==BigIntInspect::isInline(n) && got==expected) {
+		return 0;
+	}
+	std::cout << what << ": got " << got
+	          << (BigIntInspect::isInline(n) ? " (inline)" : " (heap)")
+	          << ", expected " << expected << '\n';
+	return 1;
+}
+
+
+/**
+ * Formats 64-bit number in hexadecimal, optionally prefixing it with
+ * a carry limb and a sign.
+ *
+ * \param[in] neg whether number is negative
+ * \param[in] high carry (0 or 1) put above the 64 bits
+ * \param[in] low the lower 64 bits
+ * \return number in hexadecimal
+ */
+static std::string hex(bool neg, unsigned high, unsigned long long low) {
+	char buf[24];
+	if (high) {
+		sprintf(buf, "%x%016llx", high, low);
+	} else {
+		sprintf(buf, "%llx", low);
+	}
+	return neg && (high || low) ? std::string("-") + buf : buf;
+}
+
+
+/**
+ * Checks fixed numbers crossing the two limb boundary.
+ *
+ * \return number of failed checks
+ */
+static int check_boundary() {
+	const BigInt two32(1ull << 32);
+	int failed = 0;
+
+	BigInt n(~0ull);
+	failed += check("2^64-1", n, "ffffffffffffffff");
+	n.add(1);
+	failed += check("2^64-1 + 1", n, "10000000000000000");
+	n.sub(1);
+	failed += check("2^64 - 1", n, "ffffffffffffffff");
+	n.neg().sub(1);
+	failed += check("-2^64+1 - 1", n, "-10000000000000000");
+	n.add(1);
+	failed += check("-2^64 + 1", n, "-ffffffffffffffff");
+
+	n = two32;
+	n.mul(two32);
+	failed += check("2^32 * 2^32", n, "10000000000000000");
+	n.div(two32);
+	failed += check("2^64 / 2^32", n, "100000000");
+	n.mul(two32).mul(two32);
+	failed += check("2^32 ^ 3", n, "1" + std::string(24, '0'));
+	n.mod(BigInt(MAX_INLINE).add(1));
+	failed += check("2^96 % 2^64", n, "0");
+	n = BigInt(two32).pow(3);
+	n.add(5).mod(BigInt(MAX_INLINE).add(1).mul(two32));
+	failed += check("(2^96 + 5) % 2^96", n, "5");
+	failed += check("2^96 - 2^96",
+	                BigInt(two32).pow(3).sub(BigInt(two32).pow(3)), "0");
+	failed += check("(2^64+1) * (2^64-1)",
+	                BigInt(MAX_INLINE).add(2).mul(MAX_INLINE),
+	                std::string(32, 'f'));
+	failed += check("(2^128-1) / (2^64+1)",
+	                BigInt(MAX_INLINE).add(2).mul(MAX_INLINE)
+	                .div(BigInt(MAX_INLINE).add(2)),
+	                "ffffffffffffffff");
+	failed += check("isqrt(2^128)",
+	                BigInt(MAX_INLINE).add(1).sqr().isqrt(),
+	                "10000000000000000");
+	failed += check("isqrt(2^128-1)",
+	                BigInt(MAX_INLINE).add(1).sqr().sub(1).isqrt(),
+	                "ffffffffffffffff");
+	return failed;
+}
+
+
+/**
+ * Adds and subtracts random numbers close to 2^64 comparing results
+ * with 64-bit arithmetic.
+ *
+ * \return number of failed checks
+ */
+static int check_random() {
+	const unsigned long long a = random_ull(), b = random_ull();
+	const unsigned long long sum = a + b;
+	const bool a_neg = rand() & 1;
+	int failed = 0;
+
+	BigInt n(a);
+	if (a_neg) n.neg();
+	n.add(a_neg ? BigInt(b).neg() : BigInt(b));
+	failed += check("a + b", n, hex(a_neg, sum<a, sum));
+	n.sub(a_neg ? BigInt(b).neg() : BigInt(b));
+	failed += check("a + b - b", n, hex(a_neg, 0, a));
+
+	BigInt m = BigInt(a).add(b);
+	const BigInt copy = m;
+	m.sub(a);
+	failed += check("a + b - a", m, hex(false, 0, b));
+	failed += check("shared a + b", copy, hex(false, sum<a, sum));
+
+	if (a && b) {
+		m = BigInt(a).mul(b);
+		failed += check("a * b / b", BigInt(m).div(b), hex(false, 0, a));
+		failed += check("a * b % a", BigInt(m).mod(a), "0");
+		m.add(b).mod(BigInt(a).add(1));
+		failed += check("(a * b + b) % (a + 1)", m, "0");
+	}
+	return failed;
+}
+
+
+/**
+ * Copies inline and heap numbers between objects while limbs are
+ * shared and modifies them checking that other copies are intact.
+ *
+ * \return number of failed checks
+ */
+static int check_copies() {
+	const BigInt big = random_number(3 + rand() % 4);
+	const unsigned long long v = random_ull();
+	const std::string big_hex = big.toString(16), v_hex = hex(false, 0, v);
+	int failed = 0;
+
+	BigInt heap = big, shared = heap, small(v), inline_copy = small;
+
+	/* Heap object becomes inline while another one shares its limbs */
+	heap = small;
+	failed += check("heap = inline", heap, v_hex);
+	failed += check("shared after heap = inline", shared, big_hex);
+	failed += check("inline after heap = inline", small, v_hex);
+
+	/* Inline object takes shared limbs and drops back to inline */
+	inline_copy = shared;
+	failed += check("inline = heap", inline_copy, big_hex);
+	inline_copy.sub(BigInt(big).sub(v));
+	failed += check("shared heap - (heap - v)", inline_copy, v_hex);
+	failed += check("shared after sub", shared, big_hex);
+	failed += check("big after sub", big, big_hex);
+
+	/* Inline object grows to heap while another heap copy exists */
+	small.add(big);
+	failed += check("inline + heap", small,
+	                BigInt(big).add(v).toString(16));
+	failed += check("heap copy after inline + heap", heap, v_hex);
+	small.sub(big);
+	failed += check("inline + heap - heap", small, v_hex);
+
+	/* Moving heap into inline object and back */
+	BigInt moved = std::move(shared);
+	failed += check("moved heap", moved, big_hex);
+	failed += check("moved-from heap", shared, "0");
+	shared = std::move(small);
+	failed += check("inline moved into heap", shared, v_hex);
+	failed += check("moved-from inline", small, "0");
+	failed += check("big after moves", big, big_hex);
+	return failed;
+}
+
+
+/******************** Main ********************/
+int main(int argc, char **argv) {
+	int num = argc==1 ? 1000 : strtol(argv[1], 0, 0);
+	if (num<1) num = 1000;
+	int failed = 0;
+
+	srand(time(0));
+
+	failed += check_boundary();
+	do {
+		failed += check_random();
+		failed += check_copies();
+	} while (--num);
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,125 @@
+/**
+ * \file
+ * BigInt machine integer arithmetic tester.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * This program adds, substracts, multiplies, divides and compares
+ * random numbers with random machine integers and compares results
+ * with the ones given by the same operations with the machine
+ * integer converted to BigInt first.  Machine integers include
+ * values around limits of their types and divisors of one and two
+ * limbs with the most significant bit both set and cleared.
+ *
+ * If argument is given it should be a number representing how many
+ * numbers program should check.  The default is 1000.
+ */
+
+#include <climits>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+
+#include "bigint.hpp"
+#include "check.hpp"
+
+using mina86::BigInt;
+
+
+/**
+ * Checks operations with a machine integer against operations with
+ * the same value converted to BigInt.
+ *
+ * \param[in] a BigInt number
+ * \param[in] w machine integer
+ * \param[in] type name of machine integer type
+ * \return number of failed checks
+ */
+template<class T>
+static int check(const BigInt &a, T w, const char *type) {
+	const BigInt b(w);
+	int failed = 0;
+
+	if ((a + w).cmp(BigInt(a).add(b)) || (w + a).cmp(BigInt(a).add(b))) {
+		std::cout << type << ": " << a << " + " << w << " differs\n";
+		++failed;
+	}
+	if ((a - w).cmp(BigInt(a).sub(b)) || (w - a).cmp(BigInt(b).sub(a))) {
+		std::cout << type << ": " << a << " - " << w << " differs\n";
+		++failed;
+	}
+	if ((a * w).cmp(BigInt(a).mul(b)) || (w * a).cmp(BigInt(a).mul(b))) {
+		std::cout << type << ": " << a << " * " << w << " differs\n";
+		++failed;
+	}
+	if (a.cmp(w)!=a.cmp(b) || (a<w)!=(a.cmp(b)<0) || (w<a)!=(b.cmp(a)<0) ||
+	    (a==w)!=!a.cmp(b)) {
+		std::cout << type << ": " << a << " <=> " << w << " differs\n";
+		++failed;
+	}
+
+	if (w) {
+		if ((a / w).cmp(BigInt(a).div(b))) {
+			std::cout << type << ": " << a << " / " << w << " differs\n";
+			++failed;
+		}
+		if ((a % w).cmp(BigInt(a).mod(b))) {
+			std::cout << type << ": " << a << " % " << w << " differs\n";
+			++failed;
+		}
+	} else {
+		try {
+			BigInt(a).div(w);
+			std::cout << type << ": division by zero accepted\n";
+			++failed;
+		} catch (const BigInt::DivisionByZero &) {
+		}
+	}
+
+	return failed;
+}
+
+
+/******************** Main ********************/
+int main(int argc, char **argv) {
+	int num = argc==1 ? 1000 : strtol(argv[1], 0, 0);
+	if (num<1) num = 1000;
+	int failed = 0;
+
+	srand(time(0));
+
+	/* Limits */
+	const BigInt limits[] = {
+		BigInt(), BigInt(LONG_MIN), BigInt(LONG_MAX), BigInt(ULONG_MAX),
+		BigInt(ULONG_MAX).add(1), BigInt(LONG_MIN).sub(1),
+		BigInt(LLONG_MIN), BigInt(ULLONG_MAX), BigInt(ULLONG_MAX).add(1)
+	};
+	for (unsigned i = 0; i<sizeof limits / sizeof *limits; ++i) {
+		failed += check(limits[i], LONG_MIN, "long");
+		failed += check(limits[i], LONG_MAX, "long");
+		failed += check(limits[i], ULONG_MAX, "unsigned long");
+		failed += check(limits[i], LLONG_MIN, "long long");
+		failed += check(limits[i], ULLONG_MAX, "unsigned long long");
+		failed += check(limits[i], -1, "int");
+	}
+
+	do {
+		static const unsigned sizes[] = { 0, 8, 16, 17, 24, 100, 1000 };
+		const unsigned n = rand() & 1 ? rand() % 40
+			: sizes[rand() % (sizeof sizes / sizeof *sizes)];
+		const BigInt a = random_signed(n);
+		const unsigned long long u = random_ull();
+		const long long l = rand() & 1 ? (long long)u : -(long long)(u >> 1);
+
+		failed += check(a, u, "unsigned long long");
+		failed += check(a, l, "long long");
+		failed += check(a, (unsigned long)u, "unsigned long");
+		failed += check(a, (long)l, "long");
+		failed += check(a, (unsigned)u, "unsigned");
+		failed += check(a, (int)l, "int");
+	} while (--num);
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,182 @@
+/**
+ * \file
+ * Helpers shared by BigInt testers.
+ * $Id$
+ * Copyright 2006 by Michal Nazarewicz (mina86/AT/mina86.com)
+ * Licensed under the Academic Free License version 2.1
+ *
+ * Functions generating random operands used by check-*.cpp programs
+ * and access to representation of BigInt.  Random functions use
+ * rand() so testers seed it with srand() first.
+ */
+
+#ifndef MN_CHECK_HPP
+#define MN_CHECK_HPP
+
+#include <cstdlib>
+#include <string>
+
+#include "bigint.hpp"
+
+
+/**
+ * Returns random 64-bit number.  Some numbers are small, some have
+ * all bits set, some are limits of machine types.
+ *
+ * \return random number
+ */
+inline unsigned long long random_ull() {
+	unsigned long long v = 0;
+	for (unsigned i = 0; i<4; ++i) v = v << 16 | (rand() & 0xffff);
+	switch (rand() % 8) {
+	case 0: return v >> (rand() % 64);
+	case 1: return ~0ull >> (rand() % 64);
+	case 2: return 1ull << (rand() % 64);
+	case 3: return rand() % 4;
+	default: return v;
+	}
+}
+
+
+/**
+ * Returns random non-negative number of given size.  Some numbers
+ * have all bits set.
+ *
+ * \param[in] n number of limbs
+ * \return random number
+ * \sa random_signed()
+ */
+inline mina86::BigInt random_number(unsigned n) {
+	if (!n) return mina86::BigInt();
+	const bool ones = !(rand() % 8);
+	std::string str;
+	for (unsigned i = 0; i<n * 8; ++i) {
+		str += "0123456789abcdef"[ones ? 15 : rand() % 16];
+	}
+	if (str[0]=='0') str[0] = '1';
+	return mina86::BigInt(str, 16);
+}
+
+
+/**
+ * Returns random number of given size and random sign.  Some numbers
+ * have all bits set.
+ *
+ * \param[in] n number of hexadecimal digits (plus one)
+ * \return random number
+ * \sa random_number()
+ */
+inline mina86::BigInt random_signed(unsigned n) {
+	const bool ones = !(rand() % 8);
+	std::string str(rand() & 1 ? "-" : "");
+	for (unsigned i = 0; i<n; ++i) {
+		str += "0123456789abcdef"[ones ? 15 : rand() % 16];
+	}
+	return mina86::BigInt(str + "1", 16);
+}
+
+
+/**
+ * Returns random number of random size and random sign.  The number
+ * of limbs is either one of \a sizes or less then \a max.  Some
+ * numbers are zero and some have all bits set.
+ *
+ * \param[in] sizes sizes (in limbs) picked with higher probability
+ * \param[in] max limit of the number of limbs of other numbers
+ * \return random number
+ * \sa random_number()
+ */
+template<unsigned N>
+inline mina86::BigInt random_sized(const unsigned (&sizes)[N],
+                                   unsigned max) {
+	const mina86::BigInt n =
+		random_number(rand() & 1 ? rand() % max : sizes[rand() % N]);
+	return rand() & 1 ? -n : n;
+}
+
+
+/**
+ * Returns random number of up to given number of limbs and random
+ * sign.  Depending on random choice limbs are random, all bits set,
+ * sparse or mix of the above.  Most significant limbs may be zero so
+ * number may be smaller.
+ *
+ * \param[in] limbs maximal number of limbs
+ * \return random number
+ * \sa random_number()
+ */
+inline mina86::BigInt random_pattern(unsigned limbs) {
+	static const char digits[] = "0123456789abcdef";
+	const unsigned n = rand() % (limbs + 1), kind = rand() % 4;
+	std::string str = rand() & 1 ? "-0" : "0";
+	for (unsigned i = 0; i<n * 8; ++i) {
+		switch (kind == 3 ? rand() % 3 : kind) {
+		case 0: str += digits[rand() % 16]; break;
+		case 1: str += 'f'; break;
+		case 2: str += i % 8 == 7 ? digits[rand() % 2] : '0'; break;
+		}
+	}
+	return mina86::BigInt(str, 16);
+}
+
+
+/**
+ * Returns random positive number with given number of bits.  The most
+ * significant bit is always set.
+ *
+ * \param[in] bits number of bits, must be positive
+ * \return random number
+ */
+inline mina86::BigInt random_bits(unsigned bits) {
+	std::string str = "1";
+	while (str.size()<bits) str += '0' + (rand() & 1);
+	return mina86::BigInt(str, 2);
+}
+
+
+/**
+ * Fills limb vector with random limbs or with all bits set.  The most
+ * significant limb is never zero.
+ *
+ * \param[out] a limb vector
+ * \param[in] n number of limbs, must be positive
+ */
+inline void fill(mina86::BigInt::Limb *a, unsigned n) {
+	typedef mina86::BigInt::Limb Limb;
+	const bool ones = !(rand() % 8);
+	for (unsigned i = 0; i<n; ++i) {
+		a[i] = ones ? ~(Limb)0 : ((Limb)rand() << 16) ^ (Limb)rand();
+	}
+	if (!a[n - 1]) a[n - 1] = 1;
+}
+
+
+namespace mina86 {
+
+/**
+ * Read-only access to representation of BigInt for testers.
+ */
+struct BigIntInspect {
+	/**
+	 * Returns pointer to limbs of a number.
+	 *
+	 * \param[in] n number
+	 * \return pointer to the least significant limb
+	 */
+	static const BigInt::Limb *limbs(const BigInt &n) {
+		return n.limbs_ptr();
+	}
+
+	/**
+	 * Checks whether number is stored inside the object.
+	 *
+	 * \param[in] n number
+	 * \return \c true if limbs of \a n are not on heap
+	 */
+	static bool isInline(const BigInt &n) { return !n.limbs; }
+};
+
+}
+
+
+#endif
@@ -6,9 +6,9 @@
  * By Michal Nazarewicz (mina86/AT/mina86.com)
  *
  * This program generates a list of arithmetic expressions involving
- * addition, substraction and multpilication of big integers.  The
- * expressions are printed one per line in the form: <code>number
- * operator number</code>.
+ * addition, substraction, multiplication, division and modulo of big
+ * integers.  The expressions are printed one per line in the form:
+ * <code>number operator number</code>.
  *
  * If argument is given it should be a number representing how many
  * expressions program should generate.  The default is 100000
@@ -44,10 +44,12 @@ int main(int argc, char **argv) {
 		if (argc>2 && argv[2]) {
 			*p++ = *argv[2];
 		} else {
-			switch (rand() % 3) {
+			switch (rand() % 5) {
 			case 0: *p++ = '+'; break;
 			case 1: *p++ = '*'; break;
 			case 2: *p++ = '-'; break;
+			case 3: *p++ = '/'; break;
+			case 4: *p++ = '%'; break;
 			}
 		}
 		*p++ = ' ';
@@ -7,21 +7,55 @@
  */
 
 
+#include <cstring>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
 
 #include "bigint.hpp"
+#include "bigint-acc.hpp"
+#include "bigint-batch.hpp"
 #include "array.hpp"
 
 using mina86::BigInt;
+using mina86::BigIntAccumulator;
+using mina86::BigIntBatch;
 using mina86::Array;
 
 
+/**
+ * Base numbers are printed in.
+ */
+static unsigned output_base = 10;
+
+
 /******************** Commands ********************/
 static void func_add(Array<BigInt> &stack);
 static void func_sub(Array<BigInt> &stack);
 static void func_mul(Array<BigInt> &stack);
+static void func_sqr(Array<BigInt> &stack);
+static void func_div(Array<BigInt> &stack);
+static void func_mod(Array<BigInt> &stack);
+static void func_dvm(Array<BigInt> &stack);
+static void func_tot(Array<BigInt> &stack);
+static void func_pow(Array<BigInt> &stack);
+static void func_pwm(Array<BigInt> &stack);
+static void func_gcd(Array<BigInt> &stack);
+static void func_lcm(Array<BigInt> &stack);
+static void func_gce(Array<BigInt> &stack);
+static void func_inv(Array<BigInt> &stack);
+static void func_sqt(Array<BigInt> &stack);
+static void func_rot(Array<BigInt> &stack);
+static void func_ppw(Array<BigInt> &stack);
+static void func_fac(Array<BigInt> &stack);
+static void func_bin(Array<BigInt> &stack);
+static void func_fib(Array<BigInt> &stack);
+static void func_luc(Array<BigInt> &stack);
+static void func_ipr(Array<BigInt> &stack);
+static void func_npr(Array<BigInt> &stack);
 static void func_dup(Array<BigInt> &stack);
 static void func_prn(Array<BigInt> &stack);
+static void func_obs(Array<BigInt> &stack);
 static void func_del(Array<BigInt> &stack);
 static void func_xhg(Array<BigInt> &stack);
 static void func_all(Array<BigInt> &stack);
@@ -47,10 +81,52 @@ static struct {
 	{ "*"    , func_mul, 2, 0 },
 	{ "m"    , func_mul, 2, 0 },
 	{ "mul"  , func_mul, 2, "Multiplies two numbers" },
+	{ "sq"   , func_sqr, 1, 0 },
+	{ "sqr"  , func_sqr, 1, "Squares number at the top" },
+	{ "/"    , func_div, 2, 0 },
+	{ "div"  , func_div, 2, "Divides next number by number at the top" },
+	{ "%"    , func_mod, 2, 0 },
+	{ "mod"  , func_mod, 2, "Remainder of dividing next number by number "
+	                        "at the top" },
+	{ "~"    , func_dvm, 2, 0 },
+	{ "divmod", func_dvm, 2, "Replaces two numbers with quotient and "
+	                         "remainder" },
+	{ "^"    , func_pow, 2, 0 },
+	{ "pow"  , func_pow, 2, "Raises next number to the power of number at "
+	                        "the top" },
+	{ "|"    , func_pwm, 3, 0 },
+	{ "powmod", func_pwm, 3, "Raises third number to the power of next "
+	                         "number modulo number at the top" },
+	{ "gcd"  , func_gcd, 2, "Greatest common divisor of two numbers" },
+	{ "lcm"  , func_lcm, 2, "Least common multiple of two numbers" },
+	{ "gcdext", func_gce, 2, "Replaces two numbers with their greatest "
+	                         "common divisor and Bezout's coefficients" },
+	{ "invmod", func_inv, 2, "Inverse of next number modulo number at the "
+	                         "top" },
+	{ "sqrt" , func_sqt, 1, "Square root of number at the top" },
+	{ "root" , func_rot, 2, "Root of next number of degree given by number "
+	                        "at the top" },
+	{ "perfpow", func_ppw, 1, "Replaces number at the top with a root and "
+	                          "the greatest exponent it is a power of" },
+	{ "!"    , func_fac, 1, 0 },
+	{ "fact" , func_fac, 1, "Factorial of number at the top" },
+	{ "binom", func_bin, 2, "Binomial coefficient of next number over "
+	                        "number at the top" },
+	{ "fib"  , func_fib, 1, "Fibonacci number of index at the top" },
+	{ "lucas", func_luc, 1, "Lucas number of index at the top" },
+	{ "isprime", func_ipr, 1, "Replaces number at the top with 1 if it is "
+	                          "a (probable) prime and 0 otherwise" },
+	{ "nextprime", func_npr, 1, "Smallest (probable) prime greater than "
+	                            "number at the top" },
+	{ "S"    , func_tot, 1, 0 },
+	{ "total", func_tot, 1, "Replaces all numbers on the stack with their "
+	                        "sum" },
 	{ "d"    , func_dup, 1, 0 },
 	{ "dup"  , func_dup, 1, "Duplicates number at the top" },
 	{ "p"    , func_prn, 1, 0 },
 	{ "print", func_prn, 1, "Prints number at the top" },
+	{ "o"    , func_obs, 1, 0 },
+	{ "obase", func_obs, 1, "Pops output base (2 to 36) from the top" },
 	{ "del"  , func_del, 1, "Removes number from the top" },
 	{ "x"    , func_xhg, 2, 0 },
 	{ "xchg" , func_xhg, 2, "Exchanges two numbers at the top" },
@@ -71,7 +147,202 @@ static struct {
 
 
 /******************** Main ********************/
-int main(void) {
+/**
+ * Finds command.
+ *
+ * \param[in] str name of the command
+ * \return index of the command in #commands or index of the
+ *         terminating entry if there is no such command
+ */
+static unsigned find_command(const std::string &str) {
+	unsigned i = 0;
+	while (commands[i].handler && commands[i].command != str) ++i;
+	return i;
+}
+
+
+/**
+ * Executes single token, ie. pushes number or runs command.
+ *
+ * \param[in,out] stack stack
+ * \param[in] str token
+ * \return \c false if token was an exit command
+ */
+static bool run_token(Array<BigInt> &stack, const std::string &str) {
+	/* It's a number (may be prefixed with 0x or 0b) */
+	if ((str[0]>='0' && str[0]<='9') ||
+		(str.size()>1 && (str[0]=='-' || str[0]=='+') &&
+		 (str[1]>='0' && str[1]<='9'))) {
+		stack.push(BigInt(str, 0));
+		return true;
+	}
+
+	/* Find command */
+	const unsigned i = find_command(str);
+	if (!commands[i].handler) {
+		std::cerr << "rpn: " << str
+		        << ": unknown command; type help for list of commands\n";
+		return true;
+	}
+
+	/* It's a dummy exit entry */
+	if (commands[i].handler == func_ext) return false;
+
+	/* Check stack */
+	if (commands[i].min > stack.size()) {
+		std::cerr << "rpn: " << str << ": requires at least "
+		          << commands[i].min << " numbers on stack\n";
+		return true;
+	}
+
+	/* Run command */
+	try {
+		commands[i].handler(stack);
+	}
+	catch (const std::exception &e) {
+		std::cerr << "rpn: " << str << ": " << e.what() << '\n';
+	}
+	return true;
+}
+
+
+/**
+ * Lines of the form <code><var>a</var> <var>b</var> <var>op</var> p
+ * del</code> collected by batch mode.  Such lines leave the stack
+ * intact so they may be computed in any order.  Lines are collected
+ * in a separate batch for each operation and results are printed in
+ * the order of lines.
+ */
+struct Batch {
+	/** Batches, one for each operation. */
+	BigIntBatch batch[BigIntBatch::MOD + 1];
+	/** Operations of lines in the order they were read. */
+	Array<unsigned char> order;
+
+	/**
+	 * Adds line to the batch if it has the form given above.  If
+	 * the batch of the operation is full all batches are flushed
+	 * first.
+	 *
+	 * \param[in] tok tokens of the line
+	 * \param[in] n number of tokens
+	 * \return \c false if line cannot be batched
+	 */
+	bool push(const std::string *tok, unsigned n);
+
+	/**
+	 * Runs operations on all collected lines and prints results.
+	 */
+	void flush();
+};
+
+
+bool Batch::push(const std::string *tok, unsigned n) {
+	if (n!=5 || commands[find_command(tok[3])].handler!=func_prn ||
+	    commands[find_command(tok[4])].handler!=func_del) {
+		return false;
+	}
+
+	void (*const handler)(Array<BigInt> &) =
+		commands[find_command(tok[2])].handler;
+	BigIntBatch::Op op;
+	if      (handler==func_add) op = BigIntBatch::ADD;
+	else if (handler==func_sub) op = BigIntBatch::SUB;
+	else if (handler==func_mul) op = BigIntBatch::MUL;
+	else if (handler==func_div) op = BigIntBatch::DIV;
+	else if (handler==func_mod) op = BigIntBatch::MOD;
+	else return false;
+
+	/* Division by zero is left for the calculator to report */
+	if (op>=BigIntBatch::DIV &&
+	    tok[1].find_first_not_of("+-0")==std::string::npos) {
+		return false;
+	}
+
+	if (batch[op].size()==batch[op].capacity()) {
+		flush();
+	}
+	if (!batch[op].push(tok[0].c_str(), tok[1].c_str())) {
+		return false;
+	}
+	order.push(op);
+	return true;
+}
+
+
+void Batch::flush() {
+	unsigned pos[BigIntBatch::MOD + 1];
+	for (unsigned op = 0; op<=BigIntBatch::MOD; ++op) {
+		if (batch[op].size()) batch[op].run((BigIntBatch::Op)op);
+		pos[op] = 0;
+	}
+
+	std::string out;
+	for (const unsigned char *it = order.begin(); it!=order.end(); ++it) {
+		out += batch[*it].toString(pos[*it]++, output_base);
+		out += '\n';
+	}
+	std::cout << out;
+
+	for (unsigned op = 0; op<=BigIntBatch::MOD; ++op) batch[op].clear();
+	order.clear();
+}
+
+
+/**
+ * Reads input line by line computing independent lines in batches.
+ * Other lines are executed token by token after computing the batch
+ * collected so far.
+ *
+ * \param[in,out] stack stack
+ */
+static void run_batch(Array<BigInt> &stack) {
+	Batch b;
+	std::string line, tok[6];
+	while (std::getline(std::cin, line)) {
+		/* Split line (at most six tokens are needed) */
+		unsigned n = 0;
+		std::string::size_type pos = 0;
+		while (n<6) {
+			pos = line.find_first_not_of(" \t\r\v\f", pos);
+			if (pos==std::string::npos) break;
+			const std::string::size_type e =
+				line.find_first_of(" \t\r\v\f", pos);
+			tok[n++].assign(line, pos, e - pos);
+			pos = e;
+		}
+		if (b.push(tok, n)) {
+			continue;
+		}
+
+		b.flush();
+		if (n<6) {
+			for (unsigned i = 0; i<n; ++i) {
+				if (!run_token(stack, tok[i])) return;
+			}
+		} else {
+			std::istringstream in(line);
+			for (std::string str; in >> str; ) {
+				if (!run_token(stack, str)) return;
+			}
+		}
+	}
+	b.flush();
+}
+
+
+int main(int argc, char **argv) {
+	bool batch = false;
+	if (argc==2 && !strcmp(argv[1], "-b")) {
+		batch = true;
+	} else if (argc>1) {
+		std::cerr << "usage: " << argv[0] << " [ -b ]\n"
+			"  -b  compute lines of the form `A B op p del' (where op is\n"
+			"      one of + - * / %) in batches; the result is the same\n"
+			"      but many such lines are computed much faster\n";
+		return 2;
+	}
+
 	Array<BigInt> stack;
 	stack.reserve(128);
 
@@ -82,36 +353,11 @@ int main(void) {
 		"Licensed under the Academic Free License version 2.1\n\n";
 
 	/* Main loop */
-	for (std::string str; std::cin >> str; ) {
-		/* It's a number */
-		if ((str[0]>='0' && str[0]<='9') ||
-			(str.size()>1 && (str[0]=='-' || str[0]=='+') &&
-			 (str[1]>='0' && str[1]<='9'))) {
-			stack.push(str);
-			continue;
-		}
-
-		/* Find command */
-		unsigned i = 0;
-		while (commands[i].handler && commands[i].command != str) ++i;
-		if (!commands[i].handler) {
-			std::cerr << "rpn: " << str
-			        << ": unknown command; type help for list of commands\n";
-			continue;
-		}
-
-		/* It's a dummy exit entry */
-		if (commands[i].handler == func_ext) break;
-
-		/* Check stack */
-		if (commands[i].min > stack.size()) {
-			std::cerr << "rpn: " << str << ": requires at least "
-			          << commands[i].min << " numbers on stack\n";
-			continue;
-		}
-
-		/* Run command */
-		commands[i].handler(stack);
+	if (batch) {
+		std::ios::sync_with_stdio(false);
+		run_batch(stack);
+	} else {
+		for (std::string str; std::cin >> str && run_token(stack, str); ) ;
 	}
 
 	return 0;
@@ -138,12 +384,168 @@ static void func_mul(Array<BigInt> &stack) {
 	stack.shrinkBy(1);
 }
 
+static void func_sqr(Array<BigInt> &stack) {
+	stack.rw_at(stack.size() - 1).sqr();
+}
+
+static void func_div(Array<BigInt> &stack) {
+	const unsigned s = stack.size();
+	stack.rw_at(s - 2) /= stack.at(s - 1);
+	stack.shrinkBy(1);
+}
+
+static void func_mod(Array<BigInt> &stack) {
+	const unsigned s = stack.size();
+	stack.rw_at(s - 2) %= stack.at(s - 1);
+	stack.shrinkBy(1);
+}
+
+static void func_dvm(Array<BigInt> &stack) {
+	const unsigned s = stack.size();
+	BigInt rem;
+	stack.rw_at(s - 2).divmod(stack.at(s - 1), rem);
+	stack.rw_at(s - 1) = std::move(rem);
+}
+
+static void func_pow(Array<BigInt> &stack) {
+	const unsigned s = stack.size();
+	const BigInt &e = stack[s - 1];
+	if (e.sgn()<0) {
+		throw BigInt::NegativeExponent();
+	}
+	stack.rw_at(s - 2).pow(e.toUnsignedLong());
+	stack.shrinkBy(1);
+}
+
+static void func_pwm(Array<BigInt> &stack) {
+	const unsigned s = stack.size();
+	stack.rw_at(s - 3).powmod(stack[s - 2], stack[s - 1]);
+	stack.shrinkBy(2);
+}
+
+static void func_gcd(Array<BigInt> &stack) {
+	const unsigned s = stack.size();
+	stack.rw_at(s - 2).gcd(stack[s - 1]);
+	stack.shrinkBy(1);
+}
+
+static void func_lcm(Array<BigInt> &stack) {
+	const unsigned s = stack.size();
+	stack.rw_at(s - 2).lcm(stack[s - 1]);
+	stack.shrinkBy(1);
+}
+
+static void func_gce(Array<BigInt> &stack) {
+	const unsigned s = stack.size();
+	BigInt u, v;
+	stack.rw_at(s - 2).gcdext(stack[s - 1], u, v);
+	stack.rw_at(s - 1) = std::move(u);
+	stack.push(std::move(v));
+}
+
+static void func_inv(Array<BigInt> &stack) {
+	const unsigned s = stack.size();
+	stack.rw_at(s - 2).invmod(stack[s - 1]);
+	stack.shrinkBy(1);
+}
+
+static void func_sqt(Array<BigInt> &stack) {
+	stack.rw_at(stack.size() - 1).isqrt();
+}
+
+static void func_rot(Array<BigInt> &stack) {
+	const unsigned s = stack.size();
+	const BigInt &k = stack[s - 1];
+	if (k.sgn()<0) {
+		throw std::domain_error("negative degree of root");
+	}
+	stack.rw_at(s - 2).iroot(k.toUnsignedLong());
+	stack.shrinkBy(1);
+}
+
+static void func_ppw(Array<BigInt> &stack) {
+	BigInt &n = stack.rw_at(stack.size() - 1);
+	BigInt root;
+	BigInt k;
+	k.set(n.perfectPower(&root));
+	n = std::move(root);
+	stack.push(std::move(k));
+}
+
+static void func_fac(Array<BigInt> &stack) {
+	BigInt &n = stack.rw_at(stack.size() - 1);
+	if (n.sgn()<0) {
+		throw std::domain_error("factorial of negative number");
+	}
+	n = BigInt::factorial(n.toUnsignedLong());
+}
+
+static void func_bin(Array<BigInt> &stack) {
+	const unsigned s = stack.size();
+	const BigInt &n = stack[s - 2], &k = stack[s - 1];
+	if (n.sgn()<0 || k.sgn()<0) {
+		throw std::domain_error("binomial coefficient of negative number");
+	}
+	stack.rw_at(s - 2) = BigInt::binomial(n.toUnsignedLong(),
+	                                      k.toUnsignedLong());
+	stack.shrinkBy(1);
+}
+
+static void func_fib(Array<BigInt> &stack) {
+	BigInt &n = stack.rw_at(stack.size() - 1);
+	if (n.sgn()<0) {
+		throw std::domain_error("negative index");
+	}
+	n = BigInt::fibonacci(n.toUnsignedLong());
+}
+
+static void func_luc(Array<BigInt> &stack) {
+	BigInt &n = stack.rw_at(stack.size() - 1);
+	if (n.sgn()<0) {
+		throw std::domain_error("negative index");
+	}
+	n = BigInt::lucas(n.toUnsignedLong());
+}
+
+static void func_ipr(Array<BigInt> &stack) {
+	BigInt &n = stack.rw_at(stack.size() - 1);
+	n.set(n.isProbablePrime() ? 1UL : 0UL);
+}
+
+static void func_npr(Array<BigInt> &stack) {
+	stack.rw_at(stack.size() - 1).nextPrime();
+}
+
+static void func_tot(Array<BigInt> &stack) {
+	BigIntAccumulator acc;
+	for (const BigInt *it = stack.begin(), *end = stack.end(); it!=end; ++it) {
+		acc += *it;
+	}
+	stack.clear();
+	stack.push(acc.get());
+}
+
 static void func_dup(Array<BigInt> &stack) {
 	stack.push(stack[stack.size() - 1]);
 }
 
 static void func_prn(Array<BigInt> &stack) {
-	std::cout << stack[stack.size() - 1] << '\n';
+	std::cout << stack[stack.size() - 1].toString(output_base) << '\n';
+}
+
+static void func_obs(Array<BigInt> &stack) {
+	unsigned long base;
+	try {
+		base = stack[stack.size() - 1].toUnsignedLong();
+	}
+	catch (const BigInt::OutOfRange &) {
+		throw BigInt::BadRadix();
+	}
+	if (base<2 || base>36) {
+		throw BigInt::BadRadix();
+	}
+	output_base = base;
+	stack.shrinkBy(1);
 }
 
 static void func_del(Array<BigInt> &stack) {
@@ -160,9 +562,9 @@ static void func_all(Array<BigInt> &stack) {
 	if (end==begin) {
 		std::cout << "stack is empty\n";
 	} else {
-		std::cout << "top: " << *--end << '\n';
+		std::cout << "top: " << (--end)->toString(output_base) << '\n';
 		while (end!=begin) {
-			std::cout << "     " << *--end << '\n';
+			std::cout << "     " << (--end)->toString(output_base) << '\n';
 		}
 	}
 }